@@ -46,6 +46,14 @@ enum CollisionOptions
     CO_AllGeometryContacts = 0x80, ///< if set, then will return the contact points of all the colliding geometries. Do not need to explore all pairs of links once the first pair is found. This option can be slow.    
 };
 
+/// \brief options for \ref CollisionCheckerBase::CheckCollisionBatch
+enum CollisionBatchOptions
+{
+    CBO_Environment = 1, ///< check the body against the rest of the environment
+    CBO_SelfCollision = 2, ///< check the body for self collisions using the same checker
+    CBO_StopAtFirstCollision = 4, ///< return once a configuration is in collision. The configurations after it are not checked and their bits are not set.
+};
+
 /// \brief action to perform whenever a collision is detected between objects
 enum CollisionAction
 {
@@ -109,6 +117,20 @@ public:
 
 };
 
+/// \brief the closest hit of one ray, filled by \ref CollisionCheckerBase::CheckCollisionRays
+class OPENRAVE_API RayCollisionResult
+{
+public:
+    RayCollisionResult() : fDistance(0), bCollision(false) {
+    }
+
+    KinBody::LinkConstPtr plink; ///< the hit link, can be empty if the hit object does not belong to a body
+    Vector pos; ///< the hit point in world coordinates
+    Vector norm; ///< the normal of the hit surface at pos, pointing out of the surface
+    dReal fDistance; ///< distance from the ray origin to pos
+    bool bCollision; ///< true if the ray hit something. If false, the other fields are not set.
+};
+
 /// \brief Holds information about collision report without storing openrave environment data structure such as KinBody or Geometry
 class OPENRAVE_API CollisionReportInfo : public orjson::JsonSerializable
 {
@@ -247,6 +269,17 @@ public:
     /// \param[out] report [optional] collision report to be filled with data about the collision. If a body was hit, CollisionReport::plink1 contains the hit link pointer.
     virtual bool CheckCollision(const RAY& ray, CollisionReportPtr report = CollisionReportPtr()) = 0;
 
+    /// \brief Checks many rays in one call and returns the closest hit of each. CO_ActiveDOFs option is ignored.
+    ///
+    /// Sensors and other callers casting many rays at once should use this instead of calling CheckCollision for every ray.
+    /// If CO_RayAnyHit is set, the hit of a ray is not necessarily the closest one. The default implementation calls
+    /// CheckCollision for every ray, checkers can override it to share the setup and to check the rays in parallel.
+    /// \param vrays the rays. The length of a ray is the length of its direction.
+    /// \param pbody if not empty, only the links of pbody are checked. Otherwise the entire scene is checked.
+    /// \param[out] vresults the result of every ray
+    /// \return the number of rays that hit something
+    virtual int CheckCollisionRays(const std::vector<RAY>& vrays, KinBodyConstPtr pbody, std::vector<RayCollisionResult>& vresults);
+
     /// \brief Check collision with a triangle mesh and a body in the scene.
     ///
     /// \param trimesh Holds a dynamic triangle mesh to check collision with the body.
@@ -288,6 +321,18 @@ public:
     /// \param[out] report [optional] collision report to be filled with data about the collision.
     virtual bool CheckStandaloneSelfCollision(KinBody::LinkConstPtr plink, CollisionReportPtr report = CollisionReportPtr()) = 0;
 
+    /// \brief Checks a body at many configurations in one call.
+    ///
+    /// For every configuration, sets the dofs of pbody with KinBody::CLA_Nothing and checks it according to batchoptions. The state of the body is restored before returning.
+    /// No collision reports are computed, so CO_Contacts and CO_Distance are ignored. The default implementation calls CheckCollision and CheckStandaloneSelfCollision for every configuration, checkers can override it to share setup across the configurations.
+    /// \param pbody the body to move and check
+    /// \param dofindices the dof indices each configuration sets. If empty, each configuration sets all the dofs of the body.
+    /// \param vconfigurations the configurations one after another, each of size dofindices.size()
+    /// \param[out] vcollisionmasks bit i (vcollisionmasks[i>>6] & (1<<(i&0x3f))) is set if configuration i is in collision
+    /// \param batchoptions combination of \ref CollisionBatchOptions
+    /// \return the number of configurations in collision
+    virtual int CheckCollisionBatch(KinBodyPtr pbody, const std::vector<int>& dofindices, const std::vector<dReal>& vconfigurations, std::vector<uint64_t>& vcollisionmasks, int batchoptions=CBO_Environment|CBO_SelfCollision);
+
     /// \deprecated (13/04/09)
     virtual bool CheckSelfCollision(KinBodyConstPtr pbody, CollisionReportPtr report = CollisionReportPtr()) RAVE_DEPRECATED
     {
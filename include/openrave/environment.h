@@ -586,6 +586,19 @@ public:
     /// \throw openrave_exception with ORE_Timeout error code
     virtual void GetPublishedBodyTransformsMatchingPrefix(const std::string& prefix, std::vector<std::pair<std::string, Transform> >& nameTransfPairs, uint64_t timeout = 0) = 0;
 
+    /// \brief Retrieve only the published bodies that changed since a previous call, completes even if environment is locked. <b>[multi-thread safe]</b>
+    ///
+    /// A separate **interface mutex** is locked for reading the published bodies.
+    /// Every UpdatePublishedBodies call that changes any published state increments the published stamp. The first call should pass 0 to get all the published bodies; subsequent calls pass the returned stamp to get the deltas.
+    /// Removals should be applied before the changed bodies since an environment body index can be reused by a new body.
+    /// \param stamp the stamp returned by the previous call
+    /// \param vChangedBodies filled with the states of the bodies that were added or modified after stamp
+    /// \param vRemovedEnvironmentBodyIndices filled with the environment body indices of the bodies that stopped being published after stamp
+    /// \param timeout microseconds to wait before throwing an exception, if 0, will block indefinitely.
+    /// \throw openrave_exception with ORE_Timeout error code
+    /// \return the current published stamp
+    virtual uint64_t GetPublishedBodiesChangedSince(uint64_t stamp, std::vector<KinBody::BodyState>& vChangedBodies, std::vector<int>& vRemovedEnvironmentBodyIndices, uint64_t timeout=0) = 0;
+
     /// \brief Updates the published bodies that viewers and other programs listening in on the environment see.
     ///
     /// For example, calling this function inside a planning loop allows the viewer to update the environment
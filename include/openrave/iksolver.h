@@ -231,6 +231,16 @@ public:
      */
     virtual bool SolveAll(const IkParameterization& param, int filteroptions, std::vector<IkReturnPtr>& ikreturns);
 
+    /** \brief Return all joint configurations for each of the given end effector transforms.
+
+        Returns the same solutions as calling \ref SolveAll for every parameterization, each pose starts from the robot state at the time of the call. Solvers can share the robot state saver, the collision checker options and the end effector link savers across the whole batch, the free parameter search still runs for every pose.
+        \param[in] vparams the poses the end effector has to achieve in the manipulator base's coordinate system.
+        \param[in] filteroptions A bitmask of \ref IkFilterOptions values controlling what is checked for each ik solution.
+        \param[out] vikreturns resized to vparams.size(), vikreturns[i] holds the ik output data of all the solutions of vparams[i].
+        \return the number of parameterizations that have at least one solution
+     */
+    virtual int SolveAllBatch(const std::vector<IkParameterization>& vparams, int filteroptions, std::vector< std::vector<IkReturnPtr> >& vikreturns);
+
     /** Return a joint configuration for the given end effector transform.
 
         Can specify the free parameters in [0,1] range. If NULL, the regular equivalent Solve is called
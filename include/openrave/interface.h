@@ -50,6 +50,8 @@ enum SerializationOptions
 enum InfoSerializeOption
 {
     ISO_ReferenceUriHint = 1, ///< if set, will save the referenceURI as a hint rather than as a referenceUri
+    ISO_BinaryArrays = 2, ///< if set, will save large numeric arrays like mesh vertices and indices as little-endian typed binary arrays rather than json number arrays
+    ISO_RawBinaryArrays = 4, ///< if set together with ISO_BinaryArrays, the typed binary arrays keep their raw bytes instead of base64. Only for documents packed to msgpack, since json strings cannot hold raw bytes
 };
 
 enum InfoDeserializeOption
@@ -224,6 +224,11 @@ public:
 
 typedef boost::shared_ptr<KinematicsGenerator> KinematicsGeneratorPtr;
 
+/// \brief creates the built-in generator that flattens a body's kinematic chain into straight-line forward kinematics
+///
+/// Static joints are folded into constant transforms and revolute/prismatic joints are specialized when the functions are generated. The generated functions are shared between all bodies with the same kinematics geometry hash. Bodies with mimic, passive, spherical, hinge2, trajectory joints or closed loops are not supported and fall back to the generic kinematics.
+OPENRAVE_API KinematicsGeneratorPtr CreateStraightLineKinematicsGenerator();
+
 
 /// \brief checks if link is enabled from vector of link enable state mask
 /// intended to be used on return value of GetLinkEnableStatesMasks()
@@ -526,7 +531,8 @@ public:
         /// Should be transformed by \ref _t before rendering.
         /// For spheres and cylinders, an appropriate discretization value is chosen.
         /// If empty, will be automatically computed from the geometry's type and render data
-        TriMesh _meshcollision;
+        /// Copies of the info share the mesh, use _meshcollision.GetWritable() to modify it.
+        SharedTriMesh _meshcollision;
 
         GeometryType _type = GT_None; ///< the type of geometry primitive
         std::string _id;   ///< unique id of the geometry
@@ -1515,12 +1521,30 @@ public:
             }
         };
 
+        /// \brief closed form of an equation that is linear in the values of _vdofformat, evaluated without the function parser
+        struct LinearEquation
+        {
+            inline dReal Eval(const dReal* pvalues) const {
+                dReal f = foffset;
+                for(size_t i = 0; i < vcoeffs.size(); ++i) {
+                    f += vcoeffs[i]*pvalues[i];
+                }
+                return f;
+            }
+
+            std::vector<dReal> vcoeffs; ///< one coefficient for every value of _vdofformat
+            dReal foffset = 0;
+            bool bValid = false; ///< if false, the equation is not linear and has to be evaluated with the function parser
+        };
+
         /// @name automatically set
         //@{
         std::vector< DOFFormat > _vdofformat;         ///< the format of the values the equation takes order is important.
         std::vector<DOFHierarchy> _vmimicdofs;         ///< all dof indices that the equations depends on. DOFHierarchy::dofindex can repeat
         OpenRAVEFunctionParserRealPtr _posfn;
         std::vector<OpenRAVEFunctionParserRealPtr > _velfns, _accelfns;         ///< the velocity and acceleration partial derivatives with respect to each of the values in _vdofformat
+        LinearEquation _poslinear; ///< closed form of _posfn when it is linear
+        std::vector<LinearEquation> _vellinear, _accellinear; ///< closed forms of _velfns and _accelfns, indices match
         //@}
     };
     typedef boost::shared_ptr<Mimic> MimicPtr;
@@ -3058,6 +3082,55 @@ private:
      */
     virtual void ComputeHessianAxisAngle(int linkindex, std::vector<dReal>& hessian, const std::vector<int>& dofindices=std::vector<int>()) const;
 
+    /// \brief cache of the global joint axes and anchors of one configuration, shared by the jacobian and hessian functions taking a workspace
+    ///
+    /// The cache is recomputed by the first query after the body moved (see \ref GetUpdateStamp), so any number of jacobians and hessians of
+    /// different links and points at the same configuration only compute the joint axes and the mimic partial derivatives once.
+    /// Not thread safe, every thread needs its own workspace.
+    struct KinematicsWorkspace
+    {
+        KinematicsWorkspace() : pbody(NULL), nKinematicsGenerationId(0), nUpdateStamp(0), nChainSize(0) {
+        }
+
+        const KinBody* pbody; ///< body the cache was computed for
+        uint64_t nKinematicsGenerationId; ///< kinematics structure of the body when the cache was computed, see KinBody::_nKinematicsGenerationId
+        int nUpdateStamp; ///< GetUpdateStamp() of the body when the cache was computed
+        std::vector<Vector> vJointAxes; ///< global axis of every joint dof, indexed by 3*jointindex+idof where jointindex counts the passive joints after the active ones
+        std::vector<Vector> vJointAnchors; ///< global anchor of every joint
+        std::vector<uint8_t> vJointDOFTypes; ///< 1 if revolute, 2 if prismatic, 0 if not supported, indexed like vJointAxes
+        std::vector< std::vector< std::pair<int, dReal> > > vMimicPartials; ///< (dof index, partial derivative) pairs of every mimic dof, indexed like vJointAxes
+        std::map< std::pair<Mimic::DOFFormat, int>, dReal > mapcachedpartials;
+
+        // scratch of the queries
+        std::vector<int> vDOFColumns; ///< column of every dof in the output, -1 if not requested
+        std::vector<int> vChainIndices; ///< joint dofs moving the queried link, from the base to the link
+        std::vector< std::vector< std::pair<int, dReal> > > vChainColumns; ///< (column, weight) pairs of every entry of vChainIndices, only the first nChainSize are valid
+        int nChainSize;
+        std::vector<Vector> vChainTranslations; ///< translation jacobian column of every entry of vChainIndices
+    };
+
+    /// \brief computes the translation jacobian like \ref ComputeJacobianTranslation using the cached joint axes of workspace
+    ///
+    /// \param[out] jacobian 3xdofstride row major matrix, where dofstride is dofindices.size() or GetDOF() if dofindices is empty. Has to be allocated by the caller.
+    void ComputeJacobianTranslation(KinematicsWorkspace& workspace, int linkindex, const Vector& position, dReal* jacobian, const std::vector<int>& dofindices=std::vector<int>()) const;
+
+    /// \brief computes the angular velocity jacobian like \ref ComputeJacobianAxisAngle using the cached joint axes of workspace
+    ///
+    /// \param[out] jacobian 3xdofstride row major matrix, where dofstride is dofindices.size() or GetDOF() if dofindices is empty. Has to be allocated by the caller.
+    void ComputeJacobianAxisAngle(KinematicsWorkspace& workspace, int linkindex, dReal* jacobian, const std::vector<int>& dofindices=std::vector<int>()) const;
+
+    /// \brief computes the translation hessian like \ref ComputeHessianTranslation using the cached joint axes of workspace
+    ///
+    /// Mimic joints are taken into account with the first order partial derivatives of their equations.
+    /// \param[out] hessian dofstridex3xdofstride matrix, where dofstride is dofindices.size() or GetDOF() if dofindices is empty. Has to be allocated by the caller.
+    void ComputeHessianTranslation(KinematicsWorkspace& workspace, int linkindex, const Vector& position, dReal* hessian, const std::vector<int>& dofindices=std::vector<int>()) const;
+
+    /// \brief computes the axis angle hessian like \ref ComputeHessianAxisAngle using the cached joint axes of workspace
+    ///
+    /// Mimic joints are taken into account with the first order partial derivatives of their equations.
+    /// \param[out] hessian dofstridex3xdofstride matrix, where dofstride is dofindices.size() or GetDOF() if dofindices is empty. Has to be allocated by the caller.
+    void ComputeHessianAxisAngle(KinematicsWorkspace& workspace, int linkindex, dReal* hessian, const std::vector<int>& dofindices=std::vector<int>()) const;
+
     /// \brief link index and the linear forces and torques. Value.first is linear force acting on the link's COM and Value.second is torque
     typedef std::map<int, std::pair<Vector,Vector> > ForceTorqueMap;
 
@@ -3091,6 +3164,48 @@ private:
      */
     virtual void ComputeInverseDynamics(boost::array< std::vector<dReal>, 3>& doftorquecomponents, const std::vector<dReal>& dofaccelerations, const ForceTorqueMap& externalforcetorque=ForceTorqueMap()) const;
 
+    /// \brief preallocated buffers for \ref ComputeInverseDynamicsWithVelocities and \ref ComputeInverseDynamicsBatch
+    ///
+    /// Keep one instance per caller and reuse it across calls so that the inverse dynamics do not allocate once the buffers have grown.
+    /// Not thread safe, every thread needs its own workspace.
+    struct InverseDynamicsWorkspace
+    {
+        std::vector< std::pair<Vector, Vector> > vLinkVelocities; ///< linear and angular velocity of every link origin
+        std::vector< std::pair<Vector, Vector> > vLinkAccelerations; ///< linear and angular acceleration of every link origin
+        std::vector< std::pair<Vector, Vector> > vLinkForceTorques; ///< accumulated force and torque at the COM of every link
+        std::vector<Vector> vLinkCOMs; ///< global COM of every link
+        std::vector<Vector> vLinkCOMLinearAccelerations, vLinkCOMMomentOfInertia;
+        std::vector<uint8_t> vlinkscomputed;
+        std::vector<dReal> vDOFValues, vDOFVelocities, vDOFAccelerations, vDOFTorques; ///< buffers for one sample of a batch
+    };
+
+    /** \brief Computes the inverse dynamics torques at the current robot position for the given velocities and accelerations.
+
+        Same as \ref ComputeInverseDynamics without external forces, except that the dof velocities are passed in instead of read from the physics engine
+        and the velocity of the base link is treated as zero. All intermediate values are kept in workspace, so the function does not allocate once the
+        workspace buffers have grown.
+
+        Bodies with mimic joints or non-static passive joints fall back to \ref ComputeInverseDynamics, which uses the velocities set in the physics engine,
+        so for them dofvelocities has to match GetDOFVelocities().
+        \param[out] doftorques The output torques.
+        \param[in] dofvelocities The dof velocities. If the size is 0, assumes all velocities are 0
+        \param[in] dofaccelerations The dof accelerations. If the size is 0, assumes all accelerations are 0
+        \param[inout] workspace buffers reused across calls
+     */
+    virtual void ComputeInverseDynamicsWithVelocities(std::vector<dReal>& doftorques, const std::vector<dReal>& dofvelocities, const std::vector<dReal>& dofaccelerations, InverseDynamicsWorkspace& workspace) const;
+
+    /** \brief Computes the inverse dynamics torques for a batch of states, for example the samples of a trajectory.
+
+        For every sample the body is set to the dof values and the torques are computed like \ref ComputeInverseDynamicsWithVelocities.
+        Gravity is read once for the whole batch and all buffers come from workspace. The state of the body is restored at the end.
+        \param[out] doftorques numsamples*GetDOF() output torques, sample after sample
+        \param[in] dofvalues numsamples*GetDOF() dof values
+        \param[in] dofvelocities numsamples*GetDOF() dof velocities. If the size is 0, assumes all velocities are 0
+        \param[in] dofaccelerations numsamples*GetDOF() dof accelerations. If the size is 0, assumes all accelerations are 0
+        \param[inout] workspace buffers reused across calls
+     */
+    virtual void ComputeInverseDynamicsBatch(std::vector<dReal>& doftorques, const std::vector<dReal>& dofvalues, const std::vector<dReal>& dofvelocities, const std::vector<dReal>& dofaccelerations, InverseDynamicsWorkspace& workspace);
+
     /** \brief Computes dynamic limits for acceleration and jerks, which are dynamically changing based on the given positions and velocities of the robot.
 
         Since not all robots supports dynamic limits, so this function should be overriden in the subclass.
@@ -3248,9 +3363,40 @@ private:
     };
 
     /// \brief return all possible link pairs that could get in collision.
+    ///
+    /// Pairs that are adjacent, that collide in the initial configuration, or that can never collide (see \ref SetNeverCollidingLinkPairs) are excluded.
     /// \param adjacentoptions a bitmask of \ref AdjacentOptions values
     virtual const std::vector<int>& GetNonAdjacentLinks(int adjacentoptions=0) const;
 
+    /** \brief samples the dof values within their limits and classifies the non-adjacent link pairs by whether they collide
+
+        Pairs that do not collide in any sample can never collide, pairs that collide in every sample always collide, the rest
+        sometimes collide. The pairs are encoded as index0|(index1<<16) like in \ref GetNonAdjacentLinks. All links are enabled
+        during the analysis and the state of the body is restored afterwards. Revolute and circular dofs whose range spans more
+        than one revolution are sampled over one revolution starting at their lower limit, other dofs over their limits.
+        \param numsamples number of configurations to sample, the sampling is deterministic
+        \param fSafetyMargin if > 0, a pair is only classified as never colliding if its links stay further apart than this in every sample. Requires a collision checker that supports CO_Distance.
+        \param[out] vNeverCollidingLinkPairs the pairs that did not collide in any sample
+        \param[out] vAlwaysCollidingLinkPairs the pairs that collided in every sample
+     */
+    virtual void ComputeLinkPairCollisionClasses(int numsamples, dReal fSafetyMargin, std::vector<int>& vNeverCollidingLinkPairs, std::vector<int>& vAlwaysCollidingLinkPairs);
+
+    /// \brief sets the link pairs that can never collide, these are excluded from \ref GetNonAdjacentLinks
+    ///
+    /// The pairs apply to the current kinematics, geometry and dof limits. Once \ref GetKinematicsGeometryHash changes or a dof
+    /// limit leaves the current limits, the pairs saved for the new hash and limits with \ref SaveNeverCollidingLinkPairs are loaded instead, if any.
+    /// \param vNeverCollidingLinkPairs pairs encoded as index0|(index1<<16), for example from \ref ComputeLinkPairCollisionClasses
+    virtual void SetNeverCollidingLinkPairs(const std::vector<int>& vNeverCollidingLinkPairs);
+
+    /// \brief returns the link pairs that can never collide, loading them from the database if they were saved for the current kinematics geometry hash and for dof limits that contain the current ones
+    virtual const std::vector<int>& GetNeverCollidingLinkPairs() const;
+
+    /// \brief saves the never colliding link pairs to the openrave database, keyed by \ref GetKinematicsGeometryHash
+    ///
+    /// The dof limits the pairs were computed for are saved with them. Every body with the same hash whose dof limits are within them loads them automatically.
+    /// \return true if the file was written
+    virtual bool SaveNeverCollidingLinkPairs() const;
+
     /// \brief adds the pair of links to the adjacency list. This is
     void SetAdjacentLinks(int linkindex0, int linkindex1);
 
@@ -3528,6 +3674,11 @@ private:
     /// \brief Associate the kinbody's current kinematics geometry hash with a forward kinematics generator
     virtual void SetKinematicsGenerator(KinematicsGeneratorPtr pGenerator);
 
+    /// \brief returns true if the link transforms are computed by functions of the kinematics generator instead of the generic kinematics
+    inline bool IsUsingKinematicsFunctions() const {
+        return !!_pCurrentKinematicsFunctions;
+    }
+
     /// \brief gets the associated file entries
     inline const boost::shared_ptr<rapidjson::Document>& GetAssociatedFileEntries() const {
         return _prAssociatedFileEntries;
@@ -3573,6 +3724,20 @@ protected:
     /// \param[in] externalaccelerations [optional] The external accelerations to add to each link. When doing inverse dynamics, should set the base link's acceleration to -gravity.
     virtual void _ComputeLinkAccelerations(const std::vector<dReal>& dofvelocities, const std::vector<dReal>& dofaccelerations, const std::vector< std::pair<Vector, Vector> >& linkvelocities, std::vector<std::pair<Vector,Vector> >& linkaccelerations, AccelerationMapConstPtr externalaccelerations=AccelerationMapConstPtr()) const;
 
+    /// \brief recomputes the joint axes, anchors and mimic partials of workspace if the body changed since they were computed
+    void _UpdateKinematicsWorkspace(KinematicsWorkspace& workspace) const;
+
+    /// \brief fills the chain of workspace with the joint dofs moving linkindex and the output columns they contribute to
+    ///
+    /// \return the number of columns of the output
+    int _PrepareKinematicsWorkspaceChain(KinematicsWorkspace& workspace, int linkindex, const std::vector<int>& dofindices) const;
+
+    /// \brief true if the inverse dynamics can be computed by _ComputeInverseDynamicsWithVelocities, which only handles one dof hinge and slider joints without mimic equations
+    bool _CanComputeInverseDynamicsWithVelocities() const;
+
+    /// \brief computes the inverse dynamics at the current positions. dofvelocities and dofaccelerations can be NULL if they are all 0.
+    void _ComputeInverseDynamicsWithVelocities(dReal* doftorques, const dReal* dofvelocities, const dReal* dofaccelerations, const Vector& vgravity, InverseDynamicsWorkspace& workspace) const;
+
     /// \brief Called to notify the body that certain groups of parameters have been changed.
     ///
     /// This function in calls every registers calledback that is tracking the changes. It also
@@ -3653,6 +3818,9 @@ protected:
     mutable boost::array<std::vector<int>, 4> _vNonAdjacentLinks; ///< contains cached versions of the non-adjacent links depending on values in AdjacentOptions. Declared as mutable since data is cached.
     mutable boost::array<std::set<int>, 4> _cacheSetNonAdjacentLinks; ///< used for caching return value of GetNonAdjacentLinks.
     mutable int _nNonAdjacentLinkCache; ///< specifies what information is currently valid in the AdjacentOptions.  Declared as mutable since data is cached. If 0x80000000 (ie < 0), then everything needs to be recomputed including _setNonAdjacentLinks[0].
+    mutable std::vector<int> _vNeverCollidingLinkPairs; ///< sorted link pairs that can never collide, excluded from _vNonAdjacentLinks. Loaded on demand, so mutable.
+    mutable std::string _sNeverCollidingLinkPairsHash; ///< the kinematics geometry hash _vNeverCollidingLinkPairs is valid for
+    mutable std::vector<dReal> _vNeverCollidingLinkPairsLower, _vNeverCollidingLinkPairsUpper; ///< the dof limits _vNeverCollidingLinkPairs is valid for
     std::vector<Transform> _vInitialLinkTransformations; ///< the initial transformations of each link specifying at least one pose where the robot is collision free
 
     mutable std::vector<int8_t> _vAttachedVisitedCache; ///< cache
@@ -3671,6 +3839,7 @@ protected:
 
     int _environmentBodyIndex; ///< \see GetEnvironmentBodyIndex
     mutable int _nUpdateStampId; ///< \see GetUpdateStamp
+    uint64_t _nKinematicsGenerationId; ///< unique among all bodies, renewed every time _ComputeInternalInformation rebuilds the joint structure and reset by Destroy. 0 if not computed
     uint32_t _nParametersChanged; ///< set of parameters that changed and need callbacks
     ManageDataPtr _pManageData;
     uint32_t _nHierarchyComputed; ///< 2 if the joint heirarchy and other cached information is computed. 1 if the hierarchy information is computing
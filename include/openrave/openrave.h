@@ -1063,6 +1063,18 @@ protected:
      */
     static void ConvertData(std::vector<dReal>::iterator ittargetdata, const ConfigurationSpecification& targetspec, std::vector<dReal>::const_iterator itsourcedata, const ConfigurationSpecification& sourcespec, size_t numpoints, EnvironmentBaseConstPtr penv, bool filluninitialized = true);
 
+    /** \brief Converts from one specification to another.
+
+        \param ittargetdata iterator pointing to start of target group data that should be overwritten
+        \param targetspec the target configuration specification
+        \param psourcedata pointer to start of source group data that should be read
+        \param sourcespec the source configuration specification
+        \param numpoints the number of points to convert. The target and source strides are gtarget.dof and gsource.dof
+        \param penv [optional] The environment which might be needed to fill in unknown data. Assumes environment is locked.
+        \param filluninitialized If there exists target groups that cannot be initialized, then will set default values using the current environment. For example, the current joint values of the body will be used.
+     */
+    static void ConvertData(std::vector<dReal>::iterator ittargetdata, const ConfigurationSpecification& targetspec, const dReal* psourcedata, const ConfigurationSpecification& sourcespec, size_t numpoints, EnvironmentBaseConstPtr penv, bool filluninitialized = true);
+
     /// \brief gets the name of the interpolation that represents the derivative of the passed in interpolation.
     ///
     /// For example GetInterpolationDerivative("quadratic") -> "linear"
@@ -2486,6 +2498,9 @@ public:
     AABB ComputeAABB() const;
     void serialize(std::ostream& o, int options=0) const;
 
+    /// \brief returns a hash of the vertex positions and indices. Identical meshes have identical hashes.
+    uint64_t ComputeHash() const;
+
     friend OPENRAVE_API std::ostream& operator<<(std::ostream& O, const TriMesh &trimesh);
     friend OPENRAVE_API std::istream& operator>>(std::istream& I, TriMesh& trimesh);
 
@@ -2500,6 +2515,61 @@ public:
 OPENRAVE_API std::ostream& operator<<(std::ostream& O, const TriMesh& trimesh);
 OPENRAVE_API std::istream& operator>>(std::istream& I, TriMesh& trimesh);
 
+/** \brief Reference counted, copy-on-write holder of a \ref TriMesh.
+
+    Copies share the same mesh, so cloned environments do not duplicate the meshes of their geometries. \ref Share additionally
+    replaces the mesh with an identical one that is already used in the process, so repeated parts also share their meshes.
+    Read the mesh through \ref Get, the -> operator, or the implicit conversion to const TriMesh&. Modify it only through
+    \ref GetWritable, which copies the mesh first if it is shared.
+ */
+class OPENRAVE_API SharedTriMesh
+{
+public:
+    SharedTriMesh();
+    SharedTriMesh(const TriMesh& mesh);
+
+    SharedTriMesh& operator=(const TriMesh& mesh);
+
+    inline const TriMesh& Get() const {
+        return *_pmesh;
+    }
+    inline operator const TriMesh&() const {
+        return *_pmesh;
+    }
+    inline const TriMesh* operator->() const {
+        return _pmesh.get();
+    }
+
+    /// \brief returns the mesh itself. While the pointer is held, \ref GetWritable of every holder copies the mesh first, so the mesh never changes.
+    inline boost::shared_ptr<const TriMesh> GetSharedMesh() const {
+        return _pmesh;
+    }
+
+    /// \brief returns a mesh that can be modified. Copies the mesh if other holders reference it.
+    ///
+    /// The reference is valid until this holder is copied from or assigned to.
+    TriMesh& GetWritable();
+
+    /// \brief clears the mesh without modifying the meshes of other holders
+    void Clear();
+
+    /// \brief replaces the mesh with an identical mesh used by another holder in the process, or registers it so that identical meshes can share it.
+    ///
+    /// Thread-safe with respect to other holders.
+    void Share();
+
+    bool operator==(const SharedTriMesh& other) const {
+        return _pmesh == other._pmesh || *_pmesh == *other._pmesh;
+    }
+    bool operator!=(const SharedTriMesh& other) const {
+        return !operator==(other);
+    }
+
+private:
+    boost::shared_ptr<TriMesh> _pmesh; ///< never empty
+    bool _bregistered; ///< true if _pmesh is registered for sharing with \ref Share, in which case it is never modified in place
+};
+
 /// \brief Selects which DOFs of the affine transformation to include in the active configuration.
 enum DOFAffine
 {
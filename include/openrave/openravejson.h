@@ -23,7 +23,9 @@
 #include <openrave/units.h>
 #include <openrave/sensor.h>
 
+#include <algorithm>
 #include <array>
+#include <cstring>
 #include <boost/shared_ptr.hpp>
 #include <boost/smart_ptr/make_shared.hpp>
 #include <boost/lexical_cast.hpp>
@@ -496,27 +498,291 @@ inline void LoadJsonValue(const rapidjson::Value& v, OpenRAVE::geometry::RaveTra
     }
 }
 
+/// \brief returns true if the value is a typed binary array saved with \ref SaveJsonTypedArray or read from a msgpack bin
+///
+/// Typed arrays are objects of the form {"typedArray": "float32"|"float64"|"int32", "base64": "..."} where the elements are stored
+/// little-endian. When written for or read from msgpack, the raw bytes are in "data" instead of "base64".
+inline bool IsJsonTypedArray(const rapidjson::Value& v)
+{
+    return v.IsObject() && v.HasMember("typedArray") && v["typedArray"].IsString() && (v.HasMember("base64") || v.HasMember("data"));
+}
+
+/// \brief returns the size in bytes of one element of a typed array, or 0 if the type is not supported
+inline size_t GetJsonTypedArrayElementSize(const char* type)
+{
+    if( strcmp(type, "float64") == 0 ) {
+        return 8;
+    }
+    if( strcmp(type, "float32") == 0 || strcmp(type, "int32") == 0 ) {
+        return 4;
+    }
+    return 0;
+}
+
+inline const char* GetJsonTypedArrayTypeName(float) {
+    return "float32";
+}
+inline const char* GetJsonTypedArrayTypeName(double) {
+    return "float64";
+}
+inline const char* GetJsonTypedArrayTypeName(int32_t) {
+    return "int32";
+}
+
+inline bool IsLittleEndianHost()
+{
+    const uint16_t value = 1;
+    return *reinterpret_cast<const uint8_t*>(&value) == 1;
+}
+
+/// \brief encodes bytes to base64 and appends them to out
+inline void EncodeBase64(const uint8_t* pdata, size_t size, std::string& out)
+{
+    static const char s_base64chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    out.reserve(out.size() + 4*((size+2)/3));
+    size_t i = 0;
+    for(; i + 2 < size; i += 3) {
+        const uint32_t triple = (uint32_t(pdata[i])<<16)|(uint32_t(pdata[i+1])<<8)|uint32_t(pdata[i+2]);
+        out.push_back(s_base64chars[(triple>>18)&0x3f]);
+        out.push_back(s_base64chars[(triple>>12)&0x3f]);
+        out.push_back(s_base64chars[(triple>>6)&0x3f]);
+        out.push_back(s_base64chars[triple&0x3f]);
+    }
+    if( i < size ) {
+        const uint32_t triple = (uint32_t(pdata[i])<<16)|(i + 1 < size ? (uint32_t(pdata[i+1])<<8) : 0);
+        out.push_back(s_base64chars[(triple>>18)&0x3f]);
+        out.push_back(s_base64chars[(triple>>12)&0x3f]);
+        out.push_back(i + 1 < size ? s_base64chars[(triple>>6)&0x3f] : '=');
+        out.push_back('=');
+    }
+}
+
+/// \brief decodes base64 into pout, which has to hold at least outsize bytes. Returns the number of decoded bytes.
+inline size_t DecodeBase64(const char* pdata, size_t size, uint8_t* pout, size_t outsize)
+{
+    uint32_t accum = 0;
+    int numbits = 0;
+    size_t numout = 0;
+    for(size_t i = 0; i < size; ++i) {
+        const char c = pdata[i];
+        uint32_t sextet;
+        if( c >= 'A' && c <= 'Z' ) {
+            sextet = c - 'A';
+        }
+        else if( c >= 'a' && c <= 'z' ) {
+            sextet = c - 'a' + 26;
+        }
+        else if( c >= '0' && c <= '9' ) {
+            sextet = c - '0' + 52;
+        }
+        else if( c == '+' ) {
+            sextet = 62;
+        }
+        else if( c == '/' ) {
+            sextet = 63;
+        }
+        else if( c == '=' ) {
+            break;
+        }
+        else {
+            throw OPENRAVE_EXCEPTION_FORMAT("invalid base64 character 0x%x", (int)(uint8_t)c, OpenRAVE::ORE_InvalidArguments);
+        }
+        accum = (accum<<6)|sextet;
+        numbits += 6;
+        if( numbits >= 8 ) {
+            numbits -= 8;
+            if( numout >= outsize ) {
+                throw OPENRAVE_EXCEPTION_FORMAT("base64 data decodes to more than %d bytes", outsize, OpenRAVE::ORE_InvalidArguments);
+            }
+            pout[numout++] = uint8_t(accum>>numbits);
+        }
+    }
+    return numout;
+}
+
+/// \brief saves num elements of pdata as a typed binary array, see \ref IsJsonTypedArray
+///
+/// \param bRawBytes if true, the bytes are stored as they are in "data" instead of base64. The value can then only be packed to msgpack, not written as json.
+template<typename T>
+inline void SaveJsonTypedArray(rapidjson::Value& v, const T* pdata, size_t num, rapidjson::Document::AllocatorType& alloc, bool bRawBytes=false)
+{
+    std::vector<uint8_t> vbytes;
+    const uint8_t* pbytes = reinterpret_cast<const uint8_t*>(pdata);
+    if( !IsLittleEndianHost() ) {
+        vbytes.resize(num*sizeof(T));
+        for(size_t i = 0; i < num; ++i) {
+            const uint8_t* pelement = reinterpret_cast<const uint8_t*>(pdata + i);
+            std::reverse_copy(pelement, pelement + sizeof(T), vbytes.begin() + i*sizeof(T));
+        }
+        pbytes = vbytes.data();
+    }
+    v.SetObject();
+    v.AddMember(rapidjson::Document::StringRefType("typedArray"), rapidjson::Value().SetString(GetJsonTypedArrayTypeName(T()), alloc), alloc);
+    if( bRawBytes ) {
+        v.AddMember(rapidjson::Document::StringRefType("data"), rapidjson::Value().SetString(reinterpret_cast<const char*>(pbytes), num*sizeof(T), alloc), alloc);
+    }
+    else {
+        std::string sbase64;
+        EncodeBase64(pbytes, num*sizeof(T), sbase64);
+        v.AddMember(rapidjson::Document::StringRefType("base64"), rapidjson::Value().SetString(sbase64.c_str(), sbase64.size(), alloc), alloc);
+    }
+}
+
+/// \brief helper class that accesses the little-endian elements of a typed binary array, see \ref IsJsonTypedArray
+///
+/// When the array comes from msgpack, the elements are read directly from the value's bytes. Base64 is decoded once into a
+/// scratch buffer.
+class JsonTypedArrayReader
+{
+public:
+    JsonTypedArrayReader(const rapidjson::Value& v) : _type(NULL), _pbytes(NULL), _size(0), _elementsize(0), _bfloat(false)
+    {
+        if( !IsJsonTypedArray(v) ) {
+            throw OPENRAVE_EXCEPTION_FORMAT("Cannot load typed array of json type %s", GetJsonTypeName(v), OpenRAVE::ORE_InvalidArguments);
+        }
+        _type = v["typedArray"].GetString();
+        _elementsize = GetJsonTypedArrayElementSize(_type);
+        if( _elementsize == 0 ) {
+            throw OPENRAVE_EXCEPTION_FORMAT("unsupported typed array type \"%s\"", _type, OpenRAVE::ORE_InvalidArguments);
+        }
+        _bfloat = _type[0] == 'f';
+        if( v.HasMember("data") ) {
+            const rapidjson::Value& rData = v["data"];
+            if( !rData.IsString() ) {
+                throw OPENRAVE_EXCEPTION_FORMAT("typed array \"data\" has json type %s", GetJsonTypeName(rData), OpenRAVE::ORE_InvalidArguments);
+            }
+            _pbytes = reinterpret_cast<const uint8_t*>(rData.GetString());
+            _size = rData.GetStringLength();
+        }
+        else {
+            const rapidjson::Value& rBase64 = v["base64"];
+            if( !rBase64.IsString() ) {
+                throw OPENRAVE_EXCEPTION_FORMAT("typed array \"base64\" has json type %s", GetJsonTypeName(rBase64), OpenRAVE::ORE_InvalidArguments);
+            }
+            _vscratch.resize(3*(rBase64.GetStringLength()/4) + 3);
+            _size = DecodeBase64(rBase64.GetString(), rBase64.GetStringLength(), _vscratch.data(), _vscratch.size());
+            _pbytes = _vscratch.data();
+        }
+        if( _size % _elementsize != 0 ) {
+            throw OPENRAVE_EXCEPTION_FORMAT("typed array has %d bytes, which is not a multiple of the element size %d", _size%_elementsize, OpenRAVE::ORE_InvalidArguments);
+        }
+    }
+
+    /// \brief number of elements
+    inline size_t GetSize() const {
+        return _size/_elementsize;
+    }
+
+    /// \brief little-endian bytes of all elements
+    inline const uint8_t* GetData() const {
+        return _pbytes;
+    }
+
+    /// \brief number of bytes returned by \ref GetData
+    inline size_t GetByteSize() const {
+        return _size;
+    }
+
+    /// \brief returns element i converted to T
+    template<typename T>
+    inline T GetElement(size_t i) const
+    {
+        const uint8_t* pelement = _pbytes + i*_elementsize;
+        uint8_t bytes[8];
+        if( IsLittleEndianHost() ) {
+            memcpy(bytes, pelement, _elementsize);
+        }
+        else {
+            std::reverse_copy(pelement, pelement + _elementsize, bytes);
+        }
+        if( _elementsize == 8 ) {
+            double value;
+            memcpy(&value, bytes, sizeof(value));
+            return static_cast<T>(value);
+        }
+        else if( _bfloat ) {
+            float value;
+            memcpy(&value, bytes, sizeof(value));
+            return static_cast<T>(value);
+        }
+        int32_t value;
+        memcpy(&value, bytes, sizeof(value));
+        return static_cast<T>(value);
+    }
+
+    /// \brief copies all elements into pdata, which has to hold at least \ref GetSize elements
+    template<typename T>
+    inline void CopyTo(T* pdata) const
+    {
+        const size_t num = GetSize();
+        if( IsLittleEndianHost() && strcmp(GetJsonTypedArrayTypeName(T()), _type) == 0 ) {
+            memcpy(pdata, _pbytes, _size);
+            return;
+        }
+        for(size_t i = 0; i < num; ++i) {
+            pdata[i] = GetElement<T>(i);
+        }
+    }
+
+private:
+    const char* _type; ///< element type name, points into the json value
+    const uint8_t* _pbytes; ///< little-endian elements
+    size_t _size; ///< number of bytes in _pbytes
+    size_t _elementsize; ///< size of one element in bytes
+    bool _bfloat; ///< true if the elements are floating point
+    std::vector<uint8_t> _vscratch; ///< holds the decoded base64 data
+};
+
 inline void LoadJsonValue(const rapidjson::Value& v, OpenRAVE::TriMesh& t)
 {
     if (!v.IsObject()) {
         throw OPENRAVE_EXCEPTION_FORMAT0("Cannot load TriMesh of non-object.", OpenRAVE::ORE_InvalidArguments);
     }
 
-    if (!v.HasMember("vertices") || !v["vertices"].IsArray() || v["vertices"].Size() % 3 != 0) {
+    if (!v.HasMember("vertices")) {
         throw OPENRAVE_EXCEPTION_FORMAT0("failed to deserialize json, value cannot be decoded as a TriMesh, \"vertices\" malformatted", OpenRAVE::ORE_InvalidArguments);
     }
 
-    t.vertices.clear();
-    t.vertices.reserve(v["vertices"].Size() / 3);
+    const rapidjson::Value& rVertices = v["vertices"];
+    if (IsJsonTypedArray(rVertices)) {
+        JsonTypedArrayReader reader(rVertices);
+        if (reader.GetSize() % 3 != 0) {
+            throw OPENRAVE_EXCEPTION_FORMAT0("failed to deserialize json, value cannot be decoded as a TriMesh, \"vertices\" malformatted", OpenRAVE::ORE_InvalidArguments);
+        }
+        t.vertices.resize(reader.GetSize() / 3);
+        for (size_t ivertex = 0; ivertex < t.vertices.size(); ++ivertex) {
+            OpenRAVE::Vector& vertex = t.vertices[ivertex];
+            vertex.x = reader.GetElement<OpenRAVE::dReal>(3*ivertex);
+            vertex.y = reader.GetElement<OpenRAVE::dReal>(3*ivertex+1);
+            vertex.z = reader.GetElement<OpenRAVE::dReal>(3*ivertex+2);
+            vertex.w = 0;
+        }
+    }
+    else {
+        if (!rVertices.IsArray() || rVertices.Size() % 3 != 0) {
+            throw OPENRAVE_EXCEPTION_FORMAT0("failed to deserialize json, value cannot be decoded as a TriMesh, \"vertices\" malformatted", OpenRAVE::ORE_InvalidArguments);
+        }
+
+        t.vertices.clear();
+        t.vertices.reserve(rVertices.Size() / 3);
 
-    for (rapidjson::Value::ConstValueIterator it = v["vertices"].Begin(); it != v["vertices"].End(); ) {
-        OpenRAVE::Vector vertex;
-        LoadJsonValue(*(it++), vertex.x);
-        LoadJsonValue(*(it++), vertex.y);
-        LoadJsonValue(*(it++), vertex.z);
-        t.vertices.push_back(vertex);
+        for (rapidjson::Value::ConstValueIterator it = rVertices.Begin(); it != rVertices.End(); ) {
+            OpenRAVE::Vector vertex;
+            LoadJsonValue(*(it++), vertex.x);
+            LoadJsonValue(*(it++), vertex.y);
+            LoadJsonValue(*(it++), vertex.z);
+            t.vertices.push_back(vertex);
+        }
+    }
+
+    if (v.HasMember("indices") && IsJsonTypedArray(v["indices"])) {
+        JsonTypedArrayReader reader(v["indices"]);
+        t.indices.resize(reader.GetSize());
+        reader.CopyTo(t.indices.data());
+    }
+    else {
+        LoadJsonValue(v["indices"], t.indices);
     }
-    LoadJsonValue(v["indices"], t.indices);
 }
 
 template<class T>
@@ -40,6 +40,7 @@ enum ConstraintFilterOptions
     CFO_FromPathSampling=0x00080000, ///< if set, will use \ref NSO_FromPathSampling for the _neighstatefn
     CFO_FromPathShortcutting=0x00100000, ///< if set, will use \ref NSO_FromPathShortcutting for the _neighstatefn
     CFO_FromTrajectorySmoother=0x00200000, ///< if set, will use \ref NSO_FromTrajectorySmoother for the _neighstatefn
+    CFO_CheckInBisectionOrder=0x00400000, ///< if set, the interpolated states are checked in coarse-to-fine (bisection) order after the segment is discretized, so segments invalid in the middle are rejected after a few checks. The states and the resolution are the same. If invalid, \ref ConstraintFilterReturn only has the configurations before the invalid state that was found, which is not necessarily the first one.
     CFO_FinalValuesNotReached=0x40000000, ///< if set, then the final values of the interpolation have not been reached, although a close interpolation has been computed. This happens when manipulator constraints are used.
     CFO_StateSettingError=0x80000000, ///< error when the state setting function (or neighbor function) breaks
     CFO_RecommendedOptions = 0x0000ffff, ///< recommended options that all plugins should use by default
@@ -229,6 +230,19 @@ private:
      */
     virtual void SetConfigurationSpecification(EnvironmentBasePtr env, const ConfigurationSpecification& spec);
 
+    /// \brief returns true if _neighstatefn is still the interpolation with limit clamping installed by SetRobotActiveJoints, SetRobotDOFIndices or SetConfigurationSpecification
+    ///
+    /// The installed functions are recognized through copies of the parameters. Assigning any other function makes this false.
+    bool HasDefaultNeighStateFn() const;
+
+    /// \brief returns true if _neighstatefn, _samplefn and _checkpathvelocityconstraintsfn are still the functions installed by SetRobotActiveJoints, SetRobotDOFIndices or SetConfigurationSpecification
+    ///
+    /// In that case a clone of the environment can reproduce the constraints by calling SetConfigurationSpecification with _configurationspecification.
+    bool HasDefaultConfigurationFunctions() const;
+
+    /// \brief returns true if _distmetricfn and _diffstatefn are still the functions installed by SetRobotActiveJoints, SetRobotDOFIndices or SetConfigurationSpecification
+    bool HasDefaultDistanceFunctions() const;
+
     /// \brief veriries that the configuration space and all parameters are consistent
     ///
     /// Assumes at minimum that  _setstatevaluesfn and _getstatefn are set. Correct environment should be
@@ -516,6 +530,9 @@ protected:
         return boost::static_pointer_cast<PlannerParameters const>(shared_from_this());
     }
 
+    /// \brief sets _checkpathvelocityconstraintsfn and _checkpathvelocityaccelerationconstraintsfn to check the collisions of listCheckCollisions, without timed constraints
+    void _SetDefaultCollisionConstraints(const std::list<KinBodyPtr>& listCheckCollisions);
+
     virtual bool SerializeXML(BaseXMLWriterPtr writer, int options) const override
     {
         return false;
@@ -733,11 +733,13 @@ typedef boost::shared_ptr<WorkspaceTrajectoryParameters const> WorkspaceTrajecto
 class OPENRAVE_API RRTParameters : public PlannerBase::PlannerParameters
 {
 public:
-    RRTParameters() : _minimumgoalpaths(1), _bProcessing(false) {
+    RRTParameters() : _minimumgoalpaths(1), _nNumThreads(1), _bProcessing(false) {
         _vXMLParameters.push_back("minimumgoalpaths");
+        _vXMLParameters.push_back("numthreads");
     }
 
     size_t _minimumgoalpaths; ///< minimum number of goals to connect to before exiting. the goal with the shortest path is returned.
+    int _nNumThreads; ///< number of threads extending the trees. If > 1, every thread checks constraints in its own clone of the environment, so only the constraints that can be set up from _configurationspecification are used. Seeded from _nRandomGeneratorSeed.
 
 protected:
     bool _bProcessing;
@@ -747,6 +749,7 @@ protected:
             return false;
         }
         O << "<minimumgoalpaths>" << _minimumgoalpaths << "</minimumgoalpaths>" << std::endl;
+        O << "<numthreads>" << _nNumThreads << "</numthreads>" << std::endl;
         if( !(options & 1) ) {
             O << _sExtraParameters << std::endl;
         }
@@ -764,7 +767,7 @@ protected:
         case PE_Ignore: return PE_Ignore;
         }
 
-        _bProcessing = name=="minimumgoalpaths";
+        _bProcessing = name=="minimumgoalpaths" || name=="numthreads";
         return _bProcessing ? PE_Support : PE_Pass;
     }
 
@@ -774,6 +777,9 @@ protected:
             if( name == "minimumgoalpaths") {
                 _ss >> _minimumgoalpaths;
             }
+            else if( name == "numthreads" ) {
+                _ss >> _nNumThreads;
+            }
             else {
                 RAVELOG_WARN(str(boost::format("unknown tag %s\n")%name));
             }
@@ -455,6 +455,18 @@ public:
     /// \param bCallAfterCheckCollision if set, function will be called after check collision functions.
     virtual void SetUserCheckFunction(const boost::function<bool() >& usercheckfn, bool bCallAfterCheckCollision=false);
 
+    /// \brief sets the number of threads used to check the states of straight-line segments
+    ///
+    /// When numthreads > 1, the environment of the check bodies is cloned with Clone_Bodies into numthreads worker environments. The workers clone it again only
+    /// when bodies are added or removed, their grabbed bodies, geometries or enabled links change, or the collision checker or its options change. Otherwise only the check bodies and the bodies that moved are synchronized.
+    /// For long straight-line segments (no velocities), the workers claim the discretized states in coarse-to-fine (bisection) order and skip the states after the
+    /// smallest invalid state found so far, so the first invalid state of the segment is found. It is then re-checked on the calling thread to fill \ref ConstraintFilterReturn.
+    /// The states are computed by interpolating q0 and q1 directly, so segments are only checked in parallel when PlannerParameters::HasDefaultNeighStateFn is true.
+    /// Checks using user check functions, time-based constraints, or CFO_FillCheckedConfiguration are always done on the calling thread.
+    /// The default constraints of PlannerParameters use the number of threads in the OPENRAVE_PARALLEL_SEGMENT_CHECK environment variable.
+    /// \param numthreads number of worker threads. If <= 1, all segments are checked on the calling thread (default).
+    virtual void SetParallelCheck(int numthreads);
+
     /// \brief checks line collision. Uses the constructor's self-collisions
     virtual int Check(const std::vector<dReal>& q0, const std::vector<dReal>& q1, const std::vector<dReal>& dq0, const std::vector<dReal>& dq1, dReal timeelapsed, IntervalType interval, int options = 0xffff, ConstraintFilterReturnPtr filterreturn = ConstraintFilterReturnPtr());
 
@@ -479,6 +491,30 @@ protected:
     virtual int _SetAndCheckState(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& vdofvalues, const std::vector<dReal>& vdofvelocities, const std::vector<dReal>& vdofaccels, int options, ConstraintFilterReturnPtr filterreturn);
     virtual void _PrintOnFailure(const std::string& prefix);
 
+    /// \brief if options has CFO_CheckInBisectionOrder, makes _SetAndCheckStateOrDefer record the states instead of checking them
+    void _StartDeferringStates(int options);
+
+    /// \brief calls _SetAndCheckState, or only sets and records the state if deferring
+    ///
+    /// \param ftime the time reported in ConstraintFilterReturn::_fTimeWhenInvalid if the state is invalid. If negative, only the return code is reported.
+    int _SetAndCheckStateOrDefer(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& vdofvalues, const std::vector<dReal>& vdofvelocities, const std::vector<dReal>& vdofaccels, int options, ConstraintFilterReturnPtr filterreturn, dReal ftime);
+
+    /// \brief checks the recorded states in bisection order and stops deferring
+    ///
+    /// If the states only move the single check body, the environment collisions of all states are first checked with one
+    /// CollisionCheckerBase::CheckCollisionBatch call. If a state is invalid, the configurations recorded in filterreturn after that state are removed.
+    int _CheckDeferredStates(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& vdofaccels, int options, ConstraintFilterReturnPtr filterreturn);
+
+    /// \brief checks the states q0 + (f/numSteps)*dQ for f in [start, numSteps) with the parallel workers
+    ///
+    /// \param options should already be masked with _filtermask
+    /// \param[out] nstateret the check result, only valid when true is returned
+    /// \return false if the segment cannot be checked in parallel and has to be checked on the calling thread
+    virtual bool _CheckSegmentInParallel(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& q0, int numSteps, int start, int options, ConstraintFilterReturnPtr filterreturn, int& nstateret);
+
+    class ParallelCheckWorkers;
+    typedef boost::shared_ptr<ParallelCheckWorkers> ParallelCheckWorkersPtr;
+
     PlannerBase::PlannerParametersWeakConstPtr _parameters;
     std::vector<dReal> _vtempconfig, _vtempvelconfig, dQ, _vtempveldelta, _vtempacceldelta, _vtempaccelconfig, _vtempjerkconfig, _vperturbedvalues, _vcoeff2, _vcoeff1, _vprevtempconfig, _vprevtempvelconfig, _vprevtempaccelconfig, _vtempconfig2, _vdiffconfig, _vdiffvelconfig, _vdiffaccelconfig, _vstepconfig; ///< in configuration space
     std::vector<dReal> _vrawroots, _vrawcoeffs;
@@ -497,6 +533,25 @@ protected:
     std::vector<dReal> _doftorques, _dofaccelerations; ///< in body DOF space
     boost::shared_ptr<ConfigurationSpecification::SetConfigurationStateFn> _setvelstatefn;
     std::vector<dReal> _vfulldofdynamicaccelerationlimits, _vfulldofdynamicjerklimits, _vfulldofvalues, _vfulldofvelocities; ///< in body full DOF space. the size is GetDOF().
+    KinBody::InverseDynamicsWorkspace _inversedynamicsworkspace; ///< reused by every torque check so that it does not allocate
+
+    /// \brief sets _pbatchbody if the planner state only moves the single check body
+    void _UpdateBatchBody(PlannerBase::PlannerParametersConstPtr parameters);
+
+    ParallelCheckWorkersPtr _pparallelworkers; ///< if set, long straight-line segments are checked in parallel, see SetParallelCheck
+
+    // for CFO_CheckInBisectionOrder
+    bool _bDeferStateChecks; ///< if true, _SetAndCheckStateOrDefer only records the states
+    std::vector<dReal> _vdeferredvalues, _vdeferredvelocities, _vdeferredtimes; ///< the recorded states, values and velocities are flattened
+    std::vector<size_t> _vdeferredconfigurationcounts; ///< for every recorded state, the number of configurations in the ConstraintFilterReturn when it was recorded
+    std::vector<dReal> _vdeferredstate, _vdeferredvelstate;
+    std::vector<int> _vbisectionorder;
+    std::vector< std::pair<int, int> > _vbisectionintervals;
+    KinBodyPtr _pbatchbody; ///< the check body if the planner state moves only it, the deferred states are then checked against the environment with one batch
+    bool _bBatchDeferredStates; ///< if true, the recorded states are checked with CheckCollisionBatch
+    Transform _tbatchbody; ///< transform of _pbatchbody when deferring started
+    std::vector<dReal> _vbatchconfigurations, _vbatchdofvalues; ///< the dof values of _pbatchbody for every recorded state, flattened
+    std::vector<uint64_t> _vbatchcollisionmasks;
 };
 
 typedef boost::shared_ptr<DynamicsCollisionConstraint> DynamicsCollisionConstraintPtr;
@@ -568,6 +623,16 @@ class OPENRAVE_API SimpleDistanceMetric
 public:
     SimpleDistanceMetric(RobotBasePtr robot);
     dReal Eval(const std::vector<dReal>& c0, const std::vector<dReal>& c1);
+
+    inline dReal operator()(const std::vector<dReal>& c0, const std::vector<dReal>& c1) {
+        return Eval(c0, c1);
+    }
+
+    /// \brief gets the squared weights if the metric is sqrt(sum_i weights2[i]*(c0[i]-c1[i])^2) for the current active dofs
+    ///
+    /// Allows callers to compute many distances without calling Eval.
+    /// \return false if the active dofs have circular joints or affine dofs, in which case Eval has to be used
+    bool GetEuclideanWeights2(std::vector<dReal>& vweights2) const;
 protected:
     RobotBasePtr _robot;
 //    int _activeaffine;
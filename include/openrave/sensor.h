@@ -88,6 +88,7 @@ public:
             return ST_Camera;
         }
         std::vector<uint8_t> vimagedata;         ///< rgb image data, if camera only outputs in grayscale, fill each channel with the same value
+        std::vector<float> vdepthdata;         ///< depth along the camera z axis for every pixel, 0 where nothing is seen. Empty if the camera does not output depth
         virtual bool serialize(std::ostream& O) const;
     };
 
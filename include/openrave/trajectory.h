@@ -203,6 +203,13 @@ public:
 
     /// \brief initialize the trajectory via a raw pointer to memory
     virtual void DeserializeFromRawData(const uint8_t* pdata, size_t nDataSize);
+
+    /** \brief initialize the trajectory from a file written by serialize
+
+        Implementations can memory-map the file and use its waypoints in place, so opening a trajectory does not depend on its length.
+        The waypoints are copied the first time the trajectory is modified. The file should not be modified while a trajectory references it.
+     */
+    virtual void DeserializeFromFile(const std::string& filename);
     
     virtual void Clone(InterfaceBaseConstPtr preference, int cloningoptions);
 
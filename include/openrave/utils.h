@@ -284,6 +284,13 @@ OPENRAVE_API std::string GetFilenameUntilSeparator(std::istream& sinput, char se
 /// \return returns a reference to the out string
 OPENRAVE_API std::string& SearchAndReplace(std::string& out, const std::string& in, const std::vector< std::pair<std::string, std::string> >& pairs);
 
+/// \brief calls fn(nbegin, nend) on consecutive chunks of [0, numitems) holding at most chunksize items
+///
+/// The chunks are run by the calling thread and by one process-wide pool of at most hardware_concurrency()-1 threads
+/// shared by all callers, so concurrent callers do not multiply the threads. Returns once all chunks are done, an
+/// exception thrown by fn is rethrown to the caller. fn has to be safe to call concurrently on disjoint chunks.
+OPENRAVE_API void ParallelForChunks(size_t numitems, size_t chunksize, const boost::function<void(size_t, size_t)>& fn);
+
 /// \brief compute the md5 hash of a string
 OPENRAVE_API std::string GetMD5HashString(const std::string& s);
 /// \brief compute the md5 hash of an array
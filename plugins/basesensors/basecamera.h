@@ -18,6 +18,8 @@
 
 #include <boost/lexical_cast.hpp>
 
+#include "softwarerasterizer.h"
+
 class BaseCameraSensor : public SensorBase
 {
 protected:
@@ -253,8 +255,10 @@ public:
     virtual void _Reset()
     {
         _pdata->vimagedata.resize(0);
+        _pdata->vdepthdata.resize(0);
         _pdata->__stamp = 0;
         _vimagedata.clear(); // do not resize vector here since it might never be used and it will take up lots of memory!
+        _vdepthdata.clear();
         _fTimeToImage = 0;
         _graphgeometry.reset();
         _dataviewer.reset();
@@ -283,10 +287,23 @@ public:
                         // copy the data
                         std::lock_guard<std::mutex> lock(_mutexdata);
                         pdata->vimagedata = _vimagedata;
+                        pdata->vdepthdata.resize(0);
                         pdata->__stamp = GetEnv()->GetSimulationTime();
                         pdata->__trans = _trans;
                     }
                 }
+                else {
+                    // no viewer, so render the collision meshes on the cpu
+                    if( !_prasterizer ) {
+                        _prasterizer.reset(new SoftwareRasterizer());
+                    }
+                    _prasterizer->Render(GetEnv(), _trans, _pgeom->KK, _pgeom->width, _pgeom->height, _vimagedata, _vdepthdata);
+                    std::lock_guard<std::mutex> lock(_mutexdata);
+                    pdata->vimagedata = _vimagedata;
+                    pdata->vdepthdata = _vdepthdata;
+                    pdata->__stamp = GetEnv()->GetSimulationTime();
+                    pdata->__trans = _trans;
+                }
             }
         }
         return true;
@@ -446,6 +463,8 @@ protected:
 
     // more geom stuff
     vector<uint8_t> _vimagedata;
+    vector<float> _vdepthdata;
+    boost::shared_ptr<SoftwareRasterizer> _prasterizer; ///< renders the images when the environment has no viewer, created on first use
     RaveVector<float> _vColor;
 
     Transform _trans;
@@ -225,9 +225,8 @@ public:
         if(( _fTimeToScan <= 0) && _bPower ) {
             _fTimeToScan = _pgeom->time_scan;
 
-            RAY r;
-
-            GetEnv()->GetCollisionChecker()->SetCollisionOptions(CO_Distance);
+            CollisionCheckerBasePtr pchecker = GetEnv()->GetCollisionChecker();
+            pchecker->SetCollisionOptions(CO_Distance);
             Transform t;
 
             {
@@ -237,9 +236,10 @@ public:
                 _pdata->__trans = t;
                 _pdata->__stamp = GetEnv()->GetSimulationTime();
 
-                r.pos = t.trans;
                 _pdata->positions.at(0) = t.trans;
 
+                // cast all the rays of the image in one batch, ray index is w*height+h
+                _vrays.resize(_pgeom->width*_pgeom->height);
                 for(int w = 0; w < _pgeom->width; ++w) {
                     for(int h = 0; h < _pgeom->height; ++h) {
                         Vector vdir;
@@ -247,31 +247,30 @@ public:
                         vdir.y = (float)h*_iKK[1] + _iKK[3];
                         vdir.z = 1.0f;
                         vdir = t.rotate(vdir.normalize3());
+                        RAY& r = _vrays[w*_pgeom->height+h];
+                        r.pos = t.trans;
                         r.dir = _pgeom->max_range*vdir;
-
-                        int index = w*_pgeom->height+h;
-
-                        if( GetEnv()->CheckCollision(r, _report)) {
-                            _pdata->ranges[index] = vdir*_report->minDistance;
-                            _pdata->intensity[index] = 1;
-                            // store the colliding bodies
-                            KinBody::LinkConstPtr plink = !!_report->plink1 ? _report->plink1 : _report->plink2;
-                            if( !!plink ) {
-                                _databodyids[index] = plink->GetParent()->GetEnvironmentBodyIndex();
-                            }
-                        }
-                        else {
-                            _databodyids[index] = 0;
-                            _pdata->ranges[index] = vdir*_pgeom->max_range;
-                            _pdata->intensity[index] = 0;
-                        }
                     }
                 }
-
-                _report->Reset();
+                pchecker->CheckCollisionRays(_vrays, KinBodyConstPtr(), _vrayresults);
+
+                for(size_t index = 0; index < _vrays.size(); ++index) {
+                    const RayCollisionResult& result = _vrayresults[index];
+                    if( result.bCollision ) {
+                        _pdata->ranges[index] = result.pos - t.trans;
+                        _pdata->intensity[index] = 1;
+                        // store the colliding bodies
+                        _databodyids[index] = !!result.plink ? result.plink->GetParent()->GetEnvironmentBodyIndex() : 0;
+                    }
+                    else {
+                        _databodyids[index] = 0;
+                        _pdata->ranges[index] = _vrays[index].dir;
+                        _pdata->intensity[index] = 0;
+                    }
+                }
             }
 
-            GetEnv()->GetCollisionChecker()->SetCollisionOptions(0);
+            pchecker->SetCollisionOptions(0);
 
             if( _bRenderData ) {
                 // If can render, check if some time passed before last update
@@ -446,6 +445,8 @@ protected:
     boost::shared_ptr<LaserSensorData> _pdata;
     vector<int> _databodyids;     ///< if non 0, for each point in _data, specifies the body that was hit
     CollisionReportPtr _report;
+    std::vector<RAY> _vrays; ///< cache
+    std::vector<RayCollisionResult> _vrayresults; ///< cache
     // more geom stuff
     RaveVector<float> _vColor;
     dReal _iKK[4];     // inverse of KK
@@ -222,9 +222,9 @@ public:
         if( _bPower &&( _fTimeToScan <= 0) ) {
             _fTimeToScan = _pgeom->time_scan;
             Vector rotaxis(0,0,1);
-            RAY r;
 
-            GetEnv()->GetCollisionChecker()->SetCollisionOptions(CO_Distance);
+            CollisionCheckerBasePtr pchecker = GetEnv()->GetCollisionChecker();
+            pchecker->SetCollisionOptions(CO_Distance);
             Transform t;
 
             {
@@ -234,23 +234,28 @@ public:
                 _pdata->__stamp = GetEnv()->GetSimulationTime();
                 t = GetLaserPlaneTransform();
                 _pdata->positions.at(0) = t.trans;
-                size_t index = 0;
-                for(dReal frotangle = _pgeom->min_angle[0]; frotangle <= _pgeom->max_angle[0]; frotangle += _pgeom->resolution[0], ++index) {
-                    if( index >= _pdata->ranges.size() ) {
+
+                // cast all the rays of the scan in one batch
+                _vrays.resize(0);
+                _vraydirs.resize(0);
+                for(dReal frotangle = _pgeom->min_angle[0]; frotangle <= _pgeom->max_angle[0]; frotangle += _pgeom->resolution[0]) {
+                    if( _vrays.size() >= _pdata->ranges.size() ) {
                         break;
                     }
                     Vector vdir(t.rotate(quatRotate(quatFromAxisAngle(rotaxis, (dReal)frotangle),Vector(1,0,0))));
-                    r.pos = t.trans+_pgeom->min_range*vdir;
-                    r.dir = (_pgeom->max_range-_pgeom->min_range)*vdir;
+                    _vrays.push_back(RAY(t.trans+_pgeom->min_range*vdir, (_pgeom->max_range-_pgeom->min_range)*vdir));
+                    _vraydirs.push_back(vdir);
+                }
+                pchecker->CheckCollisionRays(_vrays, KinBodyConstPtr(), _vrayresults);
 
-                    if( GetEnv()->CheckCollision(r, _report)) {
-                        _pdata->ranges[index] = vdir*(_report->minDistance+_pgeom->min_range);
+                for(size_t index = 0; index < _vrays.size(); ++index) {
+                    const RayCollisionResult& result = _vrayresults[index];
+                    const Vector& vdir = _vraydirs[index];
+                    if( result.bCollision ) {
+                        _pdata->ranges[index] = vdir*(result.fDistance+_pgeom->min_range);
                         _pdata->intensity[index] = 1;
                         // store the colliding bodies
-                        KinBody::LinkConstPtr plink = !!_report->plink1 ? _report->plink1 : _report->plink2;
-                        if( !!plink ) {
-                            _databodyids[index] = plink->GetParent()->GetEnvironmentBodyIndex();
-                        }
+                        _databodyids[index] = !!result.plink ? result.plink->GetParent()->GetEnvironmentBodyIndex() : 0;
                     }
                     else {
                         _databodyids[index] = 0;
@@ -260,7 +265,7 @@ public:
                 }
             }
 
-            GetEnv()->GetCollisionChecker()->SetCollisionOptions(0);
+            pchecker->SetCollisionOptions(0);
 
             if( _bRenderData ) {
                 // If can render, check if some time passed before last update
@@ -456,6 +461,9 @@ protected:
     boost::shared_ptr<LaserSensorData> _pdata;
     vector<int> _databodyids;     ///< if non 0, for each point in _data, specifies the body that was hit
     CollisionReportPtr _report;
+    std::vector<RAY> _vrays; ///< cache
+    std::vector<Vector> _vraydirs; ///< cache, unit direction of every ray in _vrays
+    std::vector<RayCollisionResult> _vrayresults; ///< cache
 
     // more geom stuff
     RaveVector<float> _vColor;
@@ -0,0 +1,290 @@
+// -*- coding: utf-8 -*-
+#include "softwarerasterizer.h"
+
+#include <openrave/utils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+static const int s_nTileSize = 32;
+static const dReal s_fNearPlane = 0.01; ///< triangles closer to the camera are clipped
+static const int s_nMeshBoundsSweepPeriod = 64; ///< number of frames between two sweeps of the mesh bounds cache
+static const float s_fAmbient = 0.25f; ///< the rest of the light comes from a light at the camera
+
+} // end namespace
+
+SoftwareRasterizer::SoftwareRasterizer() : _nNumFrames(0), _fx(0), _fy(0), _cx(0), _cy(0), _width(0), _height(0), _numtilesx(0), _numtilesy(0)
+{
+}
+
+void SoftwareRasterizer::Render(EnvironmentBasePtr penv, const Transform& tcamera, const SensorBase::CameraIntrinsics& KK, int width, int height, std::vector<uint8_t>& vimagedata, std::vector<float>& vdepthdata)
+{
+    vimagedata.resize(3*width*height);
+    vdepthdata.resize(width*height);
+    std::fill(vimagedata.begin(), vimagedata.end(), 0);
+    std::fill(vdepthdata.begin(), vdepthdata.end(), 0.0f);
+    if( width <= 0 || height <= 0 || KK.fx <= 0 || KK.fy <= 0 ) {
+        return;
+    }
+
+    _tcamerainv = tcamera.inverse();
+    _fx = KK.fx;
+    _fy = KK.fy;
+    _cx = KK.cx;
+    _cy = KK.cy;
+    _width = width;
+    _height = height;
+    _numtilesx = (width + s_nTileSize - 1)/s_nTileSize;
+    _numtilesy = (height + s_nTileSize - 1)/s_nTileSize;
+    _vtriangles.resize(0);
+    _vtiletriangles.resize(_numtilesx*_numtilesy);
+    FOREACH(it, _vtiletriangles) {
+        it->resize(0);
+    }
+
+    penv->GetBodies(_vbodies);
+    FOREACHC(itbody, _vbodies) {
+        if( !(*itbody)->IsEnabled() || !(*itbody)->IsVisible() ) {
+            continue;
+        }
+        FOREACHC(itlink, (*itbody)->GetLinks()) {
+            if( !(*itlink)->IsVisible() ) {
+                continue;
+            }
+            FOREACHC(itgeom, (*itlink)->GetGeometries()) {
+                const KinBody::Link::Geometry& geom = **itgeom;
+                if( !geom.IsVisible() || geom.GetTransparency() >= 1 ) {
+                    continue;
+                }
+                boost::shared_ptr<const TriMesh> pmesh = geom.GetInfo()._meshcollision.GetSharedMesh();
+                if( !pmesh || pmesh->indices.size() == 0 ) {
+                    continue;
+                }
+                const MeshBounds& bounds = _GetMeshBounds(pmesh);
+                const Transform tmesh = (*itlink)->GetTransform() * geom.GetTransform();
+                if( !_IsInFrustum(tmesh, bounds.vmin, bounds.vmax) ) {
+                    continue;
+                }
+                _AddMesh(*pmesh, tmesh, geom.GetDiffuseColor());
+            }
+        }
+    }
+    _vbodies.resize(0);
+
+    // every tile writes a disjoint set of pixels, so the tiles can be rasterized in any order
+    utils::ParallelForChunks(_numtilesx*_numtilesy, 1, [&](size_t nbegin, size_t nend) {
+        for(size_t itile = nbegin; itile < nend; ++itile) {
+            _RasterizeTile(itile, vimagedata, vdepthdata);
+        }
+    });
+
+    if( ++_nNumFrames >= s_nMeshBoundsSweepPeriod ) {
+        _nNumFrames = 0;
+        std::map<const TriMesh*, MeshBounds>::iterator it = _mapMeshBounds.begin();
+        while( it != _mapMeshBounds.end() ) {
+            if( it->second.pmesh.use_count() <= 1 ) {
+                _mapMeshBounds.erase(it++);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+}
+
+const SoftwareRasterizer::MeshBounds& SoftwareRasterizer::_GetMeshBounds(const boost::shared_ptr<const TriMesh>& pmesh)
+{
+    std::map<const TriMesh*, MeshBounds>::iterator it = _mapMeshBounds.find(pmesh.get());
+    if( it != _mapMeshBounds.end() ) {
+        return it->second;
+    }
+    MeshBounds& bounds = _mapMeshBounds[pmesh.get()];
+    bounds.pmesh = pmesh;
+    if( pmesh->vertices.size() > 0 ) {
+        bounds.vmin = bounds.vmax = pmesh->vertices[0];
+        FOREACHC(itv, pmesh->vertices) {
+            for(int j = 0; j < 3; ++j) {
+                bounds.vmin[j] = std::min(bounds.vmin[j], (*itv)[j]);
+                bounds.vmax[j] = std::max(bounds.vmax[j], (*itv)[j]);
+            }
+        }
+    }
+    return bounds;
+}
+
+bool SoftwareRasterizer::_IsInFrustum(const Transform& tbox, const Vector& vmin, const Vector& vmax) const
+{
+    // the box is culled if all its corners are outside of the same frustum plane
+    const Transform tboxincamera = _tcamerainv * tbox;
+    const dReal fxmin = -_cx/_fx, fxmax = (_width - _cx)/_fx, fymin = -_cy/_fy, fymax = (_height - _cy)/_fy;
+    int outsidemasks = 0x1f;
+    for(int i = 0; i < 8; ++i) {
+        const Vector v = tboxincamera*Vector(i&1 ? vmax.x : vmin.x, i&2 ? vmax.y : vmin.y, i&4 ? vmax.z : vmin.z);
+        int mask = 0;
+        if( v.z < s_fNearPlane ) {
+            mask |= 1;
+        }
+        if( v.x < fxmin*v.z ) {
+            mask |= 2;
+        }
+        if( v.x > fxmax*v.z ) {
+            mask |= 4;
+        }
+        if( v.y < fymin*v.z ) {
+            mask |= 8;
+        }
+        if( v.y > fymax*v.z ) {
+            mask |= 16;
+        }
+        outsidemasks &= mask;
+        if( outsidemasks == 0 ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SoftwareRasterizer::_AddMesh(const TriMesh& mesh, const Transform& tmesh, const RaveVector<float>& vcolor)
+{
+    const Transform tmeshincamera = _tcamerainv * tmesh;
+    for(size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        const Vector v0 = tmeshincamera*mesh.vertices.at(mesh.indices[i]);
+        const Vector v1 = tmeshincamera*mesh.vertices.at(mesh.indices[i+1]);
+        const Vector v2 = tmeshincamera*mesh.vertices.at(mesh.indices[i+2]);
+        if( v0.z < s_fNearPlane && v1.z < s_fNearPlane && v2.z < s_fNearPlane ) {
+            continue;
+        }
+
+        // flat shading with a light at the camera, meshes are not always consistently oriented so use both sides
+        Vector vnormal = (v1 - v0).cross(v2 - v0);
+        const Vector vview = v0 + v1 + v2;
+        const dReal fnormlength = RaveSqrt(vnormal.lengthsqr3()*vview.lengthsqr3());
+        if( fnormlength <= 0 ) {
+            continue;
+        }
+        const float fintensity = s_fAmbient + (1 - s_fAmbient)*(float)(RaveFabs(vnormal.dot3(vview))/fnormlength);
+        uint8_t color[3];
+        for(int j = 0; j < 3; ++j) {
+            color[j] = (uint8_t)(std::min(1.0f, std::max(0.0f, vcolor[j]*fintensity))*255 + 0.5f);
+        }
+        _AddTriangle(v0, v1, v2, color);
+    }
+}
+
+void SoftwareRasterizer::_AddTriangle(const Vector& v0, const Vector& v1, const Vector& v2, const uint8_t color[3])
+{
+    const Vector* pv[3] = { &v0, &v1, &v2 };
+    Vector vinside[3], voutside[3];
+    int numinside = 0, numoutside = 0;
+    for(int i = 0; i < 3; ++i) {
+        if( pv[i]->z >= s_fNearPlane ) {
+            vinside[numinside++] = *pv[i];
+        }
+        else {
+            voutside[numoutside++] = *pv[i];
+        }
+    }
+    if( numoutside == 0 ) {
+        _AddScreenTriangle(v0, v1, v2, color);
+        return;
+    }
+
+    // orientation does not matter for rasterization, so the clipped polygon does not need to keep the vertex order
+    if( numinside == 1 ) {
+        const Vector& va = vinside[0];
+        const Vector vb = va + (voutside[0] - va)*((va.z - s_fNearPlane)/(va.z - voutside[0].z));
+        const Vector vc = va + (voutside[1] - va)*((va.z - s_fNearPlane)/(va.z - voutside[1].z));
+        _AddScreenTriangle(va, vb, vc, color);
+    }
+    else if( numinside == 2 ) {
+        const Vector& vout = voutside[0];
+        const Vector vb = vinside[0] + (vout - vinside[0])*((vinside[0].z - s_fNearPlane)/(vinside[0].z - vout.z));
+        const Vector vc = vinside[1] + (vout - vinside[1])*((vinside[1].z - s_fNearPlane)/(vinside[1].z - vout.z));
+        _AddScreenTriangle(vinside[0], vinside[1], vc, color);
+        _AddScreenTriangle(vinside[0], vc, vb, color);
+    }
+}
+
+void SoftwareRasterizer::_AddScreenTriangle(const Vector& v0, const Vector& v1, const Vector& v2, const uint8_t color[3])
+{
+    ScreenTriangle tri;
+    const Vector* pv[3] = { &v0, &v1, &v2 };
+    float fxmin = std::numeric_limits<float>::max(), fxmax = -fxmin, fymin = fxmin, fymax = -fxmin;
+    for(int i = 0; i < 3; ++i) {
+        const dReal finvz = 1/pv[i]->z;
+        tri.x[i] = (float)(_fx*pv[i]->x*finvz + _cx);
+        tri.y[i] = (float)(_fy*pv[i]->y*finvz + _cy);
+        tri.invz[i] = (float)finvz;
+        fxmin = std::min(fxmin, tri.x[i]);
+        fxmax = std::max(fxmax, tri.x[i]);
+        fymin = std::min(fymin, tri.y[i]);
+        fymax = std::max(fymax, tri.y[i]);
+        tri.color[i] = color[i];
+    }
+    if( fxmax < 0 || fymax < 0 || fxmin >= _width || fymin >= _height ) {
+        return;
+    }
+
+    const int itriangle = (int)_vtriangles.size();
+    _vtriangles.push_back(tri);
+    const int ntilex0 = std::max(0, (int)fxmin/s_nTileSize), ntilex1 = std::min(_numtilesx - 1, (int)fxmax/s_nTileSize);
+    const int ntiley0 = std::max(0, (int)fymin/s_nTileSize), ntiley1 = std::min(_numtilesy - 1, (int)fymax/s_nTileSize);
+    for(int ntiley = ntiley0; ntiley <= ntiley1; ++ntiley) {
+        for(int ntilex = ntilex0; ntilex <= ntilex1; ++ntilex) {
+            _vtiletriangles[ntiley*_numtilesx + ntilex].push_back(itriangle);
+        }
+    }
+}
+
+void SoftwareRasterizer::_RasterizeTile(int itile, std::vector<uint8_t>& vimagedata, std::vector<float>& vdepthdata) const
+{
+    const std::vector<int>& vtriangleindices = _vtiletriangles[itile];
+    if( vtriangleindices.size() == 0 ) {
+        return;
+    }
+    const int ntilex0 = (itile % _numtilesx)*s_nTileSize, ntiley0 = (itile / _numtilesx)*s_nTileSize;
+    const int ntilex1 = std::min(ntilex0 + s_nTileSize, _width), ntiley1 = std::min(ntiley0 + s_nTileSize, _height);
+
+    // rasterize with the inverse depth so that larger is closer, 0 is the background
+    float vinvdepth[s_nTileSize*s_nTileSize];
+    std::fill(vinvdepth, vinvdepth + s_nTileSize*s_nTileSize, 0.0f);
+    FOREACHC(itindex, vtriangleindices) {
+        const ScreenTriangle& tri = _vtriangles[*itindex];
+        const float farea = (tri.x[1] - tri.x[0])*(tri.y[2] - tri.y[0]) - (tri.x[2] - tri.x[0])*(tri.y[1] - tri.y[0]);
+        if( std::fabs(farea) <= std::numeric_limits<float>::epsilon() ) {
+            continue;
+        }
+        const float finvarea = 1/farea;
+        const int nx0 = std::max(ntilex0, (int)std::floor(std::min(tri.x[0], std::min(tri.x[1], tri.x[2]))));
+        const int nx1 = std::min(ntilex1 - 1, (int)std::ceil(std::max(tri.x[0], std::max(tri.x[1], tri.x[2]))));
+        const int ny0 = std::max(ntiley0, (int)std::floor(std::min(tri.y[0], std::min(tri.y[1], tri.y[2]))));
+        const int ny1 = std::min(ntiley1 - 1, (int)std::ceil(std::max(tri.y[0], std::max(tri.y[1], tri.y[2]))));
+        for(int ny = ny0; ny <= ny1; ++ny) {
+            const float fy = ny + 0.5f;
+            for(int nx = nx0; nx <= nx1; ++nx) {
+                const float fx = nx + 0.5f;
+                // barycentric coordinates, the signs of the edge functions follow the orientation of the triangle
+                const float w0 = ((tri.x[1] - fx)*(tri.y[2] - fy) - (tri.x[2] - fx)*(tri.y[1] - fy))*finvarea;
+                const float w1 = ((tri.x[2] - fx)*(tri.y[0] - fy) - (tri.x[0] - fx)*(tri.y[2] - fy))*finvarea;
+                const float w2 = 1 - w0 - w1;
+                if( w0 < 0 || w1 < 0 || w2 < 0 ) {
+                    continue;
+                }
+                const float finvz = w0*tri.invz[0] + w1*tri.invz[1] + w2*tri.invz[2];
+                float& fbufferinvz = vinvdepth[(ny - ntiley0)*s_nTileSize + (nx - ntilex0)];
+                if( finvz <= fbufferinvz ) {
+                    continue;
+                }
+                fbufferinvz = finvz;
+                const int npixel = ny*_width + nx;
+                vdepthdata[npixel] = 1/finvz;
+                vimagedata[3*npixel+0] = tri.color[0];
+                vimagedata[3*npixel+1] = tri.color[1];
+                vimagedata[3*npixel+2] = tri.color[2];
+            }
+        }
+    }
+}
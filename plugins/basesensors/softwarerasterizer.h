@@ -0,0 +1,70 @@
+// -*- coding: utf-8 -*-
+#ifndef OPENRAVE_SOFTWARE_RASTERIZER_H
+#define OPENRAVE_SOFTWARE_RASTERIZER_H
+
+#include "plugindefs.h"
+
+/** \brief renders the link geometries of an environment into color and depth images on the cpu
+
+    Used by the camera sensors when the environment has no viewer. The collision meshes of the visible geometries are
+    projected with the pinhole model of the camera, distortion is ignored. The image is split into tiles that are
+    rasterized in parallel by the process-wide threads of utils::ParallelForChunks, every tile keeps its own list of the triangles overlapping it. Geometries outside of the view
+    frustum are culled with the bounds of their mesh, which are cached as long as the mesh is referenced by a geometry.
+ */
+class SoftwareRasterizer
+{
+public:
+    SoftwareRasterizer();
+
+    /// \brief renders the enabled bodies of the environment seen from tcamera
+    ///
+    /// The camera looks along its +z axis, +x is to the right of the image and +y is down.
+    /// \param vimagedata filled with width*height rgb pixels, row major
+    /// \param vdepthdata filled with width*height depths along the camera z axis, 0 where nothing is seen
+    void Render(EnvironmentBasePtr penv, const Transform& tcamera, const SensorBase::CameraIntrinsics& KK, int width, int height, std::vector<uint8_t>& vimagedata, std::vector<float>& vdepthdata);
+
+private:
+    /// \brief triangle projected on the image
+    struct ScreenTriangle
+    {
+        float x[3], y[3]; ///< pixel coordinates
+        float invz[3]; ///< inverse of the camera depth, which is linear in pixel coordinates
+        uint8_t color[3];
+    };
+
+    /// \brief cached bounds of a collision mesh
+    struct MeshBounds
+    {
+        boost::shared_ptr<const TriMesh> pmesh; ///< held so that the pointer stays unique while the bounds are cached
+        Vector vmin, vmax;
+    };
+
+    const MeshBounds& _GetMeshBounds(const boost::shared_ptr<const TriMesh>& pmesh);
+
+    /// \brief projects the triangles of the mesh transformed by tmesh into the camera frame and adds them to the tiles
+    void _AddMesh(const TriMesh& mesh, const Transform& tmesh, const RaveVector<float>& vcolor);
+
+    /// \brief clips a camera frame triangle at the near plane and adds the result
+    void _AddTriangle(const Vector& v0, const Vector& v1, const Vector& v2, const uint8_t color[3]);
+
+    void _AddScreenTriangle(const Vector& v0, const Vector& v1, const Vector& v2, const uint8_t color[3]);
+
+    /// \brief returns true if the box [vmin,vmax] transformed by tbox can be seen
+    bool _IsInFrustum(const Transform& tbox, const Vector& vmin, const Vector& vmax) const;
+
+    void _RasterizeTile(int itile, std::vector<uint8_t>& vimagedata, std::vector<float>& vdepthdata) const;
+
+    std::map<const TriMesh*, MeshBounds> _mapMeshBounds;
+    int _nNumFrames; ///< number of frames since the last sweep of _mapMeshBounds
+
+    // state of the current frame
+    Transform _tcamerainv;
+    dReal _fx, _fy, _cx, _cy;
+    int _width, _height;
+    int _numtilesx, _numtilesy;
+    std::vector<ScreenTriangle> _vtriangles;
+    std::vector< std::vector<int> > _vtiletriangles; ///< for every tile, the indices of the triangles overlapping it
+    std::vector<KinBodyPtr> _vbodies; ///< cache
+};
+
+#endif
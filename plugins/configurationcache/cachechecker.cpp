@@ -52,6 +52,8 @@ public:
                         "load self collision cache");
         RegisterCommand("GetCacheTimes",boost::bind(&CacheCollisionChecker::_GetCacheTimesCommand,this,_1,_2),
                         "get the cache times: insert, query, collision checking, load");
+        RegisterCommand("SetMaxCacheNodes",boost::bind(&CacheCollisionChecker::_SetMaxCacheNodesCommand,this,_1,_2),
+                        "bound the number of nodes of the environment and self collision caches, least recently used nodes are evicted. 0 means unbounded. [maxnodes] [selfmaxnodes]");
         std::string collisionname="ode";
         sinput >> collisionname;
         _pintchecker = RaveCreateCollisionChecker(GetEnv(), collisionname);
@@ -63,6 +65,8 @@ public:
         _selfcachedcollisionchecks=0;
         _selfcachedcollisionhits=0;
         _selfcachedfreehits = 0;
+        _maxcachenodes = 0;
+        _maxselfcachenodes = 0;
 
         __cachehash.resize(0);
 
@@ -166,6 +170,8 @@ public:
         }
 
         _strRobotName = clone->_strRobotName;
+        _maxcachenodes = clone->_maxcachenodes;
+        _maxselfcachenodes = clone->_maxselfcachenodes;
         _probot.reset(); // have to rest to force creating a new cache
         _probot = GetRobot();
 
@@ -344,12 +350,9 @@ public:
             }
         }
 
-        // save cache every other iteration if its size has increased by 1.5
+        // synchronize the cache with the other processes using the same robot every 4000 checks
         if (_selfcachedcollisionchecks % 4000 == 0) {
-            if (_size*1.5 < _selfcache->GetNumKnownNodes()) {
-                _selfcache->SaveCache(GetCacheHash());
-                _size = _selfcache->GetNumKnownNodes();
-            }
+            _SynchronizeSelfCache(false);
         }
         if( ret == 1 ) {
             ++_selfcachedcollisionhits;
@@ -510,6 +513,23 @@ protected:
         return true;
     }
 
+    virtual bool _SetMaxCacheNodesCommand(std::ostream& sout, std::istream& sinput)
+    {
+        sinput >> _maxcachenodes >> _maxselfcachenodes;
+        if( !sinput ) {
+            return false;
+        }
+        // applied when the caches are created otherwise
+        if( !!_cache ) {
+            _cache->SetMaxNodes(_maxcachenodes);
+        }
+        if( !!_selfcache ) {
+            _selfcache->SetMaxNodes(_maxselfcachenodes);
+        }
+        sout << _maxcachenodes << " " << _maxselfcachenodes;
+        return true;
+    }
+
     virtual bool _ValidateCacheCommand(std::ostream& sout, std::istream& sinput)
     {
         sout << _cache->Validate();
@@ -578,7 +598,7 @@ protected:
 
     virtual bool _SaveCacheCommand(std::ostream& sout, std::istream& sinput)
     {
-        _selfcache->SaveCache(GetCacheHash());
+        _SynchronizeSelfCache(true);
         return true;
     }
 
@@ -606,10 +626,19 @@ protected:
     {
         _robothash = GetRobot()->GetRobotStructureHash();
 
-        _vGrabbedBodies.resize(0);
-        GetRobot()->GetGrabbed(_vGrabbedBodies);
-        FOREACH(newbody, _vGrabbedBodies){
-            _robothash += (*newbody)->GetKinematicsGeometryHash();
+        // self collisions also depend on where the bodies are grabbed. sort so that the order of grabbing does not matter
+        _vGrabbedInfos.resize(0);
+        GetRobot()->GetGrabbedInfo(_vGrabbedInfos);
+        std::vector<std::string> vgrabbedhashes;
+        FOREACHC(itinfo, _vGrabbedInfos) {
+            KinBodyPtr pgrabbed = GetEnv()->GetKinBody((*itinfo)->_grabbedname);
+            std::stringstream ss;
+            ss << std::fixed << std::setprecision(4) << (!pgrabbed ? std::string() : pgrabbed->GetKinematicsGeometryHash()) << " " << (*itinfo)->_robotlinkname << " " << (*itinfo)->_trelative;
+            vgrabbedhashes.push_back(ss.str());
+        }
+        std::sort(vgrabbedhashes.begin(), vgrabbedhashes.end());
+        FOREACHC(ithash, vgrabbedhashes) {
+            _robothash += *ithash;
         }
 
 
@@ -641,6 +670,9 @@ protected:
         _selfcache->SetFreeSpaceThresh(0.3);
         _selfcache->SetInsertionDistanceMult(0.5);
         _selfcache->SetBase(1.8);
+
+        _cache->SetMaxNodes(_maxcachenodes);
+        _selfcache->SetMaxNodes(_maxselfcachenodes);
     }
 
     void _InitializeCache()
@@ -659,6 +691,38 @@ protected:
         _selfcachedfreehits=0;
     }
 
+    /// \brief shares the self collision cache with the other processes tracking the same robot
+    ///
+    /// The cache file is only replaced by renaming a complete file, so processes can load it at any time without locking.
+    /// Before publishing, the results published by the other processes are merged so they are not lost. Two processes
+    /// publishing at the same time can still overwrite each other, the process that was overwritten finds its results missing
+    /// from the new file when it merges it and publishes them again, see CacheTree::HasUnsavedNodes. A bounded cache that
+    /// evicted results of the file publishes them back together with its own, see CacheTree::PublishCache.
+    /// \param bforcesave if true, always publish. Otherwise only publish when the cache grew by 1.5 or the file changed and lacks results of the cache
+    void _SynchronizeSelfCache(bool bforcesave)
+    {
+        std::string cachehash = GetCacheHash();
+        int numknown = _selfcache->GetNumKnownNodes();
+        bool bpublish = bforcesave || _size*1.5 < numknown;
+        if( _selfcache->IsCacheFileModified(cachehash) ) {
+            _stime = utils::GetMilliTime();
+            int nmerged = _selfcache->MergeCache(cachehash, GetEnv());
+            _loadtime += utils::GetMilliTime()-_stime;
+            RAVELOG_VERBOSE_FORMAT("merged %d self collision configurations published by other processes", nmerged);
+            // results inserted since the last synchronization, or published before and overwritten by another process
+            bpublish = bpublish || _selfcache->HasUnsavedNodes();
+            if( !bpublish ) {
+                _size = _selfcache->GetNumKnownNodes();
+            }
+        }
+        if( bpublish ) {
+            _stime = utils::GetMilliTime();
+            _selfcache->PublishCache(cachehash, GetEnv());
+            _savetime += utils::GetMilliTime()-_stime;
+            _size = _selfcache->GetNumKnownNodes();
+        }
+    }
+
     void _UpdateRobotDOF()
     {
         // if DOF changed, reset environment cache
@@ -666,6 +730,7 @@ protected:
         {
             RAVELOG_VERBOSE_FORMAT("Updating robot dofs, %d/%d",_numdofs%_probot->GetActiveDOF());
             _cache.reset(new ConfigurationCache(_probot));
+            _cache->SetMaxNodes(_maxcachenodes);
 
             _numdofs = _probot->GetActiveDOF();
             _dofindices = _probot->GetActiveDOFIndices();
@@ -674,7 +739,7 @@ protected:
     }
 
     std::vector<dReal> _dofvals;
-    std::vector<KinBodyPtr> _vGrabbedBodies;
+    std::vector<KinBody::GrabbedInfoPtr> _vGrabbedInfos;
     std::vector<int> _dofindices;
     ConfigurationCachePtr _cache;
     ConfigurationCachePtr _selfcache;
@@ -686,6 +751,7 @@ protected:
     int _numdofs;
     int _cachedcollisionchecks, _cachedcollisionhits, _cachedfreehits, _size;
     int _selfcachedcollisionchecks, _selfcachedcollisionhits, _selfcachedfreehits;
+    int _maxcachenodes, _maxselfcachenodes; ///< max nodes of _cache and _selfcache, 0 if unbounded
     uint64_t _stime, _ftime, _intime, _querytime, _loadtime, _savetime, _rawtime, _resettime, _selfintime, _selfquerytime, _selfrawtime;
     stringstream _ss;
     ostringstream _oss;
@@ -14,7 +14,19 @@
 /// \author Alejandro Perez & Rosen Diankov
 #include "configurationcachetree.h"
 #include <sstream>
+#include <cstdio>
+#include <cstring>
 #include <boost/lexical_cast.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
 
 #include <boost/multi_array.hpp>
 #include <algorithm>
@@ -42,6 +54,7 @@ CacheTreeNode::CacheTreeNode(const std::vector<dReal>& cs, Vector* plinkspheres)
     _hasselfchild = 0;
     _usenn = 1;
     _hitcount = 0;
+    _lastusestamp = 0;
 }
 
 CacheTreeNode::CacheTreeNode(const dReal* pstate, int dof, Vector* plinkspheres)
@@ -54,6 +67,7 @@ CacheTreeNode::CacheTreeNode(const dReal* pstate, int dof, Vector* plinkspheres)
     _hasselfchild = 0;
     _usenn = 1;
     _hitcount = 0;
+    _lastusestamp = 0;
 }
 
 void CacheTreeNode::SetCollisionInfo(CollisionReportPtr report)
@@ -114,6 +128,14 @@ CacheTree::CacheTree(int statedof)
     _collidingbodyname.resize(0);
 
     _statedof=statedof;
+    _maxnodes = 0;
+    _numknownnodesbound = 0;
+    _nUseStamp = 0;
+    _cachefiletime = -1;
+    _cachefilesize = 0;
+    _cachefileinode = 0;
+    _bEvictedSinceCacheFileStamp = false;
+    _bHasUnsavedNodes = false;
     _weights.resize(_statedof, 1.0);
     Init(_weights, 1);
 }
@@ -170,6 +192,7 @@ void CacheTree::Reset()
     _poolNodes.reset(new boost::pool<>(sizeof(CacheTreeNode)+sizeof(dReal)*_statedof));
     //_pNodesPool.reset(new boost::pool<>(sizeof(Node)+_dof*sizeof(dReal)));
     _numnodes = 0;
+    _numknownnodesbound = 0;
 }
 
 #ifdef _DEBUG
@@ -208,6 +231,7 @@ CacheTreeNodePtr CacheTree::_CloneCacheTreeNode(CacheTreeNodeConstPtr refnode)
 #endif
     clonenode->_conftype = refnode->_conftype;
     clonenode->_hitcount = refnode->_hitcount;
+    clonenode->_lastusestamp = refnode->_lastusestamp;
     if( clonenode->IsInCollision() ) {
         clonenode->_collidinglink = refnode->_collidinglink;
         clonenode->_collidinglinktrans = refnode->_collidinglinktrans;
@@ -308,7 +332,7 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
                         bestdist2 = curdist2;
                         pbestnode = *itchild;
                         if( distancebound > 0 && bestdist2 <= distancebound2 ) {
-                            (*itchild)->IncreaseHitCount();
+                            _MarkNodeUsed(*itchild);
                             return make_pair(pbestnode, RaveSqrt(bestdist2));
                         }
                     }
@@ -364,7 +388,7 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
         if( proot->_usenn ) {
             ConfigurationNodeType cntype = proot->GetType();
             if( cntype == CNT_Collision && curdist2 <= collisionthresh2 ) {
-                proot->_hitcount++;
+                _MarkNodeUsed(proot);
                 return make_pair(proot,RaveSqrt(curdist2));
             }
             else if( cntype == CNT_Free && curdist2 <= freespacethresh2 ) {
@@ -391,7 +415,7 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
                 if( (*itchild)->_usenn ) {
                     ConfigurationNodeType cntype = (*itchild)->GetType();
                     if( cntype == CNT_Collision && curdist2 <= collisionthresh2 ) {
-                        (*itchild)->_hitcount++;
+                        _MarkNodeUsed(*itchild);
                         return make_pair(*itchild, RaveSqrt(curdist2));
                     }
                     else if( cntype == CNT_Free && curdist2 <= freespacethresh2 ) {
@@ -426,25 +450,178 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
 
 int CacheTree::InsertNode(const std::vector<dReal>& cs, CollisionReportPtr report, dReal fMinSeparationDist)
 {
-
     OPENRAVE_ASSERT_OP(cs.size(),==,_weights.size());
     CacheTreeNodePtr nodein = _CreateCacheTreeNode(cs, report);
+    nodein->_lastusestamp = ++_nUseStamp;
+    int nParentFound = _InsertNode(nodein, fMinSeparationDist);
+    if( nParentFound == 1 ) {
+        _bHasUnsavedNodes = true;
+        _CheckMaxNodes();
+    }
+    return nParentFound;
+}
+
+int CacheTree::InsertNodes(const std::vector<dReal>& vstates, CollisionReportPtr report, dReal fMinSeparationDist)
+{
+    OPENRAVE_ASSERT_OP(vstates.size()%_statedof,==,0);
+    int numinserted = 0;
+    for(size_t istate = 0; istate < vstates.size(); istate += _statedof) {
+        _curconf.assign(vstates.begin()+istate, vstates.begin()+istate+_statedof);
+        CacheTreeNodePtr nodein = _CreateCacheTreeNode(_curconf, report);
+        nodein->_lastusestamp = ++_nUseStamp;
+        if( _InsertNode(nodein, fMinSeparationDist) == 1 ) {
+            ++numinserted;
+        }
+    }
+    if( numinserted > 0 ) {
+        _bHasUnsavedNodes = true;
+        _CheckMaxNodes();
+    }
+    return numinserted;
+}
+
+void CacheTree::SetMaxNodes(int maxnodes)
+{
+    _maxnodes = maxnodes;
+    _CheckMaxNodes();
+}
+
+void CacheTree::_CheckMaxNodes()
+{
+    if( _maxnodes > 0 && _numknownnodesbound > _maxnodes ) {
+        // the bound also counts the copies and the nodes that became unknown since the last count
+        _numknownnodesbound = _GetNumDistinctKnownNodes();
+        if( _numknownnodesbound > _maxnodes ) {
+            int nremoved = EvictNodes(3*_maxnodes/4);
+            RAVELOG_DEBUG_FORMAT("evicted %d cache configurations, %d configurations left", nremoved%_numknownnodesbound);
+        }
+    }
+}
+
+int CacheTree::_GetNumDistinctKnownNodes() const
+{
+    int nknown = 0;
+    FOREACHC(itlevelnodes, _vsetLevelNodes) {
+        FOREACHC(itnode, *itlevelnodes) {
+            if( !(*itnode)->_hasselfchild && (*itnode)->_conftype != CNT_Unknown ) {
+                nknown += 1;
+            }
+        }
+    }
+    return nknown;
+}
+
+/// \brief collision information of a node kept by CacheTree::EvictNodes while the tree is rebuilt
+struct EvictionNodeInfo
+{
+    size_t stateoffset;
+    ConfigurationNodeType conftype;
+    KinBody::LinkConstPtr collidinglink;
+    Transform collidinglinktrans;
+    int robotlinkindex;
+    int hitcount;
+    uint64_t lastusestamp;
+};
+
+int CacheTree::EvictNodes(int numkeep)
+{
+    if( _numnodes <= numkeep ) {
+        // _numnodes also counts the copies and unknown nodes
+        return 0;
+    }
+
+    // nodes with a self child are copies of a node below them, so only the lowest copy is kept.
+    // hits can land on any copy, so move the usage of the copies down to the lowest one
+    dReal fEpsilon = g_fEpsilon*_maxdistance; // min distance
+    std::vector<CacheTreeNodePtr> vcandidates; vcandidates.reserve(_numnodes);
+    for(int currentlevel = _maxlevel; currentlevel >= _minlevel; --currentlevel) {
+        int enclevel = _EncodeLevel(currentlevel);
+        if( enclevel >= (int)_vsetLevelNodes.size() ) {
+            continue;
+        }
+        FOREACH(itnode, _vsetLevelNodes[enclevel]) {
+            CacheTreeNodePtr pnode = *itnode;
+            if( !pnode->_hasselfchild ) {
+                if( pnode->_conftype != CNT_Unknown ) {
+                    vcandidates.push_back(pnode);
+                }
+                continue;
+            }
+            FOREACH(itchild, pnode->_vchildren) {
+                if( _ComputeDistance2(pnode->GetConfigurationState(), (*itchild)->GetConfigurationState()) <= fEpsilon ) {
+                    (*itchild)->_hitcount = max((*itchild)->_hitcount, pnode->_hitcount);
+                    (*itchild)->_lastusestamp = max((*itchild)->_lastusestamp, pnode->_lastusestamp);
+                }
+            }
+        }
+    }
+
+    if( (int)vcandidates.size() <= numkeep ) {
+        _numknownnodesbound = vcandidates.size();
+        return 0;
+    }
+    const int numcandidates = vcandidates.size();
+    std::nth_element(vcandidates.begin(), vcandidates.begin()+numkeep, vcandidates.end(), [](CacheTreeNodeConstPtr pnode0, CacheTreeNodeConstPtr pnode1) {
+        if( pnode0->_lastusestamp != pnode1->_lastusestamp ) {
+            return pnode0->_lastusestamp > pnode1->_lastusestamp;
+        }
+        return pnode0->_hitcount > pnode1->_hitcount;
+    });
+    vcandidates.resize(numkeep);
+
+    std::vector<dReal> vstates(vcandidates.size()*_statedof);
+    std::vector<EvictionNodeInfo> vinfos(vcandidates.size());
+    for(size_t i = 0; i < vcandidates.size(); ++i) {
+        CacheTreeNodeConstPtr pnode = vcandidates[i];
+        EvictionNodeInfo& info = vinfos[i];
+        info.stateoffset = i*_statedof;
+        std::copy(pnode->GetConfigurationState(), pnode->GetConfigurationState()+_statedof, vstates.begin()+info.stateoffset);
+        info.conftype = pnode->_conftype;
+        info.collidinglink = pnode->_collidinglink;
+        info.collidinglinktrans = pnode->_collidinglinktrans;
+        info.robotlinkindex = pnode->_robotlinkindex;
+        info.hitcount = pnode->_hitcount;
+        info.lastusestamp = pnode->_lastusestamp;
+    }
+
+    Reset();
+    FOREACHC(itinfo, vinfos) {
+        _curconf.assign(vstates.begin()+itinfo->stateoffset, vstates.begin()+itinfo->stateoffset+_statedof);
+        CacheTreeNodePtr nodein = _CreateCacheTreeNode(_curconf, CollisionReportPtr());
+        nodein->_conftype = itinfo->conftype;
+        nodein->_collidinglink = itinfo->collidinglink;
+        nodein->_collidinglinktrans = itinfo->collidinglinktrans;
+        nodein->_robotlinkindex = itinfo->robotlinkindex;
+        nodein->_hitcount = itinfo->hitcount;
+        nodein->_lastusestamp = itinfo->lastusestamp;
+        _InsertNode(nodein, 0);
+    }
+    _bEvictedSinceCacheFileStamp = true;
+    return numcandidates - (int)vinfos.size();
+}
+
+int CacheTree::_InsertNode(CacheTreeNodePtr nodein, dReal fMinSeparationDist)
+{
     // if there is no root, make this the root, otherwise call the lowlevel  insert
     if( _numnodes == 0 ) {
         // no root
         _vsetLevelNodes.at(_EncodeLevel(_maxlevel)).insert(nodein); // add to the level
         _numnodes += 1;
+        _numknownnodesbound += 1;
         nodein->_level = _maxlevel;
         return 1;
     }
 
     _vCurrentLevelNodes.resize(1);
     _vCurrentLevelNodes[0].first = *_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin();
-    _vCurrentLevelNodes[0].second = _ComputeDistance2(_vCurrentLevelNodes[0].first->GetConfigurationState(), &cs[0]);
+    _vCurrentLevelNodes[0].second = _ComputeDistance2(_vCurrentLevelNodes[0].first->GetConfigurationState(), nodein->GetConfigurationState());
     int nParentFound = _Insert(nodein, _vCurrentLevelNodes, _maxlevel, Sqr(_fMaxLevelBound), Sqr(fMinSeparationDist));
     if( nParentFound != 1 ) {
         _DeleteCacheTreeNode(nodein);
     }
+    else {
+        _numknownnodesbound += 1;
+    }
     return nParentFound;
 }
 
@@ -786,76 +963,160 @@ int CacheTree::RemoveCollisionConfigurations()
     return nremoved;
 }
 
+static const uint32_t s_CacheFileMagic = 0x4343524f; // "ORCC"
+static const uint32_t s_CacheFileVersion = 2; ///< 2 adds the use stamps of the nodes
+static const int32_t s_CacheFileMaxLevel = 4096; ///< bound on the levels of a file, the distances of the levels would not fit in a dReal past it
+
+/// \brief header of a cache file, followed by the weights, the colliding body names and the node records
+struct CacheFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t realsize; ///< sizeof(dReal) of the writer
+    int32_t statedof;
+    int32_t numnodes;
+    int32_t maxlevel;
+    int32_t minlevel;
+    int32_t numbodynames;
+    dReal base;
+    dReal maxdistance;
+    dReal fMaxLevelBound;
+};
+
+/// \brief fixed size part of a node record, followed by the state and the indices of the children
+struct CacheFileNodeRecord
+{
+    int32_t level;
+    int32_t conftype;
+    int32_t robotlinkindex;
+    int32_t collidinglinkindex;
+    int32_t collidingbodyindex; ///< index into the colliding body names, -1 if not colliding
+    int32_t numchildren;
+    int32_t hitcount;
+    uint8_t hasselfchild;
+    uint8_t usenn;
+    uint8_t padding[2];
+    uint64_t lastusestamp; ///< CacheTreeNode::_lastusestamp, so that a loaded bounded tree evicts the nodes used least recently
+};
+
+template <typename T>
+inline void WriteCacheData(std::vector<uint8_t>& vdata, const T* pvalues, size_t num)
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(pvalues);
+    vdata.insert(vdata.end(), p, p+sizeof(T)*num);
+}
+
+/// \brief copies num values out of the mapped data, returns false if the data is too short
+template <typename T>
+inline bool ReadCacheData(const uint8_t*& pdata, const uint8_t* pdataend, T* pvalues, size_t num)
+{
+    size_t numbytes = sizeof(T)*num;
+    if( (size_t)(pdataend - pdata) < numbytes ) {
+        return false;
+    }
+    std::memcpy(pvalues, pdata, numbytes);
+    pdata += numbytes;
+    return true;
+}
+
 int CacheTree::SaveCache(std::string filename)
 {
     //std::lock_guard<std::mutex> lock(_mutexpool);
     _mapNodeIndices.clear();
     int index=0;
-    int knownnodes=0;
+    std::vector<std::string> vbodynames;
+    std::map<std::string, int> mapbodynameindices;
     FOREACH(itlevelnodes, _vsetLevelNodes) {
         FOREACH(itnode, *itlevelnodes) {
-            if( (*itnode)->_conftype != CNT_Unknown) {
-                knownnodes++;
-            }
             _mapNodeIndices[*itnode] = index++;
+            if( (*itnode)->_conftype == CNT_Collision && !!(*itnode)->_collidinglink ) {
+                // note, this assumes the colliding body name never changes across environments, which is a false assumption
+                const std::string& bodyname = (*itnode)->_collidinglink->GetParent()->GetName();
+                if( mapbodynameindices.insert(std::make_pair(bodyname, (int)vbodynames.size())).second ) {
+                    vbodynames.push_back(bodyname);
+                }
+            }
         }
     }
 
-    _numnodes = knownnodes;
-    _fulldirname = RaveFindDatabaseFile(std::string("selfcache.")+filename,false);
-
-    RAVELOG_DEBUG_FORMAT("Writing cache to %s, size=%d", _fulldirname%_numnodes);
-    
-    FILE* pfile;
-    pfile = fopen(_fulldirname.c_str(),"wb");
-
-    fwrite(&_statedof, sizeof(_statedof), 1, pfile);
-    fwrite(&_weights[0], sizeof(_weights[0])*_weights.size(), 1, pfile);
-    fwrite(&_base, sizeof(_base), 1, pfile);
-    fwrite(&_fBaseInv, sizeof(_fBaseInv), 1, pfile);
-    fwrite(&_fBaseInv2, sizeof(_fBaseInv2), 1, pfile);
-    fwrite(&_fBaseChildMult, sizeof(_fBaseChildMult), 1, pfile);
-    fwrite(&_maxdistance, sizeof(_maxdistance), 1, pfile);
-    fwrite(&_maxlevel, sizeof(_maxlevel), 1, pfile);
-    fwrite(&_minlevel, sizeof(_minlevel), 1, pfile);
-    fwrite(&_numnodes, sizeof(_numnodes), 1, pfile);
-    fwrite(&_fMaxLevelBound, sizeof(_fMaxLevelBound), 1, pfile);
-
+    CacheFileHeader header;
+    header.magic = s_CacheFileMagic;
+    header.version = s_CacheFileVersion;
+    header.realsize = sizeof(dReal);
+    header.statedof = _statedof;
+    header.numnodes = index;
+    header.maxlevel = _maxlevel;
+    header.minlevel = _minlevel;
+    header.numbodynames = vbodynames.size();
+    header.base = _base;
+    header.maxdistance = _maxdistance;
+    header.fMaxLevelBound = _fMaxLevelBound;
+
+    std::vector<uint8_t> vdata;
+    vdata.reserve(sizeof(header) + sizeof(dReal)*_statedof + index*(sizeof(CacheFileNodeRecord)+sizeof(dReal)*_statedof+2*sizeof(int32_t)));
+    WriteCacheData(vdata, &header, 1);
+    WriteCacheData(vdata, _weights.data(), _weights.size());
+    FOREACHC(itname, vbodynames) {
+        int32_t namelength = itname->size();
+        WriteCacheData(vdata, &namelength, 1);
+        WriteCacheData(vdata, itname->c_str(), itname->size());
+    }
+
+    // TODO save only configuration != CNT_Unknown without losing the validity of the tree
     FOREACH(itlevelnodes, _vsetLevelNodes) {
         FOREACH(itnode, *itlevelnodes) {
-            _newnode = *itnode;
-            // TODO save only configuration != CNT_Unknown without losing the validity of the tree
-            if (true) { //_newnode->_conftype != CNT_Unknown) {
-                fwrite(&_newnode->_level, sizeof(_newnode->_level), 1, pfile);
-                fwrite(_newnode->GetConfigurationState(), sizeof(dReal)*_statedof, 1, pfile);
-                fwrite(&_newnode->_conftype, sizeof(_newnode->_conftype), 1, pfile);
-
-                if (_newnode->_conftype == CNT_Collision ) {
-                    // note, this assumes the colliding body name never changes across environments, which is a false assumption
-                    _collidingbodyname = _newnode->GetCollidingLink()->GetParent()->GetName();
-                    int namelength = _collidingbodyname.size();
-                    fwrite(&namelength, sizeof(namelength), 1, pfile);
-                    fwrite(_collidingbodyname.c_str(), _collidingbodyname.size(), 1, pfile);
-                    int linkindex = _newnode->GetCollidingLink()->GetIndex();
-                    fwrite(&linkindex, sizeof(linkindex), 1, pfile);
-                    fwrite(&_newnode->_robotlinkindex, sizeof(_newnode->_robotlinkindex), 1, pfile);
-                }
-
-                fwrite(&_newnode->_hasselfchild, sizeof(_newnode->_hasselfchild), 1, pfile);
-                fwrite(&_newnode->_usenn, sizeof(_newnode->_usenn), 1, pfile);
-                int numchildren = _newnode->_vchildren.size();
-                fwrite(&numchildren, sizeof(numchildren), 1, pfile);
-
-                FOREACHC(itchild, (*itnode)->_vchildren) {
-                    int cindex = _mapNodeIndices[*itchild];
-                    fwrite(&cindex, sizeof(cindex), 1, pfile);
-                }
+            CacheTreeNodeConstPtr pnode = *itnode;
+            CacheFileNodeRecord record;
+            std::memset(&record, 0, sizeof(record));
+            record.level = pnode->_level;
+            record.conftype = pnode->_conftype;
+            record.robotlinkindex = -1;
+            record.collidinglinkindex = -1;
+            record.collidingbodyindex = -1;
+            if( pnode->_conftype == CNT_Collision && !!pnode->_collidinglink ) {
+                record.robotlinkindex = pnode->_robotlinkindex;
+                record.collidinglinkindex = pnode->_collidinglink->GetIndex();
+                record.collidingbodyindex = mapbodynameindices[pnode->_collidinglink->GetParent()->GetName()];
+            }
+            record.numchildren = pnode->_vchildren.size();
+            record.hitcount = pnode->_hitcount;
+            record.hasselfchild = pnode->_hasselfchild;
+            record.usenn = pnode->_usenn;
+            record.lastusestamp = pnode->_lastusestamp;
+            WriteCacheData(vdata, &record, 1);
+            WriteCacheData(vdata, pnode->GetConfigurationState(), _statedof);
+            FOREACHC(itchild, pnode->_vchildren) {
+                int32_t cindex = _mapNodeIndices[*itchild];
+                WriteCacheData(vdata, &cindex, 1);
             }
         }
     }
+    _mapNodeIndices.clear();
 
-    fclose(pfile);
+    _fulldirname = RaveFindDatabaseFile(std::string("selfcache.")+filename,false);
+    RAVELOG_DEBUG_FORMAT("Writing cache to %s, size=%d", _fulldirname%index);
 
+    // write to a temporary file and rename it so that readers never see a partially written cache
+    std::string tempfilename = str(boost::format("%s.%d.tmp")%_fulldirname%getpid());
+    FILE* pfile = fopen(tempfilename.c_str(),"wb");
+    if( !pfile ) {
+        RAVELOG_WARN_FORMAT("failed to open %s for writing the cache", tempfilename);
+        return 0;
+    }
+    bool bwritten = fwrite(vdata.data(), vdata.size(), 1, pfile) == 1;
+    bwritten = fclose(pfile) == 0 && bwritten;
+    if( bwritten ) {
+        // stamp the file before renaming it, another process can publish right after the rename
+        _UpdateCacheFileStamp(tempfilename);
+    }
+    if( !bwritten || std::rename(tempfilename.c_str(), _fulldirname.c_str()) != 0 ) {
+        RAVELOG_WARN_FORMAT("failed to write the cache to %s", _fulldirname);
+        std::remove(tempfilename.c_str());
+        _cachefilestamppath.resize(0);
+        return 0;
+    }
+    _bEvictedSinceCacheFileStamp = false;
+    _bHasUnsavedNodes = false;
     return 1;
 }
 
@@ -863,90 +1124,295 @@ int CacheTree::LoadCache(std::string filename, EnvironmentBasePtr penv)
 {
     //std::lock_guard<std::mutex> lock(_mutexpool);
     _fulldirname = RaveFindDatabaseFile(std::string("selfcache.")+filename,false);
+    if( _fulldirname.size() == 0 ) {
+        return 0;
+    }
 
-    FILE* pfile = fopen(_fulldirname.c_str(),"rb");
-    size_t outs;
+    // stamp before opening. If a file is published in between, the mapped file is newer than the stamp and merging it again later is harmless.
+    // stamping after opening would record the newer file without having read it
+    _UpdateCacheFileStamp(_fulldirname);
 
-    if (!pfile) {
+    boost::interprocess::file_mapping filemapping;
+    boost::interprocess::mapped_region mappedregion;
+    try {
+        boost::interprocess::file_mapping(_fulldirname.c_str(), boost::interprocess::read_only).swap(filemapping);
+        boost::interprocess::mapped_region(filemapping, boost::interprocess::read_only).swap(mappedregion);
+    }
+    catch(const boost::interprocess::interprocess_exception& ex) {
+        // file does not exist or is empty
+        _cachefilestamppath.resize(0);
         return 0;
     }
+    const uint8_t* pdata = static_cast<const uint8_t*>(mappedregion.get_address());
+    const uint8_t* pdataend = pdata + mappedregion.get_size();
 
-    Reset();
-    outs = fread(&_statedof, sizeof(_statedof), 1, pfile);
+    CacheFileHeader header;
+    if( !ReadCacheData(pdata, pdataend, &header, 1) || header.magic != s_CacheFileMagic ) {
+        RAVELOG_WARN_FORMAT("%s is not a cache file", _fulldirname);
+        return 0;
+    }
+    if( header.version != s_CacheFileVersion || header.realsize != sizeof(dReal) ) {
+        RAVELOG_WARN_FORMAT("%s has version %d and real size %d, expected %d and %d", _fulldirname%header.version%header.realsize%s_CacheFileVersion%sizeof(dReal));
+        return 0;
+    }
+    if( header.statedof != _statedof ) {
+        RAVELOG_WARN_FORMAT("%s has state dof %d, expected %d", _fulldirname%header.statedof%_statedof);
+        return 0;
+    }
+    // every node takes at least a record and a state, so a count past the file size is corrupt and must not be allocated
+    uint64_t nodesize = sizeof(CacheFileNodeRecord)+sizeof(dReal)*_statedof;
+    if( header.numnodes < 0 || (uint64_t)header.numnodes > (uint64_t)(pdataend - pdata)/nodesize || header.numbodynames < 0 || header.numbodynames > pdataend - pdata
+        || header.maxlevel < header.minlevel || header.maxlevel > s_CacheFileMaxLevel || header.minlevel < -s_CacheFileMaxLevel || !(header.base > 1) || !(header.maxdistance > 0) ) {
+        RAVELOG_WARN_FORMAT("%s has a corrupt header", _fulldirname);
+        return 0;
+    }
 
-    _weights.resize(_statedof,1.0);
+    std::vector<dReal> vweights(header.statedof);
+    std::vector<std::string> vbodynames(header.numbodynames);
+    bool bvalid = ReadCacheData(pdata, pdataend, vweights.data(), vweights.size());
+    for(size_t ibody = 0; ibody < vbodynames.size() && bvalid; ++ibody) {
+        int32_t namelength = 0;
+        bvalid = ReadCacheData(pdata, pdataend, &namelength, 1) && namelength >= 0 && namelength <= pdataend - pdata;
+        if( bvalid ) {
+            vbodynames[ibody].assign(reinterpret_cast<const char*>(pdata), namelength);
+            pdata += namelength;
+        }
+    }
+    if( !bvalid ) {
+        RAVELOG_WARN_FORMAT("%s is truncated", _fulldirname);
+        return 0;
+    }
+
+    Reset();
+    _weights.swap(vweights);
     _curconf.resize(_statedof,1.0);
-    outs = fread(&_weights[0], sizeof(_weights[0])*_weights.size(), 1, pfile);
-
-    outs = fread(&_base, sizeof(_base), 1, pfile);
-    outs = fread(&_fBaseInv, sizeof(_fBaseInv), 1, pfile);
-    outs = fread(&_fBaseInv2, sizeof(_fBaseInv2), 1, pfile);
-    outs = fread(&_fBaseChildMult, sizeof(_fBaseChildMult), 1, pfile);
-    outs = fread(&_maxdistance, sizeof(_maxdistance), 1, pfile);
-    outs = fread(&_maxlevel, sizeof(_maxlevel), 1, pfile);
-    outs = fread(&_minlevel, sizeof(_minlevel), 1, pfile);
-    outs = fread(&_numnodes, sizeof(_numnodes), 1, pfile);
-    outs = fread(&_fMaxLevelBound, sizeof(_fMaxLevelBound), 1, pfile);
+    _base = header.base;
+    _fBaseInv = 1/_base;
+    _fBaseInv2 = 1/Sqr(_base);
+    _fBaseChildMult = 1/(_base-1);
+    _maxdistance = header.maxdistance;
+    _maxlevel = header.maxlevel;
+    _minlevel = header.minlevel;
+    _fMaxLevelBound = header.fMaxLevelBound;
 
     int maxenclevel = max(_EncodeLevel(_maxlevel), _EncodeLevel(_minlevel));
-    _vsetLevelNodes.resize(maxenclevel+1);
+    if( maxenclevel >= (int)_vsetLevelNodes.size() ) {
+        _vsetLevelNodes.resize(maxenclevel+1);
+    }
 
-    _vnodes.resize(_numnodes);
-    _dummycs.resize(_statedof, 0);
+    std::vector<KinBodyPtr> vcollidingbodies(vbodynames.size());
+    for(size_t ibody = 0; ibody < vbodynames.size(); ++ibody) {
+        vcollidingbodies[ibody] = penv->GetKinBody(vbodynames[ibody]);
+        if( !vcollidingbodies[ibody] ) {
+            RAVELOG_WARN_FORMAT("loading cache expected colliding body %s, but none found", vbodynames[ibody]);
+        }
+    }
 
-    for(int i = 0; i < _numnodes; ++i) {
+    _vnodes.resize(header.numnodes);
+    _dummycs.resize(_statedof, 0);
+    for(int i = 0; i < header.numnodes; ++i) {
         _vnodes[i] = _CreateCacheTreeNode(_dummycs, CollisionReportPtr());
     }
-
-    for (int inode = 0; inode < _numnodes; ++inode)
-    {
-        _newnode = _vnodes.at(inode);
-        outs = fread(&_newnode->_level, sizeof(_newnode->_level), 1, pfile);
-        outs = fread(_newnode->_pcstate, sizeof(dReal)*_statedof, 1, pfile);
-        outs = fread(&_newnode->_conftype, sizeof(_newnode->_conftype), 1, pfile);
-
+    _numnodes = header.numnodes;
+
+    int numinserted = 0;
+    uint64_t maxusestamp = 0;
+    for(int inode = 0; inode < header.numnodes && bvalid; ++inode) {
+        _newnode = _vnodes[inode];
+        CacheFileNodeRecord record;
+        bvalid = ReadCacheData(pdata, pdataend, &record, 1) && record.level >= _minlevel && record.level <= _maxlevel && record.numchildren >= 0 && record.numchildren <= header.numnodes
+                 && record.conftype >= CNT_Unknown && record.conftype <= CNT_Free;
+        bvalid = bvalid && ReadCacheData(pdata, pdataend, _newnode->_pcstate, _statedof);
+        if( !bvalid ) {
+            break;
+        }
+        _newnode->_level = record.level;
+        _newnode->_conftype = (ConfigurationNodeType)record.conftype;
+        _newnode->_hitcount = record.hitcount;
+        _newnode->_hasselfchild = record.hasselfchild;
+        _newnode->_usenn = record.usenn;
+        _newnode->_lastusestamp = record.lastusestamp;
+        maxusestamp = max(maxusestamp, record.lastusestamp);
         if( _newnode->_conftype == CNT_Collision ) {
-            int namelength;
-            outs = fread(&namelength, sizeof(namelength), 1, pfile);
-            _collidingbodyname.resize(namelength);
-            outs = fread(&_collidingbodyname[0], namelength, 1, pfile);
-            int collidinglinkindex;
-            outs = fread(&collidinglinkindex, sizeof(collidinglinkindex), 1, pfile);
-            _pcollidingbody = penv->GetKinBody(_collidingbodyname);
-            if( !_pcollidingbody ) {
-                RAVELOG_WARN_FORMAT("loading cache expected colliding body %s, but none found", _collidingbodyname);
+            _newnode->_robotlinkindex = record.robotlinkindex;
+            if( record.collidingbodyindex >= 0 && record.collidingbodyindex < (int)vcollidingbodies.size() && !!vcollidingbodies[record.collidingbodyindex] ) {
+                const std::vector<KinBody::LinkPtr>& vlinks = vcollidingbodies[record.collidingbodyindex]->GetLinks();
+                if( record.collidinglinkindex >= 0 && record.collidinglinkindex < (int)vlinks.size() ) {
+                    _newnode->_collidinglink = vlinks[record.collidinglinkindex];
+                }
             }
-            else {
-                _newnode->_collidinglink = _pcollidingbody->GetLinks().at(collidinglinkindex);
+            if( !_newnode->_collidinglink ) {
+                // cannot tell what the configuration collides with, so have it checked again
+                _newnode->_conftype = CNT_Unknown;
             }
-            outs = fread(&_newnode->_robotlinkindex, sizeof(_newnode->_robotlinkindex), 1, pfile);
         }
 
-        outs = fread(&_newnode->_hasselfchild, sizeof(_newnode->_hasselfchild), 1, pfile);
-        outs = fread(&_newnode->_usenn, sizeof(_newnode->_usenn), 1, pfile);
-        int numchildren;
-        outs = fread(&numchildren, sizeof(numchildren), 1, pfile);
-        _newnode->_vchildren.resize(numchildren);
-
-        // create the copies of the children and insert them
-        for(int i = 0; i < numchildren; ++i) {
-            int childid;
-            outs = fread(&childid, sizeof(childid), 1, pfile);
-            _newnode->_vchildren[i] = _vnodes.at(childid);
+        _newnode->_vchildren.resize(record.numchildren);
+        for(int i = 0; i < record.numchildren && bvalid; ++i) {
+            int32_t childid = -1;
+            bvalid = ReadCacheData(pdata, pdataend, &childid, 1) && childid >= 0 && childid < header.numnodes;
+            if( bvalid ) {
+                _newnode->_vchildren[i] = _vnodes[childid];
+            }
         }
-
         _vsetLevelNodes.at(_EncodeLevel(_newnode->_level)).insert(_newnode);
+        ++numinserted;
     }
+    // the queries start from the single root at the top level
+    bvalid = bvalid && (header.numnodes == 0 || _vsetLevelNodes.at(_EncodeLevel(_maxlevel)).size() == 1);
 
-    fclose(pfile);
+    if( !bvalid ) {
+        RAVELOG_WARN_FORMAT("%s is corrupt", _fulldirname);
+        // Reset only destroys the nodes in the levels
+        for(int inode = numinserted; inode < header.numnodes; ++inode) {
+            _DeleteCacheTreeNode(_vnodes[inode]);
+        }
+        _vnodes.resize(0);
+        Init(_weights, _maxdistance);
+        return 0;
+    }
 
     _vnodes.resize(0);
-
-    int numloaded = GetNumKnownNodes();
-    OPENRAVE_ASSERT_OP(numloaded,==,_numnodes);
+    _numknownnodesbound = _numnodes;
+    // nodes used from now on are more recent than the ones used by the writer
+    _nUseStamp = max(_nUseStamp, maxusestamp);
+    _bEvictedSinceCacheFileStamp = false;
+    _bHasUnsavedNodes = false;
+    RAVELOG_DEBUG_FORMAT("loaded %d nodes from %s, %d known nodes", _numnodes%_fulldirname%GetNumKnownNodes());
     return 1;
 }
 
+int CacheTree::MergeCache(std::string filename, EnvironmentBasePtr penv, dReal fFreeSeparationDist, dReal fCollisionSeparationDist)
+{
+    CacheTree filetree(_statedof);
+    if( !filetree.LoadCache(filename, penv) ) {
+        return -1;
+    }
+
+    // another process could have published over the last publication of this tree
+    if( !_bHasUnsavedNodes && _HasNodesMissingFrom(filetree, fFreeSeparationDist, fCollisionSeparationDist) ) {
+        _bHasUnsavedNodes = true;
+    }
+    int numinserted = _InsertNodeCopies(filetree, fFreeSeparationDist, fCollisionSeparationDist);
+    _cachefilestamppath = filetree._cachefilestamppath;
+    _cachefiletime = filetree._cachefiletime;
+    _cachefilesize = filetree._cachefilesize;
+    _cachefileinode = filetree._cachefileinode;
+    _bEvictedSinceCacheFileStamp = false;
+    if( numinserted > 0 ) {
+        _CheckMaxNodes();
+    }
+    RAVELOG_DEBUG_FORMAT("merged %d/%d nodes from %s", numinserted%filetree.GetNumKnownNodes()%_cachefilestamppath);
+    return numinserted;
+}
+
+int CacheTree::PublishCache(std::string filename, EnvironmentBasePtr penv, dReal fFreeSeparationDist, dReal fCollisionSeparationDist)
+{
+    if( !_bEvictedSinceCacheFileStamp ) {
+        // the tree has everything it last saw in the file
+        return SaveCache(filename);
+    }
+
+    CacheTree filetree(_statedof);
+    if( !filetree.LoadCache(filename, penv) ) {
+        return SaveCache(filename);
+    }
+    int numinserted = filetree._InsertNodeCopies(*this, fFreeSeparationDist, fCollisionSeparationDist);
+    int nsaved = filetree.SaveCache(filename);
+    if( nsaved ) {
+        _fulldirname = filetree._fulldirname;
+        _cachefilestamppath = filetree._cachefilestamppath;
+        _cachefiletime = filetree._cachefiletime;
+        _cachefilesize = filetree._cachefilesize;
+        _cachefileinode = filetree._cachefileinode;
+        _bEvictedSinceCacheFileStamp = false;
+        _bHasUnsavedNodes = false;
+    }
+    RAVELOG_DEBUG_FORMAT("published %d nodes into the %d known nodes of %s", numinserted%(filetree.GetNumKnownNodes()-numinserted)%filetree._fulldirname);
+    return nsaved;
+}
+
+int CacheTree::_InsertNodeCopies(const CacheTree& reftree, dReal fFreeSeparationDist, dReal fCollisionSeparationDist)
+{
+    // only the lowest copy of a node is inserted
+    int numinserted = 0;
+    FOREACHC(itlevelnodes, reftree._vsetLevelNodes) {
+        FOREACHC(itnode, *itlevelnodes) {
+            CacheTreeNodeConstPtr pnode = *itnode;
+            if( pnode->_hasselfchild || pnode->_conftype == CNT_Unknown ) {
+                continue;
+            }
+            if( _InsertNodeCopy(pnode, pnode->_conftype == CNT_Collision ? fCollisionSeparationDist : fFreeSeparationDist) == 1 ) {
+                ++numinserted;
+            }
+        }
+    }
+    return numinserted;
+}
+
+bool CacheTree::_HasNodesMissingFrom(const CacheTree& reftree, dReal fFreeSeparationDist, dReal fCollisionSeparationDist) const
+{
+    dReal fEpsilon = g_fEpsilon*_maxdistance; // min distance
+    std::vector<dReal> vstate(_statedof);
+    FOREACHC(itlevelnodes, _vsetLevelNodes) {
+        FOREACHC(itnode, *itlevelnodes) {
+            CacheTreeNodeConstPtr pnode = *itnode;
+            if( pnode->_hasselfchild || pnode->_conftype == CNT_Unknown ) {
+                continue;
+            }
+            // same test as _InsertNodeCopy, reftree would not have taken a copy of a node it has a close enough node of the same type for
+            dReal fSeparationDist = max(pnode->_conftype == CNT_Collision ? fCollisionSeparationDist : fFreeSeparationDist, fEpsilon);
+            vstate.assign(pnode->GetConfigurationState(), pnode->GetConfigurationState()+_statedof);
+            if( !reftree.FindNearestNode(vstate, fSeparationDist, pnode->_conftype).first ) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool CacheTree::IsCacheFileModified(std::string filename) const
+{
+    std::string fullfilename = RaveFindDatabaseFile(std::string("selfcache.")+filename,false);
+    struct stat sb;
+    if( fullfilename.size() == 0 || ::stat(fullfilename.c_str(), &sb) != 0 ) {
+        return false;
+    }
+    return fullfilename != _cachefilestamppath || (int64_t)sb.st_mtime != _cachefiletime || (uint64_t)sb.st_size != _cachefilesize || (uint64_t)sb.st_ino != _cachefileinode;
+}
+
+void CacheTree::_UpdateCacheFileStamp(const std::string& stampfilename)
+{
+    struct stat sb;
+    _cachefilestamppath = _fulldirname;
+    if( ::stat(stampfilename.c_str(), &sb) == 0 ) {
+        _cachefiletime = (int64_t)sb.st_mtime;
+        _cachefilesize = (uint64_t)sb.st_size;
+        _cachefileinode = (uint64_t)sb.st_ino;
+    }
+    else {
+        _cachefiletime = -1;
+        _cachefilesize = 0;
+        _cachefileinode = 0;
+    }
+}
+
+int CacheTree::_InsertNodeCopy(CacheTreeNodeConstPtr refnode, dReal fMinSeparationDist)
+{
+    _curconf.assign(refnode->GetConfigurationState(), refnode->GetConfigurationState()+_statedof);
+    CacheTreeNodePtr nodein = _CreateCacheTreeNode(_curconf, CollisionReportPtr());
+    nodein->_conftype = refnode->_conftype;
+    nodein->_hitcount = refnode->_hitcount;
+    // not used by this tree yet, so it is evicted before the nodes of this tree
+    nodein->_lastusestamp = 0;
+    if( refnode->_conftype == CNT_Collision ) {
+        nodein->_collidinglink = refnode->_collidinglink;
+        nodein->_collidinglinktrans = refnode->_collidinglinktrans;
+        nodein->_robotlinkindex = refnode->_robotlinkindex;
+    }
+    return _InsertNode(nodein, fMinSeparationDist);
+}
+
 int CacheTree::UpdateCollisionConfigurations(KinBodyPtr pbody)
 {
     int nremoved=0;
@@ -1251,6 +1717,21 @@ bool ConfigurationCache::InsertConfiguration(const std::vector<dReal>& conf, Col
     return ret==1;
 }
 
+int ConfigurationCache::InsertFreeConfigurations(const std::vector<dReal>& vconfigurations)
+{
+    return _cachetree.InsertNodes(vconfigurations, CollisionReportPtr(), _freespacethresh*_insertiondistancemult);
+}
+
+int ConfigurationCache::MergeCache(std::string filename, EnvironmentBasePtr penv)
+{
+    return _cachetree.MergeCache(filename, penv, _freespacethresh*_insertiondistancemult, _collisionthresh*_insertiondistancemult);
+}
+
+int ConfigurationCache::PublishCache(std::string filename, EnvironmentBasePtr penv)
+{
+    return _cachetree.PublishCache(filename, penv, _freespacethresh*_insertiondistancemult, _collisionthresh*_insertiondistancemult);
+}
+
 int ConfigurationCache::GetNumKnownNodes()
 {
     return _cachetree.GetNumKnownNodes();
@@ -99,9 +99,14 @@ public:
         return _usenn;
     }
 
-    /// \brief function used to update the hitcount for this node, TODO use this information to prune cache when it gets too big/slow
-    inline int IncreaseHitCount(){
-        return _hitcount++;
+    /// \brief returns the number of cache hits on this node
+    inline int GetHitCount() const {
+        return _hitcount;
+    }
+
+    /// \brief returns the use stamp of the tree when this node was last inserted or hit. Used to evict the least recently used nodes
+    inline uint64_t GetLastUseStamp() const {
+        return _lastusestamp;
     }
 
     // returns closest distance to a configuration of the opposite type seen so far
@@ -132,6 +137,7 @@ protected:
     uint8_t _hasselfchild; ///< if 1, then _vchildren has contains a clone of this node in the level below it.
     uint8_t _usenn; ///< if 1, then use part of the nearest neighbor search, otherwise ignore
     int _hitcount; /// number of cache hits
+    uint64_t _lastusestamp; ///< CacheTree::_nUseStamp when the node was last inserted or hit
 
     // managed by pool
 #ifdef _DEBUG
@@ -194,6 +200,28 @@ public:
     /// \return 1 if point is inserted and parent found. 0 if no parent found and point is not inserted. -1 if parent found but point not inserted since it is close to fMinSeparationDist
     int InsertNode(const std::vector<dReal>& cs, CollisionReportPtr report, dReal fMinSeparationDist);
 
+    /// \brief inserts many configurations of the same collision state
+    ///
+    /// Eviction (see \ref SetMaxNodes) is done once after all configurations are inserted.
+    /// \param vstates the configurations one after the other, has to be a multiple of the state dof
+    /// \return the number of inserted configurations
+    int InsertNodes(const std::vector<dReal>& vstates, CollisionReportPtr report, dReal fMinSeparationDist);
+
+    /// \brief sets the max number of nodes the tree can hold, 0 (default) means unbounded.
+    ///
+    /// When an insertion makes the tree hold more than maxnodes distinct known configurations, the tree is rebuilt with the 3/4*maxnodes most recently used ones. Self-child copies and CNT_Unknown nodes do not count towards the bound.
+    void SetMaxNodes(int maxnodes);
+
+    int GetMaxNodes() const {
+        return _maxnodes;
+    }
+
+    /// \brief rebuilds the tree with at most numkeep distinct known configurations
+    ///
+    /// Nodes of type CNT_Unknown are dropped, the rest are ordered by last use and then hit count. Nothing is done if the tree does not hold more than numkeep distinct known configurations.
+    /// \return the number of evicted known configurations
+    int EvictNodes(int numkeep);
+
     /// \brief removes node from the tree
     ///
     /// \return true if node is removed
@@ -258,17 +286,76 @@ public:
     /// \brief returns the number of configurations in the tree that are not CNT_Unknown
     int GetNumKnownNodes();
 
-    /// \brief save cache to disk
+    /// \brief save cache to the database file selfcache.filename
+    ///
+    /// The file is a versioned binary image of the tree with fixed size node records, it is written to a temporary file and renamed so readers never see a partial file.
     int SaveCache(std::string filename);
 
-    /// \brief load cache from disk
+    /// \brief load cache from the database file selfcache.filename by mapping it into memory
+    ///
+    /// \return 1 if loaded, 0 if the file does not exist or is not valid
     int LoadCache(std::string filename, EnvironmentBasePtr penv);
 
+    /// \brief inserts the known configurations of the database file selfcache.filename into the tree
+    ///
+    /// Used to pick up the results other processes published with SaveCache without losing the results of this tree.
+    /// \param fFreeSeparationDist, fCollisionSeparationDist min distance to the existing nodes for inserting free and colliding configurations
+    /// \return the number of inserted configurations, -1 if the file does not exist or is not valid
+    int MergeCache(std::string filename, EnvironmentBasePtr penv, dReal fFreeSeparationDist, dReal fCollisionSeparationDist);
+
+    /// \brief saves the cache to the database file selfcache.filename without dropping the results other processes published there
+    ///
+    /// If the tree evicted nodes since it last saved, loaded or merged the file, the file can hold results the tree does not have anymore.
+    /// In that case the nodes of the tree are inserted into a copy of the file and that copy is saved instead, so a bounded tree never publishes fewer results than the file has.
+    /// \param fFreeSeparationDist, fCollisionSeparationDist min distance to the nodes of the file for inserting free and colliding configurations
+    int PublishCache(std::string filename, EnvironmentBasePtr penv, dReal fFreeSeparationDist, dReal fCollisionSeparationDist);
+
+    /// \brief returns true if the database file selfcache.filename changed since the tree last saved, loaded or merged it
+    bool IsCacheFileModified(std::string filename) const;
+
+    /// \brief returns true if the cache file the tree last saved, loaded or merged may lack some of its known nodes
+    ///
+    /// This is the case after inserting nodes, or after merging a file that another process published without the nodes of this tree.
+    inline bool HasUnsavedNodes() const {
+        return _bHasUnsavedNodes;
+    }
+
 private:
     /// \brief creates new node on the pool
     CacheTreeNodePtr _CreateCacheTreeNode(const std::vector<dReal>& cs, CollisionReportPtr report);
     CacheTreeNodePtr _CloneCacheTreeNode(CacheTreeNodeConstPtr refnode);
 
+    /// \brief inserts an already created node. If not inserted, the node is deleted.
+    int _InsertNode(CacheTreeNodePtr nodein, dReal fMinSeparationDist);
+
+    /// \brief marks the node as used by a query
+    inline void _MarkNodeUsed(CacheTreeNodePtr pnode) const {
+        pnode->_hitcount++;
+        pnode->_lastusestamp = ++_nUseStamp;
+    }
+
+    /// \brief inserts a copy of a node of another tree with the same state dof
+    int _InsertNodeCopy(CacheTreeNodeConstPtr refnode, dReal fMinSeparationDist);
+
+    /// \brief inserts copies of the known nodes of reftree, only the lowest copy of a node is inserted
+    ///
+    /// \return the number of inserted configurations
+    int _InsertNodeCopies(const CacheTree& reftree, dReal fFreeSeparationDist, dReal fCollisionSeparationDist);
+
+    /// \brief returns true if reftree has no node of the same type within the separation distance of some known node of this tree
+    bool _HasNodesMissingFrom(const CacheTree& reftree, dReal fFreeSeparationDist, dReal fCollisionSeparationDist) const;
+
+    /// \brief records the modification time, size and inode of stampfilename as the stamp of the cache file _fulldirname, see IsCacheFileModified
+    ///
+    /// \param stampfilename either _fulldirname or the temporary file that is renamed to it
+    void _UpdateCacheFileStamp(const std::string& stampfilename);
+
+    /// \brief evicts nodes if the tree has more than _maxnodes distinct known configurations
+    void _CheckMaxNodes();
+
+    /// \brief returns the number of configurations in the tree that are not CNT_Unknown, counting the self-child copies of a node once
+    int _GetNumDistinctKnownNodes() const;
+
     /// \brief deletes the node from the pool and calls its destructor.
     void _DeleteCacheTreeNode(CacheTreeNodePtr pnode);
 
@@ -318,6 +405,12 @@ private:
     std::vector<dReal> _curconf;
 
     std::string _fulldirname;
+    std::string _cachefilestamppath; ///< the cache file last saved, loaded or merged
+    int64_t _cachefiletime; ///< modification time of _cachefilestamppath at that point
+    uint64_t _cachefilesize; ///< size of _cachefilestamppath at that point
+    uint64_t _cachefileinode; ///< inode of _cachefilestamppath at that point, every publication renames a new file in place so it changes even if the time and size do not
+    bool _bEvictedSinceCacheFileStamp; ///< true if nodes were evicted since the cache file stamp was taken, so the file may hold results the tree does not have. See PublishCache
+    bool _bHasUnsavedNodes; ///< true if the cache file last saved, loaded or merged may lack known nodes of the tree
     CacheTreeNodePtr _newnode; ///< for loading
     std::string _collidingbodyname;
     KinBodyPtr _pcollidingbody;
@@ -334,6 +427,9 @@ private:
     int _maxlevel; ///< the maximum allowed levels in the tree, this is where the root node starts (inclusive)
     int _minlevel; ///< the minimum allowed levels in the tree (inclusive)
     int _numnodes; ///< the number of nodes in the current tree starting at the root at _vsetLevelNodes.at(_EncodeLevel(_maxlevel))
+    int _maxnodes; ///< if > 0, max number of distinct known configurations before evicting, see SetMaxNodes
+    int _numknownnodesbound; ///< upper bound of _GetNumDistinctKnownNodes, so that _CheckMaxNodes only counts the nodes when the bound exceeds _maxnodes
+    mutable uint64_t _nUseStamp; ///< incremented on every insertion and hit
     dReal _fMaxLevelBound; ///< pow(_base, _maxlevel)
 
     // cache cache
@@ -366,6 +462,30 @@ public:
     /// \return true if configuration was inserted
     bool InsertConfiguration(const std::vector<dReal>& cs, CollisionReportPtr report = CollisionReportPtr(), dReal indist = -1);
 
+    /// \brief inserts many free configurations at once, checking the node bound only once
+    ///
+    /// The collision checks of the cache checker insert their configurations one by one already, this is for callers that know configurations to be free by other means.
+    /// \param vconfigurations the configurations one after the other
+    /// \return the number of inserted configurations
+    int InsertFreeConfigurations(const std::vector<dReal>& vconfigurations);
+
+    /// \brief bounds the number of nodes of the cache, 0 means unbounded. See CacheTree::SetMaxNodes
+    inline void SetMaxNodes(int maxnodes)
+    {
+        _cachetree.SetMaxNodes(maxnodes);
+    }
+
+    inline int GetMaxNodes() const
+    {
+        return _cachetree.GetMaxNodes();
+    }
+
+    /// \brief keeps the numkeep most recently used configurations, see CacheTree::EvictNodes
+    inline int EvictNodes(int numkeep)
+    {
+        return _cachetree.EvictNodes(numkeep);
+    }
+
     /// \brief removes all collision configurations colliding with pbody, used to update cache when bodies are removed or moved
     int UpdateCollisionConfigurations(KinBodyPtr pbody);
 
@@ -490,15 +610,39 @@ public:
     }
 
     /// \brief saves the cache to disk
-    inline void SaveCache(std::string filename)
+    ///
+    /// \return 1 if the cache was saved, 0 otherwise
+    inline int SaveCache(std::string filename)
     {
-        _cachetree.SaveCache(filename);
+        return _cachetree.SaveCache(filename);
     }
 
     /// \brief loads cache from disk
-    inline void LoadCache(std::string filename, EnvironmentBasePtr penv)
+    ///
+    /// \return 1 if the cache was loaded, 0 if there is no valid cache file
+    inline int LoadCache(std::string filename, EnvironmentBasePtr penv)
+    {
+        return _cachetree.LoadCache(filename, penv);
+    }
+
+    /// \brief merges the configurations saved to disk by other processes into the cache
+    ///
+    /// \return the number of inserted configurations, -1 if there is no valid cache file
+    int MergeCache(std::string filename, EnvironmentBasePtr penv);
+
+    /// \brief saves the cache to disk without dropping the configurations other processes saved there, see CacheTree::PublishCache
+    int PublishCache(std::string filename, EnvironmentBasePtr penv);
+
+    /// \brief returns true if the cache on disk changed since this cache last saved, loaded or merged it
+    inline bool IsCacheFileModified(std::string filename) const
+    {
+        return _cachetree.IsCacheFileModified(filename);
+    }
+
+    /// \brief returns true if the cache on disk may lack some configurations of this cache, see CacheTree::HasUnsavedNodes
+    inline bool HasUnsavedNodes() const
     {
-        _cachetree.LoadCache(filename, penv);
+        return _cachetree.HasUnsavedNodes();
     }
 
 private:
@@ -86,6 +86,26 @@ public:
         return _cache->InsertConfiguration(openravepy::ExtractArray<dReal>(ovalues), openravepy::GetCollisionReport(pyreport));
     }
 
+    int InsertFreeConfigurations(object ovalues)
+    {
+        return _cache->InsertFreeConfigurations(openravepy::ExtractArray<dReal>(ovalues));
+    }
+
+    void SetMaxNodes(int maxnodes)
+    {
+        _cache->SetMaxNodes(maxnodes);
+    }
+
+    int GetMaxNodes()
+    {
+        return _cache->GetMaxNodes();
+    }
+
+    int EvictNodes(int numkeep)
+    {
+        return _cache->EvictNodes(numkeep);
+    }
+
     object CheckCollision(object ovalues)
     {
         KinBody::LinkConstPtr crobotlink, ccollidinglink;
@@ -181,6 +201,34 @@ public:
         return _cache->ComputeDistance(openravepy::ExtractArray<dReal>(oconfi), openravepy::ExtractArray<dReal>(oconff));
     }
 
+    int GetNumKnownNodes() {
+        return _cache->GetNumKnownNodes();
+    }
+
+    int SaveCache(const std::string& filename) {
+        return _cache->SaveCache(filename);
+    }
+
+    int LoadCache(const std::string& filename) {
+        return _cache->LoadCache(filename, _cache->GetRobot()->GetEnv());
+    }
+
+    int MergeCache(const std::string& filename) {
+        return _cache->MergeCache(filename, _cache->GetRobot()->GetEnv());
+    }
+
+    int PublishCache(const std::string& filename) {
+        return _cache->PublishCache(filename, _cache->GetRobot()->GetEnv());
+    }
+
+    bool IsCacheFileModified(const std::string& filename) {
+        return _cache->IsCacheFileModified(filename);
+    }
+
+    bool HasUnsavedNodes() {
+        return _cache->HasUnsavedNodes();
+    }
+
 protected:
     object _pyenv;
     configurationcache::ConfigurationCachePtr _cache;
@@ -218,6 +266,7 @@ OPENRAVE_PYTHON_MODULE(openravepy_configurationcache)
 #endif // USE_PYBIND11_PYTHON_BINDINGS
     .def("InsertConfigurationDist",&PyConfigurationCache::InsertConfigurationDist, PY_ARGS("values","report","dist") "Doc of InsertConfigurationDist")
     .def("InsertConfiguration",&PyConfigurationCache::InsertConfiguration, PY_ARGS("values", "report") "Doc of InsertConfiguration")
+    .def("InsertFreeConfigurations",&PyConfigurationCache::InsertFreeConfigurations, PY_ARGS("values") "inserts many free configurations checking the node bound once, values holds the configurations one after the other")
     .def("CheckCollision",&PyConfigurationCache::CheckCollision, PY_ARGS("values") "Doc of CheckCollision")
     .def("Reset",&PyConfigurationCache::Reset)
     .def("GetDOFValues",&PyConfigurationCache::GetDOFValues)
@@ -236,5 +285,15 @@ OPENRAVE_PYTHON_MODULE(openravepy_configurationcache)
     .def("GetCollisionThresh", &PyConfigurationCache::GetCollisionThresh)
     .def("GetFreeSpaceThresh", &PyConfigurationCache::GetFreeSpaceThresh)
     .def("GetInsertionDistanceMult", &PyConfigurationCache::GetInsertionDistanceMult)
+    .def("SetMaxNodes", &PyConfigurationCache::SetMaxNodes, PY_ARGS("maxnodes") "bounds the number of nodes, least recently used nodes are evicted. 0 means unbounded")
+    .def("GetMaxNodes", &PyConfigurationCache::GetMaxNodes)
+    .def("EvictNodes", &PyConfigurationCache::EvictNodes, PY_ARGS("numkeep") "keeps the numkeep most recently used configurations, returns the number of evicted configurations")
+    .def("GetNumKnownNodes", &PyConfigurationCache::GetNumKnownNodes)
+    .def("SaveCache", &PyConfigurationCache::SaveCache, PY_ARGS("filename") "saves the cache to the database file selfcache.filename, returns 1 on success")
+    .def("LoadCache", &PyConfigurationCache::LoadCache, PY_ARGS("filename") "loads the cache from the database file selfcache.filename, returns 0 if there is no valid file")
+    .def("MergeCache", &PyConfigurationCache::MergeCache, PY_ARGS("filename") "merges the configurations of the database file selfcache.filename, returns the number inserted or -1 if there is no valid file")
+    .def("PublishCache", &PyConfigurationCache::PublishCache, PY_ARGS("filename") "saves the cache to the database file selfcache.filename without dropping the configurations saved there by others")
+    .def("IsCacheFileModified", &PyConfigurationCache::IsCacheFileModified, PY_ARGS("filename") "returns True if the database file changed since the cache last saved, loaded or merged it")
+    .def("HasUnsavedNodes", &PyConfigurationCache::HasUnsavedNodes, "returns True if the database file may lack some configurations of the cache")
     ;
 }
@@ -509,20 +509,59 @@ bool FCLCollisionChecker::CheckCollision(KinBodyConstPtr pbody, std::vector<KinB
 
 bool FCLCollisionChecker::CheckCollision(const RAY& ray, LinkConstPtr plink,CollisionReportPtr report)
 {
-    RAVELOG_WARN("fcl doesn't support Ray collisions\n");
-    return false; //TODO
+    _raycaster.AddLink(*plink, _fclspace->GetBodyGeometryGroup(*plink->GetParent()));
+    return _CastRay(ray, report);
 }
 
 bool FCLCollisionChecker::CheckCollision(const RAY& ray, KinBodyConstPtr pbody, CollisionReportPtr report)
 {
-    RAVELOG_WARN("fcl doesn't support Ray collisions\n");
-    return false; //TODO
+    _raycaster.AddBody(*pbody, _fclspace->GetBodyGeometryGroup(*pbody));
+    return _CastRay(ray, report);
 }
 
 bool FCLCollisionChecker::CheckCollision(const RAY& ray, CollisionReportPtr report)
 {
-    RAVELOG_WARN("fcl doesn't support Ray collisions\n");
-    return false; //TODO
+    GetEnv()->GetBodies(_vCachedBodies);
+    FOREACHC(itbody, _vCachedBodies) {
+        _raycaster.AddBody(**itbody, _fclspace->GetBodyGeometryGroup(**itbody));
+    }
+    _vCachedBodies.resize(0);
+    return _CastRay(ray, report);
+}
+
+int FCLCollisionChecker::CheckCollisionRays(const std::vector<RAY>& vrays, KinBodyConstPtr pbody, std::vector<OpenRAVE::RayCollisionResult>& vresults)
+{
+    if( !!pbody ) {
+        _raycaster.AddBody(*pbody, _fclspace->GetBodyGeometryGroup(*pbody));
+    }
+    else {
+        GetEnv()->GetBodies(_vCachedBodies);
+        FOREACHC(itbody, _vCachedBodies) {
+            _raycaster.AddBody(**itbody, _fclspace->GetBodyGeometryGroup(**itbody));
+        }
+        _vCachedBodies.resize(0);
+    }
+    return _raycaster.CastRays(vrays, !!(_options & OpenRAVE::CO_RayAnyHit), vresults);
+}
+
+bool FCLCollisionChecker::_CastRay(const RAY& ray, CollisionReportPtr report)
+{
+    if( !!report ) {
+        report->Reset(_options);
+    }
+    _vCachedRays.resize(1);
+    _vCachedRays[0] = ray;
+    if( _raycaster.CastRays(_vCachedRays, !!(_options & OpenRAVE::CO_RayAnyHit), _vCachedRayResults) == 0 ) {
+        return false;
+    }
+    const OpenRAVE::RayCollisionResult& result = _vCachedRayResults.at(0);
+    if( !!report ) {
+        report->plink1 = result.plink;
+        report->minDistance = result.fDistance;
+        // always return contacts like the other checkers, openravepy expects them
+        report->contacts.push_back(CollisionReport::CONTACT(result.pos, result.norm, result.fDistance));
+    }
+    return true;
 }
 
 bool FCLCollisionChecker::CheckCollision(const OpenRAVE::TriMesh& trimesh, KinBodyConstPtr pbody, CollisionReportPtr report)
@@ -826,6 +865,63 @@ bool FCLCollisionChecker::CheckStandaloneSelfCollision(LinkConstPtr plink, Colli
     return query._bCollision;
 }
 
+int FCLCollisionChecker::CheckCollisionBatch(KinBodyPtr pbody, const std::vector<int>& dofindices, const std::vector<OpenRAVE::dReal>& vconfigurations, std::vector<uint64_t>& vcollisionmasks, int batchoptions)
+{
+    if( _options & OpenRAVE::CO_Distance ) {
+        // distance queries need a report per configuration
+        return CollisionCheckerBase::CheckCollisionBatch(pbody, dofindices, vconfigurations, vcollisionmasks, batchoptions);
+    }
+    START_TIMING_OPT(_statistics, "BodyBatch",_options,pbody->IsRobot());
+    const size_t ndof = dofindices.size() > 0 ? dofindices.size() : (size_t)pbody->GetDOF();
+    OPENRAVE_ASSERT_OP_FORMAT(ndof, >, 0, "env=%s, body %s has no dofs to set", GetEnv()->GetNameId()%pbody->GetName(), OpenRAVE::ORE_InvalidArguments);
+    OPENRAVE_ASSERT_OP_FORMAT(vconfigurations.size()%ndof, ==, 0, "env=%s, configurations size %d is not a multiple of %d", GetEnv()->GetNameId()%vconfigurations.size()%ndof, OpenRAVE::ORE_InvalidArguments);
+    const size_t nconfigurations = vconfigurations.size()/ndof;
+    vcollisionmasks.resize((nconfigurations+63)>>6);
+    std::fill(vcollisionmasks.begin(), vcollisionmasks.end(), 0);
+    if( nconfigurations == 0 || pbody->GetLinks().size() == 0 ) {
+        return 0;
+    }
+
+    KinBody::KinBodyStateSaver saver(pbody, KinBody::Save_LinkTransformation);
+
+    // only pbody and its attached bodies move between configurations, so the rest of the environment and its manager are synchronized once for the whole batch
+    _fclspace->Synchronize();
+    FCLCollisionManagerInstance* penvManager = NULL;
+    if( batchoptions & OpenRAVE::CBO_Environment ) {
+        std::vector<int>& attachedBodyIndices = _attachedBodyIndicesCache;
+        pbody->GetAttachedEnvironmentBodyIndices(attachedBodyIndices);
+        penvManager = &_GetEnvManager(attachedBodyIndices);
+    }
+    const bool bActiveDOFs = !!(_options & OpenRAVE::CO_ActiveDOFs);
+    const KinBodyConstPtr pconstbody(pbody);
+    const std::vector<KinBodyConstPtr> vbodyexcluded;
+    const std::vector<LinkConstPtr> vlinkexcluded;
+
+    int ncollisions = 0;
+    for(size_t iconfig = 0; iconfig < nconfigurations; ++iconfig) {
+        pbody->SetDOFValues(&vconfigurations[iconfig*ndof], ndof, KinBody::CLA_Nothing, dofindices);
+        bool bCollision = false;
+        if( !!penvManager && _IsEnabled(*pbody) ) {
+            _fclspace->SynchronizeWithAttached(*pbody);
+            FCLCollisionManagerInstance& bodyManager = _GetBodyManager(pconstbody, bActiveDOFs);
+            CollisionCallbackData query(shared_checker(), CollisionReportPtr(), vbodyexcluded, vlinkexcluded);
+            penvManager->GetManager()->collide(bodyManager.GetManager().get(), &query, &FCLCollisionChecker::CheckNarrowPhaseCollision);
+            bCollision = query._bCollision;
+        }
+        if( !bCollision && (batchoptions & OpenRAVE::CBO_SelfCollision) ) {
+            bCollision = CheckStandaloneSelfCollision(pconstbody);
+        }
+        if( bCollision ) {
+            vcollisionmasks[iconfig>>6] |= (uint64_t)1 << (iconfig&0x3f);
+            ++ncollisions;
+            if( batchoptions & OpenRAVE::CBO_StopAtFirstCollision ) {
+                break;
+            }
+        }
+    }
+    return ncollisions;
+}
+
 bool FCLCollisionChecker::CheckNarrowPhaseCollision(fcl::CollisionObject *o1, fcl::CollisionObject *o2, void *data) {
     CollisionCallbackData* pcb = static_cast<CollisionCallbackData *>(data);
     return pcb->_pchecker->CheckNarrowPhaseCollision(o1, o2, pcb);
@@ -1219,8 +1315,8 @@ std::pair<FCLSpace::FCLKinBodyInfo::LinkInfo*, LinkConstPtr> FCLCollisionChecker
 
 std::pair<FCLSpace::FCLKinBodyInfo::FCLGeometryInfo*, GeometryConstPtr> FCLCollisionChecker::GetCollisionGeometry(const fcl::CollisionObject &collObj)
 {
-    const std::shared_ptr<const fcl::CollisionGeometry>& collgeom = collObj.collisionGeometry();
-    FCLSpace::FCLKinBodyInfo::FCLGeometryInfo* geom_raw = static_cast<FCLSpace::FCLKinBodyInfo::FCLGeometryInfo *>(collgeom->getUserData());
+    const FCLSpace::FCLKinBodyInfo::LinkInfo* link_raw = static_cast<FCLSpace::FCLKinBodyInfo::LinkInfo *>(collObj.getUserData());
+    FCLSpace::FCLKinBodyInfo::FCLGeometryInfo* geom_raw = !!link_raw ? link_raw->GetGeometryInfo(collObj) : nullptr;
     if( !!geom_raw ) {
         const GeometryConstPtr pgeom = geom_raw->GetGeometry();
         if( !pgeom ) {
@@ -11,6 +11,7 @@
 
 #include "fclspace.h"
 #include "fclmanagercache.h"
+#include "fclraycaster.h"
 
 #include "fclstatistics.h"
 
@@ -184,6 +185,8 @@ public:
 
     bool CheckCollision(const RAY& ray, CollisionReportPtr report = CollisionReportPtr()) override;
 
+    int CheckCollisionRays(const std::vector<RAY>& vrays, KinBodyConstPtr pbody, std::vector<OpenRAVE::RayCollisionResult>& vresults) override;
+
     bool CheckCollision(const OpenRAVE::TriMesh& trimesh, KinBodyConstPtr pbody, CollisionReportPtr report = CollisionReportPtr()) override;
 
     bool CheckCollision(const OpenRAVE::TriMesh& trimesh, CollisionReportPtr report = CollisionReportPtr()) override;
@@ -196,6 +199,8 @@ public:
 
     bool CheckStandaloneSelfCollision(LinkConstPtr plink, CollisionReportPtr report = CollisionReportPtr()) override;
 
+    int CheckCollisionBatch(KinBodyPtr pbody, const std::vector<int>& dofindices, const std::vector<OpenRAVE::dReal>& vconfigurations, std::vector<uint64_t>& vcollisionmasks, int batchoptions=OpenRAVE::CBO_Environment|OpenRAVE::CBO_SelfCollision) override;
+
 
 private:
     inline boost::shared_ptr<FCLCollisionChecker> shared_checker() {
@@ -249,6 +254,9 @@ private:
 
     void _PrintCollisionManagerInstanceLE(const KinBody::Link& link, FCLCollisionManagerInstance& envManager);
 
+    /// \brief casts the ray against the links added to _raycaster and fills the report with the hit
+    bool _CastRay(const RAY& ray, CollisionReportPtr report);
+
     inline bool _IsEnabled(const KinBody& body)
     {
         if( body.IsEnabled() ) {
@@ -300,6 +308,11 @@ private:
     std::vector<fcl::Vec3f> _fclPointsCache;
     std::vector<fcl::Triangle> _fclTrianglesCache;
     std::vector<KinBodyPtr> _vCachedGrabbedBodies;
+    std::vector<KinBodyPtr> _vCachedBodies;
+    std::vector<RAY> _vCachedRays;
+    std::vector<OpenRAVE::RayCollisionResult> _vCachedRayResults;
+
+    FCLRayCaster _raycaster; ///< fcl does not support rays, so they are cast against the link geometries
 
     std::vector<int> _attachedBodyIndicesCache;
 
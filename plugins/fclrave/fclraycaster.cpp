@@ -0,0 +1,439 @@
+// -*- coding: utf-8 -*-
+#include "plugindefs.h"
+#include "fclraycaster.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+namespace fclrave {
+
+using OpenRAVE::dReal;
+using OpenRAVE::RaveSqrt;
+using OpenRAVE::RayCollisionResult;
+
+namespace {
+
+static const int s_nMaxLeafPrimitives = 4;
+static const int s_nMaxTreeDepth = 48; ///< deeper nodes become leaves so that the traversal stack cannot overflow
+static const size_t s_nMinParallelRays = 1024; ///< batches with fewer rays are cast on the calling thread
+static const size_t s_nRayChunkSize = 256;
+static const int s_nMeshTreeSweepPeriod = 64; ///< number of batches between two sweeps of the mesh tree cache
+
+/// \brief intersects the ray with triangle (v0,v1,v2) from both sides, returns true if the hit is in [0,ftmax]
+inline bool IntersectTriangle(const Vector& v0, const Vector& v1, const Vector& v2, const Vector& vorigin, const Vector& vdir, dReal ftmax, dReal& ft)
+{
+    const Vector vedge1 = v1 - v0, vedge2 = v2 - v0;
+    const Vector p = vdir.cross(vedge2);
+    const dReal fdet = vedge1.dot3(p);
+    if( RaveFabs(fdet) <= std::numeric_limits<dReal>::min() ) {
+        return false;
+    }
+    const dReal finvdet = 1/fdet;
+    const Vector s = vorigin - v0;
+    const dReal u = s.dot3(p)*finvdet;
+    if( u < 0 || u > 1 ) {
+        return false;
+    }
+    const Vector q = s.cross(vedge1);
+    const dReal v = vdir.dot3(q)*finvdet;
+    if( v < 0 || u + v > 1 ) {
+        return false;
+    }
+    ft = vedge2.dot3(q)*finvdet;
+    return ft >= 0 && ft <= ftmax;
+}
+
+inline Vector ComputeInverseDirection(const Vector& vdir)
+{
+    // avoid infinities so that a ray lying on a box face does not produce nans
+    const dReal fhuge = 1e30;
+    return Vector(vdir.x != 0 ? 1/vdir.x : fhuge, vdir.y != 0 ? 1/vdir.y : fhuge, vdir.z != 0 ? 1/vdir.z : fhuge);
+}
+
+/// \brief computes the world bounds of the local box [vlocalmin, vlocalmax] transformed by t
+inline void TransformBounds(const Transform& t, const Vector& vlocalmin, const Vector& vlocalmax, Vector& vmin, Vector& vmax)
+{
+    const TransformMatrix tm(t);
+    const Vector vcenter = t*(0.5*(vlocalmin + vlocalmax));
+    const Vector vhalfextents = 0.5*(vlocalmax - vlocalmin);
+    Vector vworldextents;
+    for(int i = 0; i < 3; ++i) {
+        vworldextents[i] = RaveFabs(tm.m[4*i+0])*vhalfextents.x + RaveFabs(tm.m[4*i+1])*vhalfextents.y + RaveFabs(tm.m[4*i+2])*vhalfextents.z;
+    }
+    vmin = vcenter - vworldextents;
+    vmax = vcenter + vworldextents;
+}
+
+} // end namespace
+
+void RayAABBTree::Build(const std::vector<Vector>& vmins, const std::vector<Vector>& vmaxs)
+{
+    BOOST_ASSERT(vmins.size() == vmaxs.size());
+    _vnodes.resize(0);
+    _vprimitives.resize(vmins.size());
+    if( vmins.size() == 0 ) {
+        return;
+    }
+    std::vector<Vector> vcenters(vmins.size());
+    for(size_t i = 0; i < vmins.size(); ++i) {
+        _vprimitives[i] = (int)i;
+        vcenters[i] = 0.5*(vmins[i] + vmaxs[i]);
+    }
+    _vnodes.reserve(2*vmins.size());
+    _vnodes.push_back(Node());
+    _Build(0, 0, (int)vmins.size(), vmins, vmaxs, vcenters, 0);
+}
+
+void RayAABBTree::_Build(int nodeindex, int nfirst, int ncount, const std::vector<Vector>& vmins, const std::vector<Vector>& vmaxs, const std::vector<Vector>& vcenters, int ndepth)
+{
+    Vector vmin = vmins[_vprimitives[nfirst]], vmax = vmaxs[_vprimitives[nfirst]];
+    Vector vcentermin = vcenters[_vprimitives[nfirst]], vcentermax = vcentermin;
+    for(int i = nfirst + 1; i < nfirst + ncount; ++i) {
+        const int iprimitive = _vprimitives[i];
+        for(int j = 0; j < 3; ++j) {
+            vmin[j] = std::min(vmin[j], vmins[iprimitive][j]);
+            vmax[j] = std::max(vmax[j], vmaxs[iprimitive][j]);
+            vcentermin[j] = std::min(vcentermin[j], vcenters[iprimitive][j]);
+            vcentermax[j] = std::max(vcentermax[j], vcenters[iprimitive][j]);
+        }
+    }
+    // _vnodes can grow below, so always access the node through its index
+    _vnodes[nodeindex].vmin = vmin;
+    _vnodes[nodeindex].vmax = vmax;
+    if( ncount <= s_nMaxLeafPrimitives || ndepth >= s_nMaxTreeDepth ) {
+        _vnodes[nodeindex].nfirst = nfirst;
+        _vnodes[nodeindex].ncount = ncount;
+        return;
+    }
+
+    // split at the median of the longest axis of the centers
+    const Vector vcenterextents = vcentermax - vcentermin;
+    int axis = 0;
+    if( vcenterextents.y > vcenterextents[axis] ) {
+        axis = 1;
+    }
+    if( vcenterextents.z > vcenterextents[axis] ) {
+        axis = 2;
+    }
+    const int nhalf = ncount/2;
+    std::nth_element(_vprimitives.begin() + nfirst, _vprimitives.begin() + nfirst + nhalf, _vprimitives.begin() + nfirst + ncount, [&vcenters, axis](int i0, int i1) {
+        return vcenters[i0][axis] < vcenters[i1][axis];
+    });
+
+    // both children are allocated next to each other before building the subtrees
+    const int nchildren = (int)_vnodes.size();
+    _vnodes.push_back(Node());
+    _vnodes.push_back(Node());
+    _vnodes[nodeindex].nfirst = nchildren;
+    _vnodes[nodeindex].ncount = 0;
+    _Build(nchildren, nfirst, nhalf, vmins, vmaxs, vcenters, ndepth + 1);
+    _Build(nchildren + 1, nfirst + nhalf, ncount - nhalf, vmins, vmaxs, vcenters, ndepth + 1);
+}
+
+FCLRayCaster::FCLRayCaster() : _nNumBatches(0)
+{
+}
+
+void FCLRayCaster::AddBody(const KinBody& body, const std::string& geometrygroup)
+{
+    if( !body.IsEnabled() ) {
+        return;
+    }
+    for(const KinBody::LinkPtr& plink : body.GetLinks()) {
+        AddLink(*plink, geometrygroup);
+    }
+}
+
+void FCLRayCaster::AddLink(const KinBody::Link& link, const std::string& geometrygroup)
+{
+    if( !link.IsEnabled() ) {
+        return;
+    }
+    const KinBody::LinkConstPtr plink = link.shared_from_this();
+    if( geometrygroup.size() > 0 && link.GetGroupNumGeometries(geometrygroup) >= 0 ) {
+        for(const KinBody::GeometryInfoPtr& pinfo : link.GetGeometriesFromGroup(geometrygroup)) {
+            _AddGeometry(*pinfo, plink);
+        }
+    }
+    else {
+        for(const KinBody::Link::GeometryPtr& pgeom : link.GetGeometries()) {
+            _AddGeometry(pgeom->GetInfo(), plink);
+        }
+    }
+}
+
+void FCLRayCaster::_AddGeometry(const KinBody::GeometryInfo& info, const KinBody::LinkConstPtr& plink)
+{
+    Target target;
+    target.tgeom = plink->GetTransform()*info.GetTransform();
+    target.tgeominv = target.tgeom.inverse();
+    target.pmeshtree = NULL;
+    target.plink = plink;
+    Vector vlocalmin, vlocalmax;
+    switch(info._type) {
+    case OpenRAVE::GT_None:
+        return;
+    case OpenRAVE::GT_Box:
+        target.type = Target::TT_Box;
+        target.vextents = info._vGeomData;
+        vlocalmin = -info._vGeomData;
+        vlocalmax = info._vGeomData;
+        break;
+    case OpenRAVE::GT_Sphere:
+        target.type = Target::TT_Sphere;
+        target.vextents = Vector(info._vGeomData.x, info._vGeomData.x, info._vGeomData.x);
+        vlocalmin = -target.vextents;
+        vlocalmax = target.vextents;
+        break;
+    default: {
+        boost::shared_ptr<const OpenRAVE::TriMesh> pmesh = info._meshcollision.GetSharedMesh();
+        if( (!pmesh || pmesh->indices.size() == 0) && info._type != OpenRAVE::GT_TriMesh ) {
+            // the info of a geometry group might not have been triangulated yet
+            KinBody::GeometryInfo infotriangulated = info;
+            infotriangulated.InitCollisionMesh();
+            pmesh = infotriangulated._meshcollision.GetSharedMesh();
+        }
+        if( !pmesh || pmesh->indices.size() == 0 ) {
+            return;
+        }
+        target.type = Target::TT_Mesh;
+        target.pmeshtree = _GetMeshTree(pmesh);
+        vlocalmin = target.pmeshtree->vmin;
+        vlocalmax = target.pmeshtree->vmax;
+        break;
+    }
+    }
+
+    Vector vmin, vmax;
+    TransformBounds(target.tgeom, vlocalmin, vlocalmax, vmin, vmax);
+    _vtargets.push_back(target);
+    _vtargetmins.push_back(vmin);
+    _vtargetmaxs.push_back(vmax);
+}
+
+const FCLRayCaster::MeshTree* FCLRayCaster::_GetMeshTree(const boost::shared_ptr<const OpenRAVE::TriMesh>& pmesh)
+{
+    std::map<const OpenRAVE::TriMesh*, MeshTree>::iterator it = _mapMeshTrees.find(pmesh.get());
+    if( it != _mapMeshTrees.end() ) {
+        return &it->second;
+    }
+
+    MeshTree& meshtree = _mapMeshTrees[pmesh.get()];
+    meshtree.pmesh = pmesh;
+    const std::vector<Vector>& vertices = pmesh->vertices;
+    const std::vector<int32_t>& indices = pmesh->indices;
+    const size_t numtriangles = indices.size()/3;
+    std::vector<Vector> vmins(numtriangles), vmaxs(numtriangles);
+    for(size_t itri = 0; itri < numtriangles; ++itri) {
+        const Vector& v0 = vertices.at(indices[3*itri]);
+        const Vector& v1 = vertices.at(indices[3*itri+1]);
+        const Vector& v2 = vertices.at(indices[3*itri+2]);
+        for(int j = 0; j < 3; ++j) {
+            vmins[itri][j] = std::min(v0[j], std::min(v1[j], v2[j]));
+            vmaxs[itri][j] = std::max(v0[j], std::max(v1[j], v2[j]));
+        }
+        if( itri == 0 ) {
+            meshtree.vmin = vmins[itri];
+            meshtree.vmax = vmaxs[itri];
+        }
+        else {
+            for(int j = 0; j < 3; ++j) {
+                meshtree.vmin[j] = std::min(meshtree.vmin[j], vmins[itri][j]);
+                meshtree.vmax[j] = std::max(meshtree.vmax[j], vmaxs[itri][j]);
+            }
+        }
+    }
+    meshtree.tree.Build(vmins, vmaxs);
+    return &meshtree;
+}
+
+void FCLRayCaster::_SweepMeshTrees()
+{
+    std::map<const OpenRAVE::TriMesh*, MeshTree>::iterator it = _mapMeshTrees.begin();
+    while( it != _mapMeshTrees.end() ) {
+        if( it->second.pmesh.use_count() <= 1 ) {
+            _mapMeshTrees.erase(it++);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+int FCLRayCaster::CastRays(const std::vector<RAY>& vrays, bool bAnyHit, std::vector<RayCollisionResult>& vresults)
+{
+    vresults.resize(vrays.size());
+    int numhits = 0;
+    if( _vtargets.size() > 0 ) {
+        _targettree.Build(_vtargetmins, _vtargetmaxs);
+        if( vrays.size() < s_nMinParallelRays ) {
+            numhits = _CastRays(vrays, 0, vrays.size(), bAnyHit, vresults);
+        }
+        else {
+            std::atomic<int> numhitsparallel(0);
+            OpenRAVE::utils::ParallelForChunks(vrays.size(), s_nRayChunkSize, [&](size_t nbegin, size_t nend) {
+                numhitsparallel += _CastRays(vrays, nbegin, nend, bAnyHit, vresults);
+            });
+            numhits = numhitsparallel;
+        }
+    }
+    else {
+        std::fill(vresults.begin(), vresults.end(), RayCollisionResult());
+    }
+
+    _vtargets.resize(0);
+    _vtargetmins.resize(0);
+    _vtargetmaxs.resize(0);
+    if( ++_nNumBatches >= s_nMeshTreeSweepPeriod ) {
+        _nNumBatches = 0;
+        _SweepMeshTrees();
+    }
+    return numhits;
+}
+
+int FCLRayCaster::_CastRays(const std::vector<RAY>& vrays, size_t nbegin, size_t nend, bool bAnyHit, std::vector<RayCollisionResult>& vresults) const
+{
+    int numhits = 0;
+    for(size_t iray = nbegin; iray < nend; ++iray) {
+        RayCollisionResult& result = vresults[iray];
+        result = RayCollisionResult();
+        // the length of the direction is the length of the ray
+        const Vector& vorigin = vrays[iray].pos;
+        const Vector& vdir = vrays[iray].dir;
+        if( vdir.lengthsqr3() <= 0 ) {
+            continue;
+        }
+        dReal ftmax = 1;
+        int ihit = -1;
+        Vector vnormal;
+        auto intersect = [&](int itarget, dReal& ft) {
+            if( _IntersectTarget(_vtargets[itarget], vorigin, vdir, ft, vnormal) ) {
+                ihit = itarget;
+                return bAnyHit;
+            }
+            return false;
+        };
+        _targettree.Traverse(vorigin, ComputeInverseDirection(vdir), ftmax, intersect);
+        if( ihit >= 0 ) {
+            result.plink = _vtargets[ihit].plink;
+            result.pos = vorigin + ftmax*vdir;
+            result.norm = vnormal;
+            result.fDistance = ftmax*RaveSqrt(vdir.lengthsqr3());
+            result.bCollision = true;
+            ++numhits;
+        }
+    }
+    return numhits;
+}
+
+bool FCLRayCaster::_IntersectTarget(const Target& target, const Vector& vorigin, const Vector& vdir, dReal& ftmax, Vector& vnormal) const
+{
+    // rigid transforms keep the ray parameter, so intersect in the geometry frame
+    const Vector vlocalorigin = target.tgeominv*vorigin;
+    const Vector vlocaldir = target.tgeominv.rotate(vdir);
+    Vector vlocalnormal;
+    dReal fthit;
+    switch(target.type) {
+    case Target::TT_Box: {
+        dReal ftnear = -std::numeric_limits<dReal>::max(), ftfar = std::numeric_limits<dReal>::max();
+        int nearaxis = -1, faraxis = -1;
+        for(int i = 0; i < 3; ++i) {
+            if( vlocaldir[i] == 0 ) {
+                if( RaveFabs(vlocalorigin[i]) > target.vextents[i] ) {
+                    return false;
+                }
+                continue;
+            }
+            const dReal finv = 1/vlocaldir[i];
+            dReal t0 = (-target.vextents[i] - vlocalorigin[i])*finv;
+            dReal t1 = (target.vextents[i] - vlocalorigin[i])*finv;
+            if( t0 > t1 ) {
+                std::swap(t0, t1);
+            }
+            if( t0 > ftnear ) {
+                ftnear = t0;
+                nearaxis = i;
+            }
+            if( t1 < ftfar ) {
+                ftfar = t1;
+                faraxis = i;
+            }
+        }
+        if( ftnear > ftfar || ftfar < 0 ) {
+            return false;
+        }
+        if( ftnear >= 0 ) {
+            // entering the box, the normal opposes the ray
+            fthit = ftnear;
+            vlocalnormal = Vector(0,0,0);
+            vlocalnormal[nearaxis] = vlocaldir[nearaxis] > 0 ? -1 : 1;
+        }
+        else {
+            // the ray starts inside the box and hits the face it leaves through
+            fthit = ftfar;
+            vlocalnormal = Vector(0,0,0);
+            vlocalnormal[faraxis] = vlocaldir[faraxis] > 0 ? 1 : -1;
+        }
+        break;
+    }
+    case Target::TT_Sphere: {
+        const dReal fradius = target.vextents.x;
+        const dReal a = vlocaldir.lengthsqr3();
+        const dReal b = vlocalorigin.dot3(vlocaldir);
+        const dReal c = vlocalorigin.lengthsqr3() - fradius*fradius;
+        const dReal fdiscriminant = b*b - a*c;
+        if( fdiscriminant < 0 || fradius <= 0 ) {
+            return false;
+        }
+        const dReal fsqrt = RaveSqrt(fdiscriminant);
+        fthit = (-b - fsqrt)/a;
+        if( fthit < 0 ) {
+            fthit = (-b + fsqrt)/a;
+        }
+        vlocalnormal = (vlocalorigin + fthit*vlocaldir)*(1/fradius);
+        break;
+    }
+    case Target::TT_Mesh: {
+        const OpenRAVE::TriMesh& mesh = *target.pmeshtree->pmesh;
+        fthit = ftmax;
+        int ihittriangle = -1;
+        auto intersect = [&](int itri, dReal& ft) {
+            const Vector& v0 = mesh.vertices[mesh.indices[3*itri]];
+            const Vector& v1 = mesh.vertices[mesh.indices[3*itri+1]];
+            const Vector& v2 = mesh.vertices[mesh.indices[3*itri+2]];
+            dReal fttriangle;
+            if( IntersectTriangle(v0, v1, v2, vlocalorigin, vlocaldir, ft, fttriangle) ) {
+                ft = fttriangle;
+                ihittriangle = itri;
+            }
+            return false;
+        };
+        target.pmeshtree->tree.Traverse(vlocalorigin, ComputeInverseDirection(vlocaldir), fthit, intersect);
+        if( ihittriangle < 0 ) {
+            return false;
+        }
+        const Vector& v0 = mesh.vertices[mesh.indices[3*ihittriangle]];
+        const Vector& v1 = mesh.vertices[mesh.indices[3*ihittriangle+1]];
+        const Vector& v2 = mesh.vertices[mesh.indices[3*ihittriangle+2]];
+        vlocalnormal = (v1 - v0).cross(v2 - v0);
+        // the triangles are two-sided, so return the side facing the ray
+        if( vlocalnormal.dot3(vlocaldir) > 0 ) {
+            vlocalnormal = -vlocalnormal;
+        }
+        vlocalnormal.normalize3();
+        break;
+    }
+    default:
+        return false;
+    }
+
+    if( fthit < 0 || fthit > ftmax ) {
+        return false;
+    }
+    ftmax = fthit;
+    vnormal = target.tgeom.rotate(vlocalnormal);
+    return true;
+}
+
+} // end namespace fclrave
@@ -0,0 +1,165 @@
+// -*- coding: utf-8 -*-
+#ifndef OPENRAVE_FCL_RAYCASTER
+#define OPENRAVE_FCL_RAYCASTER
+
+namespace fclrave {
+
+/// \brief bounding volume hierarchy of axis aligned boxes used for casting rays
+class RayAABBTree
+{
+public:
+    /// \brief builds the tree over the boxes [vmins[i], vmaxs[i]]
+    void Build(const std::vector<Vector>& vmins, const std::vector<Vector>& vmaxs);
+
+    /// \brief calls intersect(primitiveindex, ftmax) for every primitive whose box the ray origin + t*dir, t in [0,ftmax] hits
+    ///
+    /// intersect reduces ftmax when it finds a closer hit and returns true to stop the traversal.
+    /// \param vinvdir the inverse of every component of the ray direction
+    template <typename IntersectFn>
+    void Traverse(const Vector& vorigin, const Vector& vinvdir, OpenRAVE::dReal& ftmax, IntersectFn& intersect) const
+    {
+        if( _vnodes.size() == 0 ) {
+            return;
+        }
+        int stack[64];
+        int nstack = 0;
+        stack[nstack++] = 0;
+        while( nstack > 0 ) {
+            const Node& node = _vnodes[stack[--nstack]];
+            if( !_IntersectBox(node.vmin, node.vmax, vorigin, vinvdir, ftmax) ) {
+                continue;
+            }
+            if( node.ncount > 0 ) {
+                for(int i = node.nfirst; i < node.nfirst + node.ncount; ++i) {
+                    if( intersect(_vprimitives[i], ftmax) ) {
+                        return;
+                    }
+                }
+            }
+            else if( nstack + 2 <= 64 ) {
+                stack[nstack++] = node.nfirst;
+                stack[nstack++] = node.nfirst + 1;
+            }
+        }
+    }
+
+    inline bool IsEmpty() const {
+        return _vnodes.size() == 0;
+    }
+
+private:
+    struct Node
+    {
+        Vector vmin, vmax;
+        int nfirst; ///< first primitive if a leaf, otherwise the index of the first child. The second child is nfirst+1
+        int ncount; ///< number of primitives, 0 for internal nodes
+    };
+
+    static inline bool _IntersectBox(const Vector& vmin, const Vector& vmax, const Vector& vorigin, const Vector& vinvdir, OpenRAVE::dReal ftmax)
+    {
+        OpenRAVE::dReal ftnear = 0, ftfar = ftmax;
+        for(int i = 0; i < 3; ++i) {
+            OpenRAVE::dReal t0 = (vmin[i] - vorigin[i])*vinvdir[i];
+            OpenRAVE::dReal t1 = (vmax[i] - vorigin[i])*vinvdir[i];
+            if( t0 > t1 ) {
+                std::swap(t0, t1);
+            }
+            ftnear = t0 > ftnear ? t0 : ftnear;
+            ftfar = t1 < ftfar ? t1 : ftfar;
+            if( ftnear > ftfar ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// \brief fills node nodeindex with the primitives [nfirst, nfirst+ncount) of _vprimitives and builds its children
+    void _Build(int nodeindex, int nfirst, int ncount, const std::vector<Vector>& vmins, const std::vector<Vector>& vmaxs, const std::vector<Vector>& vcenters, int ndepth);
+
+    std::vector<Node> _vnodes;
+    std::vector<int> _vprimitives; ///< primitive indices sorted so that every leaf references a contiguous range
+};
+
+/** \brief casts batches of rays against the geometries of the enabled links
+
+    fcl has no ray queries, so the caster intersects the rays with the collision geometries of the links directly: analytically
+    for boxes and spheres, and through a bounding volume hierarchy of the collision mesh for the rest. The geometries of a batch
+    are put into one bounding volume hierarchy, and large batches of rays are split across the process-wide threads of
+    utils::ParallelForChunks. The mesh hierarchies are cached between batches as long as the meshes are referenced by a geometry.
+
+    Usage: call AddLink or AddBody for the objects to check and then CastRays. The state of the bodies must not change until
+    CastRays returns.
+ */
+class FCLRayCaster
+{
+public:
+    FCLRayCaster();
+
+    /// \brief adds all the enabled links of the body
+    ///
+    /// \param geometrygroup if not empty and a link has the group, the geometries of the group are used instead of the current geometries
+    void AddBody(const KinBody& body, const std::string& geometrygroup);
+
+    /// \brief adds the link if it is enabled
+    void AddLink(const KinBody::Link& link, const std::string& geometrygroup);
+
+    /// \brief casts the rays against the added links, removes the added links, and returns the number of rays that hit something
+    ///
+    /// \param bAnyHit if true, every ray stops at its first hit instead of looking for the closest hit
+    int CastRays(const std::vector<RAY>& vrays, bool bAnyHit, std::vector<OpenRAVE::RayCollisionResult>& vresults);
+
+private:
+    /// \brief bounding volume hierarchy of the triangles of one mesh
+    struct MeshTree
+    {
+        boost::shared_ptr<const OpenRAVE::TriMesh> pmesh; ///< held so that the mesh is not modified or freed while the tree is cached
+        RayAABBTree tree;
+        Vector vmin, vmax; ///< bounds of the mesh
+    };
+
+    /// \brief one geometry of the batch
+    struct Target
+    {
+        enum TargetType
+        {
+            TT_Box = 0,
+            TT_Sphere = 1,
+            TT_Mesh = 2,
+        };
+
+        Transform tgeom; ///< geometry transform in the world
+        Transform tgeominv;
+        Vector vextents; ///< box half extents or sphere radius in x
+        const MeshTree* pmeshtree;
+        KinBody::LinkConstPtr plink;
+        TargetType type;
+    };
+
+    /// \brief adds the geometry to the batch targets
+    void _AddGeometry(const KinBody::GeometryInfo& info, const KinBody::LinkConstPtr& plink);
+
+    /// \brief returns the cached tree of the mesh, builds it if necessary
+    const MeshTree* _GetMeshTree(const boost::shared_ptr<const OpenRAVE::TriMesh>& pmesh);
+
+    /// \brief removes the trees of the meshes that are not referenced outside of the cache anymore
+    void _SweepMeshTrees();
+
+    /// \brief casts the rays [nbegin, nend)
+    int _CastRays(const std::vector<RAY>& vrays, size_t nbegin, size_t nend, bool bAnyHit, std::vector<OpenRAVE::RayCollisionResult>& vresults) const;
+
+    /// \brief intersects a ray in world coordinates with a target, returns true if the hit is closer than ftmax
+    ///
+    /// The ray is origin + t*dir for t in [0, ftmax]. On a hit, sets ftmax to the hit t and vnormal to the world normal.
+    bool _IntersectTarget(const Target& target, const Vector& vorigin, const Vector& vdir, OpenRAVE::dReal& ftmax, Vector& vnormal) const;
+
+    std::vector<Target> _vtargets;
+    RayAABBTree _targettree; ///< built every batch over the world boxes of _vtargets
+    std::vector<Vector> _vtargetmins, _vtargetmaxs; ///< cache
+    std::map<const OpenRAVE::TriMesh*, MeshTree> _mapMeshTrees; ///< trees of the meshes indexed by the mesh pointer, which is unique since every tree holds its mesh
+
+    int _nNumBatches; ///< number of batches since the last sweep of _mapMeshTrees
+};
+
+} // end namespace fclrave
+
+#endif
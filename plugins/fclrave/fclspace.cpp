@@ -2,6 +2,9 @@
 
 #include "fclspace.h"
 
+#include <mutex>
+#include <boost/functional/hash.hpp>
+
 namespace fclrave {
 
 template <class T>
@@ -14,6 +17,126 @@ CollisionGeometryPtr ConvertMeshToFCL(std::vector<fcl::Vec3f> const &points,std:
     return model;
 }
 
+/// \brief process-wide cache of the BVH models built from meshes, indexed by a hash of the mesh content
+///
+/// Identical meshes, including the copies held by cloned environments, share one BVH model. Models are immutable once built
+/// and kept only while some collision object references them. Only valid for the BV types whose fcl traversal never modifies
+/// the model: for AABB and kDOP, fcl writes the transformed vertices back into the model during mesh-mesh collision.
+template <class T>
+class BVHModelCache
+{
+public:
+    static CollisionGeometryPtr GetOrCreateModel(std::vector<fcl::Vec3f> const &points, std::vector<fcl::Triangle> const &triangles)
+    {
+        static BVHModelCache<T> s_cache;
+        return s_cache._GetOrCreateModel(points, triangles);
+    }
+
+private:
+    typedef std::multimap<std::size_t, std::weak_ptr< fcl::BVHModel<T> > > ModelMap;
+
+    BVHModelCache() : _nPruneSize(64) {
+    }
+
+    CollisionGeometryPtr _GetOrCreateModel(std::vector<fcl::Vec3f> const &points, std::vector<fcl::Triangle> const &triangles)
+    {
+        const std::size_t hash = _ComputeHash(points, triangles);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::shared_ptr< fcl::BVHModel<T> > model = _FindModel(hash, points, triangles);
+            if( !!model ) {
+                return model;
+            }
+        }
+
+        // build outside of the lock since it dominates the cost
+        std::shared_ptr< fcl::BVHModel<T> > const newmodel = make_shared<fcl::BVHModel<T> >();
+        newmodel->beginModel(triangles.size(), points.size());
+        newmodel->addSubModel(points, triangles);
+        newmodel->endModel();
+        newmodel->setUserData(nullptr);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        // another thread could have built the same mesh in the meantime
+        std::shared_ptr< fcl::BVHModel<T> > model = _FindModel(hash, points, triangles);
+        if( !!model ) {
+            return model;
+        }
+        if( _mapModels.size() >= _nPruneSize ) {
+            for(typename ModelMap::iterator it = _mapModels.begin(); it != _mapModels.end(); ) {
+                if( it->second.expired() ) {
+                    _mapModels.erase(it++);
+                }
+                else {
+                    ++it;
+                }
+            }
+            _nPruneSize = std::max(std::size_t(64), 2*_mapModels.size());
+        }
+        _mapModels.insert(std::make_pair(hash, std::weak_ptr< fcl::BVHModel<T> >(newmodel)));
+        return newmodel;
+    }
+
+    /// \brief has to be called with _mutex locked. Compares the full content so that hash collisions never share models
+    std::shared_ptr< fcl::BVHModel<T> > _FindModel(std::size_t hash, std::vector<fcl::Vec3f> const &points, std::vector<fcl::Triangle> const &triangles)
+    {
+        std::pair<typename ModelMap::iterator, typename ModelMap::iterator> range = _mapModels.equal_range(hash);
+        for(typename ModelMap::iterator it = range.first; it != range.second; ) {
+            std::shared_ptr< fcl::BVHModel<T> > model = it->second.lock();
+            if( !model ) {
+                _mapModels.erase(it++);
+                continue;
+            }
+            if( _IsSameMesh(*model, points, triangles) ) {
+                return model;
+            }
+            ++it;
+        }
+        return std::shared_ptr< fcl::BVHModel<T> >();
+    }
+
+    static bool _IsSameMesh(const fcl::BVHModel<T>& model, std::vector<fcl::Vec3f> const &points, std::vector<fcl::Triangle> const &triangles)
+    {
+        if( model.num_vertices != (int)points.size() || model.num_tris != (int)triangles.size() ) {
+            return false;
+        }
+        for(size_t ipoint = 0; ipoint < points.size(); ++ipoint) {
+            if( model.vertices[ipoint] != points[ipoint] ) {
+                return false;
+            }
+        }
+        for(size_t itri = 0; itri < triangles.size(); ++itri) {
+            const fcl::Triangle& tri = model.tri_indices[itri];
+            if( tri[0] != triangles[itri][0] || tri[1] != triangles[itri][1] || tri[2] != triangles[itri][2] ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static std::size_t _ComputeHash(std::vector<fcl::Vec3f> const &points, std::vector<fcl::Triangle> const &triangles)
+    {
+        std::size_t hash = 0;
+        boost::hash_combine(hash, points.size());
+        boost::hash_combine(hash, triangles.size());
+        for(const fcl::Vec3f& point : points) {
+            boost::hash_combine(hash, point[0]);
+            boost::hash_combine(hash, point[1]);
+            boost::hash_combine(hash, point[2]);
+        }
+        for(const fcl::Triangle& tri : triangles) {
+            boost::hash_combine(hash, tri[0]);
+            boost::hash_combine(hash, tri[1]);
+            boost::hash_combine(hash, tri[2]);
+        }
+        return hash;
+    }
+
+    ModelMap _mapModels; ///< weak references to the models, indexed by the content hash
+    std::size_t _nPruneSize; ///< when _mapModels reaches this size, expired entries are removed
+    std::mutex _mutex; ///< protects _mapModels
+};
+
 FCLSpace::FCLKinBodyInfo::FCLKinBodyInfo()
     : nLastStamp(0)
     , nLinkUpdateStamp(0)
@@ -114,7 +237,6 @@ FCLSpace::FCLKinBodyInfoPtr FCLSpace::InitKinBody(KinBodyConstPtr pbody, FCLKinB
                 if( !pfclgeom ) {
                     continue;
                 }
-                pfclgeom->setUserData(nullptr);
 
                 // We do not set the transformation here and leave it to _Synchronize
                 CollisionObjectPtr pfclcoll = boost::make_shared<fcl::CollisionObject>(pfclgeom);
@@ -142,8 +264,7 @@ FCLSpace::FCLKinBodyInfoPtr FCLSpace::InitKinBody(KinBodyConstPtr pbody, FCLKinB
                 }
                 boost::shared_ptr<FCLKinBodyInfo::FCLGeometryInfo> pfclgeominfo(new FCLKinBodyInfo::FCLGeometryInfo(pgeom));
                 pfclgeominfo->bodylinkgeomname = pbody->GetName() + "/" + plink->GetName() + "/" + pgeom->GetName();
-                pfclgeom->setUserData(pfclgeominfo.get());
-                // save the pointers
+                // save the pointers, the geometry info is looked up through the collision object since pfclgeom can be shared
                 linkinfo->vgeominfos.push_back(pfclgeominfo);
 
                 // We do not set the transformation here and leave it to _Synchronize
@@ -300,27 +421,35 @@ void FCLSpace::SetBVHRepresentation(std::string const &type)
     if (type == "AABB") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL<fcl::AABB>;
+        _sharedMeshFactory = _meshFactory;
     } else if (type == "OBB") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL<fcl::OBB>;
+        _sharedMeshFactory = &BVHModelCache<fcl::OBB>::GetOrCreateModel;
     } else if (type == "RSS") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL<fcl::RSS>;
+        _sharedMeshFactory = &BVHModelCache<fcl::RSS>::GetOrCreateModel;
     } else if (type == "OBBRSS") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL<fcl::OBBRSS>;
+        _sharedMeshFactory = &BVHModelCache<fcl::OBBRSS>::GetOrCreateModel;
     } else if (type == "kDOP16") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL< fcl::KDOP<16> >;
+        _sharedMeshFactory = _meshFactory;
     } else if (type == "kDOP18") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL< fcl::KDOP<18> >;
+        _sharedMeshFactory = _meshFactory;
     } else if (type == "kDOP24") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL< fcl::KDOP<24> >;
+        _sharedMeshFactory = _meshFactory;
     } else if (type == "kIOS") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL<fcl::kIOS>;
+        _sharedMeshFactory = &BVHModelCache<fcl::kIOS>::GetOrCreateModel;
     } else {
         RAVELOG_WARN(str(boost::format("Unknown BVH representation '%s', keeping '%s' representation") % type % _bvhRepresentation));
         return;
@@ -483,7 +612,7 @@ CollisionGeometryPtr FCLSpace::_CreateFCLGeomFromGeometryInfo(const KinBody::Geo
             fcl_triangles[itri] = fcl::Triangle(tri_indices[0], tri_indices[1], tri_indices[2]);
         }
 
-        return _meshFactory(fcl_points, fcl_triangles);
+        return _sharedMeshFactory(fcl_points, fcl_triangles);
     }
 
     default:
@@ -127,6 +127,20 @@ public:
                 return _plink.lock();
             }
 
+            /// \brief returns the info of the geometry of collObj, or nullptr if collObj does not come from a kinbody geometry.
+            ///
+            /// Mesh geometries are shared between bodies with identical meshes, so the info cannot be stored as the user data of the fcl geometry.
+            FCLGeometryInfo* GetGeometryInfo(const fcl::CollisionObject& collObj) const {
+                if( vgeominfos.size() == vgeoms.size() ) {
+                    for(size_t igeom = 0; igeom < vgeoms.size(); ++igeom) {
+                        if( vgeoms[igeom].second.get() == &collObj ) {
+                            return vgeominfos[igeom].get();
+                        }
+                    }
+                }
+                return nullptr;
+            }
+
             KinBody::LinkWeakPtr _plink;
             vector< boost::shared_ptr<FCLGeometryInfo> > vgeominfos; ///< info for every geometry of the link
 
@@ -320,7 +334,8 @@ private:
     //SynchronizeCallbackFn _synccallback;
 
     std::string _bvhRepresentation;
-    MeshFactory _meshFactory;
+    MeshFactory _meshFactory; ///< builds a new model for every call, used for temporary meshes
+    MeshFactory _sharedMeshFactory; ///< returns models shared process-wide between identical meshes when the BVH type allows it, used for the kinbody geometries
 
     std::vector<KinBodyConstPtr> _vecInitializedBodies; ///< vector of the kinbody initialized in this space. index is the environment body index. nullptr means uninitialized.
     std::vector<std::map< std::string, FCLKinBodyInfoPtr> > _cachedpinfo; ///< Associates to each body id and geometry group name the corresponding kinbody info if already initialized and not currently set as user data. Index of vector is the environment id. index 0 holds null pointer because kin bodies in the env should have positive index.
@@ -526,6 +526,17 @@ public:
             _listCollidingTransforms.emplace_back(t,  bcolliding);
         }
 
+        /// \brief prepares the checker for a new ik target
+        ///
+        /// Restores the end effector links that were disabled and clears the colliding transforms cached for the previous target. The saved link enable states and the collision callback are kept.
+        void ResetTarget(int filteroptions)
+        {
+            RestoreCheckEndEffectorEnvCollision();
+            _bCheckEndEffectorEnvCollision = !(filteroptions & IKFO_IgnoreEndEffectorEnvCollisions);
+            _listCollidingTransforms.clear();
+            numImpossibleSelfCollisions = 0;
+        }
+
         int numImpossibleSelfCollisions; ///< a count of the number of self-collisions that most likely mean that the IK itself will fail.
 protected:
         void _InitSavers()
@@ -718,6 +729,45 @@ protected:
         return vikreturns.size()>0;
     }
 
+    virtual int SolveAllBatch(const std::vector<IkParameterization>& vrawparams, int filteroptions, std::vector< std::vector<IkReturnPtr> >& vvikreturns)
+    {
+        vvikreturns.resize(vrawparams.size());
+        if( vrawparams.size() == 0 ) {
+            return 0;
+        }
+        // the state saver, the checker options and the end effector link savers are set up once for the whole batch
+        RobotBase::ManipulatorPtr pmanip(_pmanip);
+        RobotBasePtr probot = pmanip->GetRobot();
+        RobotBase::RobotStateSaver saver(probot);
+        probot->SetActiveDOFs(pmanip->GetArmIndices());
+        CollisionOptionsStateSaver optionstate(GetEnv()->GetCollisionChecker(),GetEnv()->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
+        StateCheckEndEffector stateCheck(probot,_vchildlinks,_vindependentlinks,filteroptions);
+        std::vector<IkReal> vfree(_vfreeparams.size());
+        IkParameterization ikparamdummy;
+        int numsolved = 0;
+        for(size_t iparam = 0; iparam < vrawparams.size(); ++iparam) {
+            std::vector<IkReturnPtr>& vikreturns = vvikreturns[iparam];
+            vikreturns.resize(0);
+            if( iparam > 0 ) {
+                // the previous pose leaves the arm at the last checked solution, so restore to start from the same state SolveAll would
+                stateCheck.ResetTarget(filteroptions);
+                saver.Restore();
+                probot->SetActiveDOFs(pmanip->GetArmIndices());
+            }
+            const IkParameterization& param = _ConvertIkParameterization(vrawparams[iparam], ikparamdummy);
+            IkReturnAction retaction = ComposeSolution(_vfreeparams, vfree, 0, vector<dReal>(), boost::bind(&IkFastSolver::_SolveAll,shared_solver(), boost::ref(param),boost::ref(vfree),filteroptions,boost::ref(vikreturns), boost::ref(stateCheck)), _vFreeInc);
+            if( retaction & IKRA_Quit ) {
+                vikreturns.resize(0);
+                continue;
+            }
+            _SortSolutions(probot, vikreturns);
+            if( vikreturns.size() > 0 ) {
+                ++numsolved;
+            }
+        }
+        return numsolved;
+    }
+
     virtual bool Solve(const IkParameterization& rawparam, const std::vector<dReal>& q0, const std::vector<dReal>& vFreeParameters, int filteroptions, IkReturnPtr ikreturn)
     {
         IkParameterization ikparamdummy;
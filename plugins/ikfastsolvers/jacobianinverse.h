@@ -368,7 +368,7 @@ public:
             _lasterror2 = totalerror2;
 
             // compute jacobians, make sure to transform by the world frame
-            manip.CalculateJacobian(_vjacobian);
+            _CalculateManipJacobianTranslation(manip);
             for(size_t j = 0; j < _viweights.size(); ++j) {
                 Vector v = Vector(_vjacobian[j],_vjacobian[armdof+j],_vjacobian[2*armdof+j]);
                 _J3d(0,j) = v[0]*_viweights[j];
@@ -577,6 +577,24 @@ public:
         return totalerror2;
     }
 
+    /// \brief computes the translation jacobian of the manipulator into _vjacobian. Shares the joint axes with _CalculateManipJacobianAxisAngle while the robot does not move
+    void _CalculateManipJacobianTranslation(const RobotBase::Manipulator& manip)
+    {
+        _vjacobian.resize(3*manip.GetArmDOF());
+        if( _vjacobian.size() > 0 ) {
+            manip.GetRobot()->ComputeJacobianTranslation(_kinematicsworkspace, manip.GetEndEffector()->GetIndex(), manip.GetTransform().trans, &_vjacobian[0], manip.GetArmIndices());
+        }
+    }
+
+    /// \brief computes the angular velocity jacobian of the manipulator into _vjacobian
+    void _CalculateManipJacobianAxisAngle(const RobotBase::Manipulator& manip)
+    {
+        _vjacobian.resize(3*manip.GetArmDOF());
+        if( _vjacobian.size() > 0 ) {
+            manip.GetRobot()->ComputeJacobianAxisAngle(_kinematicsworkspace, manip.GetEndEffector()->GetIndex(), &_vjacobian[0], manip.GetArmIndices());
+        }
+    }
+
     // Calculates jacobian depending on ikparameter type. jacobian and error vector has to be consistent
     virtual void _CalculateJacobian(const RobotBase::Manipulator& manip, const IkParameterization& ikp)
     {
@@ -584,14 +602,14 @@ public:
         switch (ikp.GetType()) {
         case IKP_Transform6D:
             {
-                manip.CalculateAngularVelocityJacobian(_vjacobian); // doesn't work well...
+                _CalculateManipJacobianAxisAngle(manip); // doesn't work well...
                 for(size_t j = 0; j < _viweights.size(); ++j) {
                     Vector v = Vector(_vjacobian[j],_vjacobian[armdof+j],_vjacobian[2*armdof+j]);
                     _J(0,j) = v[0]*_viweights[j];
                     _J(1,j) = v[1]*_viweights[j];
                     _J(2,j) = v[2]*_viweights[j];
                 }
-                manip.CalculateJacobian(_vjacobian);
+                _CalculateManipJacobianTranslation(manip);
                 for(size_t j = 0; j < _viweights.size(); ++j) {
                     Vector v = Vector(_vjacobian[j],_vjacobian[armdof+j],_vjacobian[2*armdof+j]);
                     _J(0+3,j) = v[0]*_viweights[j];
@@ -615,7 +633,7 @@ public:
                 // df/dh is -1 / sqrt(1-h^2) and
                 // dh/dq is cross product b/w joint axis and manipulator direction
 
-                manip.CalculateAngularVelocityJacobian(_vjacobian);
+                _CalculateManipJacobianAxisAngle(manip);
                 for(size_t j = 0; j < _viweights.size(); ++j) {
                     // better to get joint axis from angular jacobian than, directly getting it from joint->getaxis to handle prismatic joint properly
                     const Vector jointAxis = Vector(_vjacobian[j],_vjacobian[armdof+j],_vjacobian[2*armdof+j]);
@@ -638,7 +656,7 @@ public:
                 }
             
                 // position part
-                manip.CalculateJacobian(_vjacobian);
+                _CalculateManipJacobianTranslation(manip);
                 for(size_t j = 0; j < _viweights.size(); ++j) {
                     Vector v = Vector(_vjacobian[j],_vjacobian[armdof+j],_vjacobian[2*armdof+j]);
                     _J(0+1,j) = v[0]*_viweights[j];
@@ -694,6 +712,7 @@ protected:
     std::vector<dReal> _viweights, _vcachevalues;
     T _errorthresh2;
     std::vector<dReal> _vjacobian;
+    KinBody::KinematicsWorkspace _kinematicsworkspace; ///< joint axes of the current configuration, shared by the jacobians
     boost::numeric::ublas::matrix<T> _J, _Jt, _invJJt, _invJ, _error, _qdelta;
 
     boost::numeric::ublas::matrix<T> _J3d, _Jt3d, _invJJt3d, _invJ3d, _error3d; // for translation
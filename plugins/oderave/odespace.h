@@ -648,18 +648,18 @@ private:
         case OpenRAVE::GT_Cage:
         case OpenRAVE::GT_CalibrationBoard: // calibration board is box-shaped but has z-offset. so have to use trimesh.
         case OpenRAVE::GT_TriMesh:
-            if( info._meshcollision.indices.size() > 0 ) {
-                dTriIndex* pindices = new dTriIndex[info._meshcollision.indices.size()];
-                for(size_t i = 0; i < info._meshcollision.indices.size(); ++i) {
-                    pindices[i] = info._meshcollision.indices[i];
+            if( info._meshcollision->indices.size() > 0 ) {
+                dTriIndex* pindices = new dTriIndex[info._meshcollision->indices.size()];
+                for(size_t i = 0; i < info._meshcollision->indices.size(); ++i) {
+                    pindices[i] = info._meshcollision->indices[i];
                 }
-                dReal* pvertices = new dReal[4*info._meshcollision.vertices.size()];
-                for(size_t i = 0; i < info._meshcollision.vertices.size(); ++i) {
-                    Vector v = info._meshcollision.vertices[i];
+                dReal* pvertices = new dReal[4*info._meshcollision->vertices.size()];
+                for(size_t i = 0; i < info._meshcollision->vertices.size(); ++i) {
+                    Vector v = info._meshcollision->vertices[i];
                     pvertices[4*i+0] = v.x; pvertices[4*i+1] = v.y; pvertices[4*i+2] = v.z;
                 }
                 dTriMeshDataID id = dGeomTriMeshDataCreate();
-                dGeomTriMeshDataBuildSimple(id, pvertices, info._meshcollision.vertices.size(), pindices, info._meshcollision.indices.size());
+                dGeomTriMeshDataBuildSimple(id, pvertices, info._meshcollision->vertices.size(), pindices, info._meshcollision->indices.size());
                 odegeom = dCreateTriMesh(0, id, NULL, NULL, NULL);
                 link->listtrimeshinds.push_back(pindices);
                 link->listvertices.push_back(pvertices);
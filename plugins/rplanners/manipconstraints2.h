@@ -228,8 +228,10 @@ public:
             Transform tlink = itmanipinfo->plink->GetTransform();
 
             // compute jacobians, make sure to transform by the world frame
-            probot->CalculateAngularVelocityJacobian(itmanipinfo->plink->GetIndex(), _vangularjacobian);
-            probot->CalculateJacobian(itmanipinfo->plink->GetIndex(), tlink.trans, _vtransjacobian);
+            _vangularjacobian.resize(3*probot->GetDOF());
+            _vtransjacobian.resize(3*probot->GetDOF());
+            probot->ComputeJacobianAxisAngle(_kinematicsworkspace, itmanipinfo->plink->GetIndex(), _vangularjacobian.data());
+            probot->ComputeJacobianTranslation(_kinematicsworkspace, itmanipinfo->plink->GetIndex(), tlink.trans, _vtransjacobian.data());
 
             // checking for each point is too slow, so use fmaxdistfromcenter instead
             // FOREACH(itpoint,itmanipinfo->checkpoints)
@@ -956,6 +958,7 @@ private:
     std::vector<dReal> _afill; // full robot DOF
     std::vector<std::pair<Vector,Vector> > endeffvels, endeffaccs;
     std::vector<dReal> _vtransjacobian, _vangularjacobian, _vbestvels2, _vbestaccels2;
+    KinBody::KinematicsWorkspace _kinematicsworkspace; ///< joint axes of the current configuration, shared by the jacobians
     std::vector<dReal> _vdotproducts, _vscalingfactors, _vdofvalues, _vdofvelocities, _vdofaccelerations;
     std::vector<int> _vindices;
 //@}
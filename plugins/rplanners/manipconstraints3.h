@@ -217,8 +217,10 @@ public:
             Transform tlink = itmanipinfo->plink->GetTransform();
 
             // compute jacobians, make sure to transform by the world frame
-            probot->CalculateAngularVelocityJacobian(itmanipinfo->plink->GetIndex(), _vangularjacobian);
-            probot->CalculateJacobian(itmanipinfo->plink->GetIndex(), tlink.trans, _vtransjacobian);
+            _vangularjacobian.resize(3*probot->GetDOF());
+            _vtransjacobian.resize(3*probot->GetDOF());
+            probot->ComputeJacobianAxisAngle(_kinematicsworkspace, itmanipinfo->plink->GetIndex(), _vangularjacobian.data());
+            probot->ComputeJacobianTranslation(_kinematicsworkspace, itmanipinfo->plink->GetIndex(), tlink.trans, _vtransjacobian.data());
 
             int armdof = itmanipinfo->pmanip->GetArmDOF();
 
@@ -503,6 +505,7 @@ private:
     Vector _cacheEEVelLin, _cacheEEVelAng, _cacheEEAccelLin, _cacheEEAccelAng, _cacheCheckPoint, _cacheManipSpeed, _cacheManipAccel;
     Transform _cacheManipTransform;
     std::vector<dReal> _vtransjacobian, _vangularjacobian, _vbestvels2, _vbestaccels2;
+    KinBody::KinematicsWorkspace _kinematicsworkspace; ///< joint axes of the current configuration, shared by the jacobians
     std::vector<dReal> _vdofvalues, _vdofvelocities, _vdofaccelerations;
     std::vector<PiecewisePolynomialsInternal::Coordinate> _vcoords1, _vcoords2;
     //@}
@@ -20,6 +20,8 @@
 #include "openraveplugindefs.h"
 
 #include <boost/pool/pool.hpp>
+#include <atomic>
+#include <mutex>
 
 #define _(msgid) OpenRAVE::RaveGetLocalizedTextForDomain("openrave_plugins_rplanners", msgid)
 
@@ -159,6 +161,7 @@ public:
         _maxlevel = 0;
         _minlevel = 0;
         _fMaxLevelBound = 0;
+        _nFlatCapacity = 0;
     }
 
     ~SpatialTree() {
@@ -180,6 +183,10 @@ public:
         _planner = planner;
         _distmetricfn = distmetricfn;
         _fStepLength = fStepLength;
+        if( _dof != dof ) {
+            _vFlatConfigs.resize(0);
+            _nFlatCapacity = 0;
+        }
         _dof = dof;
         _vNewConfig.resize(dof);
         _vDeltaConfig.resize(dof);
@@ -194,6 +201,13 @@ public:
             _vsetLevelNodes.resize(enclevel+1);
         }
         _constraintreturn.reset(new ConstraintFilterReturn());
+
+        // if the metric is a plain weighted euclidean distance, compute it inline and search the nearest neighbor in the flat index
+        _vweights2.resize(0);
+        const planningutils::SimpleDistanceMetric* pmetric = distmetricfn.target<planningutils::SimpleDistanceMetric>();
+        if( !pmetric || !pmetric->GetEuclideanWeights2(_vweights2) || (int)_vweights2.size() != dof ) {
+            _vweights2.resize(0);
+        }
     }
 
     virtual void Reset()
@@ -212,23 +226,43 @@ public:
             _pNodesPool.reset(new boost::pool<>(sizeof(Node)+_dof*sizeof(dReal)));
         }
         _numnodes = 0;
+        _vFlatNodes.resize(0);
     }
 
     inline dReal _ComputeDistance(const dReal* config0, const dReal* config1) const
     {
+        if( _vweights2.size() > 0 ) {
+            return _ComputeEuclideanDistance(config0, config1);
+        }
         return _distmetricfn(VectorWrapper<dReal>(config0, config0+_dof), VectorWrapper<dReal>(config1, config1+_dof));
     }
 
     inline dReal _ComputeDistance(const dReal* config0, const std::vector<dReal>& config1) const
     {
+        if( _vweights2.size() > 0 ) {
+            return _ComputeEuclideanDistance(config0, config1.data());
+        }
         return _distmetricfn(VectorWrapper<dReal>(config0,config0+_dof), config1);
     }
 
     inline dReal _ComputeDistance(NodePtr node0, NodePtr node1) const
     {
+        if( _vweights2.size() > 0 ) {
+            return _ComputeEuclideanDistance(node0->q, node1->q);
+        }
         return _distmetricfn(VectorWrapper<dReal>(node0->q, &node0->q[_dof]), VectorWrapper<dReal>(node1->q, &node1->q[_dof]));
     }
 
+    inline dReal _ComputeEuclideanDistance(const dReal* config0, const dReal* config1) const
+    {
+        dReal fdist2 = 0;
+        for(int idof = 0; idof < _dof; ++idof) {
+            const dReal fdelta = config0[idof] - config1[idof];
+            fdist2 += _vweights2[idof]*fdelta*fdelta;
+        }
+        return RaveSqrt(fdist2);
+    }
+
     std::pair<NodeBasePtr, dReal> FindNearestNode(const std::vector<dReal>& vquerystate) const
     {
         return _FindNearestNode(vquerystate);
@@ -667,6 +701,9 @@ private:
             return bestnode;
         }
         OPENRAVE_ASSERT_OP((int)vquerystate.size(),==,_dof);
+        if( _vweights2.size() > 0 ) {
+            return _FindNearestNodeFlat(vquerystate);
+        }
 
         int currentlevel = _maxlevel; // where the root node is
         // traverse all levels gathering up the children at each level
@@ -709,6 +746,87 @@ private:
         return bestnode;
     }
 
+    /// \brief brute-force nearest neighbor over the flat index with the inline weighted euclidean metric
+    ///
+    /// Distances of a batch of nodes are accumulated one dof at a time over the contiguous values, so the inner loops vectorize.
+    std::pair<NodePtr, dReal> _FindNearestNodeFlat(const std::vector<dReal>& vquerystate) const
+    {
+        static const int s_nBatchSize = 256;
+        dReal vdist2[s_nBatchSize];
+        std::pair<NodePtr, dReal> bestnode(NULL, std::numeric_limits<dReal>::infinity()), bestanynode(NULL, std::numeric_limits<dReal>::infinity());
+        const int numflatnodes = (int)_vFlatNodes.size();
+        for(int ibatch = 0; ibatch < numflatnodes; ibatch += s_nBatchSize) {
+            const int nbatch = std::min(s_nBatchSize, numflatnodes - ibatch);
+            std::fill(vdist2, vdist2 + nbatch, dReal(0));
+            for(int idof = 0; idof < _dof; ++idof) {
+                const dReal* pvalues = &_vFlatConfigs[idof*_nFlatCapacity + ibatch];
+                const dReal fquery = vquerystate[idof];
+                const dReal fweight2 = _vweights2[idof];
+                for(int i = 0; i < nbatch; ++i) {
+                    const dReal fdelta = pvalues[i] - fquery;
+                    vdist2[i] += fweight2*fdelta*fdelta;
+                }
+            }
+            for(int i = 0; i < nbatch; ++i) {
+                if( vdist2[i] < bestnode.second ) {
+                    NodePtr node = _vFlatNodes[ibatch + i];
+                    if( node->_usenn ) {
+                        bestnode.first = node;
+                        bestnode.second = vdist2[i];
+                    }
+                    else if( vdist2[i] < bestanynode.second ) {
+                        bestanynode.first = node;
+                        bestanynode.second = vdist2[i];
+                    }
+                }
+            }
+        }
+        if( !bestnode.first ) {
+            // all nodes are invalidated, so still return the closest one like the cover tree search
+            bestnode = bestanynode;
+        }
+        bestnode.second = RaveSqrt(bestnode.second);
+        return bestnode;
+    }
+
+    /// \brief adds node to the flat index, which stores the configurations of all inserted nodes as contiguous arrays for every dof
+    void _AddToFlatIndex(NodePtr node)
+    {
+        if( _vweights2.size() == 0 ) {
+            return;
+        }
+        const int numflatnodes = (int)_vFlatNodes.size();
+        if( numflatnodes >= _nFlatCapacity ) {
+            const int newcapacity = std::max(1024, 2*_nFlatCapacity);
+            std::vector<dReal> vnewconfigs(newcapacity*_dof);
+            for(int idof = 0; idof < _dof && numflatnodes > 0; ++idof) {
+                std::copy(_vFlatConfigs.begin() + idof*_nFlatCapacity, _vFlatConfigs.begin() + idof*_nFlatCapacity + numflatnodes, vnewconfigs.begin() + idof*newcapacity);
+            }
+            _vFlatConfigs.swap(vnewconfigs);
+            _nFlatCapacity = newcapacity;
+        }
+        for(int idof = 0; idof < _dof; ++idof) {
+            _vFlatConfigs[idof*_nFlatCapacity + numflatnodes] = node->q[idof];
+        }
+        _vFlatNodes.push_back(node);
+    }
+
+    void _RemoveFromFlatIndex(NodePtr node)
+    {
+        typename std::vector<NodePtr>::iterator itnode = std::find(_vFlatNodes.begin(), _vFlatNodes.end(), node);
+        if( itnode == _vFlatNodes.end() ) {
+            return;
+        }
+        // move the last node into the freed slot
+        const int index = (int)(itnode - _vFlatNodes.begin());
+        const int lastindex = (int)_vFlatNodes.size() - 1;
+        for(int idof = 0; idof < _dof; ++idof) {
+            _vFlatConfigs[idof*_nFlatCapacity + index] = _vFlatConfigs[idof*_nFlatCapacity + lastindex];
+        }
+        *itnode = _vFlatNodes.back();
+        _vFlatNodes.pop_back();
+    }
+
     NodePtr _InsertNode(NodePtr parent, const vector<dReal>& config, uint32_t userdata)
     {
         NodePtr newnode = _CreateNode(parent, config, userdata);
@@ -735,6 +853,7 @@ private:
                 return NodePtr();
             }
         }
+        _AddToFlatIndex(newnode);
         //BOOST_ASSERT(Validate());
         return newnode;
     }
@@ -921,6 +1040,7 @@ private:
         _vvCacheNodes.at(0).push_back(proot);
         bool bRemoved = _Remove(removenode, _vvCacheNodes, _maxlevel, _fMaxLevelBound);
         if( bRemoved ) {
+            _RemoveFromFlatIndex(removenode);
             _DeleteNode(removenode);
         }
         if( removenode == proot ) {
@@ -928,6 +1048,7 @@ private:
             BOOST_ASSERT(_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).size()==1);
             //_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).clear();
             _vsetLevelNodes.at(_EncodeLevel(_maxlevel)).erase(proot);
+            _RemoveFromFlatIndex(proot);
             bRemoved = true;
             _numnodes--;
         }
@@ -1077,6 +1198,171 @@ private:
 
     mutable std::vector< std::pair<NodePtr, dReal> > _vCurrentLevelNodes, _vNextLevelNodes;
     mutable std::vector< std::vector<NodePtr> > _vvCacheNodes;
+
+    // flat nearest neighbor index, only used when _vweights2 is set
+    std::vector<dReal> _vweights2; ///< if not empty, _distmetricfn is the weighted euclidean distance with these squared weights
+    std::vector<NodePtr> _vFlatNodes; ///< all inserted nodes (without the cover tree clones)
+    std::vector<dReal> _vFlatConfigs; ///< _vFlatConfigs[idof*_nFlatCapacity + i] is the idof value of _vFlatNodes[i]
+    int _nFlatCapacity; ///< number of nodes _vFlatConfigs has space for
+};
+
+/// \brief tree of configurations that several threads can extend at the same time
+///
+/// Nodes are only appended and never move, so they are read without any locks while other threads insert. Inserting is
+/// serialized with a mutex and a node becomes visible once the node count is published. The nodes are stored in
+/// fixed-size blocks allocated on demand; the table of blocks is allocated once so readers never see it reallocate.
+/// Like the flat index of SpatialTree, the nearest neighbor is a linear scan done by the thread querying.
+class ConcurrentSpatialTree
+{
+public:
+    typedef boost::function<dReal(const std::vector<dReal>&, const std::vector<dReal>&)> DistMetricFn;
+
+    ConcurrentSpatialTree() : _dof(0), _numnodes(0) {
+    }
+
+    /// \param vweights2 if not empty, the distance metric is the weighted euclidean distance with these squared weights
+    void Init(int dof, const std::vector<dReal>& vweights2)
+    {
+        Reset();
+        _dof = dof;
+        _vweights2 = vweights2;
+        if( _vblocks.size() == 0 ) {
+            _vblocks.resize(s_nMaxBlocks);
+        }
+    }
+
+    /// \brief removes all nodes, no other thread can access the tree at the same time
+    void Reset()
+    {
+        _numnodes.store(0, std::memory_order_release);
+    }
+
+    /// \brief adds a node and returns its index, or -1 if the tree is full
+    ///
+    /// \param parent index of the parent node, -1 for a root
+    /// \param rootindex the userdata of the root, inherited from the parent if this is not a root
+    int InsertNode(int parent, const dReal* pconfig, uint32_t rootindex)
+    {
+        std::lock_guard<std::mutex> lock(_mutexinsert);
+        const int index = _numnodes.load(std::memory_order_relaxed);
+        const int iblock = index >> s_nBlockSizeLog2;
+        if( iblock >= (int)_vblocks.size() ) {
+            return -1;
+        }
+        if( !_vblocks[iblock] ) {
+            _vblocks[iblock].reset(new Block(_dof));
+        }
+        Block& block = *_vblocks[iblock];
+        const int ioffset = index & (s_nBlockSize-1);
+        std::copy(pconfig, pconfig+_dof, block.vconfigs.begin() + ioffset*_dof);
+        block.vparents[ioffset] = parent;
+        block.vrootindices[ioffset] = parent >= 0 ? GetRootIndex(parent) : rootindex;
+        block.vusenn[ioffset].store(parent >= 0 ? GetUseNN(parent) : 1, std::memory_order_relaxed);
+        _numnodes.store(index+1, std::memory_order_release); // publish
+        return index;
+    }
+
+    inline int GetNumNodes() const {
+        return _numnodes.load(std::memory_order_acquire);
+    }
+
+    inline const dReal* GetConfig(int index) const {
+        return &_vblocks[index >> s_nBlockSizeLog2]->vconfigs[(index & (s_nBlockSize-1))*_dof];
+    }
+
+    inline void GetConfig(int index, std::vector<dReal>& v) const {
+        const dReal* pconfig = GetConfig(index);
+        v.resize(_dof);
+        std::copy(pconfig, pconfig+_dof, v.begin());
+    }
+
+    inline int GetParent(int index) const {
+        return _vblocks[index >> s_nBlockSizeLog2]->vparents[index & (s_nBlockSize-1)];
+    }
+
+    inline uint32_t GetRootIndex(int index) const {
+        return _vblocks[index >> s_nBlockSizeLog2]->vrootindices[index & (s_nBlockSize-1)];
+    }
+
+    inline uint8_t GetUseNN(int index) const {
+        return _vblocks[index >> s_nBlockSizeLog2]->vusenn[index & (s_nBlockSize-1)].load(std::memory_order_relaxed);
+    }
+
+    /// \brief excludes all the nodes grown from the root with rootindex from the nearest neighbor search
+    void InvalidateNodesWithRoot(uint32_t rootindex)
+    {
+        std::lock_guard<std::mutex> lock(_mutexinsert); // so that new children see the flag of their parent
+        const int numnodes = _numnodes.load(std::memory_order_relaxed);
+        for(int index = 0; index < numnodes; ++index) {
+            Block& block = *_vblocks[index >> s_nBlockSizeLog2];
+            const int ioffset = index & (s_nBlockSize-1);
+            if( block.vrootindices[ioffset] == rootindex ) {
+                block.vusenn[ioffset].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// \brief returns the index of the node closest to vquerystate and its distance, -1 if there are no nodes
+    ///
+    /// \param distmetricfn the metric of the calling thread, only used when the tree has no euclidean weights
+    std::pair<int, dReal> FindNearestNode(const std::vector<dReal>& vquerystate, const DistMetricFn& distmetricfn) const
+    {
+        std::pair<int, dReal> bestnode(-1, std::numeric_limits<dReal>::infinity());
+        const int numnodes = GetNumNodes();
+        for(int index = 0; index < numnodes; ++index) {
+            const Block& block = *_vblocks[index >> s_nBlockSizeLog2];
+            const int ioffset = index & (s_nBlockSize-1);
+            if( !block.vusenn[ioffset].load(std::memory_order_relaxed) ) {
+                continue;
+            }
+            const dReal* pconfig = &block.vconfigs[ioffset*_dof];
+            dReal fdist;
+            if( _vweights2.size() > 0 ) {
+                dReal fdist2 = 0;
+                for(int idof = 0; idof < _dof && fdist2 < bestnode.second; ++idof) {
+                    const dReal fdelta = pconfig[idof] - vquerystate[idof];
+                    fdist2 += _vweights2[idof]*fdelta*fdelta;
+                }
+                fdist = fdist2; // compare squared distances
+            }
+            else {
+                fdist = distmetricfn(VectorWrapper<dReal>(pconfig, pconfig+_dof), vquerystate);
+            }
+            if( fdist < bestnode.second ) {
+                bestnode.first = index;
+                bestnode.second = fdist;
+            }
+        }
+        if( bestnode.first >= 0 && _vweights2.size() > 0 ) {
+            bestnode.second = RaveSqrt(bestnode.second);
+        }
+        return bestnode;
+    }
+
+    inline int GetDOF() const {
+        return _dof;
+    }
+
+private:
+    static const int s_nBlockSizeLog2 = 10;
+    static const int s_nBlockSize = 1<<s_nBlockSizeLog2;
+    static const int s_nMaxBlocks = 1<<14; ///< at most 16M nodes
+
+    struct Block
+    {
+        Block(int dof) : vconfigs(s_nBlockSize*dof) {
+        }
+        std::vector<dReal> vconfigs; ///< dof values of every node
+        int vparents[s_nBlockSize];
+        uint32_t vrootindices[s_nBlockSize];
+        std::atomic<uint8_t> vusenn[s_nBlockSize]; ///< if 0, the node is ignored by the nearest neighbor search
+    };
+
+    int _dof;
+    std::vector<dReal> _vweights2;
+    std::vector< std::unique_ptr<Block> > _vblocks; ///< never resized after Init
+    std::atomic<int> _numnodes; ///< number of published nodes
+    std::mutex _mutexinsert;
 };
 
 #ifdef RAVE_REGISTER_BOOST
@@ -18,6 +18,8 @@
 
 #include "rplanners.h"
 #include <boost/algorithm/string.hpp>
+#include <condition_variable>
+#include <thread>
 
 static const dReal g_fEpsilonDotProduct = RavePow(g_fEpsilon,0.8);
 
@@ -280,9 +282,16 @@ Some python code to display data::\n\
   robot.SetActiveDOFValues(sourcetree[argmin(sourcedist)])\n\
 \n\
 ");
+        RegisterCommand("GetNumPlanningThreads", boost::bind(&BirrtPlanner::_GetNumPlanningThreadsCommand,this,_1,_2),
+                        "returns the number of threads the last PlanPath call grew the trees with, 1 if it did not plan in parallel");
         _nValidGoals = 0;
+        _nPlanningThreads = 0;
+        _nParallelFinishedWorkers = 0;
     }
     virtual ~BirrtPlanner() {
+        FOREACH(itworker, _vparallelworkers) {
+            (*itworker)->penv->Destroy();
+        }
     }
 
     struct GOALPATH
@@ -376,6 +385,12 @@ Some python code to display data::\n\
         PlannerParameters::StateSaver savestate(_parameters);
         CollisionOptionsStateSaver optionstate(GetEnv()->GetCollisionChecker(),GetEnv()->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
 
+        _nPlanningThreads = 1;
+        if( _parameters->_nNumThreads > 1 && _InitParallelWorkers(_parameters->_nNumThreads) ) {
+            _nPlanningThreads = _parameters->_nNumThreads;
+            return _PlanPathParallel(ptraj, constraintFilterOptions, basetimeus);
+        }
+
         SpatialTreeBase* TreeA = &_treeForward;
         SpatialTreeBase* TreeB = &_treeBackward;
         NodeBase* iConnectedA=NULL, *iConnectedB=NULL;
@@ -520,9 +535,15 @@ Some python code to display data::\n\
             progress._iteration = iter/3;
         }
 
+        return _ProcessGoalPaths(ptraj, basetimeus, iter/3);
+    }
+
+    /// \brief chooses the shortest of the found goal paths and writes it to ptraj
+    PlannerStatus _ProcessGoalPaths(TrajectoryBasePtr ptraj, uint64_t basetimeus, int numiterations)
+    {
         if( _vgoalpaths.size() == 0 ) {
             uint64_t elapsedtimeus = utils::GetMonotonicTime()-basetimeus;
-            std::string description = str(boost::format(_("env=%s, plan failed in %u[us], iter=%d, nMaxIterations=%d"))%GetEnv()->GetNameId()%(elapsedtimeus)%(iter/3)%_parameters->_nMaxIterations);
+            std::string description = str(boost::format(_("env=%s, plan failed in %u[us], iter=%d, nMaxIterations=%d"))%GetEnv()->GetNameId()%(elapsedtimeus)%numiterations%_parameters->_nMaxIterations);
             RAVELOG_WARN(description);
             return OPENRAVE_PLANNER_STATUS(description, PS_Failed);
         }
@@ -540,7 +561,7 @@ Some python code to display data::\n\
         }
         ptraj->Insert(ptraj->GetNumWaypoints(), itbest->qall, _parameters->_configurationspecification);
         uint64_t elapsedtimeus = utils::GetMonotonicTime()-basetimeus;
-        std::string description = str(boost::format(_("env=%s, plan success, iters=%d, path=%d points, computation time=%u[us]\n"))%GetEnv()->GetNameId()%progress._iteration%ptraj->GetNumWaypoints()%(elapsedtimeus));
+        std::string description = str(boost::format(_("env=%s, plan success, iters=%d, path=%d points, computation time=%u[us]\n"))%GetEnv()->GetNameId()%numiterations%ptraj->GetNumWaypoints()%(elapsedtimeus));
         RAVELOG_DEBUG(description);
         PlannerStatus status = _ProcessPostPlanners(_robot,ptraj);
         //TODO should use accessor to change description
@@ -631,6 +652,13 @@ Some python code to display data::\n\
             pbackward = pbackward->rrtparent;
         }
 
+        _FinishGoalPath(goalpath);
+    }
+
+    /// \brief optimizes the path in _cachedpath, copies it to goalpath and computes its length
+    void _FinishGoalPath(GOALPATH& goalpath)
+    {
+        const int dof = _parameters->GetDOF();
         BOOST_ASSERT( goalpath.goalindex >= 0 && goalpath.goalindex < (int)_vecGoalNodes.size() );
         _SimpleOptimizePath(_cachedpath,10);
         goalpath.qall.resize(_cachedpath.size());
@@ -652,10 +680,380 @@ Some python code to display data::\n\
         }
     }
 
+    /// \brief joins the two trees of the parallel planner at the given nodes
+    void _ExtractParallelPath(GOALPATH& goalpath, int iConnectedForward, int iConnectedBackward)
+    {
+        const int dof = _parameters->GetDOF();
+        _cachedpath.resize(0);
+        goalpath.startindex = -1;
+        for(int inode = iConnectedForward; inode >= 0; inode = _paralleltreeforward.GetParent(inode)) {
+            const dReal* pconfig = _paralleltreeforward.GetConfig(inode);
+            _cachedpath.insert(_cachedpath.begin(), pconfig, pconfig+dof);
+            goalpath.startindex = _paralleltreeforward.GetRootIndex(inode);
+        }
+        goalpath.goalindex = -1;
+        for(int inode = iConnectedBackward; inode >= 0; inode = _paralleltreebackward.GetParent(inode)) {
+            const dReal* pconfig = _paralleltreebackward.GetConfig(inode);
+            _cachedpath.insert(_cachedpath.end(), pconfig, pconfig+dof);
+            goalpath.goalindex = _paralleltreebackward.GetRootIndex(inode);
+        }
+        _FinishGoalPath(goalpath);
+    }
+
+    /// \brief state of a thread of the parallel planner. Kept between plans so that the cloned environment only has to be synchronized.
+    struct ParallelWorker
+    {
+        EnvironmentBasePtr penv; ///< clone of the planner environment, only used by this worker
+        RRTParametersPtr parameters; ///< functions set up for penv
+        SpaceSamplerBasePtr puniformsampler;
+        ConstraintFilterReturnPtr constraintreturn;
+        std::vector<dReal> vsample, vtarget, vcurconfig, vnewconfig, vdeltaconfig;
+    };
+    typedef boost::shared_ptr<ParallelWorker> ParallelWorkerPtr;
+
+    /// \brief nodes of the forward and backward trees that a worker connected
+    struct ParallelConnection
+    {
+        int iforward, ibackward;
+    };
+
+    /// \brief prepares numthreads workers for the current parameters, returns false if the planner has to run on a single thread
+    bool _InitParallelWorkers(int numthreads)
+    {
+        if( !_robot ) {
+            return false;
+        }
+        if( !_parameters->HasDefaultConfigurationFunctions() ) {
+            // the workers set up the default functions for their cloned environments, so user functions would be silently replaced
+            RAVELOG_INFO_FORMAT("env=%s, parameters have custom configuration functions, planning on a single thread", GetEnv()->GetNameId());
+            return false;
+        }
+        if( !_parameters->HasDefaultDistanceFunctions() ) {
+            // same for the distance metric and the state difference the workers extend with
+            RAVELOG_INFO_FORMAT("env=%s, parameters have a custom distance metric or state difference, planning on a single thread", GetEnv()->GetNameId());
+            return false;
+        }
+        try {
+            if( (int)_vparallelworkers.size() > numthreads ) {
+                for(size_t iworker = numthreads; iworker < _vparallelworkers.size(); ++iworker) {
+                    _vparallelworkers[iworker]->penv->Destroy();
+                }
+            }
+            _vparallelworkers.resize(numthreads);
+            for(int iworker = 0; iworker < numthreads; ++iworker) {
+                ParallelWorkerPtr& pworker = _vparallelworkers[iworker];
+                if( !pworker ) {
+                    pworker.reset(new ParallelWorker());
+                    pworker->penv = GetEnv()->CloneSelf(Clone_Bodies);
+                    pworker->constraintreturn.reset(new ConstraintFilterReturn());
+                }
+                else {
+                    pworker->penv->Clone(GetEnv(), Clone_Bodies);
+                }
+                EnvironmentLock lockworker(pworker->penv->GetMutex());
+                RobotBasePtr probot = pworker->penv->GetRobot(_robot->GetName());
+                if( !probot ) {
+                    RAVELOG_WARN_FORMAT("env=%s, robot %s is not in the cloned environment, planning on a single thread", GetEnv()->GetNameId()%_robot->GetName());
+                    return false;
+                }
+                probot->SetActiveDOFs(_robot->GetActiveDOFIndices(), _robot->GetAffineDOF(), _robot->GetAffineRotationAxis());
+                pworker->parameters.reset(new RRTParameters());
+                pworker->parameters->copy(_parameters);
+                pworker->parameters->SetConfigurationSpecification(pworker->penv, _parameters->_configurationspecification);
+
+                // every worker has its own deterministic seed
+                const uint32_t seed = _parameters->_nRandomGeneratorSeed*(uint32_t)numthreads + iworker + 1;
+                FOREACH(itsampler, pworker->parameters->_listInternalSamplers) {
+                    (*itsampler)->SetSeed(seed);
+                }
+                if( !pworker->puniformsampler ) {
+                    pworker->puniformsampler = RaveCreateSpaceSampler(pworker->penv, "mt19937");
+                }
+                pworker->puniformsampler->SetSeed(seed);
+            }
+        }
+        catch(const openrave_exception& ex) {
+            RAVELOG_WARN_FORMAT("env=%s, failed to set up the parallel planner, planning on a single thread: %s", GetEnv()->GetNameId()%ex.what());
+            return false;
+        }
+        return true;
+    }
+
+    /// \brief extends the trees from several threads, the environment is locked and its state saved by the caller
+    ///
+    /// Every worker claims iterations from a shared counter until the iterations run out, so threads that are slowed down
+    /// by expensive extensions take fewer iterations. The workers only grow the trees, this thread processes their
+    /// connections, calls the callbacks and samples new goals.
+    PlannerStatus _PlanPathParallel(TrajectoryBasePtr ptraj, int constraintFilterOptions, uint64_t basetimeus)
+    {
+        const int dof = _parameters->GetDOF();
+        std::vector<dReal> vweights2;
+        const planningutils::SimpleDistanceMetric* pmetric = _parameters->_distmetricfn.target<planningutils::SimpleDistanceMetric>();
+        if( !pmetric || !pmetric->GetEuclideanWeights2(vweights2) || (int)vweights2.size() != dof ) {
+            vweights2.resize(0);
+        }
+        _paralleltreeforward.Init(dof, vweights2);
+        _paralleltreebackward.Init(dof, vweights2);
+        std::vector<dReal> vconfig;
+        for(size_t iinitial = 0; iinitial < _vecInitialNodes.size(); ++iinitial) {
+            if( !!_vecInitialNodes[iinitial] ) {
+                _treeForward.GetVectorConfig(_vecInitialNodes[iinitial], vconfig);
+                _paralleltreeforward.InsertNode(-1, vconfig.data(), iinitial);
+            }
+        }
+        _vparallelgoalnodes.resize(0);
+        for(size_t igoal = 0; igoal < _vecGoalNodes.size(); ++igoal) {
+            if( !!_vecGoalNodes[igoal] ) {
+                _treeBackward.GetVectorConfig(_vecGoalNodes[igoal], vconfig);
+                _vparallelgoalnodes.push_back(_paralleltreebackward.InsertNode(-1, vconfig.data(), igoal));
+            }
+        }
+
+        _bParallelStop = false;
+        _nParallelIterations = 0;
+        _nParallelFinishedWorkers = 0;
+        _vparallelconnections.resize(0);
+        std::vector<std::thread> vthreads;
+        vthreads.reserve(_vparallelworkers.size());
+        FOREACH(itworker, _vparallelworkers) {
+            vthreads.emplace_back(&BirrtPlanner::_ParallelWorkerThread, this, std::ref(**itworker), constraintFilterOptions);
+        }
+
+        PlannerProgress progress;
+        PlannerAction callbackaction = PA_None;
+        std::vector<ParallelConnection> vconnections;
+        std::string interruptdescription;
+        bool bFinished = false;
+        while(!bFinished) {
+            {
+                std::unique_lock<std::mutex> lock(_mutexparallel);
+                _condparallel.wait_for(lock, std::chrono::milliseconds(5), [this]() {
+                    return _vparallelconnections.size() > 0 || _nParallelFinishedWorkers == (int)_vparallelworkers.size();
+                });
+                vconnections.swap(_vparallelconnections);
+                _vparallelconnections.resize(0);
+                bFinished = _nParallelFinishedWorkers == (int)_vparallelworkers.size();
+            }
+            progress._iteration = std::min((int)_nParallelIterations, _parameters->_nMaxIterations);
+
+            FOREACH(itconnection, vconnections) {
+                if( !_paralleltreebackward.GetUseNN(itconnection->ibackward) ) {
+                    continue; // another worker already reached this goal
+                }
+                _vgoalpaths.push_back(GOALPATH());
+                _ExtractParallelPath(_vgoalpaths.back(), itconnection->iforward, itconnection->ibackward);
+                RAVELOG_DEBUG_FORMAT("env=%s, found a goal, start index=%d goal index=%d, path length=%f", GetEnv()->GetNameId()%_vgoalpaths.back().startindex%_vgoalpaths.back().goalindex%_vgoalpaths.back().length);
+                if( _vgoalpaths.size() >= _parameters->_minimumgoalpaths || _vgoalpaths.size() >= _nValidGoals ) {
+                    bFinished = true;
+                    break;
+                }
+                // more goals requested, so stop growing the nodes of the current found goal
+                _paralleltreebackward.InvalidateNodesWithRoot(_vgoalpaths.back().goalindex);
+            }
+            vconnections.resize(0);
+            if( bFinished ) {
+                break;
+            }
+
+            callbackaction = _CallCallbacks(progress);
+            if( callbackaction ==  PA_Interrupt ) {
+                interruptdescription = str(boost::format("env=%s, Planning was interrupted")%GetEnv()->GetNameId());
+                break;
+            }
+            else if( callbackaction == PA_ReturnWithAnySolution ) {
+                if( _vgoalpaths.size() > 0 ) {
+                    break;
+                }
+            }
+
+            if( _parameters->_nMaxPlanningTime > 0 ) {
+                uint64_t elapsedtime = utils::GetMonotonicTime()-basetimeus;
+                if( elapsedtime >= 1000*_parameters->_nMaxPlanningTime ) {
+                    RAVELOG_DEBUG_FORMAT("env=%s, time exceeded (%d[us] > %d[us]) so breaking. iter=%d < %d", GetEnv()->GetNameId()%elapsedtime%(1000*_parameters->_nMaxPlanningTime)%progress._iteration%_parameters->_nMaxIterations);
+                    break;
+                }
+            }
+
+            // new roots are inserted from this thread only since the sampling functions use the planner environment
+            if( !!_parameters->_samplegoalfn ) {
+                if( _parameters->_samplegoalfn(vconfig) ) {
+                    RAVELOG_VERBOSE(str(boost::format("env=%s, inserting new goal index %d")%GetEnv()->GetNameId()%_vecGoalNodes.size()));
+                    _paralleltreebackward.InsertNode(-1, vconfig.data(), _vecGoalNodes.size());
+                    _vecGoalNodes.push_back(_treeBackward.InsertNode(NULL, vconfig, _vecGoalNodes.size()));
+                    _nValidGoals++;
+                }
+            }
+            if( !!_parameters->_sampleinitialfn ) {
+                if( _parameters->_sampleinitialfn(vconfig) ) {
+                    RAVELOG_VERBOSE(str(boost::format("env=%s, inserting new initial %d")%GetEnv()->GetNameId()%_vecInitialNodes.size()));
+                    _paralleltreeforward.InsertNode(-1, vconfig.data(), _vecInitialNodes.size());
+                    _vecInitialNodes.push_back(_treeForward.InsertNode(NULL, vconfig, _vecInitialNodes.size()));
+                }
+            }
+        }
+
+        _bParallelStop = true;
+        FOREACH(itthread, vthreads) {
+            itthread->join();
+        }
+        if( interruptdescription.size() > 0 ) {
+            return OPENRAVE_PLANNER_STATUS(interruptdescription, PS_Interrupted);
+        }
+        if( _vgoalpaths.size() == 0 && progress._iteration >= _parameters->_nMaxIterations ) {
+            RAVELOG_WARN_FORMAT("env=%s, iterations exceeded %d", GetEnv()->GetNameId()%_parameters->_nMaxIterations);
+        }
+        return _ProcessGoalPaths(ptraj, basetimeus, progress._iteration);
+    }
+
+    /// \brief runs the iterations of one worker of the parallel planner
+    void _ParallelWorkerThread(ParallelWorker& worker, int constraintFilterOptions)
+    {
+        try {
+            EnvironmentLock lock(worker.penv->GetMutex());
+            const RRTParameters& params = *worker.parameters;
+            PlannerParameters::StateSaver savestate(worker.parameters);
+            CollisionOptionsStateSaver optionstate(worker.penv->GetCollisionChecker(),worker.penv->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
+            while(!_bParallelStop) {
+                const int iter = _nParallelIterations++;
+                if( iter >= _parameters->_nMaxIterations ) {
+                    break;
+                }
+
+                // alternate which tree is extended towards the sample like the single threaded planner
+                const bool bForwardFirst = (iter & 1) == 0;
+                ConcurrentSpatialTree& treeA = bForwardFirst ? _paralleltreeforward : _paralleltreebackward;
+                ConcurrentSpatialTree& treeB = bForwardFirst ? _paralleltreebackward : _paralleltreeforward;
+
+                worker.vsample.resize(0);
+                if( _vparallelgoalnodes.size() > 0 && (iter == 0 || worker.puniformsampler->SampleSequenceOneReal() < _fGoalBiasProb) ) {
+                    const int igoalnode = _vparallelgoalnodes[worker.puniformsampler->SampleSequenceOneUInt32()%_vparallelgoalnodes.size()];
+                    if( _paralleltreebackward.GetUseNN(igoalnode) ) {
+                        _paralleltreebackward.GetConfig(igoalnode, worker.vsample);
+                    }
+                }
+                if( worker.vsample.size() == 0 ) {
+                    if( !params._samplefn(worker.vsample) ) {
+                        continue;
+                    }
+                }
+
+                int iConnectedA = -1, iConnectedB = -1;
+                if( _ExtendParallel(worker, treeA, !bForwardFirst, worker.vsample, iConnectedA, constraintFilterOptions) == ET_Failed ) {
+                    continue;
+                }
+                treeA.GetConfig(iConnectedA, worker.vtarget);
+                if( _ExtendParallel(worker, treeB, bForwardFirst, worker.vtarget, iConnectedB, constraintFilterOptions) == ET_Connected ) {
+                    ParallelConnection connection;
+                    connection.iforward = bForwardFirst ? iConnectedA : iConnectedB;
+                    connection.ibackward = bForwardFirst ? iConnectedB : iConnectedA;
+                    std::lock_guard<std::mutex> lockconnections(_mutexparallel);
+                    _vparallelconnections.push_back(connection);
+                    _condparallel.notify_one();
+                }
+            }
+        }
+        catch(const std::exception& ex) {
+            RAVELOG_WARN_FORMAT("env=%s, parallel planner worker stopped: %s", GetEnv()->GetNameId()%ex.what());
+        }
+        std::lock_guard<std::mutex> lock(_mutexparallel);
+        ++_nParallelFinishedWorkers;
+        _condparallel.notify_one();
+    }
+
+    /// \brief same as SpatialTree::Extend for the trees of the parallel planner, using the functions of the worker
+    ExtendType _ExtendParallel(ParallelWorker& worker, ConcurrentSpatialTree& tree, bool bFromGoal, const std::vector<dReal>& vTargetConfig, int& lastnode, int constraintFilterOptions)
+    {
+        const RRTParameters& params = *worker.parameters;
+        std::pair<int, dReal> nn = tree.FindNearestNode(vTargetConfig, params._distmetricfn);
+        if( nn.first < 0 ) {
+            return ET_Failed;
+        }
+        int inode = nn.first;
+        lastnode = inode;
+        bool bHasAdded = false;
+        const int dof = tree.GetDOF();
+        const dReal fStepLength = params._fStepLength;
+        tree.GetConfig(inode, worker.vcurconfig);
+        for(int iter = 0; iter < 100; ++iter) {     // to avoid infinite loops
+            dReal fdist = params._distmetricfn(worker.vcurconfig, vTargetConfig);
+            if( fdist > fStepLength ) {
+                fdist = fStepLength / fdist;
+            }
+            else if( fdist <= dReal(0.01) * fStepLength ) {
+                return ET_Connected;
+            }
+            else {
+                fdist = 1;
+            }
+
+            worker.vnewconfig = worker.vcurconfig;
+            worker.vdeltaconfig = vTargetConfig;
+            params._diffstatefn(worker.vdeltaconfig, worker.vcurconfig);
+            for(int i = 0; i < dof; ++i) {
+                worker.vdeltaconfig[i] *= fdist;
+            }
+            if( params.SetStateValues(worker.vnewconfig) != 0 ) {
+                return bHasAdded ? ET_Sucess : ET_Failed;
+            }
+            if( params._neighstatefn(worker.vnewconfig, worker.vdeltaconfig, (bFromGoal ? NSO_GoalToInitial : 0)|NSO_FromPathSampling) == NSS_Failed ) {
+                return bHasAdded ? ET_Sucess : ET_Failed;
+            }
+            if( params._distmetricfn(worker.vcurconfig, worker.vnewconfig) <= dReal(0.01)*fStepLength ) {
+                return bHasAdded ? ET_Sucess : ET_Failed;
+            }
+
+            int ret;
+            if( bFromGoal ) {
+                ret = params.CheckPathAllConstraints(worker.vnewconfig, worker.vcurconfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenEnd, constraintFilterOptions|CFO_FromPathSampling, worker.constraintreturn);
+            }
+            else {
+                ret = params.CheckPathAllConstraints(worker.vcurconfig, worker.vnewconfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart, constraintFilterOptions|CFO_FromPathSampling, worker.constraintreturn);
+            }
+            if( ret != 0 ) {
+                return bHasAdded ? ET_Sucess : ET_Failed;
+            }
+
+            if( worker.constraintreturn->_bHasRampDeviatedFromInterpolation ) {
+                // add all checked configurations starting from the one closest to the current node
+                const std::vector<dReal>& vconfigs = worker.constraintreturn->_configurations;
+                const int numconfigs = (int)vconfigs.size()/dof;
+                for(int i = 0; i < numconfigs; ++i) {
+                    const dReal* pconfig = &vconfigs[(bFromGoal ? numconfigs-1-i : i)*dof];
+                    const int inewnode = tree.InsertNode(inode, pconfig, 0);
+                    if( inewnode < 0 ) {
+                        return bHasAdded ? ET_Sucess : ET_Failed;
+                    }
+                    inode = inewnode;
+                    lastnode = inode;
+                    bHasAdded = true;
+                }
+                tree.GetConfig(inode, worker.vcurconfig);
+            }
+            else {
+                const int inewnode = tree.InsertNode(inode, worker.vnewconfig.data(), 0);
+                if( inewnode < 0 ) {
+                    return bHasAdded ? ET_Sucess : ET_Failed;
+                }
+                inode = inewnode;
+                lastnode = inode;
+                bHasAdded = true;
+                worker.vcurconfig.swap(worker.vnewconfig);
+            }
+        }
+
+        return bHasAdded ? ET_Sucess : ET_Failed;
+    }
+
     virtual PlannerParametersConstPtr GetParameters() const {
         return _parameters;
     }
 
+    bool _GetNumPlanningThreadsCommand(std::ostream& os, std::istream& is)
+    {
+        os << _nPlanningThreads;
+        return !!os;
+    }
+
     virtual bool _DumpTreeCommand(std::ostream& os, std::istream& is) {
         std::string filename = RaveGetHomeDirectory() + string("/birrtdump.txt");
         getline(is, filename);
@@ -675,6 +1073,18 @@ protected:
     std::vector< NodeBase* > _vecGoalNodes;
     size_t _nValidGoals; ///< num valid goals
     std::vector<GOALPATH> _vgoalpaths;
+    int _nPlanningThreads; ///< number of threads the last PlanPath call grew the trees with, see GetNumPlanningThreads
+
+    // parallel planning, see RRTParameters::_nNumThreads
+    std::vector<ParallelWorkerPtr> _vparallelworkers;
+    ConcurrentSpatialTree _paralleltreeforward, _paralleltreebackward;
+    std::vector<int> _vparallelgoalnodes; ///< roots of _paralleltreebackward that the workers bias their samples to
+    std::vector<ParallelConnection> _vparallelconnections; ///< connections not processed yet, protected by _mutexparallel
+    int _nParallelFinishedWorkers; ///< protected by _mutexparallel
+    std::mutex _mutexparallel;
+    std::condition_variable _condparallel;
+    std::atomic<bool> _bParallelStop;
+    std::atomic<int> _nParallelIterations; ///< number of iterations claimed by the workers
 };
 
 class BasicRrtPlanner : public RrtPlanner<SimpleNode>
@@ -84,6 +84,8 @@ public:
 
     object CheckCollisionRays(object rays, PyKinBodyPtr pbody,bool bFrontFacingOnly=false);
 
+    object CheckCollisionBatch(PyKinBodyPtr pbody, object odofindices, object oconfigurations, int batchoptions=CBO_Environment|CBO_SelfCollision);
+
     bool CheckCollision(OPENRAVE_SHARED_PTR<PyRay> pyray);
 
     bool CheckCollision(OPENRAVE_SHARED_PTR<PyRay> pyray, PyCollisionReportPtr pReport);
@@ -85,6 +85,14 @@ public:
     }
 };
 
+/// \brief python handle of a KinBody::KinematicsWorkspace, reused across the jacobian and hessian queries passing it
+class PyKinematicsWorkspace
+{
+public:
+    KinBody::KinematicsWorkspace _workspace;
+};
+typedef OPENRAVE_SHARED_PTR<PyKinematicsWorkspace> PyKinematicsWorkspacePtr;
+
 class PyKinBody : public PyInterfaceBase
 {
 public:
@@ -295,7 +303,13 @@ public:
     py::object CalculateAngularVelocityJacobian(int index) const;
     py::object ComputeHessianTranslation(int index, py::object oposition, py::object oindices=py::none_());
     py::object ComputeHessianAxisAngle(int index, py::object oindices=py::none_());
+    py::object ComputeJacobianTranslationWithWorkspace(PyKinematicsWorkspacePtr pyworkspace, int index, py::object oposition, py::object oindices=py::none_());
+    py::object ComputeJacobianAxisAngleWithWorkspace(PyKinematicsWorkspacePtr pyworkspace, int index, py::object oindices=py::none_());
+    py::object ComputeHessianTranslationWithWorkspace(PyKinematicsWorkspacePtr pyworkspace, int index, py::object oposition, py::object oindices=py::none_());
+    py::object ComputeHessianAxisAngleWithWorkspace(PyKinematicsWorkspacePtr pyworkspace, int index, py::object oindices=py::none_());
     py::object ComputeInverseDynamics(py::object odofaccelerations, py::object oexternalforcetorque=py::none_(), bool returncomponents=false);
+    py::object ComputeInverseDynamicsWithVelocities(py::object odofvelocities, py::object odofaccelerations);
+    py::object ComputeInverseDynamicsBatch(py::object odofvalues, py::object odofvelocities, py::object odofaccelerations);
     py::object GetDOFDynamicAccelerationJerkLimits(py::object oDOFPositions, py::object oDOFVelocities) const;
     void SetSelfCollisionChecker(PyCollisionCheckerBasePtr pycollisionchecker);
     PyInterfaceBasePtr GetSelfCollisionChecker();
@@ -306,6 +320,8 @@ public:
     py::object GetAttachedEnvironmentBodyIndices() const;
     void SetZeroConfiguration();
     void SetNonCollidingConfiguration();
+    void SetStraightLineKinematics(bool bEnable);
+    bool IsStraightLineKinematics() const;
     py::object GetConfigurationSpecification(const std::string& interpolation="") const;
     py::object GetConfigurationSpecificationIndices(py::object oindices,const std::string& interpolation="") const;
     void SetConfigurationValues(py::object ovalues, uint32_t checklimits=KinBody::CLA_CheckLimits);
@@ -332,6 +348,10 @@ public:
     py::object GetReferenceURI() const;
     py::object GetNonAdjacentLinks() const;
     py::object GetNonAdjacentLinks(int adjacentoptions) const;
+    py::object ComputeLinkPairCollisionClasses(int numsamples, dReal fSafetyMargin);
+    void SetNeverCollidingLinkPairs(py::object olinkpairs);
+    py::object GetNeverCollidingLinkPairs() const;
+    bool SaveNeverCollidingLinkPairs() const;
     void SetAdjacentLinks(int linkindex0, int linkindex1);
     void SetAdjacentLinksCombinations(py::object olinkIndices);
     py::object GetAdjacentLinks() const;
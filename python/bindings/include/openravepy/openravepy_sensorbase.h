@@ -206,6 +206,7 @@ public:
         PyCameraSensorData(OPENRAVE_SHARED_PTR<SensorBase::CameraGeomData const> pgeom);
         virtual ~PyCameraSensorData();
         object imagedata = py::none_();
+        object depthdata = py::none_(); ///< height x width float array, None if the camera does not render depth
         object KK = py::none_();
         PyCameraIntrinsics intrinsics;
     };
@@ -91,7 +91,8 @@ public:
 
     void SaveToFile(const std::string& filename, object options=py::none_());
 
-    void LoadFromFile(const std::string& filename);
+    /// \param mapfile if true, uses TrajectoryBase::DeserializeFromFile, which can reference the waypoints from a read-only mapping of the file. Otherwise the file is read and copied.
+    void LoadFromFile(const std::string& filename, bool mapfile=false);
     
     TrajectoryBasePtr GetTrajectory();
 
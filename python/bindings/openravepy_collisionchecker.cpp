@@ -612,6 +612,30 @@ object PyCollisionCheckerBase::CheckCollisionRays(object rays, PyKinBodyPtr pbod
 #endif // USE_PYBIND11_PYTHON_BINDINGS
 }
 
+object PyCollisionCheckerBase::CheckCollisionBatch(PyKinBodyPtr pbody, object odofindices, object oconfigurations, int batchoptions)
+{
+    KinBodyPtr pkinbody = openravepy::GetKinBody(pbody);
+    std::vector<int> dofindices = ExtractArray<int>(odofindices);
+    const int ndof = dofindices.size() > 0 ? (int)dofindices.size() : pkinbody->GetDOF();
+    const int num = len(oconfigurations);
+    std::vector<dReal> vconfigurations;
+    vconfigurations.reserve(num*ndof);
+    for(int i = 0; i < num; ++i) {
+        std::vector<dReal> vconfiguration = ExtractArray<dReal>(oconfigurations[py::to_object(i)]);
+        if( (int)vconfiguration.size() != ndof ) {
+            throw openrave_exception(_("configurations need to be a Nxdof array\n"));
+        }
+        vconfigurations.insert(vconfigurations.end(), vconfiguration.begin(), vconfiguration.end());
+    }
+    std::vector<uint64_t> vcollisionmasks;
+    _pCollisionChecker->CheckCollisionBatch(pkinbody, dofindices, vconfigurations, vcollisionmasks, batchoptions);
+    py::list ocollisions;
+    for(int i = 0; i < num; ++i) {
+        ocollisions.append(!!(vcollisionmasks.at(i>>6) & ((uint64_t)1 << (i&0x3f))));
+    }
+    return ocollisions;
+}
+
 bool PyCollisionCheckerBase::CheckCollision(OPENRAVE_SHARED_PTR<PyRay> pyray)
 {
     return _pCollisionChecker->CheckCollision(pyray->r);
@@ -756,6 +780,7 @@ PyCollisionCheckerBasePtr RaveCreateCollisionChecker(PyEnvironmentBasePtr pyenv,
 
 #ifndef USE_PYBIND11_PYTHON_BINDINGS
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(CheckCollisionRays_overloads, CheckCollisionRays, 2, 3)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(CheckCollisionBatch_overloads, CheckCollisionBatch, 3, 4)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(Reset_overloads, Reset, 0, 1)
 #endif
 
@@ -783,6 +808,18 @@ void init_openravepy_collisionchecker()
     .export_values()
 #endif
     ;
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    enum_<CollisionBatchOptions>(m, "CollisionBatchOptions", py::arithmetic() DOXY_ENUM(CollisionBatchOptions))
+#else
+    enum_<CollisionBatchOptions>("CollisionBatchOptions" DOXY_ENUM(CollisionBatchOptions))
+#endif
+    .value("Environment",CBO_Environment)
+    .value("SelfCollision",CBO_SelfCollision)
+    .value("StopAtFirstCollision",CBO_StopAtFirstCollision)
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    .export_values()
+#endif
+    ;
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
     enum_<CollisionAction>(m, "CollisionAction", py::arithmetic() DOXY_ENUM(CollisionAction))
 #else
@@ -911,6 +948,18 @@ void init_openravepy_collisionchecker()
     .def("CheckCollisionRays",&PyCollisionCheckerBase::CheckCollisionRays,
          CheckCollisionRays_overloads(PY_ARGS("rays","body","front_facing_only")
                                       "Check if any rays hit the body and returns their contact points along with a vector specifying if a collision occured or not. Rays is a Nx6 array, first 3 columns are position, last 3 are direction*range. The return value is: (N array of hit points, Nx6 array of hit position and surface normals."))
+#endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    .def("CheckCollisionBatch", &PyCollisionCheckerBase::CheckCollisionBatch,
+         "body"_a,
+         "dofindices"_a,
+         "configurations"_a,
+         "batchoptions"_a = (int)(CBO_Environment|CBO_SelfCollision),
+         DOXY_FN(CollisionCheckerBase,CheckCollisionBatch)
+         )
+#else
+    .def("CheckCollisionBatch",&PyCollisionCheckerBase::CheckCollisionBatch,
+         CheckCollisionBatch_overloads(PY_ARGS("body","dofindices","configurations","batchoptions") DOXY_FN(CollisionCheckerBase,CheckCollisionBatch)))
 #endif
     ;
 
@@ -415,7 +415,7 @@ void PyGeometryInfo::FillGeometryInfo(KinBody::GeometryInfo& info)
     info._vDiffuseColor = ExtractVector34<dReal>(_vDiffuseColor,0);
     info._vAmbientColor = ExtractVector34<dReal>(_vAmbientColor,0);
     if( !IS_PYTHONOBJECT_NONE(_meshcollision) ) {
-        ExtractTriMesh(_meshcollision,info._meshcollision);
+        ExtractTriMesh(_meshcollision,info._meshcollision.GetWritable());
     }
     info._type = _type;
 
@@ -3877,6 +3877,58 @@ object PyKinBody::ComputeHessianAxisAngle(int index, object oindices)
     return toPyArray(vhessian,dims);
 }
 
+object PyKinBody::ComputeJacobianTranslationWithWorkspace(PyKinematicsWorkspacePtr pyworkspace, int index, object oposition, object oindices)
+{
+    std::vector<int> vindices;
+    if( !IS_PYTHONOBJECT_NONE(oindices) ) {
+        vindices = ExtractArray<int>(oindices);
+    }
+    size_t dof = vindices.size() == 0 ? (size_t)_pbody->GetDOF() : vindices.size();
+    std::vector<dReal> vjacobian(3*dof);
+    _pbody->ComputeJacobianTranslation(pyworkspace->_workspace,index,ExtractVector3(oposition),vjacobian.data(),vindices);
+    std::vector<npy_intp> dims(2); dims[0] = 3; dims[1] = dof;
+    return toPyArray(vjacobian,dims);
+}
+
+object PyKinBody::ComputeJacobianAxisAngleWithWorkspace(PyKinematicsWorkspacePtr pyworkspace, int index, object oindices)
+{
+    std::vector<int> vindices;
+    if( !IS_PYTHONOBJECT_NONE(oindices) ) {
+        vindices = ExtractArray<int>(oindices);
+    }
+    size_t dof = vindices.size() == 0 ? (size_t)_pbody->GetDOF() : vindices.size();
+    std::vector<dReal> vjacobian(3*dof);
+    _pbody->ComputeJacobianAxisAngle(pyworkspace->_workspace,index,vjacobian.data(),vindices);
+    std::vector<npy_intp> dims(2); dims[0] = 3; dims[1] = dof;
+    return toPyArray(vjacobian,dims);
+}
+
+object PyKinBody::ComputeHessianTranslationWithWorkspace(PyKinematicsWorkspacePtr pyworkspace, int index, object oposition, object oindices)
+{
+    std::vector<int> vindices;
+    if( !IS_PYTHONOBJECT_NONE(oindices) ) {
+        vindices = ExtractArray<int>(oindices);
+    }
+    size_t dof = vindices.size() == 0 ? (size_t)_pbody->GetDOF() : vindices.size();
+    std::vector<dReal> vhessian(dof*3*dof);
+    _pbody->ComputeHessianTranslation(pyworkspace->_workspace,index,ExtractVector3(oposition),vhessian.data(),vindices);
+    std::vector<npy_intp> dims(3); dims[0] = dof; dims[1] = 3; dims[2] = dof;
+    return toPyArray(vhessian,dims);
+}
+
+object PyKinBody::ComputeHessianAxisAngleWithWorkspace(PyKinematicsWorkspacePtr pyworkspace, int index, object oindices)
+{
+    std::vector<int> vindices;
+    if( !IS_PYTHONOBJECT_NONE(oindices) ) {
+        vindices = ExtractArray<int>(oindices);
+    }
+    size_t dof = vindices.size() == 0 ? (size_t)_pbody->GetDOF() : vindices.size();
+    std::vector<dReal> vhessian(dof*3*dof);
+    _pbody->ComputeHessianAxisAngle(pyworkspace->_workspace,index,vhessian.data(),vindices);
+    std::vector<npy_intp> dims(3); dims[0] = dof; dims[1] = 3; dims[2] = dof;
+    return toPyArray(vhessian,dims);
+}
+
 object PyKinBody::ComputeInverseDynamics(object odofaccelerations, object oexternalforcetorque, bool returncomponents)
 {
     std::vector<dReal> vDOFAccelerations;
@@ -3916,6 +3968,37 @@ object PyKinBody::ComputeInverseDynamics(object odofaccelerations, object oexter
     }
 }
 
+object PyKinBody::ComputeInverseDynamicsWithVelocities(object odofvelocities, object odofaccelerations)
+{
+    std::vector<dReal> vDOFVelocities, vDOFAccelerations, vDOFTorques;
+    if( !IS_PYTHONOBJECT_NONE(odofvelocities) ) {
+        vDOFVelocities = ExtractArray<dReal>(odofvelocities);
+    }
+    if( !IS_PYTHONOBJECT_NONE(odofaccelerations) ) {
+        vDOFAccelerations = ExtractArray<dReal>(odofaccelerations);
+    }
+    KinBody::InverseDynamicsWorkspace workspace;
+    _pbody->ComputeInverseDynamicsWithVelocities(vDOFTorques, vDOFVelocities, vDOFAccelerations, workspace);
+    return toPyArray(vDOFTorques);
+}
+
+object PyKinBody::ComputeInverseDynamicsBatch(object odofvalues, object odofvelocities, object odofaccelerations)
+{
+    std::vector<dReal> vDOFValues = ExtractArray<dReal>(odofvalues);
+    std::vector<dReal> vDOFVelocities, vDOFAccelerations, vDOFTorques;
+    if( !IS_PYTHONOBJECT_NONE(odofvelocities) ) {
+        vDOFVelocities = ExtractArray<dReal>(odofvelocities);
+    }
+    if( !IS_PYTHONOBJECT_NONE(odofaccelerations) ) {
+        vDOFAccelerations = ExtractArray<dReal>(odofaccelerations);
+    }
+    KinBody::InverseDynamicsWorkspace workspace;
+    _pbody->ComputeInverseDynamicsBatch(vDOFTorques, vDOFValues, vDOFVelocities, vDOFAccelerations, workspace);
+    const int dof = _pbody->GetDOF();
+    std::vector<npy_intp> dims(2); dims[0] = dof > 0 ? vDOFTorques.size()/dof : 0; dims[1] = dof;
+    return toPyArray(vDOFTorques,dims);
+}
+
 object PyKinBody::GetDOFDynamicAccelerationJerkLimits(py::object oDOFPositions, py::object oDOFVelocities) const
 {
     if( IS_PYTHONOBJECT_NONE(oDOFPositions) || IS_PYTHONOBJECT_NONE(oDOFVelocities) ) {
@@ -3987,6 +4070,16 @@ void PyKinBody::SetNonCollidingConfiguration()
     _pbody->SetNonCollidingConfiguration();
 }
 
+void PyKinBody::SetStraightLineKinematics(bool bEnable)
+{
+    _pbody->SetKinematicsGenerator(bEnable ? CreateStraightLineKinematicsGenerator() : KinematicsGeneratorPtr());
+}
+
+bool PyKinBody::IsStraightLineKinematics() const
+{
+    return _pbody->IsUsingKinematicsFunctions();
+}
+
 object PyKinBody::GetConfigurationSpecification(const std::string& interpolation) const
 {
     return py::to_object(openravepy::toPyConfigurationSpecification(_pbody->GetConfigurationSpecification(interpolation)));
@@ -4191,6 +4284,50 @@ object PyKinBody::GetNonAdjacentLinks(int adjacentoptions) const
     return ononadjacent;
 }
 
+object PyKinBody::ComputeLinkPairCollisionClasses(int numsamples, dReal fSafetyMargin)
+{
+    std::vector<int> vNeverCollidingLinkPairs, vAlwaysCollidingLinkPairs;
+    _pbody->ComputeLinkPairCollisionClasses(numsamples, fSafetyMargin, vNeverCollidingLinkPairs, vAlwaysCollidingLinkPairs);
+    py::list onever, oalways;
+    FOREACHC(it,vNeverCollidingLinkPairs) {
+        onever.append(py::make_tuple((int)(*it)&0xffff,(int)(*it)>>16));
+    }
+    FOREACHC(it,vAlwaysCollidingLinkPairs) {
+        oalways.append(py::make_tuple((int)(*it)&0xffff,(int)(*it)>>16));
+    }
+    return py::make_tuple(onever, oalways);
+}
+
+void PyKinBody::SetNeverCollidingLinkPairs(object olinkpairs)
+{
+    std::vector<int> vNeverCollidingLinkPairs;
+    for(size_t ipair = 0; ipair < (size_t)len(olinkpairs); ++ipair) {
+        object olinkpair = olinkpairs[py::to_object(ipair)];
+        int linkindex0 = py::extract<int>(olinkpair[py::to_object(0)]);
+        int linkindex1 = py::extract<int>(olinkpair[py::to_object(1)]);
+        if( linkindex0 > linkindex1 ) {
+            std::swap(linkindex0, linkindex1);
+        }
+        vNeverCollidingLinkPairs.push_back(linkindex0|(linkindex1<<16));
+    }
+    _pbody->SetNeverCollidingLinkPairs(vNeverCollidingLinkPairs);
+}
+
+object PyKinBody::GetNeverCollidingLinkPairs() const
+{
+    py::list olinkpairs;
+    const std::vector<int>& vNeverCollidingLinkPairs = _pbody->GetNeverCollidingLinkPairs();
+    FOREACHC(it,vNeverCollidingLinkPairs) {
+        olinkpairs.append(py::make_tuple((int)(*it)&0xffff,(int)(*it)>>16));
+    }
+    return olinkpairs;
+}
+
+bool PyKinBody::SaveNeverCollidingLinkPairs() const
+{
+    return _pbody->SaveNeverCollidingLinkPairs();
+}
+
 void PyKinBody::SetAdjacentLinks(int linkindex0, int linkindex1)
 {
     _pbody->SetAdjacentLinks(linkindex0, linkindex1);
@@ -4801,6 +4938,10 @@ BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeJacobianTranslation_overloads, Com
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeJacobianAxisAngle_overloads, ComputeJacobianAxisAngle, 1, 2)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeHessianTranslation_overloads, ComputeHessianTranslation, 2, 3)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeHessianAxisAngle_overloads, ComputeHessianAxisAngle, 1, 2)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeJacobianTranslationWithWorkspace_overloads, ComputeJacobianTranslationWithWorkspace, 3, 4)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeJacobianAxisAngleWithWorkspace_overloads, ComputeJacobianAxisAngleWithWorkspace, 2, 3)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeHessianTranslationWithWorkspace_overloads, ComputeHessianTranslationWithWorkspace, 3, 4)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeHessianAxisAngleWithWorkspace_overloads, ComputeHessianAxisAngleWithWorkspace, 2, 3)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeInverseDynamics_overloads, ComputeInverseDynamics, 1, 3)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(Restore_overloads, Restore, 0,1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ExtractInfo_overloads, ExtractInfo, 0,1)
@@ -4917,6 +5058,15 @@ void init_openravepy_kinbody()
                           .value("NY",KinBody::GeometryInfo::SideWallType::SWT_NY)
                           .value("PY",KinBody::GeometryInfo::SideWallType::SWT_PY)
     ;
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    class_<PyKinematicsWorkspace, OPENRAVE_SHARED_PTR<PyKinematicsWorkspace> >(m, "KinematicsWorkspace", DOXY_CLASS(KinBody::KinematicsWorkspace))
+    .def(init<>())
+    ;
+#else
+    class_<PyKinematicsWorkspace, OPENRAVE_SHARED_PTR<PyKinematicsWorkspace> >("KinematicsWorkspace", DOXY_CLASS(KinBody::KinematicsWorkspace))
+    ;
+#endif
+
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
     object electricmotoractuatorinfo = class_<PyElectricMotorActuatorInfo, OPENRAVE_SHARED_PTR<PyElectricMotorActuatorInfo> >(m, "ElectricMotorActuatorInfo", DOXY_CLASS(KinBody::ElectricMotorActuatorInfo))
                                        .def(init<>())
@@ -5886,6 +6036,17 @@ void init_openravepy_kinbody()
 #else
                          .def("ComputeJacobianTranslation",&PyKinBody::ComputeJacobianTranslation,ComputeJacobianTranslation_overloads(PY_ARGS("linkindex","position","indices") DOXY_FN(KinBody,ComputeJacobianTranslation)))
 #endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+                         .def("ComputeJacobianTranslation", &PyKinBody::ComputeJacobianTranslationWithWorkspace,
+                              "workspace"_a,
+                              "linkindex"_a,
+                              "position"_a,
+                              "indices"_a = py::none_(),
+                              DOXY_FN(KinBody,ComputeJacobianTranslation)
+                              )
+#else
+                         .def("ComputeJacobianTranslation",&PyKinBody::ComputeJacobianTranslationWithWorkspace,ComputeJacobianTranslationWithWorkspace_overloads(PY_ARGS("workspace","linkindex","position","indices") DOXY_FN(KinBody,ComputeJacobianTranslation)))
+#endif
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
                          .def("ComputeJacobianAxisAngle", &PyKinBody::ComputeJacobianAxisAngle,
                               "linkindex"_a,
@@ -5894,6 +6055,16 @@ void init_openravepy_kinbody()
                               )
 #else
                          .def("ComputeJacobianAxisAngle",&PyKinBody::ComputeJacobianAxisAngle,ComputeJacobianAxisAngle_overloads(PY_ARGS("linkindex","indices") DOXY_FN(KinBody,ComputeJacobianAxisAngle)))
+#endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+                         .def("ComputeJacobianAxisAngle", &PyKinBody::ComputeJacobianAxisAngleWithWorkspace,
+                              "workspace"_a,
+                              "linkindex"_a,
+                              "indices"_a = py::none_(),
+                              DOXY_FN(KinBody,ComputeJacobianAxisAngle)
+                              )
+#else
+                         .def("ComputeJacobianAxisAngle",&PyKinBody::ComputeJacobianAxisAngleWithWorkspace,ComputeJacobianAxisAngleWithWorkspace_overloads(PY_ARGS("workspace","linkindex","indices") DOXY_FN(KinBody,ComputeJacobianAxisAngle)))
 #endif
                          .def("CalculateJacobian",&PyKinBody::CalculateJacobian,PY_ARGS("linkindex","position") DOXY_FN(KinBody,CalculateJacobian "int; const Vector; std::vector"))
                          .def("CalculateRotationJacobian",&PyKinBody::CalculateRotationJacobian,PY_ARGS("linkindex","quat") DOXY_FN(KinBody,CalculateRotationJacobian "int; const Vector; std::vector"))
@@ -5928,6 +6099,17 @@ void init_openravepy_kinbody()
 #else
                          .def("ComputeHessianTranslation",&PyKinBody::ComputeHessianTranslation,ComputeHessianTranslation_overloads(PY_ARGS("linkindex","position","indices") DOXY_FN(KinBody,ComputeHessianTranslation)))
 #endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+                         .def("ComputeHessianTranslation", &PyKinBody::ComputeHessianTranslationWithWorkspace,
+                              "workspace"_a,
+                              "linkindex"_a,
+                              "position"_a,
+                              "indices"_a = py::none_(),
+                              DOXY_FN(KinBody,ComputeHessianTranslation)
+                              )
+#else
+                         .def("ComputeHessianTranslation",&PyKinBody::ComputeHessianTranslationWithWorkspace,ComputeHessianTranslationWithWorkspace_overloads(PY_ARGS("workspace","linkindex","position","indices") DOXY_FN(KinBody,ComputeHessianTranslation)))
+#endif
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
                          .def("ComputeHessianAxisAngle", &PyKinBody::ComputeHessianAxisAngle,
                               "linkindex"_a,
@@ -5937,6 +6119,16 @@ void init_openravepy_kinbody()
 #else
                          .def("ComputeHessianAxisAngle",&PyKinBody::ComputeHessianAxisAngle,ComputeHessianAxisAngle_overloads(PY_ARGS("linkindex","indices") DOXY_FN(KinBody,ComputeHessianAxisAngle)))
 #endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+                         .def("ComputeHessianAxisAngle", &PyKinBody::ComputeHessianAxisAngleWithWorkspace,
+                              "workspace"_a,
+                              "linkindex"_a,
+                              "indices"_a = py::none_(),
+                              DOXY_FN(KinBody,ComputeHessianAxisAngle)
+                              )
+#else
+                         .def("ComputeHessianAxisAngle",&PyKinBody::ComputeHessianAxisAngleWithWorkspace,ComputeHessianAxisAngleWithWorkspace_overloads(PY_ARGS("workspace","linkindex","indices") DOXY_FN(KinBody,ComputeHessianAxisAngle)))
+#endif
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
                          .def("ComputeInverseDynamics", &PyKinBody::ComputeInverseDynamics,
                               "dofaccelerations"_a,
@@ -5947,6 +6139,8 @@ void init_openravepy_kinbody()
 #else
                          .def("ComputeInverseDynamics",&PyKinBody::ComputeInverseDynamics, ComputeInverseDynamics_overloads(PY_ARGS("dofaccelerations","externalforcetorque","returncomponents") sComputeInverseDynamicsDoc.c_str()))
 #endif
+                         .def("ComputeInverseDynamicsWithVelocities",&PyKinBody::ComputeInverseDynamicsWithVelocities, PY_ARGS("dofvelocities","dofaccelerations") DOXY_FN(KinBody,ComputeInverseDynamicsWithVelocities))
+                         .def("ComputeInverseDynamicsBatch",&PyKinBody::ComputeInverseDynamicsBatch, PY_ARGS("dofvalues","dofvelocities","dofaccelerations") DOXY_FN(KinBody,ComputeInverseDynamicsBatch))
                          .def("GetDOFDynamicAccelerationJerkLimits",&PyKinBody::GetDOFDynamicAccelerationJerkLimits, PY_ARGS("dofPositions","dofVelocities") DOXY_FN(KinBody,ComputeDynamicLimits))
                          .def("SetSelfCollisionChecker",&PyKinBody::SetSelfCollisionChecker,PY_ARGS("collisionchecker") DOXY_FN(KinBody,SetSelfCollisionChecker))
                          .def("GetSelfCollisionChecker", &PyKinBody::GetSelfCollisionChecker, /*PY_ARGS("collisionchecker")*/ DOXY_FN(KinBody,GetSelfCollisionChecker))
@@ -5965,6 +6159,8 @@ void init_openravepy_kinbody()
                          .def("GetAttachedEnvironmentBodyIndices",&PyKinBody::GetAttachedEnvironmentBodyIndices, DOXY_FN(KinBody,GetAttachedEnvironmentBodyIndices))
                          .def("SetZeroConfiguration",&PyKinBody::SetZeroConfiguration, DOXY_FN(KinBody,SetZeroConfiguration))
                          .def("SetNonCollidingConfiguration",&PyKinBody::SetNonCollidingConfiguration, DOXY_FN(KinBody,SetNonCollidingConfiguration))
+                         .def("SetStraightLineKinematics",&PyKinBody::SetStraightLineKinematics, PY_ARGS("enable") "Computes the forward kinematics with the straight-line kinematics generator, see CreateStraightLineKinematicsGenerator. Bodies it cannot represent keep the generic kinematics.")
+                         .def("IsStraightLineKinematics",&PyKinBody::IsStraightLineKinematics, "Returns true if the forward kinematics are computed by generated kinematics functions")
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
                          .def("GetConfigurationSpecification", &PyKinBody::GetConfigurationSpecification,
                               "interpolation"_a = "",
@@ -6002,6 +6198,10 @@ void init_openravepy_kinbody()
                          .def("GetXMLFilename",&PyKinBody::GetURI, DOXY_FN(InterfaceBase,GetURI))
                          .def("GetNonAdjacentLinks",GetNonAdjacentLinks1, DOXY_FN(KinBody,GetNonAdjacentLinks))
                          .def("GetNonAdjacentLinks",GetNonAdjacentLinks2, PY_ARGS("adjacentoptions") DOXY_FN(KinBody,GetNonAdjacentLinks))
+                         .def("ComputeLinkPairCollisionClasses",&PyKinBody::ComputeLinkPairCollisionClasses, PY_ARGS("numsamples", "safetymargin") DOXY_FN(KinBody,ComputeLinkPairCollisionClasses))
+                         .def("SetNeverCollidingLinkPairs",&PyKinBody::SetNeverCollidingLinkPairs, PY_ARGS("linkpairs") DOXY_FN(KinBody,SetNeverCollidingLinkPairs))
+                         .def("GetNeverCollidingLinkPairs",&PyKinBody::GetNeverCollidingLinkPairs, DOXY_FN(KinBody,GetNeverCollidingLinkPairs))
+                         .def("SaveNeverCollidingLinkPairs",&PyKinBody::SaveNeverCollidingLinkPairs, DOXY_FN(KinBody,SaveNeverCollidingLinkPairs))
                          .def("SetAdjacentLinks",&PyKinBody::SetAdjacentLinks, PY_ARGS("linkindex0", "linkindex1") DOXY_FN(KinBody,SetAdjacentLinks))
                          .def("SetAdjacentLinksCombinations",&PyKinBody::SetAdjacentLinksCombinations, PY_ARGS("linkIndices") DOXY_FN(KinBody,SetAdjacentLinksCombinations))
                          .def("GetAdjacentLinks",&PyKinBody::GetAdjacentLinks, DOXY_FN(KinBody,GetAdjacentLinks))
@@ -314,6 +314,10 @@ public:
         _pconstraints->SetTorqueLimitMode(static_cast<DynamicsConstraintsType>(torquelimitmode));
     }
 
+    void SetParallelCheck(int numthreads) {
+        _pconstraints->SetParallelCheck(numthreads);
+    }
+
 
     PyEnvironmentBasePtr _pyenv;
     OpenRAVE::planningutils::DynamicsCollisionConstraintPtr _pconstraints;
@@ -980,6 +984,7 @@ void InitPlanningUtils()
         .def("SetFilterMask", &planningutils::PyDynamicsCollisionConstraint::SetFilterMask, PY_ARGS("filtermask") DOXY_FN(planningutils::DynamicsCollisionConstraint,SetFilterMask))
         .def("SetPerturbation", &planningutils::PyDynamicsCollisionConstraint::SetPerturbation, PY_ARGS("parameters") DOXY_FN(planningutils::DynamicsCollisionConstraint,SetPerturbation))
         .def("SetTorqueLimitMode", &planningutils::PyDynamicsCollisionConstraint::SetTorqueLimitMode, PY_ARGS("torquelimitmode") DOXY_FN(planningutils::DynamicsCollisionConstraint,SetTorqueLimitMode))
+        .def("SetParallelCheck", &planningutils::PyDynamicsCollisionConstraint::SetParallelCheck, PY_ARGS("numthreads") DOXY_FN(planningutils::DynamicsCollisionConstraint,SetParallelCheck))
         ;
     }
 }
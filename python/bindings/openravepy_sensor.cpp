@@ -377,6 +377,14 @@ PySensorBase::PyCameraSensorData::PyCameraSensorData(OPENRAVE_SHARED_PTR<SensorB
         imagedata = py::to_array_astype<uint8_t>(pyvalues);
 #endif // USE_PYBIND11_PYTHON_BINDINGS
     }
+    // depth is optional, only cameras that render it fill vdepthdata
+    if( !pdata->vdepthdata.empty() ) {
+        if( pdata->vdepthdata.size() != size_t(pgeom->height * pgeom->width) ) {
+            throw openrave_exception(_("bad depth data"));
+        }
+        std::vector<npy_intp> dims = {npy_intp(pgeom->height), npy_intp(pgeom->width)};
+        depthdata = toPyArray(pdata->vdepthdata, dims);
+    }
 }
 PySensorBase::PyCameraSensorData::PyCameraSensorData(OPENRAVE_SHARED_PTR<SensorBase::CameraGeomData const> pgeom) : PySensorData(SensorBase::ST_Camera), intrinsics(pgeom->intrinsics)
 {
@@ -807,6 +815,7 @@ void init_openravepy_sensor()
 #endif
         .def_readonly("transform",&PySensorBase::PyCameraSensorData::transform)
         .def_readonly("imagedata",&PySensorBase::PyCameraSensorData::imagedata)
+        .def_readonly("depthdata",&PySensorBase::PyCameraSensorData::depthdata)
         .def_readonly("KK",&PySensorBase::PyCameraSensorData::KK)
         .def_readonly("intrinsics",&PySensorBase::PyCameraSensorData::intrinsics)
         ;
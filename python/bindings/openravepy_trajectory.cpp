@@ -562,11 +562,16 @@ void PyTrajectoryBase::SaveToFile(const std::string& filename, object options)
     f.close(); // necessary?
 }
 
-void PyTrajectoryBase::LoadFromFile(const std::string& filename)
+void PyTrajectoryBase::LoadFromFile(const std::string& filename, bool mapfile)
 {
-    std::ifstream f(filename.c_str(), ios::binary);
-    _ptrajectory->deserialize(f);
-    f.close(); // necessary?
+    if( mapfile ) {
+        _ptrajectory->DeserializeFromFile(filename);
+    }
+    else {
+        std::ifstream f(filename.c_str(), ios::binary);
+        _ptrajectory->deserialize(f);
+        f.close(); // necessary?
+    }
 }
 
 TrajectoryBasePtr PyTrajectoryBase::GetTrajectory() {
@@ -618,6 +623,7 @@ PyTrajectoryBasePtr RaveCreateTrajectory(PyEnvironmentBasePtr pyenv, const std::
 #ifndef USE_PYBIND11_PYTHON_BINDINGS
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(serialize_overloads, serialize, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(SaveToFile_overloads, SaveToFile, 1, 2)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(LoadFromFile_overloads, LoadFromFile, 1, 2)
 #endif //
 
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
@@ -722,7 +728,15 @@ void init_openravepy_trajectory()
     .def("SaveToFile",&PyTrajectoryBase::SaveToFile,SaveToFile_overloads(PY_ARGS("filename, options") DOXY_FN(TrajectoryBase,SaveToFile)))
 #endif
     .def("deserialize",&PyTrajectoryBase::deserialize, PY_ARGS("data") DOXY_FN(TrajectoryBase,deserialize))
-    .def("LoadFromFile",&PyTrajectoryBase::LoadFromFile, PY_ARGS("filename") DOXY_FN(TrajectoryBase,deserialize))
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    .def("LoadFromFile", &PyTrajectoryBase::LoadFromFile,
+         "filename"_a,
+         "mapfile"_a = false,
+         DOXY_FN(TrajectoryBase, DeserializeFromFile)
+         )
+#else
+    .def("LoadFromFile",&PyTrajectoryBase::LoadFromFile,LoadFromFile_overloads(PY_ARGS("filename", "mapfile") DOXY_FN(TrajectoryBase,DeserializeFromFile)))
+#endif
     .def("__len__",&PyTrajectoryBase::GetNumWaypoints,DOXY_FN(TrajectoryBase,__len__))
     .def("__getitem__",__getitem__1, PY_ARGS("index") DOXY_FN(TrajectoryBase, __getitem__ "int"))
     .def("__getitem__",__getitem__2, PY_ARGS("indices") DOXY_FN(TrajectoryBase, __getitem__ "slice"))
@@ -2492,7 +2492,7 @@ public:
                 itgeominfo->_vGeomData.y *= vscale.z;
                 break;
             case GT_TriMesh:
-                itgeominfo->_meshcollision.ApplyTransform(TransformMatrix(tmnodegeom * toriginal).inverse() * TransformMatrix(toriginal));
+                itgeominfo->_meshcollision.GetWritable().ApplyTransform(TransformMatrix(tmnodegeom * toriginal).inverse() * TransformMatrix(toriginal));
                 break;
             case GT_CalibrationBoard:
                 itgeominfo->_vGeomData *= vscale;
@@ -2566,7 +2566,7 @@ public:
             return false;
         }
 
-        TriMesh& trimesh = geom._meshcollision;
+        TriMesh& trimesh = geom._meshcollision.GetWritable();
         geom._type = GT_TriMesh;
 
         // resolve the material and assign correct colors to the geometry
@@ -2647,7 +2647,7 @@ public:
         if( !triRef ) {
             return false;
         }
-        TriMesh& trimesh = geom._meshcollision;
+        TriMesh& trimesh = geom._meshcollision.GetWritable();
         geom._type = GT_TriMesh;
 
         // resolve the material and assign correct colors to the geometry
@@ -2737,7 +2737,7 @@ public:
         if( !triRef ) {
             return false;
         }
-        TriMesh& trimesh = geom._meshcollision;
+        TriMesh& trimesh = geom._meshcollision.GetWritable();
         geom._type = GT_TriMesh;
 
         // resolve the material and assign correct colors to the geometry
@@ -2830,7 +2830,7 @@ public:
         if( !triRef ) {
             return false;
         }
-        TriMesh& trimesh = geom._meshcollision;
+        TriMesh& trimesh = geom._meshcollision.GetWritable();
         geom._type = GT_TriMesh;
 
         // resolve the material and assign correct colors to the geometry
@@ -3336,7 +3336,7 @@ public:
                 FOREACH(itgeominfo,listNewGeometryInfos) {
                     itgeominfo->InitCollisionMesh();
                     Transform tnew = tlocalgeominv * itgeominfo->GetTransform();
-                    FOREACH(itvertex, itgeominfo->_meshcollision.vertices) {
+                    FOREACHC(itvertex, itgeominfo->_meshcollision->vertices) {
                         vconvexhull.push_back(tnew * *itvertex);
                     }
                 }
@@ -3374,7 +3374,7 @@ public:
                 listGeometryInfos.back()._type = GT_TriMesh;
                 listGeometryInfos.back().SetTransform(tlocalgeom);
                 listGeometryInfos.back()._bVisible = bgeomvisible;
-                _computeConvexHull(vconvexhull,listGeometryInfos.back()._meshcollision);
+                _computeConvexHull(vconvexhull,listGeometryInfos.back()._meshcollision.GetWritable());
             }
             return true;
         }
@@ -26,6 +26,7 @@
 #endif
 
 #include <chrono>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
 #include <thread>
@@ -190,6 +191,16 @@ public:
     };
     typedef boost::shared_ptr<GraphHandleMulti> GraphHandleMultiPtr;
 
+    /// \brief immutable copy of the body lookup structures, lets the read-only queries run without locking _mutexInterfaces
+    struct BodiesSnapshot
+    {
+        int nBodiesModifiedStamp = 0; ///< _nBodiesModifiedStamp when the snapshot was taken
+        std::vector<KinBodyPtr> vecbodies; ///< copy of _vecbodies
+        std::unordered_map<std::string, int> mapBodyNameIndex; ///< copy of _mapBodyNameIndex
+        std::unordered_map<std::string, int> mapBodyIdIndex; ///< copy of _mapBodyIdIndex
+    };
+    typedef std::shared_ptr<const BodiesSnapshot> BodiesSnapshotConstPtr;
+
     class CollisionCallbackData : public UserData
     {
 public:
@@ -257,6 +268,7 @@ public:
         }
 
         _nBodiesModifiedStamp = 0;
+        _nPublishedBodiesModifiedStamp = -1;
 
         _fDeltaSimTime = 0.01f;
         _nCurSimTime = 0;
@@ -383,8 +395,9 @@ public:
                 ExclusiveLock lock874(_mutexInterfaces);
                 vecbodies.swap(_vecbodies);
                 listSensors.swap(_listSensors);
-                _vPublishedBodies.clear();
+                _ClearPublishedBodies();
                 _nBodiesModifiedStamp++;
+                _InvalidateBodiesSnapshot();
                 _listModules.clear();
                 _listViewers.clear();
                 _listOwnedInterfaces.clear();
@@ -462,8 +475,9 @@ public:
             _mapBodyNameIndex.clear();
             _mapBodyIdIndex.clear();
 
-            _vPublishedBodies.clear();
+            _ClearPublishedBodies();
             _nBodiesModifiedStamp++;
+            _InvalidateBodiesSnapshot();
 
             _environmentIndexRecyclePool.clear();
 
@@ -1151,11 +1165,11 @@ public:
             //RAVELOG_VERBOSE_FORMAT("env=%d, empty name is used to find body. Maybe caller has to be fixed.", GetId());
             return KinBodyPtr();
         }
-        SharedLock lock585(_mutexInterfaces);
-        if (!_vecbodies.empty()) {
-            const int envBodyIndex = _FindBodyIndexByName(pname);
+        const BodiesSnapshotConstPtr psnapshot = _GetBodiesSnapshot();
+        if (!psnapshot->vecbodies.empty()) {
+            const int envBodyIndex = _FindBodyIndexByName(*psnapshot, pname);
             //RAVELOG_VERBOSE_FORMAT("env=%d, name %s (envBodyIndex=%d) is nullptr, maybe already removed from env?", GetId()%pname%envBodyIndex);
-            return _vecbodies.at(envBodyIndex);
+            return psnapshot->vecbodies.at(envBodyIndex);
         }
         return KinBodyPtr();
     }
@@ -1166,14 +1180,14 @@ public:
             return KinBodyPtr();
         }
 
-        SharedLock lock942(_mutexInterfaces);
-        const std::unordered_map<std::string, int>::const_iterator it = _mapBodyIdIndex.find(id);
-        if (it == _mapBodyIdIndex.end()) {
+        const BodiesSnapshotConstPtr psnapshot = _GetBodiesSnapshot();
+        const std::unordered_map<std::string, int>::const_iterator it = psnapshot->mapBodyIdIndex.find(id);
+        if (it == psnapshot->mapBodyIdIndex.end()) {
             RAVELOG_WARN_FORMAT("env=%s, id %s is not found", GetNameId()%id);
             return 0;
         }
         const int envBodyIndex = it->second;
-        const KinBodyPtr& pbody = _vecbodies.at(envBodyIndex);
+        const KinBodyPtr& pbody = psnapshot->vecbodies.at(envBodyIndex);
         if (!!pbody ) {
             if( pbody->GetId()==id) {
                 return pbody;
@@ -1188,8 +1202,7 @@ public:
 
     int GetNumBodies() const override
     {
-        SharedLock lock627(_mutexInterfaces);
-        return (int)_mapBodyIdIndex.size();
+        return (int)_GetBodiesSnapshot()->mapBodyIdIndex.size();
     }
 
     // assumes _mutexInterfaces is locked
@@ -1229,12 +1242,12 @@ public:
             return RobotBasePtr();
         }
 
-        SharedLock lock412(_mutexInterfaces);
-        if (_vecbodies.empty()) {
+        const BodiesSnapshotConstPtr psnapshot = _GetBodiesSnapshot();
+        if (psnapshot->vecbodies.empty()) {
             return RobotBasePtr();
         }
-        const int envBodyIndex = _FindBodyIndexByName(pname);
-        const KinBodyPtr& pbody = _vecbodies.at(envBodyIndex);
+        const int envBodyIndex = _FindBodyIndexByName(*psnapshot, pname);
+        const KinBodyPtr& pbody = psnapshot->vecbodies.at(envBodyIndex);
         if (!!pbody && pbody->IsRobot()) {
             return RaveInterfaceCast<RobotBase>(pbody);
         }
@@ -1249,6 +1262,19 @@ public:
         return RobotBasePtr();
     }
 
+    /// \brief looks up the name in a bodies snapshot, does not need any lock
+    static inline int _FindBodyIndexByName(const BodiesSnapshot& snapshot, const std::string& name)
+    {
+        if (name.empty()) {
+            return 0;
+        }
+        const std::unordered_map<std::string, int>::const_iterator it = snapshot.mapBodyNameIndex.find(name);
+        if (it == snapshot.mapBodyNameIndex.end()) {
+            return 0;
+        }
+        return it->second;
+    }
+
     /// assumes _mutexInterfaces is locked
     inline int _FindBodyIndexByName(const std::string& name) const
     {
@@ -1507,13 +1533,13 @@ public:
 
     virtual void GetBodies(std::vector<KinBodyPtr>& bodies, uint64_t timeout) const override
     {
-        TimedSharedLock lock853(_mutexInterfaces, timeout);
-        if (!lock853) {
+        const BodiesSnapshotConstPtr psnapshot = _GetBodiesSnapshot(timeout);
+        if (!psnapshot) {
             throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
         }
         bodies.clear();
-        bodies.reserve(_vecbodies.size());
-        for (const KinBodyPtr& pbody : _vecbodies) {
+        bodies.reserve(psnapshot->vecbodies.size());
+        for (const KinBodyPtr& pbody : psnapshot->vecbodies) {
             if (!pbody) {
                 continue;
             }
@@ -1523,12 +1549,12 @@ public:
 
     virtual void GetRobots(std::vector<RobotBasePtr>& robots, uint64_t timeout) const override
     {
-        TimedSharedLock lock186(_mutexInterfaces, timeout);
-        if (!lock186) {
+        const BodiesSnapshotConstPtr psnapshot = _GetBodiesSnapshot(timeout);
+        if (!psnapshot) {
             throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
         }
         robots.clear();
-        for (const KinBodyPtr& pbody : _vecbodies) {
+        for (const KinBodyPtr& pbody : psnapshot->vecbodies) {
             if (!pbody || !pbody->IsRobot()) {
                 continue;
             }
@@ -2530,9 +2556,9 @@ public:
 
     KinBodyPtr GetBodyFromEnvironmentBodyIndex(int bodyIndex) const override
     {
-        SharedLock lock430(_mutexInterfaces);
-        if (0 < bodyIndex && bodyIndex < (int) _vecbodies.size()) {
-            return _vecbodies.at(bodyIndex);
+        const BodiesSnapshotConstPtr psnapshot = _GetBodiesSnapshot();
+        if (0 < bodyIndex && bodyIndex < (int) psnapshot->vecbodies.size()) {
+            return psnapshot->vecbodies.at(bodyIndex);
         }
         return KinBodyPtr();
     }
@@ -2542,13 +2568,14 @@ public:
     {
         bodies.clear();
         bodies.reserve(bodyIndices.size());
-        SharedLock lock138(_mutexInterfaces);
+        const BodiesSnapshotConstPtr psnapshot = _GetBodiesSnapshot();
+        const std::vector<KinBodyPtr>& vecbodies = psnapshot->vecbodies;
         for (int bodyIndex : bodyIndices) {
-            if (0 < bodyIndex && bodyIndex < (int) _vecbodies.size()) {
-                bodies.push_back(_vecbodies.at(bodyIndex));
+            if (0 < bodyIndex && bodyIndex < (int) vecbodies.size()) {
+                bodies.push_back(vecbodies.at(bodyIndex));
             }
             else {
-                RAVELOG_WARN_FORMAT("env=%s, could not find body for environment body index=%d from %d bodies", GetNameId()%bodyIndex%_vecbodies.size());
+                RAVELOG_WARN_FORMAT("env=%s, could not find body for environment body index=%d from %d bodies", GetNameId()%bodyIndex%vecbodies.size());
                 bodies.push_back(KinBodyPtr());
             }
         }
@@ -2663,12 +2690,47 @@ public:
         _UpdatePublishedBodies();
     }
 
+    uint64_t GetPublishedBodiesChangedSince(uint64_t stamp, std::vector<KinBody::BodyState>& vChangedBodies, std::vector<int>& vRemovedEnvironmentBodyIndices, uint64_t timeout=0) override
+    {
+        TimedSharedLock lock615(_mutexInterfaces, timeout);
+        if (!lock615) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
+        }
+        vChangedBodies.resize(0);
+        vRemovedEnvironmentBodyIndices.resize(0);
+        for (size_t envBodyIndex = 0; envBodyIndex < _vPublishedBodyRemovedStamps.size(); ++envBodyIndex) {
+            if( _vPublishedBodyRemovedStamps[envBodyIndex] > stamp ) {
+                vRemovedEnvironmentBodyIndices.push_back(envBodyIndex);
+            }
+        }
+        for (size_t ibody = 0; ibody < _vPublishedBodies.size(); ++ibody) {
+            if( _vPublishedBodyStamps.at(ibody) > stamp ) {
+                vChangedBodies.push_back(_vPublishedBodies[ibody]);
+            }
+        }
+        return _nPublishedBodiesStamp;
+    }
+
     /// assumes GetMutex() and _mutexInterfaces are both exclusively locked
     virtual void _UpdatePublishedBodies()
     {
-        // updated the published bodies, resize dynamically in case an exception occurs
-        // when creating an item and bad data is left inside _vPublishedBodies
+        // states are updated in place. As long as the same body stays at the same position and its update stamp did not
+        // change, its state is kept as is, otherwise the state is refilled reusing the memory of the previous state at that position.
+        const uint64_t nNewStamp = _nPublishedBodiesStamp + 1;
+        bool bChanged = false;
+
+        const bool bBodiesModified = _nPublishedBodiesModifiedStamp != _nBodiesModifiedStamp || _vPublishedBodies.size() != _vPublishedBodyStamps.size();
+        _vPublishedPreviousBodies.resize(0);
+        if( bBodiesModified ) {
+            // save the previous bodies in order to detect the removed ones
+            for (const KinBody::BodyState& state : _vPublishedBodies) {
+                _vPublishedPreviousBodies.emplace_back(state.environmentid, state.pbody.get());
+            }
+        }
+
+        // resize dynamically in case an exception occurs when creating an item and bad data is left inside _vPublishedBodies
         _vPublishedBodies.resize(_GetNumBodies());
+        _vPublishedBodyStamps.resize(_vPublishedBodies.size(), 0);
         int iwritten = 0;
 
         std::vector<dReal> vdoflastsetvalues;
@@ -2682,35 +2744,104 @@ public:
             }
 
             KinBody::BodyState& state = _vPublishedBodies.at(iwritten);
-            state.Reset();
-            state.pbody = pbody;
-            pbody->GetLinkTransformations(state.vectrans, vdoflastsetvalues);
-            pbody->GetLinkEnableStates(state.vLinkEnableStates);
-            pbody->GetDOFValues(state.jointvalues);
-            pbody->GetGrabbedInfo(state.vGrabbedInfos);
-            state.strname =pbody->GetName();
-            state.uri = pbody->GetURI();
-            state.updatestamp = pbody->GetUpdateStamp();
-            state.environmentid = pbody->GetEnvironmentBodyIndex();
+            bool bStateChanged = false;
+            if( state.pbody != pbody || state.updatestamp != pbody->GetUpdateStamp() ) {
+                state.pbody = pbody;
+                pbody->GetLinkTransformations(state.vectrans, vdoflastsetvalues);
+                pbody->GetLinkEnableStates(state.vLinkEnableStates);
+                pbody->GetDOFValues(state.jointvalues);
+                pbody->GetGrabbedInfo(state.vGrabbedInfos);
+                state.strname = pbody->GetName();
+                state.uri = pbody->GetURI();
+                state.updatestamp = pbody->GetUpdateStamp();
+                state.environmentid = pbody->GetEnvironmentBodyIndex();
+                bStateChanged = true;
+            }
+
+            // the active manipulator and connected bodies can change without changing the update stamp
             if( pbody->IsRobot() ) {
                 RobotBasePtr probot = RaveInterfaceCast<RobotBase>(pbody);
                 if( !!probot ) {
                     RobotBase::ManipulatorPtr pmanip = probot->GetActiveManipulator();
                     if( !!pmanip ) {
-                        state.activeManipulatorName = pmanip->GetName();
-                        state.activeManipulatorTransform = pmanip->GetTransform();
+                        if( bStateChanged || state.activeManipulatorName != pmanip->GetName() ) {
+                            state.activeManipulatorName = pmanip->GetName();
+                            bStateChanged = true;
+                        }
+                        if( bStateChanged ) {
+                            // depends only on the link transforms
+                            state.activeManipulatorTransform = pmanip->GetTransform();
+                        }
+                    }
+                    else if( !state.activeManipulatorName.empty() ) {
+                        state.activeManipulatorName.clear();
+                        state.activeManipulatorTransform = Transform();
+                        bStateChanged = true;
+                    }
+                    probot->GetConnectedBodyActiveStates(_vPublishedConnectedBodyActiveStatesCache);
+                    if( _vPublishedConnectedBodyActiveStatesCache != state.vConnectedBodyActiveStates ) {
+                        state.vConnectedBodyActiveStates.swap(_vPublishedConnectedBodyActiveStatesCache);
+                        bStateChanged = true;
                     }
-                    probot->GetConnectedBodyActiveStates(state.vConnectedBodyActiveStates);
                 }
             }
+            else if( bStateChanged ) {
+                state.activeManipulatorName.clear();
+                state.activeManipulatorTransform = Transform();
+                state.vConnectedBodyActiveStates.clear();
+            }
+
+            if( bStateChanged ) {
+                _vPublishedBodyStamps.at(iwritten) = nNewStamp;
+                bChanged = true;
+            }
             ++iwritten;
         }
 
         if( iwritten < (int)_vPublishedBodies.size() ) {
             _vPublishedBodies.resize(iwritten);
+            _vPublishedBodyStamps.resize(iwritten);
+        }
+
+        if( bBodiesModified ) {
+            // both lists are sorted by environment body index, so merge them to find the bodies that are not published anymore
+            size_t inew = 0;
+            for (const std::pair<int, const KinBody*>& previous : _vPublishedPreviousBodies) {
+                while( inew < _vPublishedBodies.size() && _vPublishedBodies[inew].environmentid < previous.first ) {
+                    ++inew;
+                }
+                if( inew < _vPublishedBodies.size() && _vPublishedBodies[inew].environmentid == previous.first && _vPublishedBodies[inew].pbody.get() == previous.second ) {
+                    continue;
+                }
+                EnsureVectorSize(_vPublishedBodyRemovedStamps, previous.first+1);
+                _vPublishedBodyRemovedStamps.at(previous.first) = nNewStamp;
+                bChanged = true;
+            }
+            _nPublishedBodiesModifiedStamp = _nBodiesModifiedStamp;
+        }
+
+        if( bChanged ) {
+            _nPublishedBodiesStamp = nNewStamp;
         }
     }
 
+    /// \brief clears the published bodies and records them as removed
+    ///
+    /// assumes _mutexInterfaces is exclusively locked
+    void _ClearPublishedBodies()
+    {
+        if( _vPublishedBodies.empty() ) {
+            return;
+        }
+        ++_nPublishedBodiesStamp;
+        for (const KinBody::BodyState& state : _vPublishedBodies) {
+            EnsureVectorSize(_vPublishedBodyRemovedStamps, state.environmentid+1);
+            _vPublishedBodyRemovedStamps.at(state.environmentid) = _nPublishedBodiesStamp;
+        }
+        _vPublishedBodies.clear();
+        _vPublishedBodyStamps.clear();
+    }
+
     virtual std::pair<std::string, dReal> GetUnit() const
     {
         return std::make_pair(std::string(GetLengthUnitString(_unitInfo.lengthUnit)), 1.0 / GetLengthUnitStandardValue<dReal>(_unitInfo.lengthUnit));
@@ -3241,6 +3372,7 @@ public:
         const int envBodyIndex = itOld->second;
         _mapBodyNameIndex.erase(itOld);
         _mapBodyNameIndex[newName] = envBodyIndex;
+        _InvalidateBodiesSnapshot();
         RAVELOG_VERBOSE_FORMAT("env=%s, body \"%s\" is renamed to \"%s\"", GetNameId()%oldName%newName);
         return true;
     }
@@ -3267,6 +3399,7 @@ public:
         const int envBodyIndex = itOld->second;
         _mapBodyIdIndex.erase(itOld);
         _mapBodyIdIndex[newId] = envBodyIndex;
+        _InvalidateBodiesSnapshot();
         RAVELOG_VERBOSE_FORMAT("env=%s, body id changed from \"%s\" to \"%s\"", GetNameId()%oldId%newId);
         return true;
     }
@@ -3279,6 +3412,8 @@ protected:
         RAVELOG_DEBUG_FORMAT("env=%s, setting openrave home directory to %s", GetNameId()%_homedirectory);
 
         _nBodiesModifiedStamp = 0;
+        _nPublishedBodiesStamp = 0;
+        _nPublishedBodiesModifiedStamp = -1;
 
         _assignedBodySensorNameIdSuffix = 0;
 
@@ -3350,6 +3485,7 @@ protected:
         pbody.swap(pbodyref); // essentially resets _vecbodies[bodyIndex]
 
         _nBodiesModifiedStamp++;
+        _InvalidateBodiesSnapshot();
         return pbody;
     }
 
@@ -3389,6 +3525,7 @@ protected:
         }
 
         _nBodiesModifiedStamp = r->_nBodiesModifiedStamp;
+        _nPublishedBodiesModifiedStamp = -1; // bodies are replaced, so have to compare all published bodies on the next update
         _homedirectory = r->_homedirectory;
         _fDeltaSimTime = r->_fDeltaSimTime;
         _nCurSimTime = 0;
@@ -3425,8 +3562,9 @@ protected:
                 _mapBodyNameIndex.clear();
                 _mapBodyIdIndex.clear();
                 _environmentIndexRecyclePool.clear();
+                _InvalidateBodiesSnapshot();
 
-                _vPublishedBodies.clear();
+                _ClearPublishedBodies();
             }
         }
 
@@ -3503,6 +3641,7 @@ protected:
                 vecbodies.swap(_vecbodies);
                 mapBodyNameIndex.swap(_mapBodyNameIndex);
                 mapBodyIdIndex.swap(_mapBodyIdIndex);
+                _InvalidateBodiesSnapshot();
             }
             // first initialize the pointers
             list<KinBodyPtr> listToClone, listToCopyState;
@@ -3805,6 +3944,44 @@ protected:
             _mapBodyIdIndex[id] = envBodyIndex;
             //RAVELOG_DEBUG_FORMAT("env=%d: id=%s -> bodyIndex=%d, _mapBodyIdIndex has %d elements", GetId()%id%newBodyIndex%_mapBodyIdIndex.size());
         }
+        _InvalidateBodiesSnapshot();
+    }
+
+    /// \brief drops the published bodies snapshot so that the next reader rebuilds it
+    ///
+    /// has to be called every time _vecbodies, _mapBodyNameIndex or _mapBodyIdIndex change. assumes _mutexInterfaces is exclusively locked
+    inline void _InvalidateBodiesSnapshot()
+    {
+        std::atomic_store(&_pBodiesSnapshot, BodiesSnapshotConstPtr());
+    }
+
+    /// \brief returns the current bodies snapshot, building it if the bodies changed since it was last published
+    ///
+    /// Readers only take _mutexInterfaces when the snapshot has to be rebuilt. The snapshot is stored while the shared lock is
+    /// held, so it can never overwrite an invalidation made by a writer.
+    /// \param timeout in microseconds to wait for _mutexInterfaces, 0 waits forever. Returns null if it times out
+    BodiesSnapshotConstPtr _GetBodiesSnapshot(uint64_t timeout=0) const
+    {
+        BodiesSnapshotConstPtr psnapshot = std::atomic_load(&_pBodiesSnapshot);
+        if( !!psnapshot ) {
+            return psnapshot;
+        }
+
+        TimedSharedLock lock(_mutexInterfaces, timeout);
+        if (!lock) {
+            return BodiesSnapshotConstPtr();
+        }
+        psnapshot = std::atomic_load(&_pBodiesSnapshot);
+        if( !psnapshot ) {
+            std::shared_ptr<BodiesSnapshot> pnewsnapshot = std::make_shared<BodiesSnapshot>();
+            pnewsnapshot->nBodiesModifiedStamp = _nBodiesModifiedStamp;
+            pnewsnapshot->vecbodies = _vecbodies;
+            pnewsnapshot->mapBodyNameIndex = _mapBodyNameIndex;
+            pnewsnapshot->mapBodyIdIndex = _mapBodyIdIndex;
+            psnapshot = pnewsnapshot;
+            std::atomic_store(&_pBodiesSnapshot, psnapshot);
+        }
+        return psnapshot;
     }
 
     /// \brief assign body / sensor to unique id by adding suffix
@@ -4314,6 +4491,8 @@ protected:
     uint64_t _nSimStartTime;
     int _nBodiesModifiedStamp;     ///< incremented every tiem bodies vector is modified
 
+    mutable BodiesSnapshotConstPtr _pBodiesSnapshot; ///< published with copy-on-write, always accessed through std::atomic_load/std::atomic_store. null when the bodies changed since the last snapshot
+
     CollisionCheckerBasePtr _pCurrentChecker;
     PhysicsEngineBasePtr _pPhysicsEngine;
 
@@ -4328,6 +4507,12 @@ protected:
     mutable std::mutex _mutexInit;     ///< lock for destroying the environment
 
     vector<KinBody::BodyState> _vPublishedBodies; ///< protected by _mutexInterfaces
+    std::vector<uint64_t> _vPublishedBodyStamps; ///< for every element of _vPublishedBodies, the _nPublishedBodiesStamp when its state last changed. protected by _mutexInterfaces
+    std::vector<uint64_t> _vPublishedBodyRemovedStamps; ///< indexed by environment body index, the _nPublishedBodiesStamp when the published body at that index was last removed, 0 if never. protected by _mutexInterfaces
+    uint64_t _nPublishedBodiesStamp; ///< incremented by every update that changes the published bodies, see GetPublishedBodiesChangedSince. protected by _mutexInterfaces
+    int _nPublishedBodiesModifiedStamp; ///< _nBodiesModifiedStamp at the last update of the published bodies
+    std::vector< std::pair<int, const KinBody*> > _vPublishedPreviousBodies; ///< cache for _UpdatePublishedBodies
+    std::vector<int8_t> _vPublishedConnectedBodyActiveStatesCache; ///< cache for _UpdatePublishedBodies
     string _homedirectory;
     std::pair<std::string, dReal> _unit; ///< unit name mm, cm, inches, m and the conversion for meters
     UnitInfo _unitInfo; ///< unitInfo that describes length unit, mass unit, time unit and angle unit
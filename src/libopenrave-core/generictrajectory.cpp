@@ -16,6 +16,8 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "ravep.h"
 #include <boost/bind/bind.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/lambda/lambda.hpp>
 #include <boost/lexical_cast.hpp>
 #include <openrave/xmlreaders.h>
@@ -26,7 +28,9 @@ namespace OpenRAVE {
 
 // To distinguish between binary and XML trajectory files
 static const uint16_t BINARY_TRAJECTORY_MAGIC_NUMBER = 0x62ff;
-static const uint16_t BINARY_TRAJECTORY_VERSION_NUMBER = 0x0003;  // Version number for serialization
+static const uint16_t BINARY_TRAJECTORY_VERSION_NUMBER = 0x0004;  // Version number for serialization
+static const uint16_t BINARY_TRAJECTORY_DATA_ALIGNMENT = 64; // since version 0x0004, waypoints start at a multiple of this many bytes from the beginning of the trajectory
+static const uint16_t BINARY_TRAJECTORY_FLAG_TIMEINDEX = 0x0001; // since version 0x0004, the accumulated times and inverse delta times of the waypoints follow the waypoints
 
 static const dReal g_fEpsilonLinear = RavePow(g_fEpsilon,0.9);
 static const dReal g_fEpsilonQuadratic = RavePow(g_fEpsilon,0.45); // should be 0.6...perhaps this is related to parabolic smoother epsilons?
@@ -42,6 +46,11 @@ inline void WriteBinaryUInt32(std::ostream& f, uint32_t value)
     f.write((const char*) &value, sizeof(value));
 }
 
+inline void WriteBinaryUInt64(std::ostream& f, uint64_t value)
+{
+    f.write((const char*) &value, sizeof(value));
+}
+
 inline void WriteBinaryInt(std::ostream& f, int value)
 {
     f.write((const char*) &value, sizeof(value));
@@ -58,15 +67,12 @@ inline void WriteBinaryString(std::ostream& f, const std::string& s)
     }
 }
 
-inline void WriteBinaryVector(std::ostream&f, const std::vector<dReal>& v)
+inline void WriteBinaryValues(std::ostream& f, const dReal* pvalues, size_t numValues)
 {
-    // Indicate number of data points
-    const uint32_t numDataPoints = v.size();
-    WriteBinaryUInt32(f, numDataPoints);
-
-    // Write vector memory block to binary file
-    const uint64_t vectorLengthBytes = numDataPoints*sizeof(dReal);
-    f.write((const char*) &v[0], vectorLengthBytes);
+    if (numValues > 0)
+    {
+        f.write((const char*) pvalues, numValues*sizeof(dReal));
+    }
 }
 
 /* Helper functions for binary trajectory file reading */
@@ -84,6 +90,12 @@ inline bool ReadBinaryUInt32(std::istream& f, uint32_t& value)
     return !!f;
 }
 
+inline bool ReadBinaryUInt64(std::istream& f, uint64_t& value)
+{
+    f.read((char*) &value, sizeof(value));
+    return !!f;
+}
+
 inline bool ReadBinaryInt(std::istream& f, int& value)
 {
     f.read((char*) &value, sizeof(value));
@@ -133,6 +145,12 @@ inline void ReadBinaryUInt32(const uint8_t*& f, uint32_t& value)
     f += sizeof(uint32_t);
 }
 
+inline void ReadBinaryUInt64(const uint8_t*& f, uint64_t& value)
+{
+    std::copy(f, f+sizeof(value), (uint8_t*)&value);
+    f += sizeof(uint64_t);
+}
+
 inline void ReadBinaryInt(const uint8_t*& f, int& value)
 {
     value = *(int*)f;
@@ -167,11 +185,147 @@ inline void ReadBinaryVector(const uint8_t*& f, std::vector<dReal>& v)
     f += vectorLengthBytes;
 }
 
+/// \brief values of GenericTrajectory that are either owned or referenced in place from a read-only memory-mapped file
+///
+/// Element access is always const. The first modification of referenced values copies them, so a mapped region is never written to.
+class TrajectoryDataBuffer
+{
+public:
+    typedef const dReal* const_iterator;
+
+    TrajectoryDataBuffer() : _pvalues(NULL), _nvalues(0) {
+    }
+    TrajectoryDataBuffer(const TrajectoryDataBuffer& r) : _vvalues(r._vvalues), _pmapping(r._pmapping) {
+        _Sync(r);
+    }
+    TrajectoryDataBuffer& operator=(const TrajectoryDataBuffer& r) {
+        _vvalues = r._vvalues;
+        _pmapping = r._pmapping;
+        _Sync(r);
+        return *this;
+    }
+
+    inline size_t size() const {
+        return _nvalues;
+    }
+    inline bool empty() const {
+        return _nvalues == 0;
+    }
+    inline const dReal& operator[](size_t index) const {
+        return _pvalues[index];
+    }
+    inline const dReal& at(size_t index) const {
+        if( index >= _nvalues ) {
+            throw std::out_of_range("TrajectoryDataBuffer::at");
+        }
+        return _pvalues[index];
+    }
+    inline const dReal& back() const {
+        return at(_nvalues-1);
+    }
+    inline const_iterator begin() const {
+        return _pvalues;
+    }
+    inline const_iterator end() const {
+        return _pvalues + _nvalues;
+    }
+
+    /// \brief true if the values are referenced from a mapped region
+    inline bool IsMapped() const {
+        return !!_pmapping;
+    }
+
+    /// \brief returns an iterator to modify the values, copies them first if they are mapped
+    std::vector<dReal>::iterator GetWritableBegin() {
+        _MakeOwned();
+        return _vvalues.begin();
+    }
+
+    void clear() {
+        _pmapping.reset();
+        _vvalues.clear();
+        _Sync();
+    }
+
+    void resize(size_t count) {
+        _MakeOwned();
+        _vvalues.resize(count);
+        _Sync();
+    }
+
+    template <typename InputIterator>
+    void insert(const_iterator itpos, InputIterator itfirst, InputIterator itlast) {
+        const size_t index = itpos - begin();
+        _MakeOwned();
+        _vvalues.insert(_vvalues.begin()+index, itfirst, itlast);
+        _Sync();
+    }
+
+    void erase(const_iterator itfirst, const_iterator itlast) {
+        const size_t startindex = itfirst - begin(), endindex = itlast - begin();
+        _MakeOwned();
+        _vvalues.erase(_vvalues.begin()+startindex, _vvalues.begin()+endindex);
+        _Sync();
+    }
+
+    /// \brief owns the values of vvalues and returns the previously owned values in it
+    void swap(std::vector<dReal>& vvalues) {
+        _pmapping.reset();
+        _vvalues.swap(vvalues);
+        _Sync();
+    }
+
+    void swap(TrajectoryDataBuffer& r) {
+        // swapping vectors keeps their memory, so the cached pointers stay valid
+        _vvalues.swap(r._vvalues);
+        _pmapping.swap(r._pmapping);
+        std::swap(_pvalues, r._pvalues);
+        std::swap(_nvalues, r._nvalues);
+    }
+
+    /// \brief references count values starting at pvalues, which are kept valid by pmapping
+    void SetMappedData(const boost::shared_ptr<const void>& pmapping, const dReal* pvalues, size_t count) {
+        _vvalues.clear();
+        _pmapping = pmapping;
+        _pvalues = pvalues;
+        _nvalues = count;
+    }
+
+private:
+    void _MakeOwned() {
+        if( !!_pmapping ) {
+            _vvalues.assign(_pvalues, _pvalues + _nvalues);
+            _pmapping.reset();
+            _Sync();
+        }
+    }
+
+    void _Sync() {
+        _pvalues = _vvalues.data();
+        _nvalues = _vvalues.size();
+    }
+
+    void _Sync(const TrajectoryDataBuffer& r) {
+        if( !!_pmapping ) {
+            _pvalues = r._pvalues;
+            _nvalues = r._nvalues;
+        }
+        else {
+            _Sync();
+        }
+    }
+
+    std::vector<dReal> _vvalues; ///< owned values, empty if the values are mapped
+    boost::shared_ptr<const void> _pmapping; ///< if not empty, keeps the memory of the referenced values valid
+    const dReal* _pvalues; ///< points to the values, either _vvalues.data() or a mapped region
+    size_t _nvalues;
+};
+
 class GenericTrajectory : public TrajectoryBase
 {
     std::map<string,int> _maporder;
 public:
-    GenericTrajectory(EnvironmentBasePtr penv, std::istream& sinput) : TrajectoryBase(penv), _timeoffset(-1)
+    GenericTrajectory(EnvironmentBasePtr penv, std::istream& sinput) : TrajectoryBase(penv), _timeoffset(-1), _npolynomialdegree(0)
     {
         _maporder["deltatime"] = 0;
         _maporder["joint_snaps"] = 1;
@@ -279,7 +433,7 @@ public:
         OPENRAVE_ASSERT_OP(index*_spec.GetDOF(),<=,_vtrajdata.size());
         if( bOverwrite && index*_spec.GetDOF() < _vtrajdata.size() ) {
             const size_t copysize = min(nDataElements, _vtrajdata.size()-index*_spec.GetDOF());
-            std::copy(pdata, pdata+copysize, _vtrajdata.begin()+index*_spec.GetDOF());
+            std::copy(pdata, pdata+copysize, _vtrajdata.GetWritableBegin()+index*_spec.GetDOF());
             if( copysize < nDataElements ) {
                 _vtrajdata.insert(_vtrajdata.end(), pdata+copysize, pdata+nDataElements);
             }
@@ -317,7 +471,7 @@ public:
             std::vector<dReal>::iterator ittargetdata;
             if( bOverwrite && index*_spec.GetDOF() < _vtrajdata.size() ) {
                 size_t copyelements = min(numpoints,_vtrajdata.size()/_spec.GetDOF()-index);
-                ittargetdata = _vtrajdata.begin()+index*_spec.GetDOF();
+                ittargetdata = _vtrajdata.GetWritableBegin()+index*_spec.GetDOF();
                 _ConvertData(ittargetdata, pdata, vconvertgroups, spec, copyelements, false);
                 sourceindex = copyelements*spec.GetDOF();
                 index += copyelements;
@@ -357,11 +511,12 @@ public:
         }
         data.resize(0);
         data.resize(_spec.GetDOF(),0);
+        // a single time is interpolated directly, computing the coefficients of the whole segment only pays off for many times
         if( time >= GetDuration() ) {
             std::copy(_vtrajdata.end()-_spec.GetDOF(),_vtrajdata.end(),data.begin());
         }
         else {
-            std::vector<dReal>::iterator it = std::lower_bound(_vaccumtime.begin(),_vaccumtime.end(),time);
+            TrajectoryDataBuffer::const_iterator it = std::lower_bound(_vaccumtime.begin(),_vaccumtime.end(),time);
             if( it == _vaccumtime.begin() ) {
                 std::copy(_vtrajdata.begin(),_vtrajdata.begin()+_spec.GetDOF(),data.begin());
                 data.at(_timeoffset) = time;
@@ -407,7 +562,7 @@ public:
             ConfigurationSpecification::ConvertData(data.begin(),spec,_vtrajdata.end()-_spec.GetDOF(),_spec,1,GetEnv());
         }
         else {
-            std::vector<dReal>::iterator it = std::lower_bound(_vaccumtime.begin(),_vaccumtime.end(),time);
+            TrajectoryDataBuffer::const_iterator it = std::lower_bound(_vaccumtime.begin(),_vaccumtime.end(),time);
             if( it == _vaccumtime.begin() ) {
                 ConfigurationSpecification::ConvertData(data.begin(),spec,_vtrajdata.begin(),_spec,1,GetEnv());
             }
@@ -438,6 +593,40 @@ public:
         }
     }
 
+    void SamplePoints(std::vector<dReal>& data, const std::vector<dReal>& times) const override
+    {
+        if( !std::is_sorted(times.begin(), times.end()) ) {
+            TrajectoryBase::SamplePoints(data, times);
+            return;
+        }
+        BOOST_ASSERT(_bInit);
+        BOOST_ASSERT(_timeoffset>=0);
+        _ComputeInternal();
+        OPENRAVE_ASSERT_OP_FORMAT0((int)_vtrajdata.size(),>=,_spec.GetDOF(), "trajectory needs at least one point to sample from", ORE_InvalidArguments);
+        if( IS_DEBUGLEVEL(Level_Verbose) || (RaveGetDebugLevel() & Level_VerifyPlans) ) {
+            _VerifySampling();
+        }
+        data.resize(0);
+        data.resize(_spec.GetDOF()*times.size(),0);
+        if( times.size() > 0 ) {
+            _SampleSortedTimes(&times[0], times.size(), data.begin());
+        }
+    }
+
+    void SamplePoints(std::vector<dReal>& data, const std::vector<dReal>& times, const ConfigurationSpecification& spec) const override
+    {
+        if( spec == _spec ) {
+            SamplePoints(data, times);
+            return;
+        }
+        std::vector<dReal> dataInSourceSpec;
+        SamplePoints(dataInSourceSpec, times);
+        data.resize(spec.GetDOF()*times.size());
+        if( times.size() > 0 ) {
+            ConfigurationSpecification::ConvertData(data.begin(), spec, dataInSourceSpec.begin(), _spec, times.size(), GetEnv());
+        }
+    }
+
     void SamplePointsSameDeltaTime(std::vector<dReal>& data, dReal deltatime, bool ensureLastPoint) const override
     {
         BOOST_ASSERT(_bInit);
@@ -455,53 +644,20 @@ public:
         }
 
         int dof = GetConfigurationSpecification().GetDOF();
-        //std::vector<dReal> dataPerTimestep(dof,0);
         data.resize(dof*numPoints);
 
-        const std::vector<dReal>::const_iterator begin = _vaccumtime.begin();
-        std::vector<dReal>::const_iterator it = begin;
-
-        std::vector<dReal>::iterator itdata = data.begin();
-
-        for(int i = 0; i < (ensureLastPoint ? numPoints-1 : numPoints); ++i, itdata += dof) {
-            dReal sampletime = i * deltatime;
-            if( sampletime >= duration ) {
-                std::copy(_vtrajdata.end() - _spec.GetDOF(), _vtrajdata.end(), itdata);
-            }
-            else {
-                // knowing time always increases, it is safe to search in [it, end] instead of [begin, end]
-                it = std::lower_bound(it, _vaccumtime.cend(), sampletime);
-
-                if( it == begin ) {
-                    std::copy(_vtrajdata.begin(),_vtrajdata.begin()+_spec.GetDOF(),itdata);
-                    *(itdata + _timeoffset) = sampletime;
-                }
-                else {
-                    size_t index = it - begin;
-                    dReal timeFromLowerWaypoint = sampletime - _vaccumtime.at(index-1);
-                    dReal waypointdeltatime = _vtrajdata.at(_spec.GetDOF()*index + _timeoffset);
-                    // unfortunately due to floating-point error timeFromLowerWaypoint might not be in the range [0, waypointdeltatime], so double check!
-                    if( timeFromLowerWaypoint < 0 ) {
-                        // most likely small epsilon
-                        timeFromLowerWaypoint = 0;
-                    }
-                    else if( timeFromLowerWaypoint > waypointdeltatime ) {
-                        timeFromLowerWaypoint = waypointdeltatime;
-                    }
-                    for(size_t j = 0; j < _vgroupinterpolators.size(); ++j) {
-                        if( !!_vgroupinterpolators[j] ) {
-                            _vgroupinterpolators[j](index-1, timeFromLowerWaypoint, itdata);
-                        }
-                    }
-                    // should return the sample time relative to the last endpoint so it is easier to re-insert in the trajectory
-                    *(itdata + _timeoffset) = timeFromLowerWaypoint;
-                }
+        const int numSampledPoints = ensureLastPoint ? numPoints-1 : numPoints;
+        if( numSampledPoints > 0 ) {
+            std::vector<dReal> vsampletimes(numSampledPoints);
+            for(int i = 0; i < numSampledPoints; ++i) {
+                vsampletimes[i] = i * deltatime;
             }
+            _SampleSortedTimes(&vsampletimes[0], vsampletimes.size(), data.begin());
         }
 
-        if (ensureLastPoint) {
-            // copy the last point, itdata should point to that
-            std::copy(_vtrajdata.end() - _spec.GetDOF(), _vtrajdata.end(), itdata);
+        if (ensureLastPoint && numPoints > 0) {
+            // copy the last point
+            std::copy(_vtrajdata.end() - _spec.GetDOF(), _vtrajdata.end(), data.begin() + dof*numSampledPoints);
         }
     }
 
@@ -572,7 +728,7 @@ public:
         if( time >= _vaccumtime.at(_vaccumtime.size()-1) ) {
             return GetNumWaypoints();
         }
-        std::vector<dReal>::const_iterator itaccum = std::lower_bound(_vaccumtime.begin(), _vaccumtime.end(), time);
+        TrajectoryDataBuffer::const_iterator itaccum = std::lower_bound(_vaccumtime.begin(), _vaccumtime.end(), time);
         return itaccum-_vaccumtime.begin();
     }
 
@@ -593,46 +749,46 @@ public:
         else {
             // NOTE: Ignore 'options' argument for now
 
+            // the metadata is buffered in order to know how much padding the waypoints need to be aligned
+            std::stringstream ssmeta;
+
             // Write binary file header
-            WriteBinaryUInt16(O, BINARY_TRAJECTORY_MAGIC_NUMBER);
-            WriteBinaryUInt16(O, BINARY_TRAJECTORY_VERSION_NUMBER);
+            WriteBinaryUInt16(ssmeta, BINARY_TRAJECTORY_MAGIC_NUMBER);
+            WriteBinaryUInt16(ssmeta, BINARY_TRAJECTORY_VERSION_NUMBER);
 
             /* Store meta-data */
 
             // Indicate size of meta data
             const ConfigurationSpecification& spec = this->GetConfigurationSpecification();
             const uint16_t numGroups = spec._vgroups.size();
-            WriteBinaryUInt16(O, numGroups);
+            WriteBinaryUInt16(ssmeta, numGroups);
 
             FOREACHC(itgroup, spec._vgroups)
             {
-                WriteBinaryString(O, itgroup->name);   // Writes group name
-                WriteBinaryInt(O, itgroup->offset);    // Writes offset
-                WriteBinaryInt(O, itgroup->dof);       // Writes dof
-                WriteBinaryString(O, itgroup->interpolation);  // Writes interpolation
+                WriteBinaryString(ssmeta, itgroup->name);   // Writes group name
+                WriteBinaryInt(ssmeta, itgroup->offset);    // Writes offset
+                WriteBinaryInt(ssmeta, itgroup->dof);       // Writes dof
+                WriteBinaryString(ssmeta, itgroup->interpolation);  // Writes interpolation
             }
 
-            /* Store data waypoints */
-            WriteBinaryVector(O, this->_vtrajdata);
-
-            WriteBinaryString(O, GetDescription());
+            WriteBinaryString(ssmeta, GetDescription());
 
             // Readable interfaces, added on BINARY_TRAJECTORY_VERSION_NUMBER=0x0002
             std::stringstream ss;
             const uint16_t numReadableInterfaces = GetReadableInterfaces().size();
-            WriteBinaryUInt16(O, numReadableInterfaces);
+            WriteBinaryUInt16(ssmeta, numReadableInterfaces);
 
             rapidjson::Document document;
             int zerooptions = 0;
             FOREACHC(itReadableInterface, GetReadableInterfaces()) {
-                WriteBinaryString(O, itReadableInterface->first);  // readable interface id
+                WriteBinaryString(ssmeta, itReadableInterface->first);  // readable interface id
 
                 // try to serialize to json first
                 if (!!itReadableInterface->second) {
                     rapidjson::Value rReadable;
                     if( itReadableInterface->second->SerializeJSON(rReadable, document.GetAllocator(), fUnitScale, zerooptions) ) {
-                        WriteBinaryString(O, rReadable.GetString());
-                        WriteBinaryString(O, "StringReadable");
+                        WriteBinaryString(ssmeta, rReadable.GetString());
+                        WriteBinaryString(ssmeta, "StringReadable");
                         continue;
                     }
                     else {
@@ -647,8 +803,8 @@ public:
                             pHierarchical->SerializeXML(writer, options);
                             writer->Serialize(ss);
 
-                            WriteBinaryString(O, ss.str());
-                            WriteBinaryString(O, "HierarchicalXMLReadable");
+                            WriteBinaryString(ssmeta, ss.str());
+                            WriteBinaryString(ssmeta, "HierarchicalXMLReadable");
                             continue;
                         }
                         else {
@@ -657,8 +813,8 @@ public:
                                 ss.clear();
                                 ss.str(std::string());
                                 writer->Serialize(ss);
-                                WriteBinaryString(O, ss.str());
-                                WriteBinaryString(O, "StringReadable");
+                                WriteBinaryString(ssmeta, ss.str());
+                                WriteBinaryString(ssmeta, "StringReadable");
                                 continue;
                             }
                         }
@@ -666,12 +822,17 @@ public:
                 }
 
                 // if neither json or xml serializable, write an empty string
-                WriteBinaryString(O, "");
-                WriteBinaryString(O, "StringReadable");
+                WriteBinaryString(ssmeta, "");
+                WriteBinaryString(ssmeta, "StringReadable");
             }
+
+            const std::string smeta = ssmeta.str();
+            O.write(smeta.c_str(), smeta.size());
+            _SerializeBinaryWaypoints(O, smeta.size());
         }
     }
 
+
     void deserialize(std::istream& I) override
     {
         // Check whether binary or XML file
@@ -711,7 +872,11 @@ public:
             this->Init(_spec);
 
             /* Read trajectory data */
-            ReadBinaryVector(I, this->_vtrajdata);
+            if (versionNumber < 0x0004) {
+                std::vector<dReal> vtrajdata;
+                ReadBinaryVector(I, vtrajdata);
+                _vtrajdata.swap(vtrajdata);
+            }
             ReadBinaryString(I, __description);
 
             // clear out existing readable interfaces
@@ -758,6 +923,11 @@ public:
                     SetReadableInterface(xmlid, readableInterface);
                 }
             }
+
+            // versions >= 0x0004 have the waypoints at the end
+            if (versionNumber >= 0x0004) {
+                _DeserializeBinaryWaypoints(I);
+            }
         }
         else {
             // try XML deserialization
@@ -767,6 +937,27 @@ public:
     }
 
     void DeserializeFromRawData(const uint8_t* pdata, size_t nDataSize) override
+    {
+        _DeserializeFromRawData(pdata, nDataSize, boost::shared_ptr<const void>());
+    }
+
+    void DeserializeFromFile(const std::string& filename) override
+    {
+        boost::shared_ptr<boost::interprocess::mapped_region> pregion;
+        try {
+            // the region stays valid after the file mapping is closed
+            boost::interprocess::file_mapping mapping(filename.c_str(), boost::interprocess::read_only);
+            pregion.reset(new boost::interprocess::mapped_region(mapping, boost::interprocess::read_only));
+        }
+        catch(const boost::interprocess::interprocess_exception& ex) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("failed to map trajectory file %s: %s"), filename%ex.what(), ORE_InvalidArguments);
+        }
+        _DeserializeFromRawData(static_cast<const uint8_t*>(pregion->get_address()), pregion->get_size(), pregion);
+    }
+
+protected:
+    /// \brief deserializes from memory. If pmapping is not empty, it keeps pdata valid and the waypoints of version >= 0x0004 are referenced in place instead of copied.
+    void _DeserializeFromRawData(const uint8_t* pdata, size_t nDataSize, const boost::shared_ptr<const void>& pmapping)
     {
         // Check whether binary or XML file
         const uint8_t* I = pdata;
@@ -803,7 +994,11 @@ public:
             this->Init(_spec);
 
             /* Read trajectory data */
-            ReadBinaryVector(I, this->_vtrajdata);
+            if (versionNumber < 0x0004) {
+                std::vector<dReal> vtrajdata;
+                ReadBinaryVector(I, vtrajdata);
+                _vtrajdata.swap(vtrajdata);
+            }
             ReadBinaryString(I, __description);
 
             // clear out existing readable interfaces
@@ -850,6 +1045,11 @@ public:
                     SetReadableInterface(xmlid, readableInterface);
                 }
             }
+
+            // versions >= 0x0004 have the waypoints at the end
+            if (versionNumber >= 0x0004) {
+                _DeserializeBinaryWaypoints(I, pdata+nDataSize, pmapping);
+            }
         }
         else {
             // try XML deserialization
@@ -857,12 +1057,178 @@ public:
         }
     }
 
+    /// \brief writes the waypoints section of version 0x0004, which starts numPrecedingBytes after the beginning of the trajectory
+    ///
+    /// The waypoints are aligned to BINARY_TRAJECTORY_DATA_ALIGNMENT and followed by the accumulated time index if it can be computed, so a mapped file can be sampled without any preprocessing.
+    void _SerializeBinaryWaypoints(std::ostream& O, size_t numPrecedingBytes) const
+    {
+        bool bHasTimeIndex = false;
+        if( _timeoffset >= 0 && _vtrajdata.size() > 0 ) {
+            try {
+                _ComputeInternal();
+                bHasTimeIndex = !_bChanged;
+            }
+            catch(const openrave_exception& ex) {
+                RAVELOG_DEBUG_FORMAT("not writing the time index of the trajectory: %s", ex.what());
+            }
+        }
+
+        WriteBinaryUInt16(O, sizeof(dReal));
+        WriteBinaryUInt16(O, bHasTimeIndex ? BINARY_TRAJECTORY_FLAG_TIMEINDEX : 0);
+        WriteBinaryUInt64(O, _vtrajdata.size());
+        const size_t numUnpaddedBytes = numPrecedingBytes + 2*sizeof(uint16_t) + sizeof(uint64_t) + sizeof(uint16_t);
+        const uint16_t numPaddingBytes = (BINARY_TRAJECTORY_DATA_ALIGNMENT - numUnpaddedBytes%BINARY_TRAJECTORY_DATA_ALIGNMENT)%BINARY_TRAJECTORY_DATA_ALIGNMENT;
+        WriteBinaryUInt16(O, numPaddingBytes);
+        const char padding[BINARY_TRAJECTORY_DATA_ALIGNMENT] = {0};
+        O.write(padding, numPaddingBytes);
+
+        WriteBinaryValues(O, _vtrajdata.begin(), _vtrajdata.size());
+        if( bHasTimeIndex ) {
+            WriteBinaryValues(O, _vaccumtime.begin(), _vaccumtime.size());
+            WriteBinaryValues(O, _vdeltainvtime.begin(), _vdeltainvtime.size());
+        }
+    }
+
+    /// \brief throws if the waypoints section with the given counts does not fit in the numRemainingBytes bytes following its header
+    ///
+    /// Every count is checked separately against what is left, so corrupt counts cannot overflow the check.
+    static void _CheckBinaryWaypointsSize(uint64_t numRemainingBytes, uint16_t numPaddingBytes, uint64_t numDataElements, uint64_t numWaypoints)
+    {
+        if( numPaddingBytes > numRemainingBytes ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("trajectory data is truncated, expected %d padding bytes but %d bytes are left"), numPaddingBytes%numRemainingBytes, ORE_InvalidArguments);
+        }
+        const uint64_t numRemainingValues = (numRemainingBytes - numPaddingBytes)/sizeof(dReal);
+        if( numDataElements > numRemainingValues ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("trajectory data is truncated, expected %d values but %d are left"), numDataElements%numRemainingValues, ORE_InvalidArguments);
+        }
+        if( numWaypoints > (numRemainingValues - numDataElements)/2 ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("trajectory time index is truncated, expected %d waypoints but %d values are left"), numWaypoints%(numRemainingValues - numDataElements), ORE_InvalidArguments);
+        }
+    }
+
+    /// \brief reads numvalues values, growing v in bounded steps so that a corrupt count cannot allocate more than the stream holds
+    static void _ReadBinaryWaypointValues(std::istream& I, uint64_t numvalues, std::vector<dReal>& v)
+    {
+        static const uint64_t s_nReadStep = 1<<16;
+        v.resize(0);
+        while( v.size() < numvalues && !!I ) {
+            const size_t nstart = v.size();
+            const size_t ncount = std::min(numvalues - nstart, s_nReadStep);
+            v.resize(nstart + ncount);
+            I.read((char*)&v[nstart], ncount*sizeof(dReal));
+        }
+    }
+
+    /// \brief reads the waypoints section written by _SerializeBinaryWaypoints
+    void _DeserializeBinaryWaypoints(std::istream& I)
+    {
+        uint16_t realSize = 0, flags = 0, numPaddingBytes = 0;
+        uint64_t numDataElements = 0;
+        ReadBinaryUInt16(I, realSize);
+        ReadBinaryUInt16(I, flags);
+        ReadBinaryUInt64(I, numDataElements);
+        ReadBinaryUInt16(I, numPaddingBytes);
+        if( !I ) {
+            throw OPENRAVE_EXCEPTION_FORMAT0(_("failed to read trajectory waypoints header"), ORE_InvalidArguments);
+        }
+        if( realSize != sizeof(dReal) ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("trajectory waypoints have %d byte values, but expected %d"), realSize%sizeof(dReal), ORE_InvalidArguments);
+        }
+
+        const bool bHasTimeIndex = (flags & BINARY_TRAJECTORY_FLAG_TIMEINDEX) && _spec.GetDOF() > 0;
+        const uint64_t numWaypoints = bHasTimeIndex ? numDataElements/_spec.GetDOF() : 0;
+        // validate the counts against the rest of the stream before allocating. streams that cannot seek are only protected by the bounded reads
+        const std::istream::pos_type posdata = I.tellg();
+        if( posdata != std::istream::pos_type(-1) ) {
+            I.seekg(0, std::ios::end);
+            const std::istream::pos_type posend = I.tellg();
+            I.seekg(posdata);
+            if( posend != std::istream::pos_type(-1) ) {
+                _CheckBinaryWaypointsSize(posend >= posdata ? (uint64_t)(posend - posdata) : 0, numPaddingBytes, numDataElements, numWaypoints);
+            }
+        }
+        I.ignore(numPaddingBytes);
+
+        std::vector<dReal> vvalues;
+        _ReadBinaryWaypointValues(I, numDataElements, vvalues);
+        std::vector<dReal> vaccumtime, vdeltainvtime;
+        if( bHasTimeIndex ) {
+            _ReadBinaryWaypointValues(I, numWaypoints, vaccumtime);
+            _ReadBinaryWaypointValues(I, numWaypoints, vdeltainvtime);
+        }
+        if( !I ) {
+            throw OPENRAVE_EXCEPTION_FORMAT0(_("failed to read trajectory waypoints"), ORE_InvalidArguments);
+        }
+        _vtrajdata.swap(vvalues);
+        if( bHasTimeIndex ) {
+            _vaccumtime.swap(vaccumtime);
+            _vdeltainvtime.swap(vdeltainvtime);
+            _bChanged = false;
+            _bSamplingVerified = false;
+        }
+    }
+
+    /// \brief reads the waypoints section written by _SerializeBinaryWaypoints from memory ending at pend. If pmapping is not empty, the values are referenced in place when they are aligned.
+    void _DeserializeBinaryWaypoints(const uint8_t*& I, const uint8_t* pend, const boost::shared_ptr<const void>& pmapping)
+    {
+        uint16_t realSize = 0, flags = 0, numPaddingBytes = 0;
+        uint64_t numDataElements = 0;
+        if( pend - I < (std::ptrdiff_t)(3*sizeof(uint16_t) + sizeof(uint64_t)) ) {
+            throw OPENRAVE_EXCEPTION_FORMAT0(_("failed to read trajectory waypoints header"), ORE_InvalidArguments);
+        }
+        ReadBinaryUInt16(I, realSize);
+        ReadBinaryUInt16(I, flags);
+        ReadBinaryUInt64(I, numDataElements);
+        ReadBinaryUInt16(I, numPaddingBytes);
+        if( realSize != sizeof(dReal) ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("trajectory waypoints have %d byte values, but expected %d"), realSize%sizeof(dReal), ORE_InvalidArguments);
+        }
+
+        const bool bHasTimeIndex = (flags & BINARY_TRAJECTORY_FLAG_TIMEINDEX) && _spec.GetDOF() > 0;
+        const uint64_t numWaypoints = bHasTimeIndex ? numDataElements/_spec.GetDOF() : 0;
+        _CheckBinaryWaypointsSize(pend - I, numPaddingBytes, numDataElements, numWaypoints);
+        I += numPaddingBytes;
+
+        const dReal* pvalues = reinterpret_cast<const dReal*>(I);
+        const bool bInPlace = !!pmapping && reinterpret_cast<uintptr_t>(I) % sizeof(dReal) == 0;
+        if( bInPlace ) {
+            _vtrajdata.SetMappedData(pmapping, pvalues, numDataElements);
+            if( bHasTimeIndex ) {
+                _vaccumtime.SetMappedData(pmapping, pvalues + numDataElements, numWaypoints);
+                _vdeltainvtime.SetMappedData(pmapping, pvalues + numDataElements + numWaypoints, numWaypoints);
+            }
+        }
+        else {
+            std::vector<dReal> vvalues(numDataElements);
+            std::copy(I, I + numDataElements*sizeof(dReal), (uint8_t*)vvalues.data());
+            _vtrajdata.swap(vvalues);
+            if( bHasTimeIndex ) {
+                std::vector<dReal> vaccumtime(numWaypoints), vdeltainvtime(numWaypoints);
+                const uint8_t* ptimeindex = I + numDataElements*sizeof(dReal);
+                std::copy(ptimeindex, ptimeindex + numWaypoints*sizeof(dReal), (uint8_t*)vaccumtime.data());
+                ptimeindex += numWaypoints*sizeof(dReal);
+                std::copy(ptimeindex, ptimeindex + numWaypoints*sizeof(dReal), (uint8_t*)vdeltainvtime.data());
+                _vaccumtime.swap(vaccumtime);
+                _vdeltainvtime.swap(vdeltainvtime);
+            }
+        }
+        I += (numDataElements + 2*numWaypoints)*sizeof(dReal);
+        if( bHasTimeIndex ) {
+            _bChanged = false;
+            _bSamplingVerified = false;
+        }
+    }
+
+public:
+
     void Clone(InterfaceBaseConstPtr preference, int cloningoptions) override
     {
         InterfaceBase::Clone(preference,cloningoptions);
         TrajectoryBaseConstPtr r = RaveInterfaceConstCast<TrajectoryBase>(preference);
         Init(r->GetConfigurationSpecification());
-        r->GetWaypoints(0,r->GetNumWaypoints(),_vtrajdata);
+        std::vector<dReal> vtrajdata;
+        r->GetWaypoints(0,r->GetNumWaypoints(),vtrajdata);
+        _vtrajdata.swap(vtrajdata);
         _bChanged = true;
     }
 
@@ -878,9 +1244,9 @@ public:
         _viioffsets.swap(traj->_viioffsets);
         std::swap(_timeoffset, traj->_timeoffset);
         std::swap(_bInit, traj->_bInit);
-        std::swap(_vtrajdata, traj->_vtrajdata);
-        std::swap(_vaccumtime, traj->_vaccumtime);
-        std::swap(_vdeltainvtime, traj->_vdeltainvtime);
+        _vtrajdata.swap(traj->_vtrajdata);
+        _vaccumtime.swap(traj->_vaccumtime);
+        _vdeltainvtime.swap(traj->_vdeltainvtime);
         std::swap(_bChanged, traj->_bChanged);
         std::swap(_bSamplingVerified, traj->_bSamplingVerified);
         _InitializeGroupFunctions();
@@ -919,30 +1285,181 @@ protected:
         }
     }
 
+    /// \brief samples the trajectory at non-decreasing times and writes one point of _spec for every time starting at itdata.
+    ///
+    /// The waypoints are walked with a cursor instead of searching for every time. The coefficients of the groups in
+    /// _vpolynomialgroups are computed once per segment and evaluated for all of their dofs together, the rest of the groups
+    /// go through _vgroupinterpolators. Assumes _ComputeInternal has finished.
+    void _SampleSortedTimes(const dReal* ptimes, size_t numtimes, std::vector<dReal>::iterator itdata) const
+    {
+        const int dof = _spec.GetDOF();
+        const dReal duration = GetDuration();
+        const int numpolynomialdofs = _vpolynomialdataoffsets.size();
+        std::vector<dReal> vcoeffs(6*numpolynomialdofs, 0), vvalues(numpolynomialdofs); // room for up to quintic coefficients
+        size_t index = 0; // first waypoint whose accumulated time is not less than the current sample time
+        size_t coeffsindex = 0; // waypoint ending the segment that vcoeffs was computed for, 0 if none
+        for(size_t isample = 0; isample < numtimes; ++isample, itdata += dof) {
+            const dReal sampletime = ptimes[isample];
+            if( sampletime >= duration ) {
+                std::copy(_vtrajdata.end() - dof, _vtrajdata.end(), itdata);
+                continue;
+            }
+
+            // times are sorted and sampletime < duration, so the cursor never passes the last waypoint
+            while( _vaccumtime[index] < sampletime ) {
+                ++index;
+            }
+            if( index == 0 ) {
+                std::copy(_vtrajdata.begin(), _vtrajdata.begin() + dof, itdata);
+                *(itdata + _timeoffset) = sampletime;
+                continue;
+            }
+
+            dReal deltatime = sampletime - _vaccumtime[index-1];
+            const dReal waypointdeltatime = _vtrajdata[dof*index + _timeoffset];
+            // unfortunately due to floating-point error deltatime might not be in the range [0, waypointdeltatime], so double check!
+            if( deltatime < 0 ) {
+                // most likely small epsilon
+                deltatime = 0;
+            }
+            else if( deltatime > waypointdeltatime ) {
+                deltatime = waypointdeltatime;
+            }
+
+            if( deltatime <= g_fEpsilon || numpolynomialdofs == 0 ) {
+                // interpolators special-case samples right at the lower waypoint, so let them handle it
+                for(size_t igroup = 0; igroup < _vgroupinterpolators.size(); ++igroup) {
+                    if( !!_vgroupinterpolators[igroup] ) {
+                        _vgroupinterpolators[igroup](index-1, deltatime, itdata);
+                    }
+                }
+            }
+            else {
+                if( coeffsindex != index ) {
+                    _ComputeSegmentPolynomials(index-1, vcoeffs);
+                    coeffsindex = index;
+                }
+
+                // horner evaluation over all polynomial dofs at once
+                const dReal* pcoeffs = &vcoeffs[_npolynomialdegree*numpolynomialdofs];
+                dReal* pvalues = &vvalues[0];
+                for(int j = 0; j < numpolynomialdofs; ++j) {
+                    pvalues[j] = pcoeffs[j];
+                }
+                for(int k = _npolynomialdegree-1; k >= 0; --k) {
+                    pcoeffs = &vcoeffs[k*numpolynomialdofs];
+                    for(int j = 0; j < numpolynomialdofs; ++j) {
+                        pvalues[j] = pvalues[j]*deltatime + pcoeffs[j];
+                    }
+                }
+                for(int j = 0; j < numpolynomialdofs; ++j) {
+                    *(itdata + _vpolynomialdataoffsets[j]) = pvalues[j];
+                }
+
+                for(size_t igroup = 0; igroup < _vgroupinterpolators.size(); ++igroup) {
+                    if( _vgroupuseinterpolator[igroup] ) {
+                        _vgroupinterpolators[igroup](index-1, deltatime, itdata);
+                    }
+                }
+            }
+            // should return the sample time relative to the last endpoint so it is easier to re-insert in the trajectory
+            *(itdata + _timeoffset) = deltatime;
+        }
+    }
+
+    /// \brief computes the coefficients of all _vpolynomialgroups for the segment between waypoints ipoint and ipoint+1.
+    ///
+    /// vcoeffs[k*numpolynomialdofs + j] is the coefficient of t^k for polynomial dof j. Coefficients above the degree of a group are left untouched, so they have to be 0.
+    void _ComputeSegmentPolynomials(size_t ipoint, std::vector<dReal>& vcoeffs) const
+    {
+        const int dof = _spec.GetDOF();
+        const size_t numpolynomialdofs = _vpolynomialdataoffsets.size();
+        const dReal* pdata0 = &_vtrajdata[ipoint*dof];
+        const dReal* pdata1 = pdata0 + dof;
+        const dReal ideltatime = _vdeltainvtime[ipoint+1];
+        const dReal ideltatime2 = ideltatime*ideltatime;
+        const dReal ideltatime3 = ideltatime2*ideltatime;
+        const dReal ideltatime4 = ideltatime2*ideltatime2;
+        const dReal ideltatime5 = ideltatime4*ideltatime;
+        dReal* c0 = &vcoeffs[0];
+        dReal* c1 = c0 + numpolynomialdofs;
+        dReal* c2 = c1 + numpolynomialdofs;
+        dReal* c3 = c2 + numpolynomialdofs;
+        dReal* c4 = c3 + numpolynomialdofs;
+        dReal* c5 = c4 + numpolynomialdofs;
+        FOREACHC(itpolynomial, _vpolynomialgroups) {
+            const ConfigurationSpecification::Group& g = _spec._vgroups[itpolynomial->groupindex];
+            const int derivoffset = _vderivoffsets[g.offset];
+            const int ddoffset = _vddoffsets[g.offset];
+            for(int i = 0; i < g.dof; ++i) {
+                const size_t j = itpolynomial->polynomialoffset + i;
+                const dReal p0 = pdata0[g.offset+i];
+                c0[j] = p0;
+                switch(itpolynomial->degree) {
+                case 1:
+                    // same as _InterpolateLinear
+                    c1[j] = derivoffset < 0 ? (pdata1[g.offset+i] - p0)*ideltatime : pdata1[derivoffset+i];
+                    break;
+                case 2: {
+                    // same as _InterpolateQuadratic with derivatives
+                    const dReal deriv0 = pdata0[derivoffset+i], deriv1 = pdata1[derivoffset+i];
+                    c1[j] = deriv0;
+                    c2[j] = 0.5*ideltatime*(deriv1-deriv0);
+                    break;
+                }
+                case 3: {
+                    // same as _InterpolateCubic with derivatives
+                    const dReal deriv0 = pdata0[derivoffset+i], deriv1 = pdata1[derivoffset+i];
+                    const dReal px = pdata1[g.offset+i] - p0;
+                    c1[j] = deriv0;
+                    c2[j] = 3*px*ideltatime2 - (2*deriv0+deriv1)*ideltatime;
+                    c3[j] = (deriv1+deriv0)*ideltatime2 - 2*px*ideltatime3;
+                    break;
+                }
+                case 5: {
+                    // same as _InterpolateQuintic
+                    const dReal deriv0 = pdata0[derivoffset+i], deriv1 = pdata1[derivoffset+i];
+                    const dReal dd0 = pdata0[ddoffset+i], dd1 = pdata1[ddoffset+i];
+                    const dReal px = pdata1[g.offset+i] - p0;
+                    c1[j] = deriv0;
+                    c2[j] = 0.5*dd0;
+                    c3[j] = (-1.5*dd0 + dd1*0.5)*ideltatime + (-6*deriv0 - 4*deriv1)*ideltatime2 + px*10*ideltatime3;
+                    c4[j] = (1.5*dd0 - dd1)*ideltatime2 + (8*deriv0 + 7*deriv1)*ideltatime3 - px*15*ideltatime4;
+                    c5[j] = (-0.5*dd0 + dd1*0.5)*ideltatime3 - (3*deriv0 + 3*deriv1)*ideltatime4 + px*6*ideltatime5;
+                    break;
+                }
+                default:
+                    break;
+                }
+            }
+        }
+    }
+
     void _ComputeInternal() const
     {
         if( !_bChanged ) {
             return;
         }
-        if( _timeoffset < 0 ) {
-            _vaccumtime.resize(0);
-            _vdeltainvtime.resize(0);
-        }
-        else {
+        // clear first so that mapped values are not copied
+        _vaccumtime.clear();
+        _vdeltainvtime.clear();
+        if( _timeoffset >= 0 ) {
             _vaccumtime.resize(GetNumWaypoints());
             _vdeltainvtime.resize(_vaccumtime.size());
             if( _vaccumtime.size() == 0 ) {
                 return;
             }
-            _vaccumtime.at(0) = _vtrajdata.at(_timeoffset);
-            _vdeltainvtime.at(0) = 1/_vtrajdata.at(_timeoffset);
+            std::vector<dReal>::iterator itaccumtime = _vaccumtime.GetWritableBegin();
+            std::vector<dReal>::iterator itdeltainvtime = _vdeltainvtime.GetWritableBegin();
+            itaccumtime[0] = _vtrajdata.at(_timeoffset);
+            itdeltainvtime[0] = 1/_vtrajdata.at(_timeoffset);
             for(size_t i = 1; i < _vaccumtime.size(); ++i) {
                 dReal deltatime = _vtrajdata[_spec.GetDOF()*i+_timeoffset];
                 if( deltatime < 0 ) {
                     throw OPENRAVE_EXCEPTION_FORMAT("deltatime (%.15e) is < 0 at point %d/%d", deltatime%i%_vaccumtime.size(), ORE_InvalidState);
                 }
-                _vdeltainvtime[i] = 1/deltatime;
-                _vaccumtime[i] = _vaccumtime[i-1] + deltatime;
+                itdeltainvtime[i] = 1/deltatime;
+                itaccumtime[i] = itaccumtime[i-1] + deltatime;
             }
         }
         _bChanged = false;
@@ -989,11 +1506,15 @@ protected:
         _bSamplingVerified = true;
     }
 
-    /// \brief called in order to initialize _vgroupinterpolators and _vgroupvalidators, _vderivoffsets, _vintegraloffsets
+    /// \brief called in order to initialize _vgroupinterpolators and _vgroupvalidators, _vderivoffsets, _vintegraloffsets, _vpolynomialgroups
     void _InitializeGroupFunctions()
     {
         // first set sizes to 0
         _vgroupinterpolators.resize(0);
+        _vgroupuseinterpolator.resize(0);
+        _vpolynomialgroups.resize(0);
+        _vpolynomialdataoffsets.resize(0);
+        _npolynomialdegree = 0;
         _vgroupvalidators.resize(0);
         _vderivoffsets.resize(0);
         _vddoffsets.resize(0);
@@ -1007,6 +1528,7 @@ protected:
         _vdddoffsets.resize(_spec.GetDOF(),-1);
         _vintegraloffsets.resize(_spec.GetDOF(),-1);
         _viioffsets.resize(_spec.GetDOF(),-1);
+        std::vector<int> vpolynomialdegrees(_spec._vgroups.size(), 0); // degree of the interpolation if it can be evaluated from per-segment coefficients
         for(size_t i = 0; i < _spec._vgroups.size(); ++i) {
             const string& interpolation = _spec._vgroups[i].interpolation;
             int nNeedNeighboringInfo = 0;
@@ -1030,6 +1552,7 @@ protected:
                 else {
                     _vgroupinterpolators[i] = boost::bind(&GenericTrajectory::_InterpolateLinear,this,boost::ref(_spec._vgroups[i]),_1,_2,_3);
                     _vgroupvalidators[i] = boost::bind(&GenericTrajectory::_ValidateLinear,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                    vpolynomialdegrees[i] = 1;
                 }
                 nNeedNeighboringInfo = 2;
             }
@@ -1046,6 +1569,7 @@ protected:
                 else {
                     _vgroupinterpolators[i] = boost::bind(&GenericTrajectory::_InterpolateQuadratic,this,boost::ref(_spec._vgroups[i]),_1,_2,_3);
                     _vgroupvalidators[i] = boost::bind(&GenericTrajectory::_ValidateQuadratic,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                    vpolynomialdegrees[i] = 2;
                 }
                 nNeedNeighboringInfo = 3;
             }
@@ -1060,6 +1584,7 @@ protected:
                 else {
                     _vgroupinterpolators[i] = boost::bind(&GenericTrajectory::_InterpolateCubic,this,boost::ref(_spec._vgroups[i]),_1,_2,_3);
                     _vgroupvalidators[i] = boost::bind(&GenericTrajectory::_ValidateCubic,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                    vpolynomialdegrees[i] = 3;
                 }
                 nNeedNeighboringInfo = 3;
             }
@@ -1071,6 +1596,7 @@ protected:
             else if( interpolation == "quintic" ) {
                 _vgroupinterpolators[i] = boost::bind(&GenericTrajectory::_InterpolateQuintic,this,boost::ref(_spec._vgroups[i]),_1,_2,_3);
                 _vgroupvalidators[i] = boost::bind(&GenericTrajectory::_ValidateQuintic,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                vpolynomialdegrees[i] = 5;
                 nNeedNeighboringInfo = 3;
             }
             else if( interpolation == "sextic" ) {
@@ -1186,6 +1712,37 @@ protected:
                 }
             }
         }
+
+        // groups that can be sampled from per-segment polynomial coefficients, the rest are sampled with _vgroupinterpolators
+        _vgroupuseinterpolator.resize(_spec._vgroups.size(), 0);
+        for(size_t i = 0; i < _spec._vgroups.size(); ++i) {
+            const ConfigurationSpecification::Group& g = _spec._vgroups[i];
+            if( !_vgroupinterpolators[i] || g.offset == _timeoffset ) {
+                // deltatime is always overwritten after sampling
+                continue;
+            }
+            int degree = vpolynomialdegrees[i];
+            if( g.dof > 0 && degree > 1 ) {
+                // the interpolators fall back to integrals or throw when derivatives are missing
+                if( _vderivoffsets[g.offset] < 0 || (degree == 5 && _vddoffsets[g.offset] < 0) ) {
+                    degree = 0;
+                }
+            }
+            if( degree > 0 ) {
+                PolynomialGroup polynomial;
+                polynomial.groupindex = i;
+                polynomial.degree = degree;
+                polynomial.polynomialoffset = _vpolynomialdataoffsets.size();
+                _vpolynomialgroups.push_back(polynomial);
+                for(int j = 0; j < g.dof; ++j) {
+                    _vpolynomialdataoffsets.push_back(g.offset+j);
+                }
+                _npolynomialdegree = max(_npolynomialdegree, degree);
+            }
+            else {
+                _vgroupuseinterpolator[i] = 1;
+            }
+        }
     }
 
     void _InterpolatePrevious(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, const std::vector<dReal>::iterator& itdata)
@@ -1754,8 +2311,20 @@ protected:
     std::vector<int> _vintegraloffsets, _viioffsets; ///< for every group that relies on other info to compute its position, this will point to the integral offset (ie the position for a velocity group). -1 if invalid and not needed, -2 if invalid and needed
     int _timeoffset;
 
-    std::vector<dReal> _vtrajdata;
-    mutable std::vector<dReal> _vaccumtime, _vdeltainvtime;
+    /// \brief group whose interpolation is a polynomial that can be computed once per segment by _ComputeSegmentPolynomials
+    struct PolynomialGroup
+    {
+        int groupindex; ///< index into _spec._vgroups
+        int degree; ///< 1, 2, 3 or 5
+        int polynomialoffset; ///< index of the first dof of the group in _vpolynomialdataoffsets
+    };
+    std::vector<PolynomialGroup> _vpolynomialgroups;
+    std::vector<int> _vpolynomialdataoffsets; ///< for every dof of _vpolynomialgroups, its offset in the point data
+    std::vector<uint8_t> _vgroupuseinterpolator; ///< for every group, 1 if _SampleSortedTimes has to call its interpolator
+    int _npolynomialdegree; ///< max degree of _vpolynomialgroups
+
+    TrajectoryDataBuffer _vtrajdata;
+    mutable TrajectoryDataBuffer _vaccumtime, _vdeltainvtime;
     bool _bInit;
     mutable bool _bChanged; ///< if true, then _ComputeInternal() has to be called in order to compute _vaccumtime and _vdeltainvtime
     mutable bool _bSamplingVerified; ///< if false, then _VerifySampling() has not be called yet to verify that all points can be sampled.
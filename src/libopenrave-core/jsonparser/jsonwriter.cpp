@@ -27,7 +27,8 @@ namespace OpenRAVE {
 class EnvironmentJSONWriter
 {
 public:
-    EnvironmentJSONWriter(const AttributesList& atts, rapidjson::Value& rEnvironment, rapidjson::Document::AllocatorType& allocator) : _rEnvironment(rEnvironment), _allocator(allocator) {
+    /// \param bMsgPack true if the document is packed to msgpack, then the typed binary arrays keep their raw bytes
+    EnvironmentJSONWriter(const AttributesList& atts, rapidjson::Value& rEnvironment, rapidjson::Document::AllocatorType& allocator, bool bMsgPack=false) : _rEnvironment(rEnvironment), _allocator(allocator) {
         _serializeOptions = 0;
         FOREACHC(itatt,atts) {
             if( itatt->first == "openravescheme" ) {
@@ -35,7 +36,15 @@ public:
             }
             else if( itatt->first == "uriHint" ) {
                 if( itatt->second == "1" ) {
-                    _serializeOptions = ISO_ReferenceUriHint;
+                    _serializeOptions |= ISO_ReferenceUriHint;
+                }
+            }
+            else if( itatt->first == "binaryArrays" ) {
+                if( itatt->second == "1" ) {
+                    _serializeOptions |= ISO_BinaryArrays;
+                    if( bMsgPack ) {
+                        _serializeOptions |= ISO_RawBinaryArrays;
+                    }
                 }
             }
         }
@@ -314,7 +323,7 @@ void RaveWriteMsgPackFile(EnvironmentBasePtr penv, const std::string& filename,
     std::ofstream ofstream(filename.c_str());
     rapidjson::Document doc(&alloc);
 
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), true);
     jsonwriter.Write(penv);
     OpenRAVE::MsgPack::DumpMsgPack(doc, ofstream);
 }
@@ -324,7 +333,7 @@ void RaveWriteMsgPackFile(KinBodyPtr pbody, const std::string& filename, const A
     std::ofstream ofstream(filename.c_str());
     rapidjson::Document doc(&alloc);
 
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), true);
     jsonwriter.Write(pbody);
     OpenRAVE::MsgPack::DumpMsgPack(doc, ofstream);
 }
@@ -334,7 +343,7 @@ void RaveWriteMsgPackFile(const std::list<KinBodyPtr>& listbodies, const std::st
     std::ofstream ofstream(filename.c_str());
     rapidjson::Document doc(&alloc);
 
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), true);
     jsonwriter.Write(listbodies);
     OpenRAVE::MsgPack::DumpMsgPack(doc, ofstream);
 }
@@ -343,7 +352,7 @@ void RaveWriteMsgPackStream(EnvironmentBasePtr penv, ostream& os, const Attribut
 {
     rapidjson::Document doc(&alloc);
 
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), true);
     jsonwriter.Write(penv);
     OpenRAVE::MsgPack::DumpMsgPack(doc, os);
 }
@@ -352,7 +361,7 @@ void RaveWriteMsgPackStream(KinBodyPtr pbody, ostream& os, const AttributesList&
 {
     rapidjson::Document doc(&alloc);
 
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), true);
     jsonwriter.Write(pbody);
     OpenRAVE::MsgPack::DumpMsgPack(doc, os);
 }
@@ -361,7 +370,7 @@ void RaveWriteMsgPackStream(const std::list<KinBodyPtr>& listbodies, ostream& os
 {
     rapidjson::Document doc(&alloc);
 
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), true);
     jsonwriter.Write(listbodies);
     OpenRAVE::MsgPack::DumpMsgPack(doc, os);
 }
@@ -369,7 +378,7 @@ void RaveWriteMsgPackStream(const std::list<KinBodyPtr>& listbodies, ostream& os
 void RaveWriteMsgPackMemory(EnvironmentBasePtr penv, std::vector<char>& output, const AttributesList& atts, rapidjson::Document::AllocatorType& alloc)
 {
     rapidjson::Document doc(&alloc);
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), true);
     jsonwriter.Write(penv);
     OpenRAVE::MsgPack::DumpMsgPack(doc, output);
 }
@@ -378,7 +387,7 @@ void RaveWriteMsgPackMemory(KinBodyPtr pbody, std::vector<char>& output, const A
 {
     rapidjson::Document doc(&alloc);
 
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), true);
     jsonwriter.Write(pbody);
     OpenRAVE::MsgPack::DumpMsgPack(doc, output);
 }
@@ -387,7 +396,7 @@ void RaveWriteMsgPackMemory(const std::list<KinBodyPtr>& listbodies, std::vector
 {
     rapidjson::Document doc(&alloc);
 
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), true);
     jsonwriter.Write(listbodies);
     OpenRAVE::MsgPack::DumpMsgPack(doc, output);
 }
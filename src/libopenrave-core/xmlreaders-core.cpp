@@ -253,30 +253,31 @@ static bool _AssimpCreateGeometries(const aiScene* scene, aiNode* node, const Ve
         g._type = GT_TriMesh;
         g._vRenderScale = scale;
         aiMesh* input_mesh = scene->mMeshes[node->mMeshes[i]];
-        g._meshcollision.vertices.resize(input_mesh->mNumVertices);
+        TriMesh& meshcollision = g._meshcollision.GetWritable();
+        meshcollision.vertices.resize(input_mesh->mNumVertices);
         for (size_t j = 0; j < input_mesh->mNumVertices; j++) {
             aiVector3D p = input_mesh->mVertices[j];
             p *= transform;
-            g._meshcollision.vertices[j] = Vector(p.x*scale.x,p.y*scale.y,p.z*scale.z);
+            meshcollision.vertices[j] = Vector(p.x*scale.x,p.y*scale.y,p.z*scale.z);
         }
         size_t indexCount = 0;
         for (size_t j = 0; j < input_mesh->mNumFaces; j++) {
             aiFace& face = input_mesh->mFaces[j];
             indexCount += 3*(face.mNumIndices-2);
         }
-        g._meshcollision.indices.reserve(indexCount);
+        meshcollision.indices.reserve(indexCount);
         for (size_t j = 0; j < input_mesh->mNumFaces; j++) {
             aiFace& face = input_mesh->mFaces[j];
             if( face.mNumIndices == 3 ) {
-                g._meshcollision.indices.push_back(face.mIndices[0]);
-                g._meshcollision.indices.push_back(face.mIndices[1]);
-                g._meshcollision.indices.push_back(face.mIndices[2]);
+                meshcollision.indices.push_back(face.mIndices[0]);
+                meshcollision.indices.push_back(face.mIndices[1]);
+                meshcollision.indices.push_back(face.mIndices[2]);
             }
             else {
                 for (size_t k = 2; k < face.mNumIndices; ++k) {
-                    g._meshcollision.indices.push_back(face.mIndices[0]);
-                    g._meshcollision.indices.push_back(face.mIndices[k-1]);
-                    g._meshcollision.indices.push_back(face.mIndices[k]);
+                    meshcollision.indices.push_back(face.mIndices[0]);
+                    meshcollision.indices.push_back(face.mIndices[k-1]);
+                    meshcollision.indices.push_back(face.mIndices[k]);
                 }
             }
         }
@@ -365,7 +366,7 @@ static bool _ParseSpecialSTLFile(EnvironmentBasePtr penv, const std::string& fil
                     FOREACH(itgeom, listGeometries) {
                         itgeom->_vDiffuseColor = vcolor;
                         if( bTransformOffset ) {
-                            itgeom->_meshcollision.ApplyTransform(toffset.inverse());
+                            itgeom->_meshcollision.GetWritable().ApplyTransform(toffset.inverse());
                         }
                     }
                     return true;
@@ -812,7 +813,7 @@ public:
         g._vDiffuseColor=Vector(1,0.5f,0.5f,1);
         g._vAmbientColor=Vector(0.1,0.0f,0.0f,0);
         g._vRenderScale = vscale;
-        if( !CreateTriMeshFromFile(penv,filename,vscale,g._meshcollision,g._vDiffuseColor,g._vAmbientColor,g._fTransparency) ) {
+        if( !CreateTriMeshFromFile(penv,filename,vscale,g._meshcollision.GetWritable(),g._vDiffuseColor,g._vAmbientColor,g._fTransparency) ) {
             return false;
         }
         return true;
@@ -1032,7 +1033,7 @@ public:
                                 itnewgeom->_bModifiable = info->_bModifiable;
                                 itnewgeom->_fTransparency = info->_fTransparency;
                                 itnewgeom->_filenamerender = string("__norenderif__:")+extension;
-                                FOREACH(it,itnewgeom->_meshcollision.vertices) {
+                                FOREACH(it,itnewgeom->_meshcollision.GetWritable().vertices) {
                                     *it = tmres * *it;
                                 }
                                 if( geomreader->IsOverwriteDiffuse() ) {
@@ -1062,7 +1063,7 @@ public:
                         }
                         else {
                             info->_vRenderScale = info->_vRenderScale*geomspacescale;
-                            FOREACH(it,info->_meshcollision.vertices) {
+                            FOREACH(it,info->_meshcollision.GetWritable().vertices) {
                                 *it = tmres * *it;
                             }
                             Transform t = info->GetTransform();
@@ -1088,7 +1089,7 @@ public:
                         // call before attaching the geom
                         KinBody::Link::GeometryPtr geom(new KinBody::Link::Geometry(_plink,*info));
                         geom->_info.InitCollisionMesh();
-                        FOREACH(it,info->_meshcollision.vertices) {
+                        FOREACH(it,info->_meshcollision.GetWritable().vertices) {
                             *it = tmres * *it;
                         }
 
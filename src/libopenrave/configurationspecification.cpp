@@ -1796,11 +1796,20 @@ void ConfigurationSpecification::ConvertGroupData(std::vector<dReal>::iterator i
 }
 
 void ConfigurationSpecification::ConvertData(std::vector<dReal>::iterator ittargetdata, const ConfigurationSpecification &targetspec, std::vector<dReal>::const_iterator itsourcedata, const ConfigurationSpecification &sourcespec, size_t numpoints, EnvironmentBaseConstPtr penv, bool filluninitialized)
+{
+    if( numpoints == 0 ) {
+        // nothing to convert, and itsourcedata can be end() of an empty vector, which cannot be dereferenced
+        return;
+    }
+    ConvertData(ittargetdata, targetspec, &(*itsourcedata), sourcespec, numpoints, penv, filluninitialized);
+}
+
+void ConfigurationSpecification::ConvertData(std::vector<dReal>::iterator ittargetdata, const ConfigurationSpecification &targetspec, const dReal* psourcedata, const ConfigurationSpecification &sourcespec, size_t numpoints, EnvironmentBaseConstPtr penv, bool filluninitialized)
 {
     for(size_t igroup = 0; igroup < targetspec._vgroups.size(); ++igroup) {
         std::vector<ConfigurationSpecification::Group>::const_iterator itcompatgroup = sourcespec.FindCompatibleGroup(targetspec._vgroups[igroup]);
         if( itcompatgroup != sourcespec._vgroups.end() ) {
-            ConfigurationSpecification::ConvertGroupData(ittargetdata+targetspec._vgroups[igroup].offset, targetspec.GetDOF(), targetspec._vgroups[igroup], itsourcedata+itcompatgroup->offset, sourcespec.GetDOF(), *itcompatgroup,numpoints,penv,filluninitialized);
+            ConfigurationSpecification::ConvertGroupData(ittargetdata+targetspec._vgroups[igroup].offset, targetspec.GetDOF(), targetspec._vgroups[igroup], psourcedata+itcompatgroup->offset, sourcespec.GetDOF(), *itcompatgroup,numpoints,penv,filluninitialized);
         }
         else if( filluninitialized ) {
             vector<dReal> vdefaultvalues(targetspec._vgroups[igroup].dof,0);
@@ -133,6 +133,18 @@ bool IkSolverBase::SolveAll(const IkParameterization& param, int filteroptions,
     return vsolutions.size() > 0;
 }
 
+int IkSolverBase::SolveAllBatch(const std::vector<IkParameterization>& vparams, int filteroptions, std::vector< std::vector<IkReturnPtr> >& vikreturns)
+{
+    vikreturns.resize(vparams.size());
+    int numsolved = 0;
+    for(size_t i = 0; i < vparams.size(); ++i) {
+        if( SolveAll(vparams[i], filteroptions, vikreturns[i]) ) {
+            ++numsolved;
+        }
+    }
+    return numsolved;
+}
+
 bool IkSolverBase::Solve(const IkParameterization& param, const std::vector<dReal>& q0, const std::vector<dReal>& vFreeParameters, int filteroptions, IkReturnPtr ikreturn)
 {
     if( !ikreturn ) {
@@ -16,6 +16,8 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "libopenrave.h"
 #include <algorithm>
+#include <atomic>
+#include <random>
 
 // used for functions that are also used internally
 #define CHECK_NO_INTERNAL_COMPUTATION OPENRAVE_ASSERT_FORMAT(_nHierarchyComputed == 0, "env=%s, body %s cannot be added to environment when doing this operation, current value is %d", GetEnv()->GetNameId()%GetName()%_nHierarchyComputed, ORE_InvalidState);
@@ -435,9 +437,11 @@ KinBody::KinBody(InterfaceType type, EnvironmentBasePtr penv) : InterfaceBase(ty
     _environmentBodyIndex = 0;
     _nNonAdjacentLinkCache = 0x80000000;
     _nUpdateStampId = 0;
+    _nKinematicsGenerationId = 0;
     _bAreAllJoints1DOFAndNonCircular = false;
     _lastModifiedAtUS = 0;
     _revisionId = 0;
+    _pKinematicsGenerator = GetDefaultKinematicsGenerator();
 }
 
 KinBody::~KinBody()
@@ -484,6 +488,7 @@ void KinBody::Destroy()
     _vClosedLoopIndices.clear();
     _vForcedAdjacentLinks.clear();
     _nHierarchyComputed = 0;
+    _nKinematicsGenerationId = 0;
     _nParametersChanged = 0;
     _pManageData.reset();
 
@@ -3447,6 +3452,217 @@ void KinBody::ComputeHessianAxisAngle(int linkindex, std::vector<dReal>& hessian
     }
 }
 
+void KinBody::_UpdateKinematicsWorkspace(KinematicsWorkspace& workspace) const
+{
+    const size_t numjoints = _vecjoints.size() + _vPassiveJoints.size();
+    // the generation changes whenever the joints are rebuilt, so a workspace of a destroyed body or of the previous structure is never reused
+    if( workspace.pbody == this && workspace.nKinematicsGenerationId == _nKinematicsGenerationId && workspace.nUpdateStamp == _nUpdateStampId && workspace.vJointAnchors.size() == numjoints ) {
+        return;
+    }
+    workspace.vJointAxes.resize(3*numjoints);
+    workspace.vJointAnchors.resize(numjoints);
+    workspace.vJointDOFTypes.resize(3*numjoints);
+    workspace.vMimicPartials.resize(3*numjoints);
+    workspace.mapcachedpartials.clear();
+    for(size_t jointindex = 0; jointindex < numjoints; ++jointindex) {
+        const bool bPassive = jointindex >= _vecjoints.size();
+        const Joint& joint = bPassive ? *_vPassiveJoints[jointindex-_vecjoints.size()] : *_vecjoints[jointindex];
+        workspace.vJointAnchors[jointindex] = joint.GetAnchor();
+        for(int idof = 0; idof < joint.GetDOF() && idof < 3; ++idof) {
+            const size_t index = 3*jointindex+idof;
+            workspace.vMimicPartials[index].resize(0);
+            if( joint.IsRevolute(idof) ) {
+                workspace.vJointDOFTypes[index] = 1;
+                workspace.vJointAxes[index] = joint.GetAxis(idof);
+            }
+            else if( joint.IsPrismatic(idof) ) {
+                workspace.vJointDOFTypes[index] = 2;
+                workspace.vJointAxes[index] = joint.GetAxis(idof);
+            }
+            else {
+                workspace.vJointDOFTypes[index] = 0;
+                workspace.vJointAxes[index] = Vector();
+            }
+            if( bPassive && joint.IsMimic(idof) ) {
+                joint._ComputePartialVelocities(workspace.vMimicPartials[index], idof, workspace.mapcachedpartials);
+            }
+        }
+    }
+    workspace.pbody = this;
+    workspace.nKinematicsGenerationId = _nKinematicsGenerationId;
+    workspace.nUpdateStamp = _nUpdateStampId;
+}
+
+int KinBody::_PrepareKinematicsWorkspaceChain(KinematicsWorkspace& workspace, int linkindex, const std::vector<int>& dofindices) const
+{
+    CHECK_INTERNAL_COMPUTATION;
+    const int nlinks = _veclinks.size();
+    const int nActiveJoints = _vecjoints.size();
+    OPENRAVE_ASSERT_FORMAT(linkindex >= 0 && linkindex < nlinks, "body %s bad link index %d (num links %d)", GetName()%linkindex%nlinks, ORE_InvalidArguments);
+    _UpdateKinematicsWorkspace(workspace);
+
+    workspace.vDOFColumns.resize(GetDOF());
+    int dofstride;
+    if( dofindices.empty() ) {
+        dofstride = GetDOF();
+        for(int idof = 0; idof < dofstride; ++idof) {
+            workspace.vDOFColumns[idof] = idof;
+        }
+    }
+    else {
+        dofstride = dofindices.size();
+        std::fill(workspace.vDOFColumns.begin(), workspace.vDOFColumns.end(), -1);
+        for(int icolumn = 0; icolumn < dofstride; ++icolumn) {
+            workspace.vDOFColumns.at(dofindices[icolumn]) = icolumn;
+        }
+    }
+
+    // the chain goes from the base to linkindex, keep the capacities of the column vectors by never shrinking vChainColumns
+    workspace.vChainIndices.resize(0);
+    workspace.nChainSize = 0;
+    const int offset = linkindex*nlinks;
+    for(int curlink = 0; _vAllPairsShortestPaths[offset+curlink].first >= 0; curlink = _vAllPairsShortestPaths[offset+curlink].first) {
+        const int jointindex = _vAllPairsShortestPaths[offset+curlink].second;
+        const bool bPassive = jointindex >= nActiveJoints;
+        const Joint& joint = bPassive ? *_vPassiveJoints[jointindex-nActiveJoints] : *_vecjoints[jointindex];
+        if( !bPassive && !DoesAffect(jointindex, linkindex) ) {
+            continue;
+        }
+        for(int idof = 0; idof < joint.GetDOF() && idof < 3; ++idof) {
+            if( bPassive && !joint.IsMimic(idof) ) {
+                continue;
+            }
+            const int index = 3*jointindex+idof;
+            if( workspace.vJointDOFTypes[index] == 0 ) {
+                RAVELOG_WARN_FORMAT("body %s joint %s type 0x%x is not supported for jacobians", GetName()%joint.GetName()%joint.GetType());
+                continue;
+            }
+            if( (int)workspace.vChainColumns.size() <= workspace.nChainSize ) {
+                workspace.vChainColumns.resize(workspace.nChainSize+1);
+            }
+            std::vector< std::pair<int, dReal> >& vcolumns = workspace.vChainColumns[workspace.nChainSize];
+            vcolumns.resize(0);
+            if( bPassive ) {
+                FOREACHC(itpartial, workspace.vMimicPartials[index]) {
+                    const int column = workspace.vDOFColumns.at(itpartial->first);
+                    if( column >= 0 ) {
+                        vcolumns.emplace_back(column, itpartial->second);
+                    }
+                }
+            }
+            else if( workspace.vDOFColumns[joint.GetDOFIndex()+idof] >= 0 ) {
+                vcolumns.emplace_back(workspace.vDOFColumns[joint.GetDOFIndex()+idof], dReal(1));
+            }
+            if( vcolumns.size() > 0 ) {
+                workspace.vChainIndices.push_back(index);
+                workspace.nChainSize++;
+            }
+        }
+    }
+    return dofstride;
+}
+
+void KinBody::ComputeJacobianTranslation(KinematicsWorkspace& workspace, int linkindex, const Vector& position, dReal* jacobian, const std::vector<int>& dofindices) const
+{
+    const int dofstride = _PrepareKinematicsWorkspaceChain(workspace, linkindex, dofindices);
+    std::fill(jacobian, jacobian+3*dofstride, dReal(0));
+    for(int ichain = 0; ichain < workspace.nChainSize; ++ichain) {
+        const int index = workspace.vChainIndices[ichain];
+        Vector vcolumn = workspace.vJointAxes[index];
+        if( workspace.vJointDOFTypes[index] == 1 ) {
+            vcolumn = vcolumn.cross(position - workspace.vJointAnchors[index/3]);
+        }
+        FOREACHC(itcolumn, workspace.vChainColumns[ichain]) {
+            jacobian[itcolumn->first] += vcolumn.x*itcolumn->second;
+            jacobian[itcolumn->first+dofstride] += vcolumn.y*itcolumn->second;
+            jacobian[itcolumn->first+2*dofstride] += vcolumn.z*itcolumn->second;
+        }
+    }
+}
+
+void KinBody::ComputeJacobianAxisAngle(KinematicsWorkspace& workspace, int linkindex, dReal* jacobian, const std::vector<int>& dofindices) const
+{
+    const int dofstride = _PrepareKinematicsWorkspaceChain(workspace, linkindex, dofindices);
+    std::fill(jacobian, jacobian+3*dofstride, dReal(0));
+    for(int ichain = 0; ichain < workspace.nChainSize; ++ichain) {
+        const int index = workspace.vChainIndices[ichain];
+        if( workspace.vJointDOFTypes[index] != 1 ) {
+            continue; // prismatic joints do not change the orientation
+        }
+        const Vector& vcolumn = workspace.vJointAxes[index];
+        FOREACHC(itcolumn, workspace.vChainColumns[ichain]) {
+            jacobian[itcolumn->first] += vcolumn.x*itcolumn->second;
+            jacobian[itcolumn->first+dofstride] += vcolumn.y*itcolumn->second;
+            jacobian[itcolumn->first+2*dofstride] += vcolumn.z*itcolumn->second;
+        }
+    }
+}
+
+/// \brief adds v to the hessian entries of all column pairs of the two chain entries, and to the transposed entries if bSymmetric
+static void AddHessianColumns(dReal* hessian, int dofstride, const std::vector< std::pair<int, dReal> >& vcolumns0, const std::vector< std::pair<int, dReal> >& vcolumns1, const Vector& v, bool bSymmetric)
+{
+    FOREACHC(itcolumn0, vcolumns0) {
+        FOREACHC(itcolumn1, vcolumns1) {
+            const dReal fweight = itcolumn0->second*itcolumn1->second;
+            size_t indexoffset = 3*dofstride*itcolumn0->first+itcolumn1->first;
+            hessian[indexoffset] += v.x*fweight;
+            hessian[indexoffset+dofstride] += v.y*fweight;
+            hessian[indexoffset+2*dofstride] += v.z*fweight;
+            if( bSymmetric ) {
+                indexoffset = 3*dofstride*itcolumn1->first+itcolumn0->first;
+                hessian[indexoffset] += v.x*fweight;
+                hessian[indexoffset+dofstride] += v.y*fweight;
+                hessian[indexoffset+2*dofstride] += v.z*fweight;
+            }
+        }
+    }
+}
+
+void KinBody::ComputeHessianTranslation(KinematicsWorkspace& workspace, int linkindex, const Vector& position, dReal* hessian, const std::vector<int>& dofindices) const
+{
+    const int dofstride = _PrepareKinematicsWorkspaceChain(workspace, linkindex, dofindices);
+    std::fill(hessian, hessian+3*dofstride*dofstride, dReal(0));
+    workspace.vChainTranslations.resize(workspace.nChainSize);
+    for(int ichain = 0; ichain < workspace.nChainSize; ++ichain) {
+        const int index = workspace.vChainIndices[ichain];
+        workspace.vChainTranslations[ichain] = workspace.vJointAxes[index];
+        if( workspace.vJointDOFTypes[index] == 1 ) {
+            workspace.vChainTranslations[ichain] = workspace.vJointAxes[index].cross(position - workspace.vJointAnchors[index/3]);
+        }
+    }
+    // d^2p/dqi dqj = axis_i x J_j where joint i is closer to the base than joint j
+    for(int ichain = 0; ichain < workspace.nChainSize; ++ichain) {
+        const int index = workspace.vChainIndices[ichain];
+        if( workspace.vJointDOFTypes[index] != 1 ) {
+            continue;
+        }
+        for(int jchain = ichain; jchain < workspace.nChainSize; ++jchain) {
+            Vector v = workspace.vJointAxes[index].cross(workspace.vChainTranslations[jchain]);
+            AddHessianColumns(hessian, dofstride, workspace.vChainColumns[ichain], workspace.vChainColumns[jchain], v, jchain != ichain);
+        }
+    }
+}
+
+void KinBody::ComputeHessianAxisAngle(KinematicsWorkspace& workspace, int linkindex, dReal* hessian, const std::vector<int>& dofindices) const
+{
+    const int dofstride = _PrepareKinematicsWorkspaceChain(workspace, linkindex, dofindices);
+    std::fill(hessian, hessian+3*dofstride*dofstride, dReal(0));
+    for(int ichain = 0; ichain < workspace.nChainSize; ++ichain) {
+        const int index = workspace.vChainIndices[ichain];
+        if( workspace.vJointDOFTypes[index] != 1 ) {
+            continue;
+        }
+        for(int jchain = ichain+1; jchain < workspace.nChainSize; ++jchain) {
+            const int index2 = workspace.vChainIndices[jchain];
+            if( workspace.vJointDOFTypes[index2] != 1 ) {
+                continue;
+            }
+            Vector v = workspace.vJointAxes[index].cross(workspace.vJointAxes[index2]);
+            AddHessianColumns(hessian, dofstride, workspace.vChainColumns[ichain], workspace.vChainColumns[jchain], v, true);
+        }
+    }
+}
+
 void KinBody::ComputeInverseDynamics(std::vector<dReal>& doftorques, const std::vector<dReal>& vDOFAccelerations, const KinBody::ForceTorqueMap& mapExternalForceTorque) const
 {
     CHECK_INTERNAL_COMPUTATION;
@@ -3580,6 +3796,229 @@ void KinBody::ComputeInverseDynamics(std::vector<dReal>& doftorques, const std::
     }
 }
 
+bool KinBody::_CanComputeInverseDynamicsWithVelocities() const
+{
+    FOREACHC(itjoint, _vTopologicallySortedJointsAll) {
+        const Joint& joint = **itjoint;
+        if( joint.IsMimic() ) {
+            return false;
+        }
+        if( joint.GetDOFIndex() >= 0 ) {
+            if( joint.GetDOF() != 1 || (joint.GetType() != JointHinge && joint.GetType() != JointSlider) ) {
+                return false;
+            }
+        }
+        else if( !joint.IsStatic() ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void KinBody::_ComputeInverseDynamicsWithVelocities(dReal* doftorques, const dReal* dofvelocities, const dReal* dofaccelerations, const Vector& vgravity, InverseDynamicsWorkspace& workspace) const
+{
+    const size_t numlinks = _veclinks.size();
+    workspace.vLinkVelocities.resize(numlinks);
+    workspace.vLinkAccelerations.resize(numlinks);
+    workspace.vLinkForceTorques.resize(numlinks);
+    workspace.vLinkCOMs.resize(numlinks);
+    workspace.vLinkCOMLinearAccelerations.resize(numlinks);
+    workspace.vLinkCOMMomentOfInertia.resize(numlinks);
+    workspace.vlinkscomputed.resize(numlinks);
+    for(size_t ilink = 0; ilink < numlinks; ++ilink) {
+        workspace.vLinkVelocities[ilink].first = Vector();
+        workspace.vLinkVelocities[ilink].second = Vector();
+        workspace.vLinkAccelerations[ilink].first = Vector();
+        workspace.vLinkAccelerations[ilink].second = Vector();
+        workspace.vLinkForceTorques[ilink].first = Vector();
+        workspace.vLinkForceTorques[ilink].second = Vector();
+        workspace.vlinkscomputed[ilink] = 0;
+    }
+    std::fill(doftorques, doftorques+GetDOF(), dReal(0));
+    if( numlinks == 0 ) {
+        return;
+    }
+    workspace.vLinkAccelerations[0].first = -vgravity;
+    workspace.vlinkscomputed[0] = 1;
+
+    // forward recursion of the link velocities and accelerations, same equations as _ComputeDOFLinkVelocities and _ComputeLinkAccelerations
+    FOREACHC(itjoint, _vTopologicallySortedJointsAll) {
+        const Joint& joint = **itjoint;
+        int childindex = joint.GetHierarchyChildLink()->GetIndex();
+        if( workspace.vlinkscomputed[childindex] ) {
+            continue;
+        }
+        int parentindex = 0;
+        if( !!joint.GetHierarchyParentLink() ) {
+            parentindex = joint.GetHierarchyParentLink()->GetIndex();
+        }
+        const std::pair<Vector, Vector>& vParentVelocities = workspace.vLinkVelocities[parentindex];
+        const std::pair<Vector, Vector>& vParentAccelerations = workspace.vLinkAccelerations[parentindex];
+        std::pair<Vector, Vector>& vChildVelocities = workspace.vLinkVelocities[childindex];
+        std::pair<Vector, Vector>& vChildAccelerations = workspace.vLinkAccelerations[childindex];
+        const Vector& vchildorigin = _veclinks[childindex]->_info._t.trans;
+        Vector xyzdelta = vchildorigin - _veclinks[parentindex]->_info._t.trans;
+
+        dReal fvelocity = 0, facceleration = 0;
+        int dofindex = joint.GetDOFIndex();
+        if( dofindex >= 0 ) {
+            if( !!dofvelocities ) {
+                fvelocity = dofvelocities[dofindex];
+            }
+            if( !!dofaccelerations ) {
+                facceleration = dofaccelerations[dofindex];
+            }
+        }
+
+        vChildVelocities.first = vParentVelocities.first + vParentVelocities.second.cross(xyzdelta);
+        vChildVelocities.second = vParentVelocities.second;
+        vChildAccelerations.first = vParentAccelerations.first + vParentAccelerations.second.cross(xyzdelta) + vParentVelocities.second.cross(vParentVelocities.second.cross(xyzdelta));
+        vChildAccelerations.second = vParentAccelerations.second;
+        if( fvelocity != 0 || facceleration != 0 ) {
+            Transform tdelta = _veclinks[parentindex]->_info._t * joint.GetInternalHierarchyLeftTransform();
+            Vector vaxis = tdelta.rotate(joint.GetInternalHierarchyAxis(0));
+            if( joint.GetType() == JointHinge ) {
+                Vector vanchortochild = vchildorigin - tdelta.trans;
+                Vector gw = vaxis*fvelocity;
+                Vector vjointlinear = gw.cross(vanchortochild);
+                vChildVelocities.first += vjointlinear;
+                vChildVelocities.second += gw;
+                vChildAccelerations.first += vParentVelocities.second.cross(vjointlinear)*2 + gw.cross(vjointlinear) + (vaxis*facceleration).cross(vanchortochild);
+                vChildAccelerations.second += vParentVelocities.second.cross(gw) + vaxis*facceleration;
+            }
+            else {
+                Vector vjointlinear = vaxis*fvelocity;
+                vChildVelocities.first += vjointlinear;
+                vChildAccelerations.first += vParentVelocities.second.cross(vjointlinear)*2 + vaxis*facceleration;
+            }
+        }
+        workspace.vlinkscomputed[childindex] = 1;
+    }
+
+    for(size_t ilink = 0; ilink < numlinks; ++ilink) {
+        const Link& link = *_veclinks[ilink];
+        Transform tmassframe = link._info._t*link._info._tMassFrame;
+        workspace.vLinkCOMs[ilink] = tmassframe.trans;
+        Vector vglobalcomfromlink = tmassframe.trans - link._info._t.trans;
+        const Vector& vangularaccel = workspace.vLinkAccelerations[ilink].second;
+        const Vector& vangularvelocity = workspace.vLinkVelocities[ilink].second;
+        workspace.vLinkCOMLinearAccelerations[ilink] = workspace.vLinkAccelerations[ilink].first + vangularaccel.cross(vglobalcomfromlink) + vangularvelocity.cross(vangularvelocity.cross(vglobalcomfromlink));
+        TransformMatrix tm = link.GetGlobalInertia();
+        workspace.vLinkCOMMomentOfInertia[ilink] = tm.rotate(vangularaccel) + vangularvelocity.cross(tm.rotate(vangularvelocity));
+    }
+
+    // backward recursion, same as ComputeInverseDynamics
+    for(std::vector<JointPtr>::const_reverse_iterator itjoint = _vTopologicallySortedJointsAll.rbegin(); itjoint != _vTopologicallySortedJointsAll.rend(); ++itjoint) {
+        const Joint& joint = **itjoint;
+        int childindex = joint.GetHierarchyChildLink()->GetIndex();
+        Vector vcomforce = workspace.vLinkCOMLinearAccelerations[childindex]*joint.GetHierarchyChildLink()->GetMass() + workspace.vLinkForceTorques[childindex].first;
+        Vector vjointtorque = workspace.vLinkForceTorques[childindex].second + workspace.vLinkCOMMomentOfInertia[childindex];
+
+        if( !!joint.GetHierarchyParentLink() ) {
+            int parentindex = joint.GetHierarchyParentLink()->GetIndex();
+            Vector vchildcomtoparentcom = workspace.vLinkCOMs[childindex] - workspace.vLinkCOMs[parentindex];
+            workspace.vLinkForceTorques[parentindex].first += vcomforce;
+            workspace.vLinkForceTorques[parentindex].second += vjointtorque + vchildcomtoparentcom.cross(vcomforce);
+        }
+
+        int dofindex = joint.GetDOFIndex();
+        if( dofindex < 0 ) {
+            continue;
+        }
+        if( joint.GetType() == JointHinge ) {
+            Vector vcomtoanchor = workspace.vLinkCOMs[childindex] - joint.GetAnchor();
+            doftorques[dofindex] += joint.GetAxis(0).dot3(vjointtorque + vcomtoanchor.cross(vcomforce));
+        }
+        else {
+            doftorques[dofindex] += joint.GetAxis(0).dot3(vcomforce)/(2*PI);
+        }
+
+        if( !!joint._info._infoElectricMotor ) {
+            const ElectricMotorActuatorInfo& actuatorinfo = *joint._info._infoElectricMotor;
+            if( !!dofvelocities ) {
+                dReal fvelocity = dofvelocities[dofindex];
+                if( fvelocity > g_fEpsilonLinear ) {
+                    doftorques[dofindex] += actuatorinfo.coloumb_friction;
+                }
+                else if( fvelocity < -g_fEpsilonLinear ) {
+                    doftorques[dofindex] -= actuatorinfo.coloumb_friction;
+                }
+                doftorques[dofindex] += fvelocity*actuatorinfo.viscous_friction;
+            }
+            if( actuatorinfo.rotor_inertia > 0.0 && !!dofaccelerations ) {
+                doftorques[dofindex] += dofaccelerations[dofindex] * actuatorinfo.rotor_inertia * actuatorinfo.gear_ratio * actuatorinfo.gear_ratio;
+            }
+        }
+    }
+}
+
+void KinBody::ComputeInverseDynamicsWithVelocities(std::vector<dReal>& doftorques, const std::vector<dReal>& vDOFVelocities, const std::vector<dReal>& vDOFAccelerations, InverseDynamicsWorkspace& workspace) const
+{
+    CHECK_INTERNAL_COMPUTATION;
+    doftorques.resize(GetDOF());
+    if( _vecjoints.size() == 0 ) {
+        return;
+    }
+    if( !_CanComputeInverseDynamicsWithVelocities() ) {
+        ComputeInverseDynamics(doftorques, vDOFAccelerations);
+        return;
+    }
+    OPENRAVE_ASSERT_FORMAT0(vDOFVelocities.size() == 0 || (int)vDOFVelocities.size() == GetDOF(), "dof velocities have wrong size", ORE_InvalidArguments);
+    OPENRAVE_ASSERT_FORMAT0(vDOFAccelerations.size() == 0 || (int)vDOFAccelerations.size() == GetDOF(), "dof accelerations have wrong size", ORE_InvalidArguments);
+    _ComputeInverseDynamicsWithVelocities(doftorques.data(), vDOFVelocities.size() > 0 ? vDOFVelocities.data() : NULL, vDOFAccelerations.size() > 0 ? vDOFAccelerations.data() : NULL, GetEnv()->GetPhysicsEngine()->GetGravity(), workspace);
+}
+
+void KinBody::ComputeInverseDynamicsBatch(std::vector<dReal>& doftorques, const std::vector<dReal>& vDOFValues, const std::vector<dReal>& vDOFVelocities, const std::vector<dReal>& vDOFAccelerations, InverseDynamicsWorkspace& workspace)
+{
+    CHECK_INTERNAL_COMPUTATION;
+    const int dof = GetDOF();
+    if( dof == 0 ) {
+        doftorques.resize(0);
+        return;
+    }
+    OPENRAVE_ASSERT_OP_FORMAT0(vDOFValues.size() % dof, ==, 0, "dof values have wrong size", ORE_InvalidArguments);
+    const size_t numsamples = vDOFValues.size()/dof;
+    OPENRAVE_ASSERT_FORMAT0(vDOFVelocities.size() == 0 || vDOFVelocities.size() == vDOFValues.size(), "dof velocities have wrong size", ORE_InvalidArguments);
+    OPENRAVE_ASSERT_FORMAT0(vDOFAccelerations.size() == 0 || vDOFAccelerations.size() == vDOFValues.size(), "dof accelerations have wrong size", ORE_InvalidArguments);
+    doftorques.resize(vDOFValues.size());
+    if( numsamples == 0 ) {
+        return;
+    }
+
+    const Vector vgravity = GetEnv()->GetPhysicsEngine()->GetGravity();
+    const bool bDirect = _CanComputeInverseDynamicsWithVelocities();
+    KinBodyStateSaver saver(shared_kinbody(), bDirect ? Save_LinkTransformation : (Save_LinkTransformation|Save_LinkVelocities));
+
+    for(size_t isample = 0; isample < numsamples; ++isample) {
+        const size_t offset = isample*dof;
+        workspace.vDOFValues.assign(vDOFValues.begin()+offset, vDOFValues.begin()+offset+dof);
+        SetDOFValues(workspace.vDOFValues, CLA_Nothing);
+        const dReal* pdofvelocities = vDOFVelocities.size() > 0 ? &vDOFVelocities[offset] : NULL;
+        const dReal* pdofaccelerations = vDOFAccelerations.size() > 0 ? &vDOFAccelerations[offset] : NULL;
+        if( bDirect ) {
+            _ComputeInverseDynamicsWithVelocities(&doftorques[offset], pdofvelocities, pdofaccelerations, vgravity, workspace);
+        }
+        else {
+            // mimic joints, have to go through the physics engine for the velocities
+            if( !!pdofvelocities ) {
+                workspace.vDOFVelocities.assign(pdofvelocities, pdofvelocities+dof);
+            }
+            else {
+                workspace.vDOFVelocities.assign(dof, 0);
+            }
+            SetDOFVelocities(workspace.vDOFVelocities, CLA_Nothing);
+            if( !!pdofaccelerations ) {
+                workspace.vDOFAccelerations.assign(pdofaccelerations, pdofaccelerations+dof);
+            }
+            else {
+                workspace.vDOFAccelerations.resize(0);
+            }
+            ComputeInverseDynamics(workspace.vDOFTorques, workspace.vDOFAccelerations);
+            std::copy(workspace.vDOFTorques.begin(), workspace.vDOFTorques.end(), doftorques.begin()+offset);
+        }
+    }
+}
+
 void KinBody::ComputeInverseDynamics(boost::array< std::vector<dReal>, 3>& vDOFTorqueComponents, const std::vector<dReal>& vDOFAccelerations, const KinBody::ForceTorqueMap& mapExternalForceTorque) const
 {
     CHECK_INTERNAL_COMPUTATION;
@@ -4093,10 +4532,14 @@ CollisionCheckerBasePtr KinBody::GetSelfCollisionChecker() const
 }
 
 
+/// \brief source of KinBody::_nKinematicsGenerationId, shared by all bodies so that two structures never get the same id
+static std::atomic<uint64_t> s_nKinematicsGenerationId(0);
+
 void KinBody::_ComputeInternalInformation()
 {
     uint64_t starttime = utils::GetMicroTime();
     _nHierarchyComputed = 1;
+    _nKinematicsGenerationId = ++s_nKinematicsGenerationId;
 
     _vLinkTransformPointers.clear();
     if( !!_pCurrentKinematicsFunctions ) {
@@ -5465,6 +5908,8 @@ private:
 
     CHECK_INTERNAL_COMPUTATION;
     if( _nNonAdjacentLinkCache & 0x80000000 ) {
+        const std::vector<int>& vNeverCollidingLinkPairs = GetNeverCollidingLinkPairs(); // before the transforms are modified
+
         // Check for colliding link pairs given the initial pose _vInitialLinkTransformations
         // this is actually weird, we need to call the individual link collisions on a const body. in order to pull this off, we need to be very careful with the body state.
         TransformsSaver saver(shared_kinbody_const());
@@ -5479,7 +5924,10 @@ private:
         for(size_t ind0 = 0; ind0 < _veclinks.size(); ++ind0) {
             for(size_t ind1 = ind0+1; ind1 < _veclinks.size(); ++ind1) {
                 const bool bAdjacent = AreAdjacentLinks(ind0, ind1);
-                if(!bAdjacent && !collisionchecker->CheckCollision(LinkConstPtr(_veclinks[ind0]), LinkConstPtr(_veclinks[ind1])) ) {
+                if( bAdjacent || std::binary_search(vNeverCollidingLinkPairs.begin(), vNeverCollidingLinkPairs.end(), int(ind0|(ind1<<16))) ) {
+                    continue;
+                }
+                if( !collisionchecker->CheckCollision(LinkConstPtr(_veclinks[ind0]), LinkConstPtr(_veclinks[ind1])) ) {
                     _vNonAdjacentLinks[0].push_back(ind0|(ind1<<16));
                 }
             }
@@ -5509,6 +5957,208 @@ private:
     return _vNonAdjacentLinks.at(adjacentoptions);
 }
 
+void KinBody::ComputeLinkPairCollisionClasses(int numsamples, dReal fSafetyMargin, std::vector<int>& vNeverCollidingLinkPairs, std::vector<int>& vAlwaysCollidingLinkPairs)
+{
+    CHECK_INTERNAL_COMPUTATION;
+    OPENRAVE_ASSERT_OP(numsamples,>,0);
+    vNeverCollidingLinkPairs.resize(0);
+    vAlwaysCollidingLinkPairs.resize(0);
+
+    // pairs whose links do not move relative to each other only need to be checked once. ignores closed loops.
+    std::vector<int> vlinkpairs;
+    std::vector<uint8_t> vrigidpairs;
+    for(int ind0 = 0; ind0 < (int)_veclinks.size(); ++ind0) {
+        for(int ind1 = ind0+1; ind1 < (int)_veclinks.size(); ++ind1) {
+            if( AreAdjacentLinks(ind0, ind1) ) {
+                continue;
+            }
+            uint8_t bRigid = 1;
+            for(int idof = 0; idof < GetDOF(); ++idof) {
+                if( (DoesDOFAffectLink(idof, ind0) != 0) != (DoesDOFAffectLink(idof, ind1) != 0) ) {
+                    bRigid = 0;
+                    break;
+                }
+            }
+            vlinkpairs.push_back(ind0|(ind1<<16));
+            vrigidpairs.push_back(bRigid);
+        }
+    }
+
+    KinBodyStateSaver saver(shared_kinbody(), Save_LinkTransformation|Save_LinkEnable);
+    for(size_t ilink = 0; ilink < _veclinks.size(); ++ilink) {
+        _veclinks[ilink]->Enable(true);
+    }
+    CollisionCheckerBasePtr collisionchecker = !!_selfcollisionchecker ? _selfcollisionchecker : GetEnv()->GetCollisionChecker();
+    CollisionOptionsStateSaver colsaver(collisionchecker, fSafetyMargin > 0 ? CO_Distance : 0);
+    CollisionReportPtr report;
+    if( fSafetyMargin > 0 ) {
+        report.reset(new CollisionReport());
+    }
+
+    std::vector<int> vnumcollisions(vlinkpairs.size(), 0); ///< number of samples the pair collided in
+    std::vector<uint8_t> vnear(vlinkpairs.size(), 0); ///< 1 if the pair collided or came closer than fSafetyMargin
+    std::vector<int> vnumchecked(vlinkpairs.size(), 0);
+    std::vector<dReal> vlower, vupper, vvalues(GetDOF());
+    GetDOFLimits(vlower, vupper);
+    std::mt19937 generator(0); // fixed seed so that the analysis is reproducible
+    std::uniform_real_distribution<dReal> distribution(0, 1);
+    for(int isample = 0; isample < numsamples; ++isample) {
+        for(int idof = 0; idof < GetDOF(); ++idof) {
+            dReal flower = vlower[idof], fupper = vupper[idof];
+            const Joint& joint = _GetJointFromDOFIndex(idof);
+            const int iaxis = idof - joint.GetDOFIndex();
+            if( (joint.IsRevolute(iaxis) || joint.IsCircular(iaxis)) && fupper - flower > 2*PI ) {
+                // rotations covering more than one revolution only need to be sampled over one
+                fupper = flower + 2*PI;
+            }
+            vvalues[idof] = flower + distribution(generator)*(fupper - flower);
+        }
+        SetDOFValues(vvalues, CLA_Nothing);
+
+        for(size_t ipair = 0; ipair < vlinkpairs.size(); ++ipair) {
+            if( vrigidpairs[ipair] && vnumchecked[ipair] > 0 ) {
+                continue;
+            }
+            if( vnumcollisions[ipair] > 0 && vnumcollisions[ipair] < vnumchecked[ipair] ) {
+                continue; // already known to sometimes collide
+            }
+            LinkConstPtr plink0(_veclinks.at(vlinkpairs[ipair]&0xffff)), plink1(_veclinks.at(vlinkpairs[ipair]>>16));
+            const bool bCollision = collisionchecker->CheckCollision(plink0, plink1, report);
+            ++vnumchecked[ipair];
+            if( bCollision ) {
+                ++vnumcollisions[ipair];
+                vnear[ipair] = 1;
+            }
+            else if( fSafetyMargin > 0 && report->minDistance <= fSafetyMargin ) {
+                vnear[ipair] = 1;
+            }
+        }
+    }
+
+    for(size_t ipair = 0; ipair < vlinkpairs.size(); ++ipair) {
+        if( !vnear[ipair] ) {
+            vNeverCollidingLinkPairs.push_back(vlinkpairs[ipair]);
+        }
+        else if( vnumcollisions[ipair] == vnumchecked[ipair] ) {
+            vAlwaysCollidingLinkPairs.push_back(vlinkpairs[ipair]);
+        }
+    }
+    RAVELOG_DEBUG_FORMAT("env=%s, body %s has %d never and %d always colliding link pairs out of %d non-adjacent pairs over %d samples", GetEnv()->GetNameId()%GetName()%vNeverCollidingLinkPairs.size()%vAlwaysCollidingLinkPairs.size()%vlinkpairs.size()%numsamples);
+}
+
+static std::string _GetNeverCollidingLinkPairsFilename(const std::string& hash)
+{
+    return std::string("selfcollision.") + hash + ".neverpairs.txt";
+}
+
+/// \brief returns true if the limits of every dof are within the outer limits
+static bool _AreDOFLimitsWithin(const std::vector<dReal>& vlower, const std::vector<dReal>& vupper, const std::vector<dReal>& vouterlower, const std::vector<dReal>& vouterupper)
+{
+    if( vlower.size() != vouterlower.size() || vupper.size() != vouterupper.size() ) {
+        return false;
+    }
+    for(size_t idof = 0; idof < vlower.size(); ++idof) {
+        if( vlower[idof] < vouterlower[idof] - g_fEpsilonJointLimit || vupper[idof] > vouterupper[idof] + g_fEpsilonJointLimit ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void KinBody::SetNeverCollidingLinkPairs(const std::vector<int>& vNeverCollidingLinkPairs)
+{
+    _vNeverCollidingLinkPairs = vNeverCollidingLinkPairs;
+    std::sort(_vNeverCollidingLinkPairs.begin(), _vNeverCollidingLinkPairs.end());
+    _sNeverCollidingLinkPairsHash = GetKinematicsGeometryHash();
+    GetDOFLimits(_vNeverCollidingLinkPairsLower, _vNeverCollidingLinkPairsUpper);
+    _ResetInternalCollisionCache();
+}
+
+const std::vector<int>& KinBody::GetNeverCollidingLinkPairs() const
+{
+    const std::string& hash = GetKinematicsGeometryHash();
+    std::vector<dReal> vlower, vupper;
+    GetDOFLimits(vlower, vupper);
+    if( _sNeverCollidingLinkPairsHash != hash || !_AreDOFLimitsWithin(vlower, vupper, _vNeverCollidingLinkPairsLower, _vNeverCollidingLinkPairsUpper) ) {
+        _sNeverCollidingLinkPairsHash = hash;
+        _vNeverCollidingLinkPairs.resize(0);
+        _vNeverCollidingLinkPairsLower = vlower;
+        _vNeverCollidingLinkPairsUpper = vupper;
+        const std::string fullfilename = RaveFindDatabaseFile(_GetNeverCollidingLinkPairsFilename(hash), true);
+        if( fullfilename.size() > 0 ) {
+            std::ifstream f(fullfilename.c_str());
+            std::string line;
+            int ind0, ind1;
+            std::vector<int> vlinkpairs;
+            std::vector<dReal> vfilelower, vfileupper;
+            bool bValid = true;
+            while( std::getline(f, line) ) {
+                if( line.size() == 0 || line[0] == '#' ) {
+                    continue;
+                }
+                std::stringstream ssline(line);
+                if( line.compare(0, 7, "limits ") == 0 ) {
+                    std::string keyword;
+                    dReal flower, fupper;
+                    ssline >> keyword;
+                    while( ssline >> flower >> fupper ) {
+                        vfilelower.push_back(flower);
+                        vfileupper.push_back(fupper);
+                    }
+                    continue;
+                }
+                if( !(ssline >> ind0 >> ind1) ) {
+                    ind0 = ind1 = -1;
+                }
+                if( ind0 < 0 || ind1 <= ind0 || ind1 >= (int)_veclinks.size() ) {
+                    RAVELOG_WARN_FORMAT("env=%s, body %s has invalid link pair (%d, %d) in %s, ignoring the file", GetEnv()->GetNameId()%GetName()%ind0%ind1%fullfilename);
+                    bValid = false;
+                    break;
+                }
+                vlinkpairs.push_back(ind0|(ind1<<16));
+            }
+            if( bValid && !_AreDOFLimitsWithin(vlower, vupper, vfilelower, vfileupper) ) {
+                // pairs that never collide within the analyzed limits might collide outside of them
+                RAVELOG_DEBUG_FORMAT("env=%s, dof limits of body %s are not within the limits %s was computed for, ignoring the file", GetEnv()->GetNameId()%GetName()%fullfilename);
+                bValid = false;
+            }
+            if( bValid ) {
+                _vNeverCollidingLinkPairs.swap(vlinkpairs);
+                std::sort(_vNeverCollidingLinkPairs.begin(), _vNeverCollidingLinkPairs.end());
+                _vNeverCollidingLinkPairsLower.swap(vfilelower);
+                _vNeverCollidingLinkPairsUpper.swap(vfileupper);
+                RAVELOG_DEBUG_FORMAT("env=%s, loaded %d never colliding link pairs of body %s from %s", GetEnv()->GetNameId()%_vNeverCollidingLinkPairs.size()%GetName()%fullfilename);
+            }
+        }
+    }
+    return _vNeverCollidingLinkPairs;
+}
+
+bool KinBody::SaveNeverCollidingLinkPairs() const
+{
+    const std::vector<int>& vNeverCollidingLinkPairs = GetNeverCollidingLinkPairs();
+    const std::string fullfilename = RaveFindDatabaseFile(_GetNeverCollidingLinkPairsFilename(GetKinematicsGeometryHash()), false);
+    if( fullfilename.size() == 0 ) {
+        return false;
+    }
+    std::ofstream f(fullfilename.c_str());
+    if( !f ) {
+        RAVELOG_WARN_FORMAT("env=%s, failed to write never colliding link pairs of body %s to %s", GetEnv()->GetNameId()%GetName()%fullfilename);
+        return false;
+    }
+    f << "# never colliding link pairs of " << GetName() << ", one pair of link indices per line" << std::endl;
+    f << "# the pairs are valid as long as the dof limits are within the lower and upper limits of every dof below" << std::endl;
+    f << std::setprecision(std::numeric_limits<dReal>::digits10+2) << "limits";
+    for(size_t idof = 0; idof < _vNeverCollidingLinkPairsLower.size(); ++idof) {
+        f << " " << _vNeverCollidingLinkPairsLower[idof] << " " << _vNeverCollidingLinkPairsUpper[idof];
+    }
+    f << std::endl;
+    FOREACHC(itpair, vNeverCollidingLinkPairs) {
+        f << (*itpair&0xffff) << " " << (*itpair>>16) << std::endl;
+    }
+    return !!f;
+}
+
 bool KinBody::AreAdjacentLinks(int linkindex0, int linkindex1) const
 {
     CHECK_INTERNAL_COMPUTATION;
@@ -5662,6 +6312,10 @@ void KinBody::Clone(InterfaceBaseConstPtr preference, int cloningoptions)
     _vAdjacentLinks = r->_vAdjacentLinks;
     _vInitialLinkTransformations = r->_vInitialLinkTransformations;
     _vForcedAdjacentLinks = r->_vForcedAdjacentLinks;
+    _vNeverCollidingLinkPairs = r->_vNeverCollidingLinkPairs;
+    _sNeverCollidingLinkPairsHash = r->_sNeverCollidingLinkPairsHash;
+    _vNeverCollidingLinkPairsLower = r->_vNeverCollidingLinkPairsLower;
+    _vNeverCollidingLinkPairsUpper = r->_vNeverCollidingLinkPairsUpper;
     _vAllPairsShortestPaths = r->_vAllPairsShortestPaths;
     _vClosedLoopIndices = r->_vClosedLoopIndices;
     _vClosedLoops.resize(0); _vClosedLoops.reserve(r->_vClosedLoops.size());
@@ -5794,6 +6448,11 @@ void KinBody::_PostprocessChangedParameters(uint32_t parameters)
     if( (parameters&Prop_LinkEnable) == Prop_LinkEnable ) {
     }
 
+    if( (parameters&Prop_JointLimits) == Prop_JointLimits && _vNeverCollidingLinkPairs.size() > 0 ) {
+        // the never colliding pairs might not apply to the new limits
+        _ResetInternalCollisionCache();
+    }
+
     std::list<UserDataWeakPtr> listRegisteredCallbacks;
     uint32_t index = 0;
     while(parameters && index < _vlistRegisteredCallbacks.size()) {
@@ -5963,7 +6622,7 @@ void KinBody::_InitAndAddLink(LinkPtr plink)
     plink->_collision.indices.clear();
     FOREACHC(itgeominfo,info._vgeometryinfos) {
         Link::GeometryPtr geom(new Link::Geometry(plink,**itgeominfo));
-        if( geom->_info._meshcollision.vertices.size() == 0 ) { // try to avoid recomputing
+        if( geom->_info._meshcollision->vertices.size() == 0 ) { // try to avoid recomputing
             geom->_info.InitCollisionMesh();
         }
         plink->_vGeometries.push_back(geom);
@@ -6348,6 +7007,11 @@ void KinBody::SetKinematicsGenerator(KinematicsGeneratorPtr pGenerator)
     }
     _pKinematicsGenerator = pGenerator;
     if( !!_pKinematicsGenerator ) {
+        if( _nHierarchyComputed != 2 ) {
+            // functions are generated in _ComputeInternalInformation once the kinematics hierarchy is known
+            _pCurrentKinematicsFunctions.reset();
+            return;
+        }
         try {
             _pCurrentKinematicsFunctions = _pKinematicsGenerator->GenerateKinematicsFunctions(*this);
         }
@@ -475,15 +475,15 @@ int KinBody::GeometryInfo::Compare(const GeometryInfo& rhs, dReal fUnitScale, dR
         }
     // use collision mesh to make the rest of the comparison
     case GT_TriMesh:
-        if( _meshcollision.vertices.size() != rhs._meshcollision.vertices.size() ) {
+        if( _meshcollision->vertices.size() != rhs._meshcollision->vertices.size() ) {
             return 17;
         }
-        for(int ivertex = 0; ivertex < (int)_meshcollision.vertices.size(); ++ivertex) {
-            if( !IsZeroWithEpsilon3(_meshcollision.vertices[ivertex]-rhs._meshcollision.vertices[ivertex]*fUnitScale, fEpsilon) ) {
+        for(int ivertex = 0; ivertex < (int)_meshcollision->vertices.size(); ++ivertex) {
+            if( !IsZeroWithEpsilon3(_meshcollision->vertices[ivertex]-rhs._meshcollision->vertices[ivertex]*fUnitScale, fEpsilon) ) {
                 return 18;
             }
         }
-        if( _meshcollision.indices != rhs._meshcollision.indices ) {
+        if( _meshcollision->indices != rhs._meshcollision->indices ) {
             return 19;
         }
 
@@ -514,10 +514,9 @@ bool KinBody::GeometryInfo::InitCollisionMesh(float fTessellation)
         return true;
     }
 
-    // is clear() better since it releases the memory?
     _modifiedFields |= GIF_Mesh;
-    _meshcollision.indices.resize(0);
-    _meshcollision.vertices.resize(0);
+    _meshcollision.Clear();
+    TriMesh& meshcollision = _meshcollision.GetWritable();
 
     if( fTessellation < 0.01f ) {
         fTessellation = 0.01f;
@@ -526,9 +525,9 @@ bool KinBody::GeometryInfo::InitCollisionMesh(float fTessellation)
     switch(_type) {
     case GT_Sphere: {
         // log_2 (1+ tess)
-        GenerateSphereTriangulation(_meshcollision, 3 + (int)(logf(fTessellation) / logf(2.0f)) );
+        GenerateSphereTriangulation(meshcollision, 3 + (int)(logf(fTessellation) / logf(2.0f)) );
         dReal fRadius = GetSphereRadius();
-        FOREACH(it, _meshcollision.vertices) {
+        FOREACH(it, meshcollision.vertices) {
             *it *= fRadius;
         }
         break;
@@ -559,16 +558,16 @@ bool KinBody::GeometryInfo::InitCollisionMesh(float fTessellation)
             1, 3, 5,
             3, 7, 5
         };
-        _meshcollision.vertices.resize(8);
-        std::copy(&v[0],&v[8],_meshcollision.vertices.begin());
-        _meshcollision.indices.resize(nindices);
-        std::copy(&indices[0],&indices[nindices],_meshcollision.indices.begin());
+        meshcollision.vertices.resize(8);
+        std::copy(&v[0],&v[8],meshcollision.vertices.begin());
+        meshcollision.indices.resize(nindices);
+        std::copy(&indices[0],&indices[nindices],meshcollision.indices.begin());
         break;
     }
     case GT_Cylinder: {
         // cylinder is on z axis
         int numverts = (int)(fTessellation*48.0f) + 3;
-        AppendCylinderTriangulation(Vector(0, 0, 0), GetCylinderRadius(), GetCylinderHeight()*0.5, numverts, _meshcollision);
+        AppendCylinderTriangulation(Vector(0, 0, 0), GetCylinderRadius(), GetCylinderHeight()*0.5, numverts, meshcollision);
         break;
     }
     case GT_ConicalFrustum:
@@ -578,7 +577,7 @@ bool KinBody::GeometryInfo::InitCollisionMesh(float fTessellation)
             GetConicalFrustumBottomRadius(),
             GetConicalFrustumHeight() / 2,
             (int)(fTessellation*48.0f) + 3,
-            _meshcollision
+            meshcollision
             );
         break;
     case GT_Axial: {
@@ -589,14 +588,14 @@ bool KinBody::GeometryInfo::InitCollisionMesh(float fTessellation)
 
             int numberOfSections = (int)(fTessellation*48.0f) + 3;
             int numberOfAxialSlices = _vAxialSlices.size();
-            _meshcollision.vertices.reserve(2+numberOfAxialSlices*(numberOfSections+1));
-            _meshcollision.indices.reserve((numberOfAxialSlices*2)*(numberOfSections+1));
+            meshcollision.vertices.reserve(2+numberOfAxialSlices*(numberOfSections+1));
+            meshcollision.indices.reserve((numberOfAxialSlices*2)*(numberOfSections+1));
 
             // add top center point
-            _meshcollision.vertices.push_back(Vector(0, 0, _vAxialSlices.front().zOffset));
+            meshcollision.vertices.push_back(Vector(0, 0, _vAxialSlices.front().zOffset));
 
             // add bottom center point
-            _meshcollision.vertices.push_back(Vector(0, 0, _vAxialSlices.back().zOffset));
+            meshcollision.vertices.push_back(Vector(0, 0, _vAxialSlices.back().zOffset));
 
             // tessellate the surfaces
             dReal dAngle = 2 * PI / (dReal)numberOfSections;
@@ -607,7 +606,7 @@ bool KinBody::GeometryInfo::InitCollisionMesh(float fTessellation)
 
                 // add every slice's outer edge vertices
                 FOREACH(axialSlice, _vAxialSlices) {
-                    _meshcollision.vertices.push_back(Vector(axialSlice->radius*cosTheta, axialSlice->radius*sinTheta, axialSlice->zOffset));
+                    meshcollision.vertices.push_back(Vector(axialSlice->radius*cosTheta, axialSlice->radius*sinTheta, axialSlice->zOffset));
                 }
 
                 // we can start adding vertices after the first section only
@@ -615,30 +614,30 @@ bool KinBody::GeometryInfo::InitCollisionMesh(float fTessellation)
                     continue;
                 }
 
-                int numberOfVertices = (int)(_meshcollision.vertices.size());
+                int numberOfVertices = (int)(meshcollision.vertices.size());
 
                 // add top circle surface
-                _meshcollision.indices.push_back(0);
-                _meshcollision.indices.push_back(numberOfVertices-numberOfAxialSlices);
-                _meshcollision.indices.push_back(numberOfVertices-2*numberOfAxialSlices);
+                meshcollision.indices.push_back(0);
+                meshcollision.indices.push_back(numberOfVertices-numberOfAxialSlices);
+                meshcollision.indices.push_back(numberOfVertices-2*numberOfAxialSlices);
 
                 // add bottom circle surface
-                _meshcollision.indices.push_back(1);
-                _meshcollision.indices.push_back(numberOfVertices-numberOfAxialSlices-1);
-                _meshcollision.indices.push_back(numberOfVertices-1);
+                meshcollision.indices.push_back(1);
+                meshcollision.indices.push_back(numberOfVertices-numberOfAxialSlices-1);
+                meshcollision.indices.push_back(numberOfVertices-1);
 
                 // add the upper side triangles
                 for (int index = 0; index < numberOfAxialSlices-1; index++) {
-                    _meshcollision.indices.push_back(index+numberOfVertices-numberOfAxialSlices);
-                    _meshcollision.indices.push_back(index+numberOfVertices-numberOfAxialSlices+1);
-                    _meshcollision.indices.push_back(index+numberOfVertices-2*numberOfAxialSlices);
+                    meshcollision.indices.push_back(index+numberOfVertices-numberOfAxialSlices);
+                    meshcollision.indices.push_back(index+numberOfVertices-numberOfAxialSlices+1);
+                    meshcollision.indices.push_back(index+numberOfVertices-2*numberOfAxialSlices);
                 }
 
                 // add the lower side triangles
                 for (int index = 1; index < numberOfAxialSlices; index++) {
-                    _meshcollision.indices.push_back(index+(numberOfVertices-numberOfAxialSlices));
-                    _meshcollision.indices.push_back(index+(numberOfVertices-2*numberOfAxialSlices));
-                    _meshcollision.indices.push_back(index+(numberOfVertices-2*numberOfAxialSlices)-1);
+                    meshcollision.indices.push_back(index+(numberOfVertices-numberOfAxialSlices));
+                    meshcollision.indices.push_back(index+(numberOfVertices-2*numberOfAxialSlices));
+                    meshcollision.indices.push_back(index+(numberOfVertices-2*numberOfAxialSlices)-1);
                 }
             }
         }
@@ -648,15 +647,15 @@ bool KinBody::GeometryInfo::InitCollisionMesh(float fTessellation)
         const Vector& vCageBaseExtents = _vGeomData;
         for (size_t i = 0; i < _vSideWalls.size(); ++i) {
             const SideWall &s = _vSideWalls[i];
-            const size_t vBase = _meshcollision.vertices.size();
-            AppendBoxTriangulation(Vector(0, 0, s.vExtents[2]), s.vExtents, _meshcollision);
+            const size_t vBase = meshcollision.vertices.size();
+            AppendBoxTriangulation(Vector(0, 0, s.vExtents[2]), s.vExtents, meshcollision);
 
             for (size_t j = 0; j < 8; ++j) {
-                _meshcollision.vertices[vBase + j] = s.transf * _meshcollision.vertices[vBase + j];
+                meshcollision.vertices[vBase + j] = s.transf * meshcollision.vertices[vBase + j];
             }
         }
         // finally add the base
-        AppendBoxTriangulation(Vector(0, 0, vCageBaseExtents.z),vCageBaseExtents, _meshcollision);
+        AppendBoxTriangulation(Vector(0, 0, vCageBaseExtents.z),vCageBaseExtents, meshcollision);
         break;
     }
     case GT_Container: {
@@ -671,30 +670,30 @@ bool KinBody::GeometryInfo::InitCollisionMesh(float fTessellation)
             }
         }
         // +x wall
-        AppendBoxTriangulation(Vector((outerextents[0]+innerextents[0])/4.,0,outerextents[2]/2.+zoffset), Vector((outerextents[0]-innerextents[0])/4., outerextents[1]/2., outerextents[2]/2.), _meshcollision);
+        AppendBoxTriangulation(Vector((outerextents[0]+innerextents[0])/4.,0,outerextents[2]/2.+zoffset), Vector((outerextents[0]-innerextents[0])/4., outerextents[1]/2., outerextents[2]/2.), meshcollision);
         // -x wall
-        AppendBoxTriangulation(Vector(-(outerextents[0]+innerextents[0])/4.,0,outerextents[2]/2.+zoffset), Vector((outerextents[0]-innerextents[0])/4., outerextents[1]/2., outerextents[2]/2.), _meshcollision);
+        AppendBoxTriangulation(Vector(-(outerextents[0]+innerextents[0])/4.,0,outerextents[2]/2.+zoffset), Vector((outerextents[0]-innerextents[0])/4., outerextents[1]/2., outerextents[2]/2.), meshcollision);
         // +y wall
-        AppendBoxTriangulation(Vector(0,(outerextents[1]+innerextents[1])/4.,outerextents[2]/2.+zoffset), Vector(outerextents[0]/2., (outerextents[1]-innerextents[1])/4., outerextents[2]/2.), _meshcollision);
+        AppendBoxTriangulation(Vector(0,(outerextents[1]+innerextents[1])/4.,outerextents[2]/2.+zoffset), Vector(outerextents[0]/2., (outerextents[1]-innerextents[1])/4., outerextents[2]/2.), meshcollision);
         // -y wall
-        AppendBoxTriangulation(Vector(0,-(outerextents[1]+innerextents[1])/4.,outerextents[2]/2.+zoffset), Vector(outerextents[0]/2., (outerextents[1]-innerextents[1])/4., outerextents[2]/2.), _meshcollision);
+        AppendBoxTriangulation(Vector(0,-(outerextents[1]+innerextents[1])/4.,outerextents[2]/2.+zoffset), Vector(outerextents[0]/2., (outerextents[1]-innerextents[1])/4., outerextents[2]/2.), meshcollision);
         // bottom
         if( outerextents[2] - innerextents[2] >= 1e-6 ) { // small epsilon error can make thin triangles appear, so test with a reasonable threshold
-            AppendBoxTriangulation(Vector(0,0,(outerextents[2]-innerextents[2])/2.+zoffset), Vector(outerextents[0]/2., outerextents[1]/2., (outerextents[2]-innerextents[2])/2), _meshcollision);
+            AppendBoxTriangulation(Vector(0,0,(outerextents[2]-innerextents[2])/2.+zoffset), Vector(outerextents[0]/2., outerextents[1]/2., (outerextents[2]-innerextents[2])/2), meshcollision);
         }
         // cross
         if( bottomcross[2] > 0 ) {
             if( bottomcross[0] > 0 ) {
-                AppendBoxTriangulation(Vector(0, 0, bottomcross[2]/2+outerextents[2]-innerextents[2]+zoffset), Vector(bottomcross[0]/2, innerextents[1]/2, bottomcross[2]/2), _meshcollision);
+                AppendBoxTriangulation(Vector(0, 0, bottomcross[2]/2+outerextents[2]-innerextents[2]+zoffset), Vector(bottomcross[0]/2, innerextents[1]/2, bottomcross[2]/2), meshcollision);
             }
             if( bottomcross[1] > 0 ) {
-                AppendBoxTriangulation(Vector(0, 0, bottomcross[2]/2+outerextents[2]-innerextents[2]+zoffset), Vector(innerextents[0]/2, bottomcross[1]/2, bottomcross[2]/2), _meshcollision);
+                AppendBoxTriangulation(Vector(0, 0, bottomcross[2]/2+outerextents[2]-innerextents[2]+zoffset), Vector(innerextents[0]/2, bottomcross[1]/2, bottomcross[2]/2), meshcollision);
             }
         }
         // bottom
         if( bottom[2] > 0 ) {
             if( bottom[0] > 0 && bottom[1] > 0 ) {
-                AppendBoxTriangulation(Vector(0, 0, bottom[2]/2), Vector(bottom[0]/2., bottom[1]/2., bottom[2]/2.), _meshcollision);
+                AppendBoxTriangulation(Vector(0, 0, bottom[2]/2), Vector(bottom[0]/2., bottom[1]/2., bottom[2]/2.), meshcollision);
             }
         }
         break;
@@ -702,13 +701,15 @@ bool KinBody::GeometryInfo::InitCollisionMesh(float fTessellation)
     case GT_CalibrationBoard: {
         // create board mesh
         Vector boardEx = GetBoxExtents();
-        AppendBoxTriangulation(Vector(0, 0, -boardEx[2]), boardEx, _meshcollision);
+        AppendBoxTriangulation(Vector(0, 0, -boardEx[2]), boardEx, meshcollision);
         break;
     }
     default:
         throw OPENRAVE_EXCEPTION_FORMAT(_("unrecognized geom type %d!"), _type, ORE_InvalidArguments);
     }
 
+    // geometries with the same primitive parameters share their meshes
+    _meshcollision.Share();
     return true;
 }
 
@@ -972,7 +973,7 @@ void KinBody::GeometryInfo::ConvertUnitScale(dReal fUnitScale)
         break;
 
     case GT_TriMesh:
-        FOREACH(itvertex, _meshcollision.vertices) {
+        FOREACH(itvertex, _meshcollision.GetWritable().vertices) {
             *itvertex *= fUnitScale;
         }
         _modifiedFields |= GIF_Mesh;
@@ -1002,8 +1003,7 @@ void KinBody::GeometryInfo::Reset()
     _vAxialSlices.clear();
     _vDiffuseColor = Vector(1,1,1);
     _vAmbientColor = Vector(0,0,0);
-    _meshcollision.vertices.clear();
-    _meshcollision.indices.clear();
+    _meshcollision.Clear();
     _type = GT_None;
     _id.clear();
     _name.clear();
@@ -1167,15 +1167,31 @@ void KinBody::GeometryInfo::SerializeJSON(rapidjson::Value& rGeometryInfo, rapid
         rapidjson::Value rTriMesh;
         rTriMesh.SetObject();
         rapidjson::Value rVertices;
-        rVertices.SetArray();
-        rVertices.Reserve(_meshcollision.vertices.size()*3, allocator);
-        for(size_t ivertex = 0; ivertex < _meshcollision.vertices.size(); ++ivertex) {
-            rVertices.PushBack(_meshcollision.vertices[ivertex][0]*fUnitScale, allocator);
-            rVertices.PushBack(_meshcollision.vertices[ivertex][1]*fUnitScale, allocator);
-            rVertices.PushBack(_meshcollision.vertices[ivertex][2]*fUnitScale, allocator);
-        }
-        rTriMesh.AddMember("vertices", rVertices, allocator);
-        orjson::SetJsonValueByKey(rTriMesh, "indices", _meshcollision.indices, allocator);
+        if( options & ISO_BinaryArrays ) {
+            const bool bRawBytes = !!(options & ISO_RawBinaryArrays);
+            std::vector<dReal> vvertices(_meshcollision->vertices.size()*3);
+            for(size_t ivertex = 0; ivertex < _meshcollision->vertices.size(); ++ivertex) {
+                vvertices[3*ivertex] = _meshcollision->vertices[ivertex][0]*fUnitScale;
+                vvertices[3*ivertex+1] = _meshcollision->vertices[ivertex][1]*fUnitScale;
+                vvertices[3*ivertex+2] = _meshcollision->vertices[ivertex][2]*fUnitScale;
+            }
+            orjson::SaveJsonTypedArray(rVertices, vvertices.data(), vvertices.size(), allocator, bRawBytes);
+            rTriMesh.AddMember("vertices", rVertices, allocator);
+            rapidjson::Value rIndices;
+            orjson::SaveJsonTypedArray(rIndices, _meshcollision->indices.data(), _meshcollision->indices.size(), allocator, bRawBytes);
+            rTriMesh.AddMember("indices", rIndices, allocator);
+        }
+        else {
+            rVertices.SetArray();
+            rVertices.Reserve(_meshcollision->vertices.size()*3, allocator);
+            for(size_t ivertex = 0; ivertex < _meshcollision->vertices.size(); ++ivertex) {
+                rVertices.PushBack(_meshcollision->vertices[ivertex][0]*fUnitScale, allocator);
+                rVertices.PushBack(_meshcollision->vertices[ivertex][1]*fUnitScale, allocator);
+                rVertices.PushBack(_meshcollision->vertices[ivertex][2]*fUnitScale, allocator);
+            }
+            rTriMesh.AddMember("vertices", rVertices, allocator);
+            orjson::SetJsonValueByKey(rTriMesh, "indices", _meshcollision->indices, allocator);
+        }
         rGeometryInfo.AddMember(rapidjson::Document::StringRefType("mesh"), rTriMesh, allocator);
         break;
     }
@@ -1502,8 +1518,9 @@ void KinBody::GeometryInfo::DeserializeJSON(const rapidjson::Value &value, const
 
     case GT_TriMesh:
         if (value.HasMember("mesh")) {
-            orjson::LoadJsonValueByKey(value, "mesh", _meshcollision);
-            FOREACH(itvertex, _meshcollision.vertices) {
+            TriMesh& meshcollision = _meshcollision.GetWritable();
+            orjson::LoadJsonValueByKey(value, "mesh", meshcollision);
+            FOREACH(itvertex, meshcollision.vertices) {
                 *itvertex *= fUnitScale;
             }
             _modifiedFields |= KinBody::GeometryInfo::GIF_Mesh; // hard to check if mesh changed, need to do manual rapidjson operations for that
@@ -1717,21 +1734,21 @@ AABB KinBody::GeometryInfo::ComputeAABB(const Transform& tGeometryWorld) const
     case GT_TriMesh: {
         // Cage: init collision mesh?
         // just use _meshcollision
-        if( _meshcollision.vertices.size() > 0) {
+        if( _meshcollision->vertices.size() > 0) {
             // no need to check rot(2,2), guaranteed to be 1 if rot(0,0) and rot(1,1) are both 1
             const bool bRotationIsIdentity = RaveFabs(tglobal.rot(0,0) - 1.0) <= g_fEpsilon && RaveFabs(tglobal.rot(1,1) - 1.0) <= g_fEpsilon;
             Vector vmin, vmax;
             // if no rotation (identity), skip rotation of vertices
             if (bRotationIsIdentity) {
-                vmin = vmax = _meshcollision.vertices.at(0);
-                for (const Vector& vertex : _meshcollision.vertices) {
+                vmin = vmax = _meshcollision->vertices.at(0);
+                for (const Vector& vertex : _meshcollision->vertices) {
                     _UpdateExtrema(vertex, vmin, vmax);
                 }
                 ab.pos = (dReal)0.5*(vmax+vmin) + tglobal.trans;
             }
             else {
-                vmin = vmax = tglobal*_meshcollision.vertices.at(0);
-                for (const Vector& vertex : _meshcollision.vertices) {
+                vmin = vmax = tglobal*_meshcollision->vertices.at(0);
+                for (const Vector& vertex : _meshcollision->vertices) {
                     _UpdateExtrema(tglobal * vertex, vmin, vmax);
                 }
                 ab.pos = (dReal)0.5*(vmax+vmin);
@@ -1761,6 +1778,8 @@ uint8_t KinBody::GeometryInfo::GetSideWallExists() const
 
 KinBody::Geometry::Geometry(KinBody::LinkPtr parent, const KinBody::GeometryInfo& info) : _parent(parent), _info(info)
 {
+    // share the mesh with identical meshes of other bodies, like repeated parts
+    _info._meshcollision.Share();
 }
 
 bool KinBody::Geometry::InitCollisionMesh(float fTessellation)
@@ -1784,7 +1803,7 @@ void KinBody::Geometry::serialize(std::ostream& o, int options) const
     o << (int)_info._type << " ";
     SerializeRound3(o,_info._vRenderScale);
     if( _info._type == GT_TriMesh ) {
-        _info._meshcollision.serialize(o,options);
+        _info._meshcollision->serialize(o,options);
     }
     else {
         SerializeRound3(o,_info._vGeomData);
@@ -1810,6 +1829,7 @@ void KinBody::Geometry::SetCollisionMesh(const TriMesh& mesh)
     OPENRAVE_ASSERT_FORMAT0(_info._bModifiable, "geometry cannot be modified", ORE_Failed);
     LinkPtr parent(_parent);
     _info._meshcollision = mesh;
+    _info._meshcollision.Share();
     // _info._modifiedFields; change??
     parent->_Update();
 }
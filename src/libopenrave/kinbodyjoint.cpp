@@ -762,6 +762,191 @@ OpenRAVEFunctionParserRealPtr CreateJointFunctionParser()
     return parser;
 }
 
+/// \brief recognizes mimic equations that are linear in their variables, like "2*joint0+0.1" or "-(joint1 - 0.5*joint2)"
+///
+/// Only numbers, variables, +, -, * and parentheses are accepted, and every product can have at most one non-constant factor.
+/// Anything else, including functions, divisions and common subexpressions, is left to the function parser.
+class LinearMimicEquationParser
+{
+public:
+    LinearMimicEquationParser(const std::string& equation, const std::vector<std::string>& vvars) : _equation(equation), _vvars(vvars), _pos(0) {
+    }
+
+    bool Parse(KinBody::Mimic::LinearEquation& linear)
+    {
+        linear.bValid = false;
+        Form form;
+        if( !_ParseSum(form) ) {
+            return false;
+        }
+        _SkipSpaces();
+        if( _pos != _equation.size() ) {
+            return false;
+        }
+        linear.vcoeffs.swap(form.vcoeffs);
+        linear.foffset = form.foffset;
+        linear.bValid = true;
+        return true;
+    }
+
+private:
+    /// \brief sum_i vcoeffs[i]*var_i + foffset
+    struct Form
+    {
+        std::vector<dReal> vcoeffs;
+        dReal foffset = 0;
+    };
+
+    void _InitForm(Form& form) const
+    {
+        form.vcoeffs.assign(_vvars.size(), 0);
+        form.foffset = 0;
+    }
+
+    static bool _IsConstant(const Form& form)
+    {
+        for(dReal fcoeff : form.vcoeffs) {
+            if( fcoeff != 0 ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void _SkipSpaces()
+    {
+        while( _pos < _equation.size() && std::isspace(static_cast<unsigned char>(_equation[_pos])) ) {
+            ++_pos;
+        }
+    }
+
+    bool _ParseSum(Form& form)
+    {
+        _InitForm(form);
+        bool bfirst = true;
+        while(true) {
+            _SkipSpaces();
+            dReal fsign = 1;
+            if( _pos < _equation.size() && (_equation[_pos] == '+' || _equation[_pos] == '-') ) {
+                fsign = _equation[_pos] == '-' ? -1 : 1;
+                ++_pos;
+            }
+            else if( !bfirst ) {
+                return true;
+            }
+            Form term;
+            if( !_ParseProduct(term) ) {
+                return false;
+            }
+            for(size_t i = 0; i < form.vcoeffs.size(); ++i) {
+                form.vcoeffs[i] += fsign*term.vcoeffs[i];
+            }
+            form.foffset += fsign*term.foffset;
+            bfirst = false;
+        }
+    }
+
+    bool _ParseProduct(Form& form)
+    {
+        if( !_ParseFactor(form) ) {
+            return false;
+        }
+        while(true) {
+            _SkipSpaces();
+            if( _pos >= _equation.size() || _equation[_pos] != '*' ) {
+                return true;
+            }
+            ++_pos;
+            Form factor;
+            if( !_ParseFactor(factor) ) {
+                return false;
+            }
+            // one of the two has to be a constant for the product to stay linear
+            if( _IsConstant(factor) ) {
+                for(dReal& fcoeff : form.vcoeffs) {
+                    fcoeff *= factor.foffset;
+                }
+                form.foffset *= factor.foffset;
+            }
+            else if( _IsConstant(form) ) {
+                const dReal fscale = form.foffset;
+                form.vcoeffs.swap(factor.vcoeffs);
+                for(dReal& fcoeff : form.vcoeffs) {
+                    fcoeff *= fscale;
+                }
+                form.foffset = fscale*factor.foffset;
+            }
+            else {
+                return false;
+            }
+        }
+    }
+
+    bool _ParseFactor(Form& form)
+    {
+        _SkipSpaces();
+        if( _pos >= _equation.size() ) {
+            return false;
+        }
+        const char c = _equation[_pos];
+        if( c == '(' ) {
+            ++_pos;
+            if( !_ParseSum(form) ) {
+                return false;
+            }
+            _SkipSpaces();
+            if( _pos >= _equation.size() || _equation[_pos] != ')' ) {
+                return false;
+            }
+            ++_pos;
+            return true;
+        }
+        if( c == '-' || c == '+' ) {
+            // unary sign inside a product
+            ++_pos;
+            if( !_ParseFactor(form) ) {
+                return false;
+            }
+            if( c == '-' ) {
+                for(dReal& fcoeff : form.vcoeffs) {
+                    fcoeff = -fcoeff;
+                }
+                form.foffset = -form.foffset;
+            }
+            return true;
+        }
+        _InitForm(form);
+        if( std::isdigit(static_cast<unsigned char>(c)) || c == '.' ) {
+            const char* pstart = _equation.c_str() + _pos;
+            char* pend = NULL;
+            form.foffset = std::strtod(pstart, &pend);
+            if( pend == pstart ) {
+                return false;
+            }
+            _pos += pend - pstart;
+            return true;
+        }
+        if( std::isalpha(static_cast<unsigned char>(c)) || c == '_' ) {
+            const size_t startpos = _pos;
+            while( _pos < _equation.size() && (std::isalnum(static_cast<unsigned char>(_equation[_pos])) || _equation[_pos] == '_') ) {
+                ++_pos;
+            }
+            std::vector<std::string>::const_iterator itvar = std::find(_vvars.begin(), _vvars.end(), _equation.substr(startpos, _pos-startpos));
+            if( itvar == _vvars.end() ) {
+                // function or unknown constant
+                return false;
+            }
+            form.vcoeffs.at(itvar-_vvars.begin()) = 1;
+            return true;
+        }
+        return false;
+    }
+
+    const std::string& _equation;
+    const std::vector<std::string>& _vvars;
+    size_t _pos;
+};
+
 KinBody::Joint::Joint(KinBodyPtr parent, KinBody::JointType type)
 {
     _parent = parent;
@@ -2244,6 +2429,7 @@ void KinBody::Joint::SetMimicEquations(int iaxis, const std::string& poseq, cons
     if( ret >= 0 ) {
         throw OPENRAVE_EXCEPTION_FORMAT(_("failed to set equation '%s' on %s:%s, at %d. Error is %s\n"), poseq % parent->GetName() % GetName() % ret % pmimic->_posfn->ErrorMsg(), ORE_InvalidArguments);
     }
+    LinearMimicEquationParser(eq, resultVars).Parse(pmimic->_poslinear);
 
     // process the depended joint variables
     for(const std::string& var : resultVars) {
@@ -2286,6 +2472,7 @@ void KinBody::Joint::SetMimicEquations(int iaxis, const std::string& poseq, cons
         }
 
         std::vector<OpenRAVEFunctionParserRealPtr> vfns(nVars);
+        std::vector<Mimic::LinearEquation> vlinear(nVars);
         /*
             extract from `eq` the partial derivative formulas ∂z/∂xi for joint z:=z(x1,x2,...xn) defined in `poseq`.
             `eq` takes form
@@ -2337,6 +2524,7 @@ void KinBody::Joint::SetMimicEquations(int iaxis, const std::string& poseq, cons
                 throw OPENRAVE_EXCEPTION_FORMAT(_("failed to set equation '%s' on %s:%s, at %d. Error is %s"), sequation%parent->GetName()%GetName()%ret%fn->ErrorMsg(),ORE_InvalidArguments);
             }
             vfns.at(itnameindex-resultVars.begin()) = fn;
+            LinearMimicEquationParser(sequation, resultVars).Parse(vlinear.at(itnameindex-resultVars.begin()));
         }
         // check if anything is missing
         for(size_t j = 0; j < nVars; ++j) {
@@ -2345,14 +2533,17 @@ void KinBody::Joint::SetMimicEquations(int iaxis, const std::string& poseq, cons
                 RAVELOG_WARN(str(boost::format("SetMimicEquations: missing variable %s from partial derivatives of joint %s!")%mapinvnames[resultVars[j]]%_info._name));
                 vfns[j] = CreateJointFunctionParser();
                 vfns[j]->Parse("0","");
+                LinearMimicEquationParser("0", resultVars).Parse(vlinear[j]);
             }
         }
 
         if( itype == 1 ) {
             pmimic->_velfns.swap(vfns);
+            pmimic->_vellinear.swap(vlinear);
         }
         else {
             pmimic->_accelfns.swap(vfns);
+            pmimic->_accellinear.swap(vlinear);
         }
     }
     _vmimic.at(iaxis) = pmimic;
@@ -2431,8 +2622,13 @@ void KinBody::Joint::_ComputePartialVelocities(std::vector<std::pair<int, dReal>
         const int jointIndex = dofformat.jointindex; ///< index of this depended joint
         dReal fvel = 0;
         if(ivar < nvelfns) {
-            const OpenRAVEFunctionParserRealPtr velfn = pmimic->_velfns.at(ivar); ///< function that evaluates the partial derivative ∂z/∂x
-            fvel = velfn->Eval(vDependedJointValues.empty() ? NULL : &vDependedJointValues[0]); ///< value of ∂z/∂x
+            if( ivar < pmimic->_vellinear.size() && pmimic->_vellinear[ivar].bValid ) {
+                fvel = pmimic->_vellinear[ivar].Eval(vDependedJointValues.empty() ? NULL : &vDependedJointValues[0]);
+            }
+            else {
+                const OpenRAVEFunctionParserRealPtr velfn = pmimic->_velfns.at(ivar); ///< function that evaluates the partial derivative ∂z/∂x
+                fvel = velfn->Eval(vDependedJointValues.empty() ? NULL : &vDependedJointValues[0]); ///< value of ∂z/∂x
+            }
         }
         else {
             RAVELOG_WARN_FORMAT("This mimic joint %s depends on joint %s, but the user did not provide the mimic velocity formula. Now treat the first-order partial derivative as 0", this->GetName() % dependedjoint->GetName());
@@ -2488,25 +2684,40 @@ void KinBody::Joint::_ComputePartialVelocities(std::vector<std::pair<int, dReal>
 
 int KinBody::Joint::_Eval(int axis, uint32_t timederiv, const std::vector<dReal>& vdependentvalues, std::vector<dReal>& voutput) const
 {
+    const Mimic& mimic = *_vmimic.at(axis);
+    const dReal* pvalues = vdependentvalues.empty() ? NULL : &vdependentvalues[0];
     if( timederiv == 0 ) {
-        _vmimic.at(axis)->_posfn->EvalMulti(voutput, vdependentvalues.empty() ? NULL : &vdependentvalues[0]);
-        return _vmimic.at(axis)->_posfn->EvalError();
+        if( mimic._poslinear.bValid ) {
+            voutput.resize(1);
+            voutput[0] = mimic._poslinear.Eval(pvalues);
+            return 0;
+        }
+        mimic._posfn->EvalMulti(voutput, pvalues);
+        return mimic._posfn->EvalError();
     }
     else if( timederiv == 1 ) {
-        voutput.resize(_vmimic.at(axis)->_velfns.size());
+        voutput.resize(mimic._velfns.size());
         for(size_t i = 0; i < voutput.size(); ++i) {
-            voutput[i] = _vmimic.at(axis)->_velfns.at(i)->Eval(vdependentvalues.empty() ? NULL : &vdependentvalues[0]);
-            int err = _vmimic.at(axis)->_velfns.at(i)->EvalError();
+            if( i < mimic._vellinear.size() && mimic._vellinear[i].bValid ) {
+                voutput[i] = mimic._vellinear[i].Eval(pvalues);
+                continue;
+            }
+            voutput[i] = mimic._velfns.at(i)->Eval(pvalues);
+            int err = mimic._velfns.at(i)->EvalError();
             if( err ) {
                 return err;
             }
         }
     }
     else if( timederiv == 2 ) {
-        voutput.resize(_vmimic.at(axis)->_accelfns.size());
+        voutput.resize(mimic._accelfns.size());
         for(size_t i = 0; i < voutput.size(); ++i) {
-            voutput[i] = _vmimic.at(axis)->_accelfns.at(i)->Eval(vdependentvalues.empty() ? NULL : &vdependentvalues[0]);
-            int err = _vmimic.at(axis)->_accelfns.at(i)->EvalError();
+            if( i < mimic._accellinear.size() && mimic._accellinear[i].bValid ) {
+                voutput[i] = mimic._accellinear[i].Eval(pvalues);
+                continue;
+            }
+            voutput[i] = mimic._accelfns.at(i)->Eval(pvalues);
+            int err = mimic._accelfns.at(i)->EvalError();
             if( err ) {
                 return err;
             }
@@ -0,0 +1,227 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2006-2019 Rosen Diankov (rosen.diankov@gmail.com)
+//
+// This file is part of OpenRAVE.
+// OpenRAVE is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#include "libopenrave.h"
+
+namespace OpenRAVE {
+
+namespace {
+
+/// \brief one step of the flattened forward kinematics program
+///
+/// Every step computes T[childlinkindex] = T[anchorlinkindex] * f(q). Chains of static joints are folded into the constant
+/// parts of the step, so anchorlinkindex always refers to the root link or a link moved by a revolute/prismatic joint.
+struct KinematicsStep
+{
+    enum StepType : uint8_t
+    {
+        ST_Static = 0, ///< T = Tanchor * tleft
+        ST_Revolute = 1, ///< T = Tanchor * tleft * R(axis, q) * tright
+        ST_Prismatic = 2, ///< T = Tanchor * (tleft.rot*tright.rot, vbase + vaxis*q)
+    };
+
+    StepType type;
+    int anchorlinkindex;
+    int childlinkindex;
+    int dofindex;
+    Transform tleft;
+    Transform tright;
+    Vector vaxis; ///< for revolute the normalized joint axis, for prismatic the joint axis in the tleft frame
+    Vector vbase; ///< for prismatic, the translation of tleft*tright
+};
+
+/// \brief forward kinematics for one body topology, computed by a precompiled list of steps
+///
+/// Instances do not hold any scratch memory and are never modified after construction, so they are shared across all bodies
+/// with the same kinematics geometry hash, including bodies in cloned environments used from different threads.
+class StraightLineKinematicsFunctions : public KinematicsFunctions
+{
+public:
+    StraightLineKinematicsFunctions(std::vector<KinematicsStep>& vsteps) {
+        _vsteps.swap(vsteps);
+    }
+
+    bool SetLinkTransforms(const dReal* pJointValues, const std::vector<Transform*>& vLinkTransformPointers) override
+    {
+        Transform* const* ptransforms = vLinkTransformPointers.data();
+        for(const KinematicsStep& step : _vsteps) {
+            const Transform& tanchor = *ptransforms[step.anchorlinkindex];
+            switch(step.type) {
+            case KinematicsStep::ST_Revolute: {
+                const dReal fhalfangle = dReal(0.5)*pJointValues[step.dofindex];
+                const dReal fsin = RaveSin(fhalfangle);
+                const Vector qjoint(RaveCos(fhalfangle), step.vaxis.x*fsin, step.vaxis.y*fsin, step.vaxis.z*fsin);
+                const Vector qleft = quatMultiply(step.tleft.rot, qjoint);
+                Transform tlocal;
+                tlocal.rot = quatMultiply(qleft, step.tright.rot);
+                tlocal.trans = step.tleft.trans + quatRotate(qleft, step.tright.trans);
+                *ptransforms[step.childlinkindex] = tanchor * tlocal;
+                break;
+            }
+            case KinematicsStep::ST_Prismatic: {
+                Transform tlocal;
+                tlocal.rot = step.tleft.rot;
+                tlocal.trans = step.vbase + step.vaxis*pJointValues[step.dofindex];
+                *ptransforms[step.childlinkindex] = tanchor * tlocal;
+                break;
+            }
+            default:
+                *ptransforms[step.childlinkindex] = tanchor * step.tleft;
+                break;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::vector<KinematicsStep> _vsteps;
+};
+
+class StraightLineKinematicsGenerator : public KinematicsGenerator
+{
+public:
+    KinematicsFunctionsPtr GenerateKinematicsFunctions(const KinBody& body) override
+    {
+        const std::string& hash = body.GetKinematicsGeometryHash();
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            std::map<std::string, boost::weak_ptr<KinematicsFunctions> >::iterator it = _mapFunctions.find(hash);
+            if( it != _mapFunctions.end() ) {
+                KinematicsFunctionsPtr pfunctions = it->second.lock();
+                if( !!pfunctions ) {
+                    return pfunctions;
+                }
+                _mapFunctions.erase(it);
+            }
+        }
+
+        std::vector<KinematicsStep> vsteps;
+        if( !_CompileSteps(body, vsteps) ) {
+            return KinematicsFunctionsPtr();
+        }
+
+        KinematicsFunctionsPtr pfunctions(new StraightLineKinematicsFunctions(vsteps));
+        boost::mutex::scoped_lock lock(_mutex);
+        // remove expired entries so that the cache does not grow with bodies that were destroyed
+        for(std::map<std::string, boost::weak_ptr<KinematicsFunctions> >::iterator it = _mapFunctions.begin(); it != _mapFunctions.end(); ) {
+            if( it->second.expired() ) {
+                _mapFunctions.erase(it++);
+            }
+            else {
+                ++it;
+            }
+        }
+        _mapFunctions[hash] = pfunctions;
+        return pfunctions;
+    }
+
+private:
+    /// \brief flattens the topologically sorted joints into steps. Returns false if the body uses joints that the steps cannot represent, in which case the generic forward kinematics is used.
+    static bool _CompileSteps(const KinBody& body, std::vector<KinematicsStep>& vsteps)
+    {
+        const std::vector<KinBody::LinkPtr>& vlinks = body.GetLinks();
+        if( vlinks.empty() ) {
+            return false;
+        }
+
+        // for every link, the link whose transform is computed explicitly and the constant offset from it
+        std::vector<int> vanchors(vlinks.size(), -1);
+        std::vector<Transform> voffsets(vlinks.size());
+        vanchors[0] = 0;
+
+        vsteps.resize(0);
+        vsteps.reserve(body.GetDependencyOrderedJointsAll().size());
+        for(const KinBody::JointPtr& pjoint : body.GetDependencyOrderedJointsAll()) {
+            const KinBody::Joint& joint = *pjoint;
+            const KinBody::LinkPtr& parentlink = joint.GetFirstAttached();
+            const KinBody::LinkPtr& childlink = joint.GetSecondAttached();
+            if( !childlink ) {
+                return false;
+            }
+            const int parentindex = !!parentlink ? parentlink->GetIndex() : 0;
+            const int childindex = childlink->GetIndex();
+            if( vanchors.at(parentindex) < 0 || vanchors.at(childindex) >= 0 ) {
+                // closed loops or a parent that has not been computed yet
+                return false;
+            }
+
+            KinematicsStep step;
+            step.anchorlinkindex = vanchors[parentindex];
+            step.childlinkindex = childindex;
+            step.dofindex = joint.GetDOFIndex();
+            step.tleft = voffsets[parentindex] * joint.GetInternalHierarchyLeftTransform();
+            if( joint.IsStatic() ) {
+                step.type = KinematicsStep::ST_Static;
+                vanchors[childindex] = step.anchorlinkindex;
+                voffsets[childindex] = step.tleft;
+            }
+            else {
+                if( joint.IsMimic() || step.dofindex < 0 ) {
+                    // mimic and passive joints depend on evaluated equations and stored passive values
+                    return false;
+                }
+                step.tright = joint.GetInternalHierarchyRightTransform();
+                const Vector vaxis = joint.GetInternalHierarchyAxis(0);
+                if( joint.GetType() == KinBody::JointRevolute ) {
+                    const dReal faxislen = RaveSqrt(vaxis.lengthsqr3());
+                    if( faxislen == 0 ) {
+                        return false;
+                    }
+                    step.type = KinematicsStep::ST_Revolute;
+                    step.vaxis = vaxis * (1/faxislen);
+                }
+                else if( joint.GetType() == KinBody::JointPrismatic ) {
+                    step.type = KinematicsStep::ST_Prismatic;
+                    step.vaxis = step.tleft.rotate(vaxis);
+                    step.vbase = step.tleft.trans + step.tleft.rotate(step.tright.trans);
+                    step.tleft.rot = quatMultiply(step.tleft.rot, step.tright.rot);
+                }
+                else {
+                    return false;
+                }
+                vanchors[childindex] = childindex;
+            }
+            vsteps.push_back(step);
+        }
+        return true;
+    }
+
+    std::map<std::string, boost::weak_ptr<KinematicsFunctions> > _mapFunctions; ///< generated functions indexed by the kinematics geometry hash of the body
+    boost::mutex _mutex; ///< protects _mapFunctions
+};
+
+} // end namespace
+
+KinematicsGeneratorPtr CreateStraightLineKinematicsGenerator()
+{
+    return KinematicsGeneratorPtr(new StraightLineKinematicsGenerator());
+}
+
+KinematicsGeneratorPtr GetDefaultKinematicsGenerator()
+{
+    // read once, one generator instance shares the generated functions between all bodies
+    static const KinematicsGeneratorPtr s_pDefaultGenerator = []() {
+        const char* pOPENRAVE_STRAIGHTLINE_KINEMATICS = getenv("OPENRAVE_STRAIGHTLINE_KINEMATICS");
+        if( !!pOPENRAVE_STRAIGHTLINE_KINEMATICS && strcmp(pOPENRAVE_STRAIGHTLINE_KINEMATICS, "0") != 0 ) {
+            RAVELOG_DEBUG("OPENRAVE_STRAIGHTLINE_KINEMATICS is set, using straight-line kinematics for all bodies");
+            return CreateStraightLineKinematicsGenerator();
+        }
+        return KinematicsGeneratorPtr();
+    }();
+    return s_pDefaultGenerator;
+}
+
+} // end namespace OpenRAVE
@@ -450,7 +450,6 @@ public:
 #else
         boost::shared_ptr<RaveDatabase> pdatabase = boost::make_shared<DynamicRaveDatabase>();
 #endif // OPENRAVE_STATIC_PLUGINS
-        pdatabase->Init();
 
         char* phomedir = getenv("OPENRAVE_HOME"); // getenv not thread-safe?
         if( phomedir == NULL ) {
@@ -468,6 +467,7 @@ public:
 #else
         CreateDirectory(_homedirectory.c_str(),NULL);
 #endif
+        pdatabase->Init(); // after the home directory is set since it keeps the plugin index there
 
 #ifdef _WIN32
         const char* delim = ";";
@@ -661,12 +661,19 @@ protected:
 
     UserDataPtr RegisterXMLReader(InterfaceType type, const std::string& xmltag, const CreateXMLReaderFn& fn)
     {
+#if !OPENRAVE_STATIC_PLUGINS
+        DynamicRaveDatabase::NotifyReaderRegistered(type, xmltag, false);
+#endif
         return UserDataPtr(new XMLReaderFunctionData(type,xmltag,fn,shared_from_this()));
     }
 
     const BaseXMLReaderPtr CallXMLReader(InterfaceType type, const std::string& xmltag, InterfaceBasePtr pinterface, const AttributesList& atts)
     {
         XMLREADERSMAP::iterator it = _mapxmlreaders[type].find(xmltag);
+        if( it == _mapxmlreaders[type].end() && !!_pdatabase && _pdatabase->LoadPluginForReader(type, xmltag, false) ) {
+            // the reader is registered by a plugin that was not loaded yet
+            it = _mapxmlreaders[type].find(xmltag);
+        }
         if( it == _mapxmlreaders[type].end() ) {
             //throw openrave_exception(str(boost::format(_("No function registered for interface %s xml tag %s"))%GetInterfaceName(type)%xmltag),ORE_InvalidArguments);
             return BaseXMLReaderPtr();
@@ -700,12 +707,19 @@ protected:
 
     UserDataPtr RegisterJSONReader(InterfaceType type, const std::string& id, const CreateJSONReaderFn& fn)
     {
+#if !OPENRAVE_STATIC_PLUGINS
+        DynamicRaveDatabase::NotifyReaderRegistered(type, id, true);
+#endif
         return UserDataPtr(new JSONReaderFunctionData(type,id,fn,shared_from_this()));
     }
 
     const BaseJSONReaderPtr CallJSONReader(InterfaceType type, const std::string& id, ReadablePtr pReadable, const AttributesList& atts)
     {
         JSONREADERSMAP::iterator it = _mapjsonreaders[type].find(id);
+        if( it == _mapjsonreaders[type].end() && !!_pdatabase && _pdatabase->LoadPluginForReader(type, id, true) ) {
+            // the reader is registered by a plugin that was not loaded yet
+            it = _mapjsonreaders[type].find(id);
+        }
         if( it == _mapjsonreaders[type].end() ) {
             //throw openrave_exception(str(boost::format(_("No function registered for interface %s xml tag %s"))%GetInterfaceName(type)%id),ORE_InvalidArguments);
             return BaseJSONReaderPtr();
@@ -2368,6 +2382,140 @@ void TriMesh::serialize(std::ostream& o, int options) const
     }
 }
 
+uint64_t TriMesh::ComputeHash() const
+{
+    // 64-bit FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const uint64_t prime = 0x100000001b3ULL;
+    const auto hashbytes = [&hash, prime](const void* pdata, size_t size) {
+        const uint8_t* pbytes = static_cast<const uint8_t*>(pdata);
+        for(size_t i = 0; i < size; ++i) {
+            hash = (hash ^ pbytes[i])*prime;
+        }
+    };
+    const uint64_t numvertices = vertices.size(), numindices = indices.size();
+    hashbytes(&numvertices, sizeof(numvertices));
+    for(const Vector& v : vertices) {
+        hashbytes(&v.x, sizeof(v.x)*3);
+    }
+    hashbytes(&numindices, sizeof(numindices));
+    if( numindices > 0 ) {
+        hashbytes(indices.data(), sizeof(indices[0])*numindices);
+    }
+    return hash;
+}
+
+namespace {
+
+/// \brief process-wide registry of the meshes shared with SharedTriMesh::Share, indexed by TriMesh::ComputeHash
+class SharedTriMeshRegistry
+{
+public:
+    SharedTriMeshRegistry() : _nextsweepsize(64) {
+    }
+
+    /// \brief returns a registered mesh identical to pmesh, or registers pmesh
+    ///
+    /// \param bcopy if true, registers a copy of pmesh instead of pmesh, which is necessary when other unregistered holders reference pmesh and might modify it
+    boost::shared_ptr<TriMesh> Register(const boost::shared_ptr<TriMesh>& pmesh, bool bcopy)
+    {
+        const uint64_t hash = pmesh->ComputeHash();
+        boost::mutex::scoped_lock lock(_mutex);
+        std::pair<std::multimap<uint64_t, boost::weak_ptr<TriMesh> >::iterator, std::multimap<uint64_t, boost::weak_ptr<TriMesh> >::iterator> range = _mapMeshes.equal_range(hash);
+        for(std::multimap<uint64_t, boost::weak_ptr<TriMesh> >::iterator it = range.first; it != range.second; ) {
+            boost::shared_ptr<TriMesh> pregistered = it->second.lock();
+            if( !pregistered ) {
+                _mapMeshes.erase(it++);
+                continue;
+            }
+            if( pregistered == pmesh || *pregistered == *pmesh ) {
+                return pregistered;
+            }
+            ++it;
+        }
+        const boost::shared_ptr<TriMesh> pnewmesh = bcopy ? boost::shared_ptr<TriMesh>(new TriMesh(*pmesh)) : pmesh;
+        _mapMeshes.insert(std::make_pair(hash, boost::weak_ptr<TriMesh>(pnewmesh)));
+        if( _mapMeshes.size() >= _nextsweepsize ) {
+            // remove the meshes that are not used anymore so that the registry does not grow with destroyed environments
+            for(std::multimap<uint64_t, boost::weak_ptr<TriMesh> >::iterator it = _mapMeshes.begin(); it != _mapMeshes.end(); ) {
+                if( it->second.expired() ) {
+                    _mapMeshes.erase(it++);
+                }
+                else {
+                    ++it;
+                }
+            }
+            _nextsweepsize = std::max(size_t(64), 2*_mapMeshes.size());
+        }
+        return pnewmesh;
+    }
+
+private:
+    std::multimap<uint64_t, boost::weak_ptr<TriMesh> > _mapMeshes;
+    size_t _nextsweepsize; ///< number of registered meshes at which the expired ones are removed
+    boost::mutex _mutex; ///< protects _mapMeshes
+};
+
+SharedTriMeshRegistry& GetSharedTriMeshRegistry()
+{
+    static SharedTriMeshRegistry s_registry;
+    return s_registry;
+}
+
+const boost::shared_ptr<TriMesh>& GetEmptySharedTriMesh()
+{
+    static const boost::shared_ptr<TriMesh> s_pemptymesh(new TriMesh());
+    return s_pemptymesh;
+}
+
+} // end namespace
+
+SharedTriMesh::SharedTriMesh() : _pmesh(GetEmptySharedTriMesh()), _bregistered(true)
+{
+}
+
+SharedTriMesh::SharedTriMesh(const TriMesh& mesh) : _pmesh(new TriMesh(mesh)), _bregistered(false)
+{
+}
+
+SharedTriMesh& SharedTriMesh::operator=(const TriMesh& mesh)
+{
+    if( &mesh != _pmesh.get() ) {
+        if( !_bregistered && _pmesh.unique() ) {
+            *_pmesh = mesh;
+        }
+        else {
+            _pmesh.reset(new TriMesh(mesh));
+            _bregistered = false;
+        }
+    }
+    return *this;
+}
+
+TriMesh& SharedTriMesh::GetWritable()
+{
+    if( _bregistered || !_pmesh.unique() ) {
+        _pmesh.reset(new TriMesh(*_pmesh));
+        _bregistered = false;
+    }
+    return *_pmesh;
+}
+
+void SharedTriMesh::Clear()
+{
+    _pmesh = GetEmptySharedTriMesh();
+    _bregistered = true;
+}
+
+void SharedTriMesh::Share()
+{
+    if( _bregistered ) {
+        return;
+    }
+    _pmesh = GetSharedTriMeshRegistry().Register(_pmesh, !_pmesh.unique());
+    _bregistered = true;
+}
+
 std::ostream& operator<<(std::ostream& O, const TriMesh& trimesh)
 {
     trimesh.serialize(O,0);
@@ -2700,6 +2848,71 @@ int SpaceSamplerBase::_CallStatusFunctions(int sampleiteration)
     return ret;
 }
 
+int CollisionCheckerBase::CheckCollisionBatch(KinBodyPtr pbody, const std::vector<int>& dofindices, const std::vector<dReal>& vconfigurations, std::vector<uint64_t>& vcollisionmasks, int batchoptions)
+{
+    const size_t ndof = dofindices.size() > 0 ? dofindices.size() : (size_t)pbody->GetDOF();
+    OPENRAVE_ASSERT_OP_FORMAT(ndof, >, 0, "env=%s, body %s has no dofs to set", GetEnv()->GetNameId()%pbody->GetName(), ORE_InvalidArguments);
+    OPENRAVE_ASSERT_OP_FORMAT(vconfigurations.size()%ndof, ==, 0, "env=%s, configurations size %d is not a multiple of %d", GetEnv()->GetNameId()%vconfigurations.size()%ndof, ORE_InvalidArguments);
+    const size_t nconfigurations = vconfigurations.size()/ndof;
+    vcollisionmasks.resize((nconfigurations+63)>>6);
+    std::fill(vcollisionmasks.begin(), vcollisionmasks.end(), 0);
+
+    KinBody::KinBodyStateSaver saver(pbody, KinBody::Save_LinkTransformation);
+    int ncollisions = 0;
+    for(size_t iconfig = 0; iconfig < nconfigurations; ++iconfig) {
+        pbody->SetDOFValues(&vconfigurations[iconfig*ndof], ndof, KinBody::CLA_Nothing, dofindices);
+        bool bCollision = false;
+        if( batchoptions & CBO_Environment ) {
+            bCollision = CheckCollision(KinBodyConstPtr(pbody));
+        }
+        if( !bCollision && (batchoptions & CBO_SelfCollision) ) {
+            bCollision = CheckStandaloneSelfCollision(KinBodyConstPtr(pbody));
+        }
+        if( bCollision ) {
+            vcollisionmasks[iconfig>>6] |= (uint64_t)1 << (iconfig&0x3f);
+            ++ncollisions;
+            if( batchoptions & CBO_StopAtFirstCollision ) {
+                break;
+            }
+        }
+    }
+    return ncollisions;
+}
+
+int CollisionCheckerBase::CheckCollisionRays(const std::vector<RAY>& vrays, KinBodyConstPtr pbody, std::vector<RayCollisionResult>& vresults)
+{
+    vresults.resize(vrays.size());
+    if( vrays.size() == 0 ) {
+        return 0;
+    }
+    CollisionOptionsStateSaver optionsaver(shared_collisionchecker(), GetCollisionOptions()|CO_Distance|CO_Contacts, false);
+    CollisionReport report;
+    CollisionReportPtr preport(&report, utils::null_deleter());
+    int nhits = 0;
+    for(size_t iray = 0; iray < vrays.size(); ++iray) {
+        const RAY& ray = vrays[iray];
+        RayCollisionResult& result = vresults[iray];
+        result = RayCollisionResult();
+        const bool bCollision = !!pbody ? CheckCollision(ray, pbody, preport) : CheckCollision(ray, preport);
+        if( !bCollision ) {
+            continue;
+        }
+        result.bCollision = true;
+        result.plink = !!report.plink1 ? report.plink1 : report.plink2;
+        result.fDistance = report.minDistance;
+        if( report.contacts.size() > 0 ) {
+            result.pos = report.contacts[0].pos;
+            result.norm = report.contacts[0].norm;
+        }
+        else {
+            const dReal flength = RaveSqrt(ray.dir.lengthsqr3());
+            result.pos = flength > 0 ? ray.pos + ray.dir*(report.minDistance/flength) : ray.pos;
+        }
+        ++nhits;
+    }
+    return nhits;
+}
+
 CollisionOptionsStateSaver::CollisionOptionsStateSaver(CollisionCheckerBasePtr p, int newoptions, bool required)
 {
     _oldoptions = p->GetCollisionOptions();
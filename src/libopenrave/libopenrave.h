@@ -308,6 +308,11 @@ int CallSetStateValuesFns(const std::vector< std::pair<PlannerBase::PlannerParam
 void CallGetStateFns(const std::vector< std::pair<PlannerBase::PlannerParameters::GetStateFn, int> >& vfunctions, int nDOF, int nMaxDOFForGroup, std::vector<dReal>& v);
 
 void subtractstates(std::vector<dReal>& q1, const std::vector<dReal>& q2);
+
+/// \brief returns the kinematics generator new bodies start with
+///
+/// It is the straight-line generator (see CreateStraightLineKinematicsGenerator) if the environment variable OPENRAVE_STRAIGHTLINE_KINEMATICS is set to anything except 0, otherwise empty.
+KinematicsGeneratorPtr GetDefaultKinematicsGenerator();
 /// -1 v1 is smaller than v2
 // 0 two vectors are equivalent
 /// +1 v1 is greater than v2
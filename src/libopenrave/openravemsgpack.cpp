@@ -22,6 +22,173 @@
 #include <msgpack.hpp>
 #include <rapidjson/document.h>
 
+namespace {
+
+/// \brief formats a msgpack timestamp extension (type -1) in RFC 3339 format
+std::string FormatMsgPackTimestamp(const msgpack::object& o)
+{
+    const std::chrono::system_clock::time_point tp = o.as<std::chrono::system_clock::time_point>();
+    const std::time_t parsedTime = std::chrono::system_clock::to_time_t(tp);
+
+    // RFC 3339 Nano format
+    char formatted[sizeof("2006-01-02T15:04:05.999999999Z07:00")];
+
+    // The extension does not include timezone information. By convention, we format to local time.
+    struct tm datetime = {0};
+    std::size_t size = std::strftime(formatted, sizeof(formatted), "%FT%T", localtime_r(&parsedTime, &datetime));
+
+    // Add nanoseconds portion if present
+    const long nanoseconds = (std::chrono::duration_cast<chrono::nanoseconds>(tp.time_since_epoch()).count() % 1000000000 + 1000000000) % 1000000000;
+    if (nanoseconds != 0) {
+        size += sprintf(formatted + size, ".%09lu", nanoseconds);
+        // remove trailing zeros
+        while (formatted[size - 1] == '0') {
+            --size;
+        }
+    }
+    if (datetime.tm_gmtoff == 0) {
+        formatted[size] = 'Z';
+    } else {
+        size += std::strftime(formatted + size, sizeof(formatted) - size, "%z", &datetime);
+        // fix timezone format (0000 -> 00:00)
+        formatted[size] = formatted[size - 1];
+        formatted[size - 1] = formatted[size - 2];
+        formatted[size - 2] = ':';
+    }
+    formatted[++size] = '\0';
+    return std::string(formatted, size);
+}
+
+/// \brief msgpack parser visitor that directly calls a rapidjson handler for every value, so no intermediate msgpack::object tree is created
+template <typename Handler>
+class RapidJsonMsgPackVisitor : public msgpack::v2::null_visitor
+{
+public:
+    RapidJsonMsgPackVisitor(Handler& handler) : _handler(handler), _bInKey(false) {
+    }
+
+    bool visit_nil() {
+        _CheckNotKey();
+        return _handler.Null();
+    }
+    bool visit_boolean(bool v) {
+        _CheckNotKey();
+        return _handler.Bool(v);
+    }
+    bool visit_positive_integer(uint64_t v) {
+        _CheckNotKey();
+        return _handler.Uint64(v);
+    }
+    bool visit_negative_integer(int64_t v) {
+        _CheckNotKey();
+        return _handler.Int64(v);
+    }
+    bool visit_float32(float v) {
+        _CheckNotKey();
+        return _handler.Double(v);
+    }
+    bool visit_float64(double v) {
+        _CheckNotKey();
+        return _handler.Double(v);
+    }
+    bool visit_str(const char* v, uint32_t size) {
+        if( _bInKey ) {
+            _bInKey = false;
+            return _handler.Key(v, size, true);
+        }
+        return _handler.String(v, size, true);
+    }
+    bool visit_bin(const char* v, uint32_t size) {
+        return visit_str(v, size);
+    }
+    bool visit_ext(const char* v, uint32_t size) {
+        _CheckNotKey();
+        // v starts with the extension type
+        msgpack::object o;
+        o.type = msgpack::type::EXT;
+        o.via.ext.ptr = v;
+        o.via.ext.size = size - 1;
+        if( o.via.ext.type() == -1 ) {
+            const std::string formatted = FormatMsgPackTimestamp(o);
+            return _handler.String(formatted.c_str(), formatted.size(), true);
+        }
+        RAVELOG_WARN("Unrecognized msgpack extension type.");
+        return _handler.Null();
+    }
+    bool start_array(uint32_t num_elements) {
+        _CheckNotKey();
+        _vcounts.push_back(num_elements);
+        return _handler.StartArray();
+    }
+    bool end_array() {
+        const uint32_t num_elements = _vcounts.back();
+        _vcounts.pop_back();
+        return _handler.EndArray(num_elements);
+    }
+    bool start_map(uint32_t num_kv_pairs) {
+        _CheckNotKey();
+        _vcounts.push_back(num_kv_pairs);
+        return _handler.StartObject();
+    }
+    bool start_map_key() {
+        _bInKey = true;
+        return true;
+    }
+    bool end_map_key() {
+        _CheckNotKey();
+        return true;
+    }
+    bool end_map() {
+        const uint32_t num_kv_pairs = _vcounts.back();
+        _vcounts.pop_back();
+        return _handler.EndObject(num_kv_pairs);
+    }
+    void parse_error(size_t /*parsed_offset*/, size_t /*error_offset*/) {
+        throw msgpack::parse_error("parse error");
+    }
+    void insufficient_bytes(size_t /*parsed_offset*/, size_t /*error_offset*/) {
+        throw msgpack::insufficient_bytes("insufficient bytes");
+    }
+
+private:
+    /// \brief throws if a map key is expected, since only string keys can be converted to rapidjson
+    inline void _CheckNotKey() {
+        if( _bInKey ) {
+            // clear the state in case the caller keeps using the visitor after catching
+            _bInKey = false;
+            throw msgpack::type_error();
+        }
+    }
+
+    Handler& _handler;
+    std::vector<uint32_t> _vcounts; ///< number of elements of the arrays and maps being parsed
+    bool _bInKey; ///< true if the next string is a map key
+};
+
+/// \brief rapidjson document generator that parses msgpack data in one pass
+class MsgPackDocumentGenerator
+{
+public:
+    MsgPackDocumentGenerator(const char* data, size_t size) : _data(data), _size(size) {
+    }
+
+    template <typename Handler>
+    bool operator()(Handler& handler) {
+        RapidJsonMsgPackVisitor<Handler> visitor(handler);
+        std::size_t offset = 0;
+        if( !msgpack::v2::parse(_data, _size, offset, visitor) ) {
+            throw msgpack::parse_error("parse error");
+        }
+        return true;
+    }
+
+private:
+    const char* _data;
+    size_t _size;
+};
+
+} // end namespace
+
 namespace msgpack {
 
 MSGPACK_API_VERSION_NAMESPACE(MSGPACK_DEFAULT_API_NS) {
@@ -58,6 +225,9 @@ struct convert< rapidjson::GenericDocument<Encoding, Allocator, StackAllocator>
                 msgpack::object_kv* END = ptr + o.via.map.size;
                 for (; ptr < END; ++ptr)
                 {
+                    if( ptr->key.type != msgpack::type::STR && ptr->key.type != msgpack::type::BIN ) {
+                        throw msgpack::type_error();
+                    }
                     rapidjson::GenericValue<Encoding, Allocator> key(ptr->key.via.str.ptr, ptr->key.via.str.size, v.GetAllocator());
                     rapidjson::GenericDocument<Encoding, Allocator, StackAllocator> val(&v.GetAllocator());
                     ptr->val.convert(val);
@@ -68,37 +238,8 @@ struct convert< rapidjson::GenericDocument<Encoding, Allocator, StackAllocator>
                 break;
             case msgpack::type::EXT: {
                 if (o.via.ext.type() == -1) {
-                    const std::chrono::system_clock::time_point tp = o.as<std::chrono::system_clock::time_point>();
-                    const std::time_t parsedTime = std::chrono::system_clock::to_time_t(tp);
-
-                    // RFC 3339 Nano format
-                    char formatted[sizeof("2006-01-02T15:04:05.999999999Z07:00")];
-
-                    // The extension does not include timezone information. By convention, we format to local time.
-                    struct tm datetime = {0};
-                    std::size_t size = std::strftime(formatted, sizeof(formatted), "%FT%T", localtime_r(&parsedTime, &datetime));
-
-                    // Add nanoseconds portion if present
-                    const long nanoseconds = (std::chrono::duration_cast<chrono::nanoseconds>(tp.time_since_epoch()).count() % 1000000000 + 1000000000) % 1000000000;
-                    if (nanoseconds != 0) {
-                        size += sprintf(formatted + size, ".%09lu", nanoseconds);
-                        // remove trailing zeros
-                        while (formatted[size - 1] == '0') {
-                            --size;
-                        }
-                    }
-                    if (datetime.tm_gmtoff == 0) {
-                        formatted[size] = 'Z';
-                    } else {
-                        size += std::strftime(formatted + size, sizeof(formatted) - size, "%z", &datetime);
-                        // fix timezone format (0000 -> 00:00)
-                        formatted[size] = formatted[size - 1];
-                        formatted[size - 1] = formatted[size - 2];
-                        formatted[size - 2] = ':';
-                    }
-                    formatted[++size] = '\0';
-
-                    v.SetString(formatted, size, v.GetAllocator());
+                    const std::string formatted = FormatMsgPackTimestamp(o);
+                    v.SetString(formatted.c_str(), formatted.size(), v.GetAllocator());
                 } else {
                     RAVELOG_WARN("Unrecognized msgpack extension type.");
                 }
@@ -136,6 +277,29 @@ struct pack< rapidjson::GenericValue<Encoding, Allocator> > {
                 return o.pack_true();
             case rapidjson::kObjectType:
             {
+                if( v.MemberCount() == 2 && OpenRAVE::orjson::IsJsonTypedArray(v) ) {
+                    // typed arrays written for msgpack already hold the raw bytes in "data", those read from json are base64 encoded.
+                    // both are packed as bin. objects with any other member are packed as they are, since the other members would be lost
+                    const rapidjson::GenericValue<Encoding, Allocator>& rType = v["typedArray"];
+                    if( v.HasMember("data") && v["data"].IsString() ) {
+                        const rapidjson::GenericValue<Encoding, Allocator>& rData = v["data"];
+                        o.pack_map(2);
+                        o.pack_str(10).pack_str_body("typedArray", 10);
+                        o.pack_str(rType.GetStringLength()).pack_str_body(rType.GetString(), rType.GetStringLength());
+                        o.pack_str(4).pack_str_body("data", 4);
+                        o.pack_bin(rData.GetStringLength()).pack_bin_body(rData.GetString(), rData.GetStringLength());
+                        return o;
+                    }
+                    if( v.HasMember("base64") && v["base64"].IsString() ) {
+                        OpenRAVE::orjson::JsonTypedArrayReader reader(v);
+                        o.pack_map(2);
+                        o.pack_str(10).pack_str_body("typedArray", 10);
+                        o.pack_str(rType.GetStringLength()).pack_str_body(rType.GetString(), rType.GetStringLength());
+                        o.pack_str(4).pack_str_body("data", 4);
+                        o.pack_bin(reader.GetByteSize()).pack_bin_body(reinterpret_cast<const char*>(reader.GetData()), reader.GetByteSize());
+                        return o;
+                    }
+                }
                 o.pack_map(v.MemberCount());
                 typename rapidjson::GenericValue<Encoding, Allocator>::ConstMemberIterator i = v.MemberBegin(), END = v.MemberEnd();
                 for (; i != END; ++i)
@@ -333,16 +497,13 @@ void OpenRAVE::MsgPack::DumpMsgPack(const rapidjson::Value& value, std::vector<c
 
 void OpenRAVE::MsgPack::ParseMsgPack(rapidjson::Document& d, const std::string& str)
 {
-    msgpack::unpacked unpacked;
-    msgpack::unpack(unpacked, str.data(), str.size());
-    unpacked.get().convert(d);
+    OpenRAVE::MsgPack::ParseMsgPack(d, str.data(), str.size());
 }
 
 void OpenRAVE::MsgPack::ParseMsgPack(rapidjson::Document& d, const void* data, size_t size)
 {
-    msgpack::unpacked unpacked;
-    msgpack::unpack(unpacked, (const char*) data, size);
-    unpacked.get().convert(d);
+    MsgPackDocumentGenerator generator((const char*) data, size);
+    d.Populate(generator);
 }
 
 void OpenRAVE::MsgPack::ParseMsgPack(rapidjson::Document& d, std::istream& is)
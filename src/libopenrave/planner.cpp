@@ -111,6 +111,25 @@ int AddStatesWithLimitCheck(std::vector<dReal>& q, const std::vector<dReal>& qde
     return status;
 }
 
+/// \brief holds a function installed by SetRobotActiveJoints, SetRobotDOFIndices or SetConfigurationSpecification
+///
+/// boost::function copies its target, so the wrapper type is what lets target<DefaultPlannerFunction<Fn> >() recognize the function after the parameters are copied.
+template <typename Fn>
+class DefaultPlannerFunction
+{
+public:
+    DefaultPlannerFunction(const Fn& fn) : _fn(fn) {
+    }
+
+    template <typename... Args>
+    typename Fn::result_type operator()(Args&&... args) const {
+        return _fn(std::forward<Args>(args)...);
+    }
+
+private:
+    Fn _fn;
+};
+
 PlannerStatus::PlannerStatus()
 {
     statusCode = 0;
@@ -646,17 +665,18 @@ void PlannerParameters::SetRobotActiveJoints(RobotBasePtr& robot)
     }
 
     using namespace planningutils;
-    _distmetricfn = boost::bind(&SimpleDistanceMetric::Eval,boost::shared_ptr<SimpleDistanceMetric>(new SimpleDistanceMetric(robot)),_1,_2);
+    // store the metric directly so that planners can recognize it with _distmetricfn.target<SimpleDistanceMetric>()
+    _distmetricfn = SimpleDistanceMetric(robot);
     if( robot->GetActiveDOF() == (int)robot->GetActiveDOFIndices().size() ) {
         // only roobt joint indices, so use a more resiliant function
         _getstatefn = boost::bind(&RobotBase::GetDOFValues,robot,_1,robot->GetActiveDOFIndices());
         _setstatevaluesfn = boost::bind(SetDOFValuesIndicesParameters,robot, _1, robot->GetActiveDOFIndices(), _2);
-        _diffstatefn = boost::bind(&RobotBase::SubtractDOFValues,robot,_1,_2, robot->GetActiveDOFIndices());
+        _diffstatefn = DefaultPlannerFunction<DiffStateFn>(boost::bind(&RobotBase::SubtractDOFValues,robot,_1,_2, robot->GetActiveDOFIndices()));
     }
     else {
         _getstatefn = boost::bind(&RobotBase::GetActiveDOFValues,robot,_1);
         _setstatevaluesfn = boost::bind(SetActiveDOFValuesParameters,robot, _1, _2);
-        _diffstatefn = boost::bind(&RobotBase::SubtractActiveDOFValues,robot,_1,_2);
+        _diffstatefn = DefaultPlannerFunction<DiffStateFn>(boost::bind(&RobotBase::SubtractActiveDOFValues,robot,_1,_2));
     }
 
     SpaceSamplerBasePtr pconfigsampler = RaveCreateSpaceSampler(robot->GetEnv(),str(boost::format("robotconfiguration %s")%robot->GetName()));
@@ -664,7 +684,7 @@ void PlannerParameters::SetRobotActiveJoints(RobotBasePtr& robot)
     _listInternalSamplers.push_back(pconfigsampler);
 
     boost::shared_ptr<SimpleNeighborhoodSampler> defaultsamplefn(new SimpleNeighborhoodSampler(pconfigsampler,_distmetricfn, _diffstatefn));
-    _samplefn = boost::bind(&SimpleNeighborhoodSampler::Sample,defaultsamplefn,_1);
+    _samplefn = DefaultPlannerFunction<SampleFn>(boost::bind(&SimpleNeighborhoodSampler::Sample,defaultsamplefn,_1));
     _sampleneighfn = boost::bind(&SimpleNeighborhoodSampler::Sample,defaultsamplefn,_1,_2,_3);
 
     robot->GetActiveDOFLimits(_vConfigLowerLimit,_vConfigUpperLimit);
@@ -676,15 +696,11 @@ void PlannerParameters::SetRobotActiveJoints(RobotBasePtr& robot)
     robot->GetActiveDOFVelocities(_vInitialConfigVelocities); // necessary?
     _configurationspecification = robot->GetActiveConfigurationSpecification();
 
-    _neighstatefn = boost::bind(AddStatesWithLimitCheck, _1, _2, _3, boost::ref(_vConfigLowerLimit), boost::ref(_vConfigUpperLimit)); // probably ok... do we need to clamp limits?
+    _neighstatefn = DefaultPlannerFunction<NeighStateFn>(boost::bind(AddStatesWithLimitCheck, _1, _2, _3, boost::ref(_vConfigLowerLimit), boost::ref(_vConfigUpperLimit))); // probably ok... do we need to clamp limits?
 
     // have to do this last, disable timed constraints for default
     std::list<KinBodyPtr> listCheckCollisions; listCheckCollisions.push_back(robot);
-    boost::shared_ptr<DynamicsCollisionConstraint> pcollision(new DynamicsCollisionConstraint(shared_parameters(), listCheckCollisions,0xffffffff&~CFO_CheckTimeBasedConstraints));
-    _checkpathvelocityconstraintsfn = boost::bind(&DynamicsCollisionConstraint::Check,pcollision,_1, _2, _3, _4, _5, _6, _7, _8);
-
-    int (DynamicsCollisionConstraint::*CheckWithAccelerations)(const std::vector<dReal>&, const std::vector<dReal>&, const std::vector<dReal>&, const std::vector<dReal>&, const std::vector<dReal>&, const std::vector<dReal>&, dReal, IntervalType, int, ConstraintFilterReturnPtr) = &DynamicsCollisionConstraint::Check;
-    _checkpathvelocityaccelerationconstraintsfn = std::bind(CheckWithAccelerations, pcollision, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, std::placeholders::_7, std::placeholders::_8, std::placeholders::_9, std::placeholders::_10);
+    _SetDefaultCollisionConstraints(listCheckCollisions);
 }
 
 void PlannerParameters::SetRobotDOFIndices(RobotBasePtr& probot, const std::vector<int>& dofindices)
@@ -701,18 +717,18 @@ void PlannerParameters::SetRobotDOFIndices(RobotBasePtr& probot, const std::vect
     }
 
     using namespace planningutils;
-    _distmetricfn = boost::bind(&SimpleDistanceMetric::Eval,boost::shared_ptr<SimpleDistanceMetric>(new SimpleDistanceMetric(probot)),_1,_2);
+    _distmetricfn = DefaultPlannerFunction<DistMetricFn>(boost::bind(&SimpleDistanceMetric::Eval,boost::shared_ptr<SimpleDistanceMetric>(new SimpleDistanceMetric(probot)),_1,_2));
     // only roobt joint indices, so use a more resiliant function
     _getstatefn = boost::bind(&RobotBase::GetDOFValues,probot,_1,dofindices);
     _setstatevaluesfn = boost::bind(SetDOFValuesIndicesParameters,probot, _1, dofindices, _2);
-    _diffstatefn = boost::bind(&RobotBase::SubtractDOFValues,probot,_1,_2, dofindices);
+    _diffstatefn = DefaultPlannerFunction<DiffStateFn>(boost::bind(&RobotBase::SubtractDOFValues,probot,_1,_2, dofindices));
 
     SpaceSamplerBasePtr pconfigsampler = RaveCreateSpaceSampler(robot.GetEnv(),str(boost::format("robotconfiguration %s")%robot.GetName()));
     _listInternalSamplers.clear();
     _listInternalSamplers.push_back(pconfigsampler);
 
     boost::shared_ptr<SimpleNeighborhoodSampler> defaultsamplefn(new SimpleNeighborhoodSampler(pconfigsampler,_distmetricfn, _diffstatefn));
-    _samplefn = boost::bind(&SimpleNeighborhoodSampler::Sample,defaultsamplefn,_1);
+    _samplefn = DefaultPlannerFunction<SampleFn>(boost::bind(&SimpleNeighborhoodSampler::Sample,defaultsamplefn,_1));
     _sampleneighfn = boost::bind(&SimpleNeighborhoodSampler::Sample,defaultsamplefn,_1,_2,_3);
 
     robot.GetDOFLimits(_vConfigLowerLimit,_vConfigUpperLimit, dofindices);
@@ -724,15 +740,11 @@ void PlannerParameters::SetRobotDOFIndices(RobotBasePtr& probot, const std::vect
     robot.GetDOFVelocities(_vInitialConfigVelocities, dofindices); // necessary?
     _configurationspecification = robot.GetConfigurationSpecificationIndices(dofindices);
 
-    _neighstatefn = boost::bind(AddStatesWithLimitCheck, _1, _2, _3, boost::ref(_vConfigLowerLimit), boost::ref(_vConfigUpperLimit)); // probably ok... do we need to clamp limits?
+    _neighstatefn = DefaultPlannerFunction<NeighStateFn>(boost::bind(AddStatesWithLimitCheck, _1, _2, _3, boost::ref(_vConfigLowerLimit), boost::ref(_vConfigUpperLimit))); // probably ok... do we need to clamp limits?
 
     // have to do this last, disable timed constraints for default
     std::list<KinBodyPtr> listCheckCollisions; listCheckCollisions.push_back(probot);
-    boost::shared_ptr<DynamicsCollisionConstraint> pcollision(new DynamicsCollisionConstraint(shared_parameters(), listCheckCollisions,0xffffffff&~CFO_CheckTimeBasedConstraints));
-    _checkpathvelocityconstraintsfn = boost::bind(&DynamicsCollisionConstraint::Check,pcollision,_1, _2, _3, _4, _5, _6, _7, _8);
-
-    int (DynamicsCollisionConstraint::*CheckWithAccelerations)(const std::vector<dReal>&, const std::vector<dReal>&, const std::vector<dReal>&, const std::vector<dReal>&, const std::vector<dReal>&, const std::vector<dReal>&, dReal, IntervalType, int, ConstraintFilterReturnPtr) = &DynamicsCollisionConstraint::Check;
-    _checkpathvelocityaccelerationconstraintsfn = std::bind(CheckWithAccelerations, pcollision, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, std::placeholders::_7, std::placeholders::_8, std::placeholders::_9, std::placeholders::_10);
+    _SetDefaultCollisionConstraints(listCheckCollisions);
 }
 
 void _CallDiffStateFns(const std::vector< std::pair<PlannerParameters::DiffStateFn, int> >& vfunctions, int nDOF, int nMaxDOFForGroup, std::vector<dReal>& v0, const std::vector<dReal>& v1)
@@ -1018,13 +1030,13 @@ void PlannerParameters::SetConfigurationSpecification(EnvironmentBasePtr penv, c
             throw OPENRAVE_EXCEPTION_FORMAT(_("group %s not supported for for planner parameters configuration"),g.name,ORE_InvalidArguments);
         }
     }
-    _diffstatefn = boost::bind(_CallDiffStateFns,diffstatefns, spec.GetDOF(), nMaxDOFForGroup, _1, _2);
-    _distmetricfn = boost::bind(_CallDistMetricFns,distmetricfns, spec.GetDOF(), nMaxDOFForGroup, _1, _2);
-    _samplefn = boost::bind(_CallSampleFns,samplefns, spec.GetDOF(), nMaxDOFForGroup, _1);
+    _diffstatefn = DefaultPlannerFunction<DiffStateFn>(boost::bind(_CallDiffStateFns,diffstatefns, spec.GetDOF(), nMaxDOFForGroup, _1, _2));
+    _distmetricfn = DefaultPlannerFunction<DistMetricFn>(boost::bind(_CallDistMetricFns,distmetricfns, spec.GetDOF(), nMaxDOFForGroup, _1, _2));
+    _samplefn = DefaultPlannerFunction<SampleFn>(boost::bind(_CallSampleFns,samplefns, spec.GetDOF(), nMaxDOFForGroup, _1));
     _sampleneighfn = boost::bind(_CallSampleNeighFns,sampleneighfns, distmetricfns, spec.GetDOF(), nMaxDOFForGroup, _1, _2, _3);
     _setstatevaluesfn = boost::bind(CallSetStateValuesFns,setstatevaluesfns, spec.GetDOF(), nMaxDOFForGroup, _1, _2);
     _getstatefn = boost::bind(CallGetStateFns,getstatefns, spec.GetDOF(), nMaxDOFForGroup, _1);
-    _neighstatefn = boost::bind(_CallNeighStateFns,neighstatefns, spec.GetDOF(), nMaxDOFForGroup, _1,_2,_3);
+    _neighstatefn = DefaultPlannerFunction<NeighStateFn>(boost::bind(_CallNeighStateFns,neighstatefns, spec.GetDOF(), nMaxDOFForGroup, _1,_2,_3));
     _vConfigLowerLimit.swap(vConfigLowerLimit);
     _vConfigUpperLimit.swap(vConfigUpperLimit);
     _vConfigVelocityLimit.swap(vConfigVelocityLimit);
@@ -1034,8 +1046,38 @@ void PlannerParameters::SetConfigurationSpecification(EnvironmentBasePtr penv, c
     _configurationspecification = spec;
     _getstatefn(vinitialconfig);
     // have to do this last, disable timed constraints for default
+    _SetDefaultCollisionConstraints(listCheckCollisions);
+}
+
+bool PlannerParameters::HasDefaultNeighStateFn() const
+{
+    return !!_neighstatefn.target< DefaultPlannerFunction<NeighStateFn> >();
+}
+
+bool PlannerParameters::HasDefaultConfigurationFunctions() const
+{
+    return HasDefaultNeighStateFn() && !!_samplefn.target< DefaultPlannerFunction<SampleFn> >() && !!_checkpathvelocityconstraintsfn.target< DefaultPlannerFunction<CheckPathVelocityConstraintFn> >();
+}
+
+bool PlannerParameters::HasDefaultDistanceFunctions() const
+{
+    // SetRobotActiveJoints stores its metric directly, see there
+    return (!!_distmetricfn.target<planningutils::SimpleDistanceMetric>() || !!_distmetricfn.target< DefaultPlannerFunction<DistMetricFn> >()) && !!_diffstatefn.target< DefaultPlannerFunction<DiffStateFn> >();
+}
+
+void PlannerParameters::_SetDefaultCollisionConstraints(const std::list<KinBodyPtr>& listCheckCollisions)
+{
+    using namespace planningutils;
+    // read once, the number of threads checking the states of long straight-line segments
+    static const int s_nParallelSegmentThreads = []() {
+        const char* pOPENRAVE_PARALLEL_SEGMENT_CHECK = getenv("OPENRAVE_PARALLEL_SEGMENT_CHECK");
+        return !!pOPENRAVE_PARALLEL_SEGMENT_CHECK ? atoi(pOPENRAVE_PARALLEL_SEGMENT_CHECK) : 0;
+    }();
     boost::shared_ptr<DynamicsCollisionConstraint> pcollision(new DynamicsCollisionConstraint(shared_parameters(), listCheckCollisions,0xffffffff&~CFO_CheckTimeBasedConstraints));
-    _checkpathvelocityconstraintsfn = boost::bind(&DynamicsCollisionConstraint::Check,pcollision,_1, _2, _3, _4, _5, _6, _7, _8);
+    if( s_nParallelSegmentThreads > 1 ) {
+        pcollision->SetParallelCheck(s_nParallelSegmentThreads);
+    }
+    _checkpathvelocityconstraintsfn = DefaultPlannerFunction<CheckPathVelocityConstraintFn>(boost::bind(&DynamicsCollisionConstraint::Check,pcollision,_1, _2, _3, _4, _5, _6, _7, _8));
 
     int (DynamicsCollisionConstraint::*CheckWithAccelerations)(const std::vector<dReal>&, const std::vector<dReal>&, const std::vector<dReal>&, const std::vector<dReal>&, const std::vector<dReal>&, const std::vector<dReal>&, dReal, IntervalType, int, ConstraintFilterReturnPtr) = &DynamicsCollisionConstraint::Check;
     _checkpathvelocityaccelerationconstraintsfn = std::bind(CheckWithAccelerations, pcollision, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, std::placeholders::_7, std::placeholders::_8, std::placeholders::_9, std::placeholders::_10);
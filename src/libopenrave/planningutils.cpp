@@ -25,6 +25,10 @@
 
 #include <boost/bind/bind.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+
 using namespace boost::placeholders;
 
 namespace OpenRAVE {
@@ -2238,7 +2242,362 @@ void GetDHParameters(std::vector<DHParameter>& vparameters, KinBodyConstPtr pbod
     }
 }
 
-DynamicsCollisionConstraint::DynamicsCollisionConstraint(PlannerBase::PlannerParametersConstPtr parameters, const std::list<KinBodyPtr>& listCheckBodies, int filtermask) : _listCheckBodies(listCheckBodies), _filtermask(filtermask), _torquelimitmode(DC_NominalTorque), _perturbation(0.1)
+/// \brief fills vorder with the integers in [istart, iend) in coarse-to-fine order: the midpoint of the range first, then the midpoints of its two halves, and so on.
+static void _GetBisectionOrder(int istart, int iend, std::vector<int>& vorder, std::vector< std::pair<int, int> >& vintervals)
+{
+    vorder.resize(0);
+    vintervals.resize(0);
+    if( istart >= iend ) {
+        return;
+    }
+    vorder.reserve(iend-istart);
+    vintervals.reserve(iend-istart);
+    // breadth-first over the half-open intervals, so every level halves the largest gap between the checked states
+    vintervals.emplace_back(istart, iend);
+    for(size_t iinterval = 0; iinterval < vintervals.size(); ++iinterval) {
+        const int ilow = vintervals[iinterval].first;
+        const int ihigh = vintervals[iinterval].second;
+        const int imid = ilow + (ihigh - ilow)/2;
+        vorder.push_back(imid);
+        if( ilow < imid ) {
+            vintervals.emplace_back(ilow, imid);
+        }
+        if( imid + 1 < ihigh ) {
+            vintervals.emplace_back(imid + 1, ihigh);
+        }
+    }
+}
+
+/// \brief pool of threads each owning a clone of the environment of the check bodies
+class DynamicsCollisionConstraint::ParallelCheckWorkers
+{
+public:
+    ParallelCheckWorkers(int numthreads) : _nCheckerOptions(0), _bBodiesChanged(false), _numSteps(0), _options(0), _perturbation(0), _nNextOrderIndex(0), _nInvalidStep(0), _nInvalidReturn(0), _nJobId(0), _nNumRunning(0), _bShutdown(false)
+    {
+        _vworkers.resize(numthreads);
+        _vthreads.reserve(numthreads);
+        for(int iworker = 0; iworker < numthreads; ++iworker) {
+            _vthreads.emplace_back(std::bind(&ParallelCheckWorkers::_WorkerThread, this, iworker));
+        }
+    }
+
+    virtual ~ParallelCheckWorkers()
+    {
+        _vbodystates.clear(); // unregister the change callbacks
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _bShutdown = true;
+        }
+        _condJob.notify_all();
+        for(std::thread& thread : _vthreads) {
+            thread.join();
+        }
+        for(Worker& worker : _vworkers) {
+            if( !!worker.penv ) {
+                worker.penv->Destroy();
+            }
+        }
+    }
+
+    inline int GetNumThreads() const {
+        return (int)_vworkers.size();
+    }
+
+    /// \brief synchronizes the worker environments with the environment of listCheckBodies and checks the states q0 + (f/numSteps)*dQ for f in [start, numSteps)
+    ///
+    /// The workers clone the environment only when its bodies, their grabbed bodies, geometries or enabled links, or the collision checker
+    /// changed. Otherwise only the check bodies and the bodies that moved since the last check are synchronized.
+    /// \param[out] ninvalidstep the smallest invalid step, numSteps if all states are valid
+    /// \return false if the worker environments could not be synchronized
+    bool Check(PlannerBase::PlannerParametersConstPtr params, const std::list<KinBodyPtr>& listCheckBodies, const std::vector<dReal>& q0, const std::vector<dReal>& dQ, int numSteps, int start, int options, dReal perturbation, int& ninvalidstep)
+    {
+        EnvironmentBasePtr penv = listCheckBodies.front()->GetEnv();
+        const bool bClone = _UpdateBodyStates(penv, listCheckBodies);
+        const bool bUpdateSetFn = bClone || _spec != params->_configurationspecification;
+        for(Worker& worker : _vworkers) {
+            if( bClone || !worker.penv ) {
+                if( !_CloneEnvironment(penv, listCheckBodies, worker) ) {
+                    _vbodystates.resize(0); // clone again next time
+                    return false;
+                }
+            }
+            else {
+                EnvironmentLock lockworker(worker.penv->GetMutex());
+                for(size_t ibody = 0; ibody < _vbodystates.size(); ++ibody) {
+                    const BodyState& state = _vbodystates[ibody];
+                    if( state.bsync ) {
+                        worker.vbodies[ibody]->SetLinkTransformations(state.vlinktransforms, state.vdofbranches);
+                    }
+                }
+            }
+            if( bUpdateSetFn ) {
+                worker.setstatefn = params->_configurationspecification.GetSetFn(worker.penv);
+            }
+        }
+        _spec = params->_configurationspecification;
+
+        _GetBisectionOrder(start, numSteps, _vorder, _vintervals);
+        _params = params;
+        _pq0 = &q0;
+        _pdQ = &dQ;
+        _numSteps = numSteps;
+        _options = options;
+        _perturbation = perturbation;
+        _nNextOrderIndex = 0;
+        _nInvalidStep = numSteps;
+        _nInvalidReturn = 0;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            ++_nJobId;
+            _nNumRunning = (int)_vworkers.size();
+            _condJob.notify_all();
+            _condFinished.wait(lock, [this] {
+                return _nNumRunning == 0;
+            });
+        }
+        _params.reset();
+        ninvalidstep = _nInvalidStep;
+        return true;
+    }
+
+private:
+    struct Worker
+    {
+        EnvironmentBasePtr penv; ///< clone of the environment of the check bodies
+        std::vector<KinBodyPtr> vbodies; ///< the bodies of penv in the order of _vbodystates
+        std::vector<KinBodyPtr> vcheckbodies; ///< the check bodies in penv
+        boost::shared_ptr<ConfigurationSpecification::SetConfigurationStateFn> setstatefn; ///< sets the planner configuration in penv
+        std::vector<dReal> vtempconfig, vperturbedvalues;
+    };
+
+    /// \brief what the workers know about a body of the environment since the last synchronization
+    struct BodyState
+    {
+        KinBodyWeakPtr pbody; ///< the body in the environment of the check bodies
+        int nupdatestamp = -1; ///< \see KinBody::GetUpdateStamp
+        std::vector<int> vgrabbedbodyindices; ///< environment body indices of the grabbed bodies
+        std::vector<uint64_t> vlinkenablemasks; ///< \see KinBody::GetLinkEnableStatesMasks
+        UserDataPtr handlechange; ///< sets _bBodiesChanged when the geometries or grabbed bodies of the body change
+        bool bsync = false; ///< if true, the link transforms have to be set in the worker environments
+        std::vector<Transform> vlinktransforms;
+        std::vector<dReal> vdofbranches;
+    };
+
+    /// \brief updates _vbodystates from the bodies of penv
+    ///
+    /// \return true if the workers have to clone the environment since a body was added or removed, its grabbed bodies, geometries or enabled links changed, or the collision checker changed
+    bool _UpdateBodyStates(EnvironmentBasePtr penv, const std::list<KinBodyPtr>& listCheckBodies)
+    {
+        penv->GetBodies(_vbodies);
+        // the change callbacks catch geometry edits, geometry group switches and grabbing with another relative pose
+        bool bClone = _bBodiesChanged.exchange(false) || _vbodies.size() != _vbodystates.size();
+        CollisionCheckerBasePtr pchecker = penv->GetCollisionChecker();
+        const std::string checkerid = !pchecker ? std::string() : pchecker->GetXMLId();
+        const int nCheckerOptions = !pchecker ? 0 : pchecker->GetCollisionOptions();
+        if( checkerid != _checkerid || nCheckerOptions != _nCheckerOptions ) {
+            _checkerid = checkerid;
+            _nCheckerOptions = nCheckerOptions;
+            bClone = true;
+        }
+        _vbodystates.resize(_vbodies.size());
+        for(size_t ibody = 0; ibody < _vbodies.size(); ++ibody) {
+            const KinBodyPtr& pbody = _vbodies[ibody];
+            BodyState& state = _vbodystates[ibody];
+            bool bChanged = state.pbody.lock() != pbody || (int)state.vgrabbedbodyindices.size() != pbody->GetNumGrabbed() || state.vlinkenablemasks != pbody->GetLinkEnableStatesMasks();
+            for(int igrabbed = 0; igrabbed < (int)state.vgrabbedbodyindices.size() && !bChanged; ++igrabbed) {
+                KinBodyPtr pgrabbed = pbody->GetGrabbedBody(igrabbed);
+                bChanged = !pgrabbed || pgrabbed->GetEnvironmentBodyIndex() != state.vgrabbedbodyindices[igrabbed];
+            }
+            if( bChanged ) {
+                if( state.pbody.lock() != pbody ) {
+                    state.pbody = pbody;
+                    state.handlechange = pbody->RegisterChangeCallback(KinBody::Prop_LinkGeometry|KinBody::Prop_LinkGeometryGroup|KinBody::Prop_LinkStatic|KinBody::Prop_JointMimic|KinBody::Prop_RobotGrabbed, std::bind(&ParallelCheckWorkers::_SetBodiesChanged, this));
+                }
+                state.vgrabbedbodyindices.resize(pbody->GetNumGrabbed());
+                for(int igrabbed = 0; igrabbed < (int)state.vgrabbedbodyindices.size(); ++igrabbed) {
+                    KinBodyPtr pgrabbed = pbody->GetGrabbedBody(igrabbed);
+                    state.vgrabbedbodyindices[igrabbed] = !pgrabbed ? -1 : pgrabbed->GetEnvironmentBodyIndex();
+                }
+                state.vlinkenablemasks = pbody->GetLinkEnableStatesMasks();
+                bClone = true;
+            }
+            // the planner changes the check bodies for every state, so always set them
+            state.bsync = state.nupdatestamp != pbody->GetUpdateStamp() || find(listCheckBodies.begin(), listCheckBodies.end(), pbody) != listCheckBodies.end();
+            state.nupdatestamp = pbody->GetUpdateStamp();
+            if( state.bsync ) {
+                pbody->GetLinkTransformations(state.vlinktransforms, state.vdofbranches);
+            }
+        }
+        return bClone;
+    }
+
+    void _SetBodiesChanged()
+    {
+        _bBodiesChanged = true;
+    }
+
+    bool _CloneEnvironment(EnvironmentBasePtr penv, const std::list<KinBodyPtr>& listCheckBodies, Worker& worker)
+    {
+        if( !worker.penv ) {
+            worker.penv = penv->CloneSelf(Clone_Bodies);
+        }
+        else {
+            worker.penv->Clone(penv, Clone_Bodies);
+        }
+        worker.vbodies.resize(_vbodies.size());
+        for(size_t ibody = 0; ibody < _vbodies.size(); ++ibody) {
+            worker.vbodies[ibody] = worker.penv->GetBodyFromEnvironmentBodyIndex(_vbodies[ibody]->GetEnvironmentBodyIndex());
+            if( !worker.vbodies[ibody] || worker.vbodies[ibody]->GetName() != _vbodies[ibody]->GetName() ) {
+                RAVELOG_DEBUG_FORMAT("env=%s, body %s is not in the worker environment", penv->GetNameId()%_vbodies[ibody]->GetName());
+                return false;
+            }
+        }
+        worker.vcheckbodies.resize(0);
+        for(const KinBodyPtr& pbody : listCheckBodies) {
+            KinBodyPtr pworkerbody = worker.penv->GetBodyFromEnvironmentBodyIndex(pbody->GetEnvironmentBodyIndex());
+            if( !pworkerbody || pworkerbody->GetName() != pbody->GetName() ) {
+                RAVELOG_DEBUG_FORMAT("env=%s, body %s is not in the worker environment", penv->GetNameId()%pbody->GetName());
+                return false;
+            }
+            worker.vcheckbodies.push_back(pworkerbody);
+        }
+        // cloning keeps the checker of the worker environment if it has the same type, so also copy the current options
+        CollisionCheckerBasePtr pchecker = penv->GetCollisionChecker(), pworkerchecker = worker.penv->GetCollisionChecker();
+        if( !!pchecker && !!pworkerchecker ) {
+            pworkerchecker->SetCollisionOptions(pchecker->GetCollisionOptions());
+        }
+        return true;
+    }
+
+    void _WorkerThread(int iworker)
+    {
+        int nlastjobid = 0;
+        while(1) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _condJob.wait(lock, [this, nlastjobid] {
+                    return _bShutdown || _nJobId != nlastjobid;
+                });
+                if( _bShutdown ) {
+                    return;
+                }
+                nlastjobid = _nJobId;
+            }
+
+            _CheckStates(_vworkers[iworker]);
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if( --_nNumRunning == 0 ) {
+                _condFinished.notify_all();
+            }
+        }
+    }
+
+    /// \brief claims states in bisection order until all states before the smallest invalid step found by any worker are checked
+    void _CheckStates(Worker& worker)
+    {
+        const std::vector<dReal>& q0 = *_pq0;
+        const std::vector<dReal>& dQ = *_pdQ;
+        const dReal fisteps = dReal(1.0)/_numSteps;
+        worker.vtempconfig.resize(q0.size());
+        int istep = _numSteps - 1;
+        try {
+            EnvironmentLock lockenv(worker.penv->GetMutex());
+            while(1) {
+                const int iorder = _nNextOrderIndex++;
+                if( iorder >= (int)_vorder.size() ) {
+                    break;
+                }
+                istep = _vorder[iorder];
+                if( istep >= _nInvalidStep ) {
+                    // a state before this one is already invalid
+                    continue;
+                }
+                for(size_t idof = 0; idof < q0.size(); ++idof) {
+                    worker.vtempconfig[idof] = q0[idof] + (istep*fisteps)*dQ[idof];
+                }
+                int nstateret = _CheckState(worker, worker.vtempconfig);
+                if( nstateret == 0 && (_options & CFO_CheckWithPerturbation) && _perturbation > 0 ) {
+                    worker.vperturbedvalues.resize(q0.size());
+                    for(int isign = -1; isign <= 1 && nstateret == 0; isign += 2) {
+                        for(size_t idof = 0; idof < q0.size(); ++idof) {
+                            worker.vperturbedvalues[idof] = worker.vtempconfig[idof] + isign * _perturbation * _params->_vConfigResolution.at(idof);
+                            if( worker.vperturbedvalues[idof] < _params->_vConfigLowerLimit.at(idof) ) {
+                                worker.vperturbedvalues[idof] = _params->_vConfigLowerLimit.at(idof);
+                            }
+                            if( worker.vperturbedvalues[idof] > _params->_vConfigUpperLimit.at(idof) ) {
+                                worker.vperturbedvalues[idof] = _params->_vConfigUpperLimit.at(idof);
+                            }
+                        }
+                        nstateret = _CheckState(worker, worker.vperturbedvalues);
+                    }
+                }
+                if( nstateret != 0 ) {
+                    _SetInvalid(istep, nstateret);
+                }
+            }
+        }
+        catch(const std::exception& ex) {
+            RAVELOG_WARN_FORMAT("env=%s, parallel check failed: %s", worker.penv->GetNameId()%ex.what());
+            // the calling thread re-checks the state and falls back to sequential checking if it is valid
+            _SetInvalid(istep, CFO_StateSettingError);
+        }
+    }
+
+    int _CheckState(Worker& worker, const std::vector<dReal>& vconfig)
+    {
+        if( (*worker.setstatefn)(vconfig) != 0 ) {
+            return CFO_StateSettingError;
+        }
+        for(const KinBodyPtr& pbody : worker.vcheckbodies) {
+            if( (_options & CFO_CheckEnvCollisions) && worker.penv->CheckCollision(KinBodyConstPtr(pbody), CollisionReportPtr()) ) {
+                return CFO_CheckEnvCollisions;
+            }
+            if( (_options & CFO_CheckSelfCollisions) && pbody->CheckSelfCollision(CollisionReportPtr()) ) {
+                return CFO_CheckSelfCollisions;
+            }
+        }
+        return 0;
+    }
+
+    void _SetInvalid(int istep, int nstateret)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if( istep < _nInvalidStep ) {
+            _nInvalidStep = istep;
+            _nInvalidReturn = nstateret;
+        }
+    }
+
+    std::vector<Worker> _vworkers;
+    std::vector<std::thread> _vthreads;
+    std::vector<BodyState> _vbodystates; ///< the bodies of the environment of the check bodies when the workers were last synchronized
+    std::vector<KinBodyPtr> _vbodies; ///< cache for _UpdateBodyStates
+    std::string _checkerid; ///< xml id of the collision checker of the environment when the workers were last synchronized
+    int _nCheckerOptions; ///< collision options of that checker
+    std::atomic<bool> _bBodiesChanged; ///< set by the change callbacks of the bodies in _vbodystates
+    ConfigurationSpecification _spec; ///< the configuration specification of the setstatefn of the workers
+
+    // the current job, only modified when no worker is running
+    PlannerBase::PlannerParametersConstPtr _params;
+    const std::vector<dReal>* _pq0;
+    const std::vector<dReal>* _pdQ;
+    int _numSteps, _options;
+    dReal _perturbation;
+    std::vector<int> _vorder; ///< steps to check in bisection order
+    std::vector< std::pair<int, int> > _vintervals; ///< cache for _GetBisectionOrder
+
+    std::atomic<int> _nNextOrderIndex; ///< index into _vorder of the next step to be claimed
+    std::atomic<int> _nInvalidStep; ///< smallest invalid step found, _numSteps if none. Only modified under _mutex
+    int _nInvalidReturn; ///< the ConstraintFilterOptions of _nInvalidStep
+
+    std::mutex _mutex; ///< protects _nJobId, _nNumRunning, _bShutdown
+    std::condition_variable _condJob, _condFinished;
+    int _nJobId, _nNumRunning;
+    bool _bShutdown;
+};
+
+DynamicsCollisionConstraint::DynamicsCollisionConstraint(PlannerBase::PlannerParametersConstPtr parameters, const std::list<KinBodyPtr>& listCheckBodies, int filtermask) : _listCheckBodies(listCheckBodies), _filtermask(filtermask), _torquelimitmode(DC_NominalTorque), _perturbation(0.1), _bDeferStateChecks(false), _bBatchDeferredStates(false)
 {
     BOOST_ASSERT(listCheckBodies.size()>0);
     _report.reset(new CollisionReport());
@@ -2247,6 +2606,7 @@ DynamicsCollisionConstraint::DynamicsCollisionConstraint(PlannerBase::PlannerPar
         _specvel = parameters->_configurationspecification.ConvertToVelocitySpecification();
         _setvelstatefn = _specvel.GetSetFn(_listCheckBodies.front()->GetEnv());
     }
+    _UpdateBatchBody(parameters);
 }
 
 void DynamicsCollisionConstraint::SetPlannerParameters(PlannerBase::PlannerParametersConstPtr parameters)
@@ -2256,6 +2616,21 @@ void DynamicsCollisionConstraint::SetPlannerParameters(PlannerBase::PlannerParam
         _specvel = parameters->_configurationspecification.ConvertToVelocitySpecification();
         _setvelstatefn = _specvel.GetSetFn(_listCheckBodies.front()->GetEnv());
     }
+    _UpdateBatchBody(parameters);
+}
+
+void DynamicsCollisionConstraint::_UpdateBatchBody(PlannerBase::PlannerParametersConstPtr parameters)
+{
+    _pbatchbody.reset();
+    if( !parameters || _listCheckBodies.size() != 1 || _listCheckBodies.front()->GetDOF() == 0 ) {
+        return;
+    }
+    // the batch only moves the check body, so the planner state cannot move any other body
+    std::vector<KinBodyPtr> vusedbodies;
+    parameters->_configurationspecification.ExtractUsedBodies(_listCheckBodies.front()->GetEnv(), vusedbodies);
+    if( vusedbodies.size() == 1 && vusedbodies[0] == _listCheckBodies.front() ) {
+        _pbatchbody = vusedbodies[0];
+    }
 }
 
 void DynamicsCollisionConstraint::SetUserCheckFunction(const boost::function<bool() >& usercheckfn, bool bCallAfterCheckCollision)
@@ -2278,6 +2653,65 @@ void DynamicsCollisionConstraint::SetPerturbation(dReal perturbation)
     _perturbation = perturbation;
 }
 
+void DynamicsCollisionConstraint::SetParallelCheck(int numthreads)
+{
+    if( numthreads <= 1 ) {
+        _pparallelworkers.reset();
+    }
+    else if( !_pparallelworkers || _pparallelworkers->GetNumThreads() != numthreads ) {
+        _pparallelworkers.reset(new ParallelCheckWorkers(numthreads));
+    }
+}
+
+bool DynamicsCollisionConstraint::_CheckSegmentInParallel(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& q0, int numSteps, int start, int options, ConstraintFilterReturnPtr filterreturn, int& nstateret)
+{
+    if( (options & CFO_FillCheckedConfiguration) && !!filterreturn ) {
+        return false;
+    }
+    if( (options & CFO_CheckUserConstraints) && (!!_usercheckfns[0] || !!_usercheckfns[1]) ) {
+        return false;
+    }
+    if( (options & CFO_CheckTimeBasedConstraints) && _vtempvelconfig.size() > 0 && (_torquelimitmode != DC_Unknown && _torquelimitmode != DC_IgnoreTorque) ) {
+        return false;
+    }
+    if( numSteps - start < std::max(64, 8*_pparallelworkers->GetNumThreads()) ) {
+        // too short to be worth waking up the workers
+        return false;
+    }
+    if( !params->HasDefaultNeighStateFn() ) {
+        // the workers interpolate the states directly, so they cannot follow projections of _neighstatefn
+        return false;
+    }
+
+    int ninvalidstep = numSteps;
+    if( !_pparallelworkers->Check(params, _listCheckBodies, q0, dQ, numSteps, start, options, _perturbation, ninvalidstep) ) {
+        return false;
+    }
+    nstateret = 0;
+    if( ninvalidstep >= numSteps ) {
+        return true;
+    }
+
+    // re-check on the calling thread so that the report and the current state refer to the real environment
+    const dReal ftime = ninvalidstep*(dReal(1.0)/numSteps);
+    _vtempconfig.resize(q0.size());
+    for(size_t idof = 0; idof < q0.size(); ++idof) {
+        _vtempconfig[idof] = q0[idof] + ftime*dQ[idof];
+    }
+    nstateret = _SetAndCheckState(params, _vtempconfig, _vtempvelconfig, _vtempaccelconfig, options, filterreturn);
+    if( nstateret == 0 ) {
+        RAVELOG_DEBUG_FORMAT("env=%d, step %d/%d is invalid in the worker environment only, so checking sequentially", _listCheckBodies.front()->GetEnv()->GetId()%ninvalidstep%numSteps);
+        return false;
+    }
+    if( !!filterreturn ) {
+        filterreturn->_returncode = nstateret;
+        filterreturn->_invalidvalues = _vtempconfig;
+        filterreturn->_invalidvelocities = _vtempvelconfig;
+        filterreturn->_fTimeWhenInvalid = ftime;
+    }
+    return true;
+}
+
 int DynamicsCollisionConstraint::_SetAndCheckState(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& vdofvalues, const std::vector<dReal>& vdofvelocities, const std::vector<dReal>& vdofaccels, int options, ConstraintFilterReturnPtr filterreturn)
 {
 //    if( IS_DEBUGLEVEL(Level_Verbose) ) {
@@ -2331,6 +2765,100 @@ int DynamicsCollisionConstraint::_SetAndCheckState(PlannerBase::PlannerParameter
     return 0;
 }
 
+void DynamicsCollisionConstraint::_StartDeferringStates(int options)
+{
+    _bDeferStateChecks = !!(options & CFO_CheckInBisectionOrder);
+    _vdeferredvalues.resize(0);
+    _vdeferredvelocities.resize(0);
+    _vdeferredtimes.resize(0);
+    _vdeferredconfigurationcounts.resize(0);
+    _vbatchconfigurations.resize(0);
+    // perturbed states are not recorded, so they would miss the environment checks
+    const int maskoptions = options & _filtermask;
+    _bBatchDeferredStates = _bDeferStateChecks && !!_pbatchbody && (maskoptions & CFO_CheckEnvCollisions) && !((maskoptions & CFO_CheckWithPerturbation) && _perturbation > 0);
+    if( _bBatchDeferredStates ) {
+        _tbatchbody = _pbatchbody->GetTransform();
+    }
+}
+
+int DynamicsCollisionConstraint::_SetAndCheckStateOrDefer(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& vdofvalues, const std::vector<dReal>& vdofvelocities, const std::vector<dReal>& vdofaccels, int options, ConstraintFilterReturnPtr filterreturn, dReal ftime)
+{
+    if( !_bDeferStateChecks ) {
+        return _SetAndCheckState(params, vdofvalues, vdofvelocities, vdofaccels, options, filterreturn);
+    }
+    // the state still has to be set since _neighstatefn and _getstatefn expect it
+    if( params->SetStateValues(vdofvalues, 0) != 0 ) {
+        return CFO_StateSettingError;
+    }
+    if( _vdeferredtimes.size() == 0 ) {
+        _vdeferredvalues.reserve(16*vdofvalues.size());
+        _vdeferredvelocities.reserve(16*vdofvelocities.size());
+    }
+    _vdeferredvalues.insert(_vdeferredvalues.end(), vdofvalues.begin(), vdofvalues.end());
+    _vdeferredvelocities.insert(_vdeferredvelocities.end(), vdofvelocities.begin(), vdofvelocities.end());
+    _vdeferredtimes.push_back(ftime);
+    _vdeferredconfigurationcounts.push_back(!!filterreturn ? filterreturn->_configurationtimes.size() : 0);
+    if( _bBatchDeferredStates ) {
+        // record the dof values the state really set on the body. The batch cannot move the base
+        if( TransformDistanceFast(_pbatchbody->GetTransform(), _tbatchbody) > g_fEpsilonLinear ) {
+            _bBatchDeferredStates = false;
+        }
+        else {
+            _pbatchbody->GetDOFValues(_vbatchdofvalues);
+            _vbatchconfigurations.insert(_vbatchconfigurations.end(), _vbatchdofvalues.begin(), _vbatchdofvalues.end());
+        }
+    }
+    return 0;
+}
+
+int DynamicsCollisionConstraint::_CheckDeferredStates(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& vdofaccels, int options, ConstraintFilterReturnPtr filterreturn)
+{
+    _bDeferStateChecks = false;
+    const int numstates = (int)_vdeferredtimes.size();
+    if( numstates == 0 ) {
+        return 0;
+    }
+    const size_t ndof = _vdeferredvalues.size()/numstates;
+    const size_t nvel = _vdeferredvelocities.size()/numstates;
+    OPENRAVE_ASSERT_OP(_vdeferredvalues.size(), ==, ndof*numstates);
+    OPENRAVE_ASSERT_OP(_vdeferredvelocities.size(), ==, nvel*numstates);
+    int stateoptions = options;
+    if( _bBatchDeferredStates ) {
+        // check all the states against the environment in one call. if none collide, the states only need the remaining checks.
+        // otherwise the states are fully checked one by one so that the first invalid state in bisection order is reported
+        _bBatchDeferredStates = false;
+        if( _pbatchbody->GetEnv()->GetCollisionChecker()->CheckCollisionBatch(_pbatchbody, std::vector<int>(), _vbatchconfigurations, _vbatchcollisionmasks, CBO_Environment|CBO_StopAtFirstCollision) == 0 ) {
+            stateoptions &= ~CFO_CheckEnvCollisions;
+        }
+    }
+    _GetBisectionOrder(0, numstates, _vbisectionorder, _vbisectionintervals);
+    _vdeferredstate.resize(ndof);
+    _vdeferredvelstate.resize(nvel);
+    for(int istate : _vbisectionorder) {
+        std::copy(_vdeferredvalues.begin() + istate*ndof, _vdeferredvalues.begin() + (istate+1)*ndof, _vdeferredstate.begin());
+        std::copy(_vdeferredvelocities.begin() + istate*nvel, _vdeferredvelocities.begin() + (istate+1)*nvel, _vdeferredvelstate.begin());
+        int nstateret = _SetAndCheckState(params, _vdeferredstate, _vdeferredvelstate, vdofaccels, stateoptions, filterreturn);
+        if( nstateret != 0 ) {
+            if( !!filterreturn ) {
+                filterreturn->_returncode = nstateret;
+                if( _vdeferredtimes[istate] >= 0 ) {
+                    filterreturn->_invalidvalues = _vdeferredstate;
+                    filterreturn->_invalidvelocities = _vdeferredvelstate;
+                    filterreturn->_fTimeWhenInvalid = _vdeferredtimes[istate];
+                }
+                // only keep the configurations that were recorded before the invalid state
+                const size_t numconfigurations = _vdeferredconfigurationcounts[istate];
+                if( numconfigurations < filterreturn->_configurationtimes.size() ) {
+                    filterreturn->_configurationtimes.resize(numconfigurations);
+                    filterreturn->_configurations.resize(numconfigurations*ndof);
+                }
+            }
+            return nstateret;
+        }
+    }
+    return 0;
+}
+
 int DynamicsCollisionConstraint::_CheckState(const std::vector<dReal>& vdofvelocities, const std::vector<dReal>& vdofaccels, int options, ConstraintFilterReturnPtr filterreturn)
 {
     options &= _filtermask;
@@ -2453,7 +2981,7 @@ int DynamicsCollisionConstraint::_CheckState(const std::vector<dReal>& vdofveloc
                 _specvel.ExtractJointValues(_dofaccelerations.begin(), vdofaccels.begin(), pbody, _vdofindices, 1);
 
                 // compute inverse dynamics and check
-                pbody->ComputeInverseDynamics(_doftorques, _dofaccelerations);
+                pbody->ComputeInverseDynamicsWithVelocities(_doftorques, _vfulldofvelocities, _dofaccelerations, _inversedynamicsworkspace);
                 FOREACH(it, _vtorquevalues) {
                     int index = it->first;
                     const std::pair<dReal, dReal>& torquelimits = it->second;
@@ -2549,6 +3077,7 @@ inline std::ostream& RaveSerializeValues(std::ostream& O, const std::vector<dRea
 
 int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::vector<dReal>& q1, const std::vector<dReal>& dq0, const std::vector<dReal>& dq1, dReal timeelapsed, IntervalType interval, int options, ConstraintFilterReturnPtr filterreturn)
 {
+    _bDeferStateChecks = false;
     int maskoptions = options&_filtermask;
     int maskinterval = interval & IT_IntervalMask;
     int maskinterpolation = interval & IT_InterpolationMask;
@@ -2806,7 +3335,10 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
         _vtempvelconfig = dq0;
     }
 
+    int nparallelret = 0;
     if( maskinterpolation == IT_Default && (timeelapsed > 0 && dq0.size() == _vtempconfig.size() && dq1.size() == _vtempconfig.size()) ) {
+        // when checking in bisection order, the states are only set and recorded while walking the segment, and are checked at the end by _CheckDeferredStates
+        _StartDeferringStates(options);
         // just in case, have to set the current values to _vtempconfig since neighstatefn expects the state to be set.
         if( params->SetStateValues(_vtempconfig, 0) != 0 ) {
             if( !!filterreturn ) {
@@ -2855,7 +3387,7 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
         while(istep < numSteps && prevtimestep < timeelapsed) {
             int nstateret = 0;
             if( istep >= start ) {
-                nstateret = _SetAndCheckState(params, _vtempconfig, _vtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn);
+                nstateret = _SetAndCheckStateOrDefer(params, _vtempconfig, _vtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn, timestep);
                 if( !!params->_getstatefn ) {
                     params->_getstatefn(_vtempconfig);     // query again in order to get normalizations/joint limits
                 }
@@ -3131,7 +3663,7 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
                             _vprevtempvelconfig[i] += vpostddq[i]; // probably not right with the way interpolation works out, but it is a reasonable approximation
                         }
 
-                        nstateret = _SetAndCheckState(params, _vprevtempconfig, _vprevtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn);
+                        nstateret = _SetAndCheckStateOrDefer(params, _vprevtempconfig, _vprevtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn, -1);
 //                        if( !!params->_getstatefn ) {
 //                            params->_getstatefn(_vprevtempconfig);     // query again in order to get normalizations/joint limits
 //                        }
@@ -3206,7 +3738,7 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
                         _vprevtempvelconfig[i] += vpostddq[i]; // probably not right with the way interpolation works out, but it is a reasonable approximation
                     }
 
-                    int nstateret = _SetAndCheckState(params, _vprevtempconfig, _vprevtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn);
+                    int nstateret = _SetAndCheckStateOrDefer(params, _vprevtempconfig, _vprevtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn, -1);
 //                        if( !!params->_getstatefn ) {
 //                            params->_getstatefn(_vprevtempconfig);     // query again in order to get normalizations/joint limits
 //                        }
@@ -3235,7 +3767,7 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
                     if( options & CFO_FillCheckedConfiguration ) {
                         int nstateret = 0;
                         if( istep >= start ) {
-                            nstateret = _SetAndCheckState(params, _vtempconfig, _vtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn);
+                            nstateret = _SetAndCheckStateOrDefer(params, _vtempconfig, _vtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn, -1);
                             if( !!params->_getstatefn ) {
                                 params->_getstatefn(_vtempconfig);     // query again in order to get normalizations/joint limits
                             }
@@ -3255,10 +3787,18 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
             }
         }
     }
+    else if( !!_pparallelworkers && _CheckSegmentInParallel(params, q0, numSteps, start, maskoptions, filterreturn, nparallelret) ) {
+        // the straight-line states were checked by the worker environments
+        if( nparallelret != 0 ) {
+            return nparallelret;
+        }
+    }
     else {
         // check for collision along the straight-line path
         // NOTE: this does not check the end config, and may or may
         // not check the start based on the value of 'start'
+        // when checking in bisection order, the states are only set and recorded while walking the segment, and are checked at the end by _CheckDeferredStates
+        _StartDeferringStates(options);
         dReal fisteps = dReal(1.0f)/numSteps;
         for(std::vector<dReal>::iterator it = dQ.begin(); it != dQ.end(); ++it) {
             *it *= fisteps;
@@ -3337,7 +3877,7 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
                         if( s == (maxnumsteps - 1) ) {
                             break;
                         }
-                        int ret = _SetAndCheckState(params, _vstepconfig, _vtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn);
+                        int ret = _SetAndCheckStateOrDefer(params, _vstepconfig, _vtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn, (s * imaxnumsteps)*fisteps);
                         if( !!params->_getstatefn ) {
                             params->_getstatefn(_vstepconfig); // query again in order to get normalizations/joint limits
                         }
@@ -3362,7 +3902,7 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
 
         _vprevtempconfig.resize(dQ.size());
         for (int f = start; f < numSteps; f++) {
-            int nstateret = _SetAndCheckState(params, _vtempconfig, _vtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn);
+            int nstateret = _SetAndCheckStateOrDefer(params, _vtempconfig, _vtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn, f*fisteps);
             if( !!params->_getstatefn ) {
                 params->_getstatefn(_vtempconfig);     // query again in order to get normalizations/joint limits
             }
@@ -3456,7 +3996,7 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
                         if( s == (maxnumsteps - 1) ) {
                             break;
                         }
-                        int ret = _SetAndCheckState(params, _vstepconfig, _vtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn);
+                        int ret = _SetAndCheckStateOrDefer(params, _vstepconfig, _vtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn, (f + (s * imaxnumsteps))*fisteps);
                         if( !!params->_getstatefn ) {
                             params->_getstatefn(_vstepconfig); // query again in order to get normalizations/joint limits
                         }
@@ -3528,7 +4068,7 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
                         }
                     }
 
-                    int nstateret = _SetAndCheckState(params, _vprevtempconfig, _vprevtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn);
+                    int nstateret = _SetAndCheckStateOrDefer(params, _vprevtempconfig, _vprevtempvelconfig, _vtempaccelconfig, maskoptions, filterreturn, -1);
 //                        if( !!params->_getstatefn ) {
 //                            params->_getstatefn(_vprevtempconfig);     // query again in order to get normalizations/joint limits
 //                        }
@@ -3548,6 +4088,13 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
         }
     }
 
+    if( _bDeferStateChecks ) {
+        int nstateret = _CheckDeferredStates(params, _vtempaccelconfig, maskoptions, filterreturn);
+        if( nstateret != 0 ) {
+            return nstateret;
+        }
+    }
+
     if( !!filterreturn ) {
         filterreturn->_bHasRampDeviatedFromInterpolation = bHasRampDeviatedFromInterpolation;
         if( options & CFO_FillCheckedConfiguration ) {
@@ -4658,6 +5205,25 @@ dReal SimpleDistanceMetric::Eval(const std::vector<dReal>& c0, const std::vector
     return RaveSqrt(dist);
 }
 
+bool SimpleDistanceMetric::GetEuclideanWeights2(std::vector<dReal>& vweights2) const
+{
+    if( _robot->GetAffineDOF() != DOF_NoTransform ) {
+        return false;
+    }
+    const std::vector<int>& vActiveDOFIndices = _robot->GetActiveDOFIndices();
+    if( vActiveDOFIndices.size() != weights2.size() ) {
+        return false;
+    }
+    for(int dofindex : vActiveDOFIndices) {
+        KinBody::JointPtr pjoint = _robot->GetJointFromDOFIndex(dofindex);
+        if( pjoint->IsCircular(dofindex-pjoint->GetDOFIndex()) ) {
+            return false;
+        }
+    }
+    vweights2 = weights2;
+    return true;
+}
+
 SimpleNeighborhoodSampler::SimpleNeighborhoodSampler(SpaceSamplerBasePtr psampler, const PlannerBase::PlannerParameters::DistMetricFn& distmetricfn, const PlannerBase::PlannerParameters::DiffStateFn& diffstatefn) : _psampler(psampler), _distmetricfn(distmetricfn), _diffstatefn(diffstatefn)
 {
 }
@@ -17,8 +17,11 @@
 #if !OPENRAVE_STATIC_PLUGINS
 
 #include <cstdarg>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <functional>
+#include <iterator>
 #include <mutex>
 
 #include <openrave/openraveexception.h>
@@ -30,14 +33,18 @@ namespace fs = boost::filesystem;
 #endif
 #include <boost/version.hpp>
 
+#include <sys/types.h>
+#include <sys/stat.h>
+
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#include <process.h>
+#define getpid _getpid
 #else
 #include <dlfcn.h>
-#include <sys/stat.h>
-#include <sys/types.h>
 #include <dirent.h>
+#include <unistd.h>
 
 #endif
 
@@ -63,6 +70,132 @@ static const std::string PLUGIN_EXT =
     ".so";
 #endif
 
+static const char s_pluginIndexHeader[] = "openrave_plugin_index 2";
+
+namespace {
+
+/// \brief plugin whose shared object is only loaded the first time one of its interfaces is created
+///
+/// The interfaces and the name come from the plugin index.
+class LazyPlugin final : public RavePlugin
+{
+public:
+    LazyPlugin(const std::string& path, const std::string& pluginname, const InterfaceMap& interfaces, const DynamicRaveDatabase::PluginReaders& readers, const std::function<PluginPtr(const std::string&)>& openfn)
+        : _pluginname(pluginname), _interfaces(interfaces), _readers(readers), _openfn(openfn)
+    {
+        SetPluginPath(path);
+    }
+
+    const InterfaceMap& GetInterfaces() const override
+    {
+        return _interfaces;
+    }
+
+    const std::string& GetPluginName() const override
+    {
+        return _pluginname;
+    }
+
+    void OnRaveInitialized() override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _bRaveInitialized = true;
+        if( !!_pplugin ) {
+            _pplugin->OnRaveInitialized();
+        }
+    }
+
+    void OnRavePreDestroy() override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _bRaveInitialized = false;
+        if( !!_pplugin ) {
+            _pplugin->OnRavePreDestroy();
+        }
+    }
+
+    void Destroy() override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if( !!_pplugin ) {
+            _pplugin->Destroy();
+            _pplugin.reset();
+        }
+        _bLoadFailed = true; // do not load again
+    }
+
+    /// \brief returns true if the plugin registers the reader when it is loaded
+    bool HasReader(InterfaceType type, const std::string& id, bool bJSON) const
+    {
+        const std::set< std::pair<InterfaceType, std::string> >& readers = bJSON ? _readers.jsonreaders : _readers.xmlreaders;
+        return readers.find(std::make_pair(type, id)) != readers.end();
+    }
+
+    bool IsLoaded() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return !!_pplugin;
+    }
+
+    /// \brief loads the shared object if not done yet, returns true if the plugin is loaded
+    bool Load()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if( !_pplugin && !_bLoadFailed ) {
+            RAVELOG_DEBUG_FORMAT("Loading plugin %s from %s on first use.", _pluginname % GetPluginPath());
+            _pplugin = _openfn(GetPluginPath());
+            if( !_pplugin ) {
+                _bLoadFailed = true;
+            }
+            else {
+                _pplugin->SetPluginPath(GetPluginPath());
+                if( _bRaveInitialized ) {
+                    _pplugin->OnRaveInitialized();
+                }
+            }
+        }
+        return !!_pplugin;
+    }
+
+protected:
+    InterfaceBasePtr CreateInterface(InterfaceType type, const std::string& interfacename, std::istream& sinput, EnvironmentBasePtr penv) override
+    {
+        if( !Load() ) {
+            return InterfaceBasePtr();
+        }
+        // the loaded plugin parses the name again, so put back the arguments following the interface name
+        std::string name = interfacename;
+        name.append(std::istreambuf_iterator<char>(sinput), std::istreambuf_iterator<char>());
+        return _pplugin->OpenRAVECreateInterface(type, name, RaveGetInterfaceHash(type), OPENRAVE_ENVIRONMENT_HASH, penv);
+    }
+
+private:
+    std::string _pluginname;
+    InterfaceMap _interfaces;
+    DynamicRaveDatabase::PluginReaders _readers;
+    std::function<PluginPtr(const std::string&)> _openfn;
+    mutable std::mutex _mutex;
+    PluginPtr _pplugin; ///< the plugin of the shared object once loaded
+    bool _bRaveInitialized = false;
+    bool _bLoadFailed = false;
+};
+
+/// \brief gets the modification time and the size of a file, returns false if it cannot be read
+bool GetFileStamp(const std::string& strpath, int64_t& modificationtime, uint64_t& filesize)
+{
+    struct stat sb;
+    if( ::stat(strpath.c_str(), &sb) != 0 ) {
+        return false;
+    }
+    modificationtime = (int64_t)sb.st_mtime;
+    filesize = (uint64_t)sb.st_size;
+    return true;
+}
+
+} // end namespace
+
+thread_local DynamicRaveDatabase::PluginReaders* DynamicRaveDatabase::_pRecordingReaders = nullptr;
+
 DynamicRaveDatabase::DynamicLibrary::DynamicLibrary(const std::string& path)
 {
 #ifdef _WIN32
@@ -198,10 +331,35 @@ void DynamicRaveDatabase::Init()
         }
         _vPluginDirs.emplace_back(std::move(entry));
     }
+
+    // unless disabled, plugins already in the index are only loaded when first used
+    const char* pOPENRAVE_PLUGINS_LAZY = getenv("OPENRAVE_PLUGINS_LAZY");
+    if( !pOPENRAVE_PLUGINS_LAZY || strcmp(pOPENRAVE_PLUGINS_LAZY, "0") != 0 ) {
+        _pluginindexfilename = RaveGetHomeDirectory() + s_filesep + "plugins_" + OPENRAVE_VERSION_STRING + ".index";
+        _ReadPluginIndex();
+    }
+
     for (const std::string& entry : _vPluginDirs) {
         RAVELOG_DEBUG_FORMAT("Looking for plugins in %s", entry);
         _LoadPluginsFromPath(entry);
     }
+
+    if( !_pluginindexfilename.empty() ) {
+        // forget the shared objects that were removed
+        for(std::map<std::string, PluginIndexEntry>::iterator it = _mapPluginIndex.begin(); it != _mapPluginIndex.end(); ) {
+            if( !it->second.bFound ) {
+                it = _mapPluginIndex.erase(it);
+                _bPluginIndexModified = true;
+            }
+            else {
+                ++it;
+            }
+        }
+        if( _bPluginIndexModified ) {
+            _WritePluginIndex();
+            _bPluginIndexModified = false;
+        }
+    }
 }
 
 void DynamicRaveDatabase::ReloadPlugins()
@@ -212,6 +370,10 @@ void DynamicRaveDatabase::ReloadPlugins()
         vPlugins = _vPlugins; // Copy
     }
     for (const PluginPtr& plugin : vPlugins) {
+        boost::shared_ptr<LazyPlugin> plazyplugin = boost::dynamic_pointer_cast<LazyPlugin>(plugin);
+        if( !!plazyplugin && !plazyplugin->IsLoaded() ) {
+            continue; // will be loaded from the current shared object on first use
+        }
         _LoadPlugin(plugin->GetPluginPath());
     }
 }
@@ -237,6 +399,29 @@ bool DynamicRaveDatabase::LoadPlugin(const std::string& libraryname)
     return _LoadPlugin(canonicalizedLibraryname);
 }
 
+bool DynamicRaveDatabase::LoadPluginForReader(InterfaceType type, const std::string& id, bool bJSON)
+{
+    std::vector<PluginPtr> vPlugins;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        vPlugins = _vPlugins; // Copy
+    }
+    for (const PluginPtr& plugin : vPlugins) {
+        boost::shared_ptr<LazyPlugin> plazyplugin = boost::dynamic_pointer_cast<LazyPlugin>(plugin);
+        if( !!plazyplugin && plazyplugin->HasReader(type, id, bJSON) && !plazyplugin->IsLoaded() ) {
+            return plazyplugin->Load();
+        }
+    }
+    return false;
+}
+
+void DynamicRaveDatabase::NotifyReaderRegistered(InterfaceType type, const std::string& id, bool bJSON)
+{
+    if( !!_pRecordingReaders ) {
+        (bJSON ? _pRecordingReaders->jsonreaders : _pRecordingReaders->xmlreaders).insert(std::make_pair(type, id));
+    }
+}
+
 void DynamicRaveDatabase::_LoadPluginsFromPath(const std::string& strpath, bool recurse) try
 {
 #ifdef HAVE_BOOST_FILESYSTEM
@@ -258,7 +443,7 @@ void DynamicRaveDatabase::_LoadPluginsFromPath(const std::string& strpath, bool
     } else if (fs::is_regular_file(path)) {
         // Check that the file has a platform-appropriate extension
         if (0 == strpath.compare(strpath.size() - PLUGIN_EXT.size(), PLUGIN_EXT.size(), PLUGIN_EXT)) {
-            _LoadPlugin(path.string());
+            _AddPlugin(path.string());
         }
     } else {
         RAVELOG_WARN_FORMAT("Path is not a valid directory or file: %s", strpath);
@@ -296,7 +481,7 @@ void DynamicRaveDatabase::_LoadPluginsFromPath(const std::string& strpath, bool
         }
         ::closedir(dirptr);
     } else if (S_ISREG(sb.st_mode)) {
-        _LoadPlugin(strpath);
+        _AddPlugin(strpath);
     } else {
         // Not a directory or file, ignore it
     }
@@ -307,34 +492,196 @@ void DynamicRaveDatabase::_LoadPluginsFromPath(const std::string& strpath, bool
     RAVELOG_VERBOSE_FORMAT("%s", e.what());
 }
 
-bool DynamicRaveDatabase::_LoadPlugin(const std::string& strpath)
+void DynamicRaveDatabase::_AddPlugin(const std::string& strpath)
+{
+    if( _pluginindexfilename.empty() ) {
+        _LoadPlugin(strpath);
+        return;
+    }
+
+    int64_t modificationtime = 0;
+    uint64_t filesize = 0;
+    if( !GetFileStamp(strpath, modificationtime, filesize) ) {
+        _LoadPlugin(strpath);
+        return;
+    }
+    std::map<std::string, PluginIndexEntry>::iterator itentry = _mapPluginIndex.find(strpath);
+    if( itentry != _mapPluginIndex.end() && itentry->second.modificationtime == modificationtime && itentry->second.filesize == filesize ) {
+        PluginIndexEntry& entry = itentry->second;
+        entry.bFound = true;
+        if( entry.bIsPlugin ) {
+            PluginPtr plugin = boost::make_shared<LazyPlugin>(strpath, entry.pluginname, entry.interfaces, entry.readers, std::bind(&DynamicRaveDatabase::_OpenPlugin, this, std::placeholders::_1, static_cast<PluginReaders*>(nullptr)));
+            std::lock_guard<std::mutex> lock(_mutex);
+            _vPlugins.push_back(plugin);
+        }
+        return;
+    }
+
+    // the shared object is new or changed, so load it now and index what it offers
+    PluginIndexEntry& entry = _mapPluginIndex[strpath];
+    entry = PluginIndexEntry();
+    entry.modificationtime = modificationtime;
+    entry.filesize = filesize;
+    entry.bFound = true;
+    _bPluginIndexModified = true;
+    if( _LoadPlugin(strpath, &entry.readers) ) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        entry.bIsPlugin = true;
+        entry.pluginname = _vPlugins.back()->GetPluginName();
+        entry.interfaces = _vPlugins.back()->GetInterfaces();
+    }
+}
+
+bool DynamicRaveDatabase::_LoadPlugin(const std::string& strpath, PluginReaders* preaders)
+{
+    PluginPtr plugin = _OpenPlugin(strpath, preaders);
+    if (!plugin) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _vPlugins.emplace_back(plugin);
+    _vPlugins.back()->SetPluginPath(strpath);
+    RAVELOG_DEBUG_FORMAT("Found %s at %s.", _vPlugins.back()->GetPluginName() % strpath);
+    return true;
+}
+
+PluginPtr DynamicRaveDatabase::_OpenPlugin(const std::string& strpath, PluginReaders* preaders)
 {
     DynamicLibrary dylib(strpath);
     if (!dylib) {
         RAVELOG_DEBUG_FORMAT("Failed to load shared object %s", strpath);
-        return false;
+        return PluginPtr();
     }
     std::string errstr;
     void* psym = dylib.LoadSymbol("CreatePlugin", errstr);
     if (!psym) {
         RAVELOG_DEBUG_FORMAT("%s, might not be an OpenRAVE plugin.", errstr);
-        return false;
+        return PluginPtr();
     }
     RavePlugin* plugin = nullptr;
+    // plugins register their readers in their constructors
+    PluginReaders* poldreaders = _pRecordingReaders;
+    _pRecordingReaders = preaders;
     try {
         plugin = reinterpret_cast<PluginExportFn_Create>(psym)();
     } catch (const std::exception& e) {
         RAVELOG_WARN_FORMAT("Failed to construct a RavePlugin from %s: %s", strpath % e.what());
     }
+    _pRecordingReaders = poldreaders;
     if (!plugin) {
-        return false;
+        return PluginPtr();
     }
     std::lock_guard<std::mutex> lock(_mutex);
     _mapLibraryHandles.emplace(strpath, std::move(dylib)); // Keep the library handle around in case we need it
-    _vPlugins.emplace_back(PluginPtr(plugin)); // Ownership passed to the shared_ptr
-    _vPlugins.back()->SetPluginPath(strpath);
-    RAVELOG_DEBUG_FORMAT("Found %s at %s.", _vPlugins.back()->GetPluginName() % strpath);
-    return true;
+    return PluginPtr(plugin); // Ownership passed to the shared_ptr
+}
+
+void DynamicRaveDatabase::_ReadPluginIndex()
+{
+    _mapPluginIndex.clear();
+    std::ifstream f(_pluginindexfilename.c_str());
+    if( !f ) {
+        return;
+    }
+    // format: header line, then for every shared object a line "path\tmtime\tsize\tisplugin\tpluginname\tnuminterfaces\tnumreaders" followed by numinterfaces lines "type\tname" and numreaders lines "xml|json\ttype\tid"
+    std::string line;
+    if( !std::getline(f, line) || line != s_pluginIndexHeader ) {
+        RAVELOG_DEBUG_FORMAT("plugin index %s has an unknown format, rebuilding it", _pluginindexfilename);
+        return;
+    }
+    std::vector<std::string> vfields;
+    while( std::getline(f, line) ) {
+        vfields.clear();
+        boost::split(vfields, line, boost::is_any_of("\t"));
+        if( vfields.size() != 7 ) {
+            break;
+        }
+        PluginIndexEntry entry;
+        int numinterfaces = 0, numreaders = 0;
+        try {
+            entry.modificationtime = boost::lexical_cast<int64_t>(vfields[1]);
+            entry.filesize = boost::lexical_cast<uint64_t>(vfields[2]);
+            entry.bIsPlugin = vfields[3] == "1";
+            entry.pluginname = vfields[4];
+            numinterfaces = boost::lexical_cast<int>(vfields[5]);
+            numreaders = boost::lexical_cast<int>(vfields[6]);
+        }
+        catch(const boost::bad_lexical_cast&) {
+            break;
+        }
+        bool bValid = true;
+        for(int iinterface = 0; iinterface < numinterfaces; ++iinterface) {
+            size_t pos;
+            if( !std::getline(f, line) || (pos = line.find('\t')) == std::string::npos ) {
+                bValid = false;
+                break;
+            }
+            const int type = atoi(line.substr(0, pos).c_str());
+            entry.interfaces[(InterfaceType)type].push_back(line.substr(pos+1));
+        }
+        std::vector<std::string> vreaderfields;
+        for(int ireader = 0; ireader < numreaders && bValid; ++ireader) {
+            vreaderfields.clear();
+            if( !std::getline(f, line) ) {
+                bValid = false;
+                break;
+            }
+            boost::split(vreaderfields, line, boost::is_any_of("\t"));
+            if( vreaderfields.size() != 3 || (vreaderfields[0] != "xml" && vreaderfields[0] != "json") ) {
+                bValid = false;
+                break;
+            }
+            const InterfaceType type = (InterfaceType)atoi(vreaderfields[1].c_str());
+            (vreaderfields[0] == "json" ? entry.readers.jsonreaders : entry.readers.xmlreaders).insert(std::make_pair(type, vreaderfields[2]));
+        }
+        if( !bValid ) {
+            break;
+        }
+        _mapPluginIndex[vfields[0]] = entry;
+    }
+}
+
+void DynamicRaveDatabase::_WritePluginIndex() const
+{
+    // several processes can initialize at the same time, so write to a temporary file and rename it
+    const std::string tempfilename = str(boost::format("%s.%d.tmp")%_pluginindexfilename%getpid());
+    {
+        std::ofstream f(tempfilename.c_str());
+        if( !f ) {
+            RAVELOG_DEBUG_FORMAT("failed to write plugin index %s", tempfilename);
+            return;
+        }
+        f << s_pluginIndexHeader << "\n";
+        for(const std::pair<const std::string, PluginIndexEntry>& itentry : _mapPluginIndex) {
+            const PluginIndexEntry& entry = itentry.second;
+            size_t numinterfaces = 0;
+            for(const std::pair<const InterfaceType, std::vector<std::string> >& itinterfaces : entry.interfaces) {
+                numinterfaces += itinterfaces.second.size();
+            }
+            f << itentry.first << "\t" << entry.modificationtime << "\t" << entry.filesize << "\t" << (entry.bIsPlugin ? 1 : 0) << "\t" << entry.pluginname << "\t" << numinterfaces << "\t" << (entry.readers.xmlreaders.size() + entry.readers.jsonreaders.size()) << "\n";
+            for(const std::pair<const InterfaceType, std::vector<std::string> >& itinterfaces : entry.interfaces) {
+                for(const std::string& name : itinterfaces.second) {
+                    f << (int)itinterfaces.first << "\t" << name << "\n";
+                }
+            }
+            for(const std::pair<InterfaceType, std::string>& reader : entry.readers.xmlreaders) {
+                f << "xml\t" << (int)reader.first << "\t" << reader.second << "\n";
+            }
+            for(const std::pair<InterfaceType, std::string>& reader : entry.readers.jsonreaders) {
+                f << "json\t" << (int)reader.first << "\t" << reader.second << "\n";
+            }
+        }
+        if( !f ) {
+            RAVELOG_DEBUG_FORMAT("failed to write plugin index %s", tempfilename);
+            f.close();
+            std::remove(tempfilename.c_str());
+            return;
+        }
+    }
+    if( std::rename(tempfilename.c_str(), _pluginindexfilename.c_str()) != 0 ) {
+        RAVELOG_DEBUG_FORMAT("failed to write plugin index %s", _pluginindexfilename);
+        std::remove(tempfilename.c_str());
+    }
 }
 
 } // namespace OpenRAVE
@@ -26,6 +26,8 @@
 
 #include <mutex>
 #include <boost/shared_ptr.hpp>
+#include <map>
+#include <set>
 #include <unordered_map>
 
 namespace OpenRAVE {
@@ -41,6 +43,17 @@ public:
 
     void ReloadPlugins() override;
     bool LoadPlugin(const std::string& libraryname) override;
+    bool LoadPluginForReader(InterfaceType type, const std::string& id, bool bJSON) override;
+
+    /// \brief called whenever an xml or json reader is registered, remembers it for the plugin being constructed on this thread
+    static void NotifyReaderRegistered(InterfaceType type, const std::string& id, bool bJSON);
+
+    /// \brief the xml and json readers a plugin registers when it is constructed
+    struct PluginReaders
+    {
+        std::set< std::pair<InterfaceType, std::string> > xmlreaders; ///< (type, xml tag)
+        std::set< std::pair<InterfaceType, std::string> > jsonreaders; ///< (type, json id)
+    };
 
 private:
     struct DynamicLibrary final
@@ -58,11 +71,42 @@ private:
         void* _handle;
     };
 
+    /// \brief what a shared object offers, cached in the plugin index so that the shared object does not need to be loaded to know it
+    struct PluginIndexEntry
+    {
+        int64_t modificationtime = 0; ///< modification time of the shared object when it was indexed
+        uint64_t filesize = 0; ///< size of the shared object when it was indexed
+        bool bIsPlugin = false; ///< false if the shared object is not an OpenRAVE plugin
+        std::string pluginname;
+        RavePlugin::InterfaceMap interfaces;
+        PluginReaders readers;
+        bool bFound = false; ///< true if the shared object was found when scanning the plugin directories, not saved
+    };
+
     void _LoadPluginsFromPath(const std::string&, bool recurse = false);
-    bool _LoadPlugin(const std::string&); ///< Attempts to load a RavePlugin from a shared object, fails liberally if the right symbols cannot be found. Locks _mutex.
+
+    /// \brief adds the plugin of the shared object, deferring the loading if the plugin index is up to date for it
+    void _AddPlugin(const std::string& strpath);
+
+    /// \brief Attempts to load a RavePlugin from a shared object, fails liberally if the right symbols cannot be found. Locks _mutex.
+    ///
+    /// \param preaders if not null, filled with the readers that the plugin registers when constructed
+    bool _LoadPlugin(const std::string& strpath, PluginReaders* preaders = nullptr);
+
+    /// \brief loads a RavePlugin from a shared object without adding it to _vPlugins. Locks _mutex.
+    PluginPtr _OpenPlugin(const std::string& strpath, PluginReaders* preaders = nullptr);
+
+    void _ReadPluginIndex();
+    void _WritePluginIndex() const;
 
     std::vector<std::string> _vPluginDirs; ///< List of plugin directories
     std::unordered_map<std::string, DynamicLibrary> _mapLibraryHandles; ///< A map of paths to *open* shared object handles.
+
+    std::string _pluginindexfilename; ///< file storing _mapPluginIndex between processes, empty if plugins are loaded at initialization
+    std::map<std::string, PluginIndexEntry> _mapPluginIndex; ///< indexed shared objects by path
+    bool _bPluginIndexModified = false; ///< true if _mapPluginIndex differs from the file
+
+    static thread_local PluginReaders* _pRecordingReaders; ///< readers of the plugin being constructed on this thread, null if not recording
 };
 
 } // end namespace OpenRAVE
@@ -40,6 +40,15 @@ public:
     virtual void ReloadPlugins() = 0;
     virtual bool LoadPlugin(const std::string& libraryname) = 0;
 
+    /// \brief loads the deferred plugin that registers the xml or json reader with the given id when it is constructed
+    ///
+    /// Called when a reader is not found, since plugins whose loading was deferred until first use did not register their readers yet.
+    /// \param bJSON if true, id is a json reader id, otherwise an xml tag
+    /// \return true if a plugin was loaded
+    virtual bool LoadPluginForReader(InterfaceType type, const std::string& id, bool bJSON) {
+        return false;
+    }
+
     virtual UserDataPtr AddVirtualPlugin(InterfaceType type, std::string name, std::function<InterfaceBasePtr(EnvironmentBasePtr, std::istream&)> createfn);
 
     // Old interface
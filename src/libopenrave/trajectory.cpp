@@ -79,6 +79,15 @@ void TrajectoryBase::DeserializeFromRawData(const uint8_t* pdata, size_t nDataSi
     xmlreaders::TrajectoryReader readerdata(GetEnv(),shared_trajectory());
     xmlreaders::ParseXMLData(readerdata, (const char*)pdata, nDataSize);
 }
+
+void TrajectoryBase::DeserializeFromFile(const std::string& filename)
+{
+    std::ifstream f(filename.c_str(), std::ios::in|std::ios::binary);
+    if( !f ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("failed to open trajectory file %s"), filename, ORE_InvalidArguments);
+    }
+    deserialize(f);
+}
     
 void TrajectoryBase::Clone(InterfaceBaseConstPtr preference, int cloningoptions)
 {
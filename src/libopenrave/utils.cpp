@@ -19,6 +19,12 @@
 
 #include "md5.h"
 
+#include <condition_variable>
+#include <exception>
+#include <list>
+#include <mutex>
+#include <thread>
+
 namespace OpenRAVE {
 namespace utils {
 
@@ -121,5 +127,157 @@ std::string GetFilenameUntilSeparator(std::istream& sinput, char separator)
     return filename.substr( startpos, endpos-startpos+1 );
 }
 
+namespace {
+
+/// \brief one call of ParallelForChunks, threads claim chunks of it until all items are assigned
+struct ParallelJob
+{
+    const boost::function<void(size_t, size_t)>* pfn;
+    size_t numitems;
+    size_t chunksize;
+    size_t nextitem; ///< first item that is not assigned to a thread
+    int numrunning; ///< number of pool threads running a chunk of this job
+    std::exception_ptr exception; ///< first exception thrown by a chunk
+};
+
+/// \brief threads shared by all ParallelForChunks calls of the process, started on the first job
+class ParallelPool
+{
+public:
+    ParallelPool() : _bShutdown(false) {
+    }
+
+    ~ParallelPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _bShutdown = true;
+        }
+        _condJob.notify_all();
+        FOREACH(itthread, _vthreads) {
+            itthread->join();
+        }
+    }
+
+    void Run(ParallelJob& job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if( _vthreads.size() == 0 ) {
+                // the calling threads also run chunks
+                const int numthreads = (int)std::thread::hardware_concurrency() - 1;
+                for(int ithread = 0; ithread < numthreads; ++ithread) {
+                    _vthreads.emplace_back(&ParallelPool::_WorkerThread, this);
+                }
+            }
+            _listjobs.push_back(&job);
+        }
+        _condJob.notify_all();
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        while( job.nextitem < job.numitems ) {
+            size_t nbegin, nend;
+            _ClaimChunk(job, nbegin, nend);
+            lock.unlock();
+            try {
+                (*job.pfn)(nbegin, nend);
+                lock.lock();
+            }
+            catch(...) {
+                lock.lock();
+                _AbortJob(job);
+            }
+        }
+        _condDone.wait(lock, [&job]() {
+            return job.numrunning == 0;
+        });
+        if( !!job.exception ) {
+            std::rethrow_exception(job.exception);
+        }
+    }
+
+private:
+    void _WorkerThread()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while( true ) {
+            _condJob.wait(lock, [this]() {
+                return _bShutdown || !_listjobs.empty();
+            });
+            if( _bShutdown ) {
+                return;
+            }
+            ParallelJob& job = *_listjobs.front();
+            size_t nbegin, nend;
+            _ClaimChunk(job, nbegin, nend);
+            ++job.numrunning;
+            lock.unlock();
+            try {
+                (*job.pfn)(nbegin, nend);
+                lock.lock();
+            }
+            catch(...) {
+                lock.lock();
+                _AbortJob(job);
+            }
+            // the caller waits for numrunning to be 0 before job goes out of scope
+            if( --job.numrunning == 0 ) {
+                _condDone.notify_all();
+            }
+        }
+    }
+
+    /// \brief assigns the next chunk of job, removes job from the list once all of its items are assigned. _mutex has to be locked
+    void _ClaimChunk(ParallelJob& job, size_t& nbegin, size_t& nend)
+    {
+        nbegin = job.nextitem;
+        nend = std::min(nbegin + job.chunksize, job.numitems);
+        job.nextitem = nend;
+        if( nend >= job.numitems ) {
+            _listjobs.remove(&job);
+        }
+    }
+
+    /// \brief stores the current exception in job and drops its remaining chunks. _mutex has to be locked
+    void _AbortJob(ParallelJob& job)
+    {
+        if( !job.exception ) {
+            job.exception = std::current_exception();
+        }
+        if( job.nextitem < job.numitems ) {
+            job.nextitem = job.numitems;
+            _listjobs.remove(&job);
+        }
+    }
+
+    std::vector<std::thread> _vthreads;
+    std::mutex _mutex;
+    std::condition_variable _condJob, _condDone;
+    std::list<ParallelJob*> _listjobs; ///< jobs that still have items not assigned to a thread, oldest first
+    bool _bShutdown;
+};
+
+} // end namespace
+
+void ParallelForChunks(size_t numitems, size_t chunksize, const boost::function<void(size_t, size_t)>& fn)
+{
+    if( chunksize == 0 ) {
+        chunksize = 1;
+    }
+    if( numitems <= chunksize ) {
+        if( numitems > 0 ) {
+            fn(0, numitems);
+        }
+        return;
+    }
+    static ParallelPool s_pool;
+    ParallelJob job;
+    job.pfn = &fn;
+    job.numitems = numitems;
+    job.chunksize = chunksize;
+    job.nextitem = 0;
+    job.numrunning = 0;
+    s_pool.Run(job);
+}
+
 } // utils
 } // OpenRAVE
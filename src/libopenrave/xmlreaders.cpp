@@ -439,15 +439,16 @@ bool GeometryInfoReader::endElement(const std::string& xmlname)
                     RAVELOG_WARN(str(boost::format("number of points specified in the vertices field needs to be a multiple of 3 (it is %d), ignoring...\n")%values.size()));
                 }
                 else {
-                    _pgeom->_meshcollision.vertices.resize(values.size()/3);
-                    _pgeom->_meshcollision.indices.resize(values.size()/3);
+                    TriMesh& meshcollision = _pgeom->_meshcollision.GetWritable();
+                    meshcollision.vertices.resize(values.size()/3);
+                    meshcollision.indices.resize(values.size()/3);
                     vector<dReal>::iterator itvalue = values.begin();
                     size_t i = 0;
-                    FOREACH(itv,_pgeom->_meshcollision.vertices) {
+                    FOREACH(itv,meshcollision.vertices) {
                         itv->x = *itvalue++;
                         itv->y = *itvalue++;
                         itv->z = *itvalue++;
-                        _pgeom->_meshcollision.indices[i] = i;
+                        meshcollision.indices[i] = i;
                         ++i;
                     }
                 }
@@ -12,6 +12,8 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 from common_test_openrave import *
+import struct
+import tempfile
 
 class TestBinaryTrajectory(EnvironmentSetup):
 	def test_binary_traj(self):
@@ -107,3 +109,91 @@ class TestBinaryTrajectory(EnvironmentSetup):
 		trajBinary1 = trajectory1.serialize()
 		trajectory1Copy.deserialize(trajBinary1)
 		assert(trajectory1Copy.GetDescription()=='test')
+
+	def test_binary_traj_file(self):
+		env = Environment()
+		numpoints = 200
+		data = numpy.random.rand(numpoints, 4)
+		data[:,3] = 0.01 # deltatime
+		data[0,3] = 0
+		trajFile = """
+		<trajectory>
+		<configuration>
+		<group name="joint_values GP7 0 1 2" offset="0" dof="3" interpolation="linear"/>
+		<group name="deltatime" offset="3" dof="1" interpolation=""/>
+		</configuration>
+		<data count="%d">
+		%s
+		</data>
+		</trajectory>
+		"""%(numpoints, ' '.join(['%.17g'%value for value in data.flatten()]))
+		trajectory = RaveCreateTrajectory(env, '')
+		trajectory.deserialize(trajFile)
+
+		fd, filename = tempfile.mkstemp(suffix='.traj')
+		os.close(fd)
+		try:
+			trajectory.SaveToFile(filename)
+			with open(filename, 'rb') as f:
+				magic, version = struct.unpack('=HH', f.read(4))
+			# version 0x0004 has the aligned waypoints that can be mapped
+			assert(magic == 0x62ff and version == 0x0004)
+
+			trajectoryCopy = RaveCreateTrajectory(env, '')
+			trajectoryCopy.LoadFromFile(filename)
+			trajectoryMapped = RaveCreateTrajectory(env, '')
+			trajectoryMapped.LoadFromFile(filename, True)
+			for trajectoryLoaded in [trajectoryCopy, trajectoryMapped]:
+				assert(trajectory.GetConfigurationSpecification() == trajectoryLoaded.GetConfigurationSpecification())
+				assert(trajectoryLoaded.GetNumWaypoints() == numpoints)
+				assert(list(trajectory.GetWaypoints(0, numpoints)) == list(trajectoryLoaded.GetWaypoints(0, numpoints)))
+				assert(abs(trajectory.GetDuration() - trajectoryLoaded.GetDuration()) <= g_epsilon)
+				for time in numpy.linspace(0, trajectory.GetDuration(), 37):
+					assert(numpy.all(abs(trajectory.Sample(time) - trajectoryLoaded.Sample(time)) <= g_epsilon))
+
+			# modifying the mapped trajectory copies the waypoints and leaves the file untouched
+			trajectoryMapped.Insert(numpoints, data[-1])
+			assert(trajectoryMapped.GetNumWaypoints() == numpoints+1)
+			trajectoryCopy.LoadFromFile(filename)
+			assert(trajectoryCopy.GetNumWaypoints() == numpoints)
+			assert(list(trajectory.GetWaypoints(0, numpoints)) == list(trajectoryCopy.GetWaypoints(0, numpoints)))
+		finally:
+			os.remove(filename)
+
+	def test_binary_traj_corrupt(self):
+		env = Environment()
+		numpoints = 50
+		data = numpy.random.rand(numpoints, 4)
+		data[:,3] = 0.01 # deltatime
+		data[0,3] = 0
+		spec = ConfigurationSpecification()
+		spec.AddGroup('joint_values GP7 0 1 2', 3, 'linear')
+		spec.AddDeltaTimeGroup()
+		trajectory = RaveCreateTrajectory(env, '')
+		trajectory.Init(spec)
+		trajectory.Insert(0, data.flatten())
+
+		fd, filename = tempfile.mkstemp(suffix='.traj')
+		os.close(fd)
+		try:
+			trajectory.SaveToFile(filename)
+			with open(filename, 'rb') as f:
+				content = f.read()
+			# the waypoints header is the value size, the flags, the number of values and the number of padding bytes
+			posnumvalues = content.rfind(struct.pack('=Q', numpoints*4))
+			assert(posnumvalues >= 4 and struct.unpack('=H', content[posnumvalues-4:posnumvalues-2])[0] == 8)
+			corruptcontents = [
+				content[:-8], # truncated time index
+				content[:posnumvalues+10+8], # truncated waypoints
+				content[:posnumvalues] + struct.pack('=Q', 2**64-1) + content[posnumvalues+8:], # count that overflows when adding the time index
+				content[:posnumvalues] + struct.pack('=Q', 2**61) + content[posnumvalues+8:], # count larger than the file
+				content[:posnumvalues+8] + struct.pack('=H', 0xffff) + content[posnumvalues+10:], # padding past the end of the file
+			]
+			for corruptcontent in corruptcontents:
+				with open(filename, 'wb') as f:
+					f.write(corruptcontent)
+				for mapfile in [False, True]:
+					trajectoryLoaded = RaveCreateTrajectory(env, '')
+					assert_raises(openrave_exception, trajectoryLoaded.LoadFromFile, filename, mapfile)
+		finally:
+			os.remove(filename)
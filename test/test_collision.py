@@ -82,6 +82,29 @@ class RunCollision(EnvironmentSetup):
             assert(not target1.CheckSelfCollision())
             assert(self.env.CheckCollision(target1,report))
 
+    def test_collisionbatch(self):
+        with self.env:
+            self.LoadEnv('data/lab1.env.xml')
+            robot = self.env.GetRobots()[0]
+            checker = self.env.GetCollisionChecker()
+            lower,upper = robot.GetDOFLimits()
+            dofindices = robot.GetActiveDOFIndices()
+            configurations = array([randlimits(lower[dofindices],upper[dofindices]) for i in range(100)])
+            Tlinks = robot.GetLinkTransformations()
+            for batchoptions in [CollisionBatchOptions.Environment, CollisionBatchOptions.SelfCollision, CollisionBatchOptions.Environment|CollisionBatchOptions.SelfCollision]:
+                collisions = checker.CheckCollisionBatch(robot,dofindices,configurations,batchoptions)
+                # the batch restores the state of the body
+                assert(transdist(robot.GetLinkTransformations(),Tlinks) <= g_epsilon)
+                for configuration, bcollision in izip(configurations, collisions):
+                    robot.SetDOFValues(configuration,dofindices)
+                    bexpected = False
+                    if batchoptions & CollisionBatchOptions.Environment:
+                        bexpected = checker.CheckCollision(robot)
+                    if not bexpected and batchoptions & CollisionBatchOptions.SelfCollision:
+                        bexpected = checker.CheckSelfCollision(robot,None)
+                    assert(bcollision == bexpected)
+                robot.SetLinkTransformations(Tlinks)
+
     def test_attachedbodiescollision(self):
         with self.env:
             self.LoadEnv('data/lab1.env.xml')
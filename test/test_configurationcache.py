@@ -13,6 +13,7 @@
 # limitations under the License.
 from common_test_openrave import *
 from openravepy import openravepy_configurationcache
+import struct
 
 class TestConfigurationCache(EnvironmentSetup):
     def setup(self):
@@ -163,6 +164,158 @@ class TestConfigurationCache(EnvironmentSetup):
 
              self.log.info('exhaustive insertion test passed')
 
+    def test_maxnodes(self):
+        self.LoadEnv('data/lab1.env.xml')
+        env=self.env
+        robot=env.GetRobots()[0]
+        robot.SetActiveDOFs(range(7))
+        with env:
+            cache=openravepy_configurationcache.ConfigurationCache(robot)
+            cache.SetMaxNodes(40)
+            assert(cache.GetMaxNodes() == 40)
+            values = robot.GetActiveDOFValues()
+            allvalues = []
+            for i in range(100):
+                newvalues = array(values)
+                newvalues[0] = -1.5+0.3*(i%10)
+                newvalues[1] = -1.5+0.3*(i//10)
+                assert(cache.InsertConfiguration(newvalues, None) == 1)
+                allvalues.append(newvalues)
+            assert(cache.Validate())
+            # evicting keeps the 30 most recently inserted configurations
+            for newvalues in allvalues[:30]:
+                assert(cache.FindNearestNode(newvalues, 1e-4) is None)
+            for newvalues in allvalues[-30:]:
+                assert(cache.FindNearestNode(newvalues, 1e-4) is not None)
+
+            cache.SetMaxNodes(0)
+            cache.Reset()
+            for newvalues in allvalues[:10]:
+                assert(cache.InsertConfiguration(newvalues, None) == 1)
+            assert(cache.EvictNodes(3) == 7)
+            assert(cache.Validate())
+            for newvalues in allvalues[:7]:
+                assert(cache.FindNearestNode(newvalues, 1e-4) is None)
+            for newvalues in allvalues[7:10]:
+                assert(cache.FindNearestNode(newvalues, 1e-4) is not None)
+            assert(cache.EvictNodes(3) == 0)
+
+    def test_saveload(self):
+        self.LoadEnv('data/lab1.env.xml')
+        env=self.env
+        robot=env.GetRobots()[0]
+        robot.SetActiveDOFs(range(7))
+        cachename = 'testsaveload%d'%os.getpid()
+        cachefilename = RaveFindDatabaseFile('selfcache.'+cachename, False)
+        try:
+            with env:
+                cache0=openravepy_configurationcache.ConfigurationCache(robot)
+                values = robot.GetActiveDOFValues()
+                allvalues = []
+                for i in range(10):
+                    newvalues = array(values)
+                    newvalues[0] = -1.5+0.3*i
+                    assert(cache0.InsertConfiguration(newvalues, None) == 1)
+                    allvalues.append(newvalues)
+                assert(cache0.SaveCache(cachename) == 1)
+
+                cache1=openravepy_configurationcache.ConfigurationCache(robot)
+                assert(cache1.LoadCache(cachename) == 1)
+                assert(cache1.Validate())
+                for newvalues in allvalues:
+                    assert(cache1.FindNearestNode(newvalues, 1e-4) is not None)
+
+                # the use stamps are saved, so the loaded cache evicts the configurations used least recently by the writer
+                cache1=openravepy_configurationcache.ConfigurationCache(robot)
+                assert(cache1.LoadCache(cachename) == 1)
+                newvalues = array(values)
+                newvalues[1] = 1
+                assert(cache1.InsertConfiguration(newvalues, None) == 1)
+                assert(cache1.EvictNodes(3) == 8)
+                for oldvalues in allvalues[:8]:
+                    assert(cache1.FindNearestNode(oldvalues, 1e-4) is None)
+                for oldvalues in allvalues[8:]+[newvalues]:
+                    assert(cache1.FindNearestNode(oldvalues, 1e-4) is not None)
+
+                with open(cachefilename, 'rb') as f:
+                    data = f.read()
+                corruptdatas = [data[:length] for length in [0, 10, len(data)//2, len(data)-1]]
+                corruptdata = bytearray(data)
+                struct.pack_into('=I', corruptdata, 4, 1) # version
+                corruptdatas.append(corruptdata)
+                corruptdata = bytearray(data)
+                struct.pack_into('=i', corruptdata, 16, 0x7fffffff) # number of nodes
+                corruptdatas.append(corruptdata)
+                corruptdata = bytearray(data)
+                corruptdata[56:] = b'\xff'*(len(data)-56) # everything after the header
+                corruptdatas.append(corruptdata)
+                cache2=openravepy_configurationcache.ConfigurationCache(robot)
+                for corruptdata in corruptdatas:
+                    with open(cachefilename, 'wb') as f:
+                        f.write(corruptdata)
+                    assert(cache2.LoadCache(cachename) == 0)
+                    assert(cache2.Validate())
+
+                with open(cachefilename, 'wb') as f:
+                    f.write(data)
+                assert(cache2.LoadCache(cachename) == 1)
+                for newvalues in allvalues:
+                    assert(cache2.FindNearestNode(newvalues, 1e-4) is not None)
+        finally:
+            if os.path.exists(cachefilename):
+                os.remove(cachefilename)
+
+    def test_publishmerge(self):
+        self.LoadEnv('data/lab1.env.xml')
+        env=self.env
+        robot=env.GetRobots()[0]
+        robot.SetActiveDOFs(range(7))
+        cachename = 'testpublishmerge%d'%os.getpid()
+        cachefilename = RaveFindDatabaseFile('selfcache.'+cachename, False)
+        try:
+            with env:
+                cache0=openravepy_configurationcache.ConfigurationCache(robot)
+                cache1=openravepy_configurationcache.ConfigurationCache(robot)
+                values = robot.GetActiveDOFValues()
+                allvalues0 = []
+                allvalues1 = []
+                for i in range(10):
+                    values0 = array(values)
+                    values0[0] = -1.5+0.3*i
+                    assert(cache0.InsertConfiguration(values0, None) == 1)
+                    allvalues0.append(values0)
+                    values1 = array(values)
+                    values1[1] = -1.5+0.3*i
+                    assert(cache1.InsertConfiguration(values1, None) == 1)
+                    allvalues1.append(values1)
+                assert(cache0.HasUnsavedNodes() and cache1.HasUnsavedNodes())
+
+                # both publish at the same time, cache1 overwrites the publication of cache0
+                assert(cache0.PublishCache(cachename) == 1)
+                assert(not cache0.HasUnsavedNodes())
+                assert(cache1.PublishCache(cachename) == 1)
+
+                # cache0 finds its nodes missing from the file when merging it and has to publish again
+                assert(cache0.IsCacheFileModified(cachename))
+                assert(cache0.MergeCache(cachename) > 0)
+                assert(cache0.HasUnsavedNodes())
+                assert(cache0.PublishCache(cachename) == 1)
+
+                # the file now has all the nodes of cache1, so it does not need to publish
+                assert(cache1.IsCacheFileModified(cachename))
+                assert(cache1.MergeCache(cachename) > 0)
+                assert(not cache1.HasUnsavedNodes())
+
+                cache2=openravepy_configurationcache.ConfigurationCache(robot)
+                assert(cache2.LoadCache(cachename) == 1)
+                assert(cache2.Validate())
+                for values in allvalues0+allvalues1:
+                    nn = cache2.FindNearestNode(values, 1e-4)
+                    assert(nn is not None and nn[1] <= 1e-4)
+        finally:
+            if os.path.exists(cachefilename):
+                os.remove(cachefilename)
+
     def test_updates(self):
         env = self.env
         with env:
@@ -14,6 +14,9 @@
 from common_test_openrave import *
 from subprocess import Popen, PIPE
 import shutil
+import tempfile
+import json
+import base64
 import threading
 
 class TestEnvironment(EnvironmentSetup):
@@ -56,6 +59,63 @@ class TestEnvironment(EnvironmentSetup):
         self.LoadDataEnv(xml)
         assert(env.GetBodies()[0].GetURI().find('data/mug1.dae') >= 0)
 
+    def test_binaryarrays(self):
+        self.log.info('check that mesh typed arrays keep their values and types from json to msgpack and back to json')
+        env=self.env
+        body = RaveCreateKinBody(env,'')
+        body.InitFromTrimesh(TriMesh(*misc.ComputeBoxMesh([0.1,0.2,0.3])),True)
+        body.SetName('box')
+        env.Add(body)
+        trimesh = body.GetLinks()[0].GetGeometries()[0].GetCollisionMesh()
+
+        def GetTypedArrays(value, typedarrays):
+            if isinstance(value, dict):
+                if 'typedArray' in value:
+                    typedarrays.append(value)
+                else:
+                    for child in value.values():
+                        GetTypedArrays(child, typedarrays)
+            elif isinstance(value, list):
+                for child in value:
+                    GetTypedArrays(child, typedarrays)
+            return typedarrays
+
+        dtypes = {'float64':'<f8', 'float32':'<f4', 'int32':'<i4'}
+        tempdir = tempfile.mkdtemp()
+        try:
+            jsonfilename = os.path.join(tempdir, 'box.json')
+            msgpackfilename = os.path.join(tempdir, 'box.msgpack')
+            jsonfilename2 = os.path.join(tempdir, 'box2.json')
+            env.Save(jsonfilename, Environment.SelectionOptions.Everything, {'binaryArrays':'1'})
+            env2 = Environment()
+            env3 = Environment()
+            try:
+                assert(env2.Load(jsonfilename))
+                env2.Save(msgpackfilename, Environment.SelectionOptions.Everything, {'binaryArrays':'1'})
+                assert(env3.Load(msgpackfilename))
+                env3.Save(jsonfilename2, Environment.SelectionOptions.Everything, {'binaryArrays':'1'})
+                trimesh3 = env3.GetKinBody('box').GetLinks()[0].GetGeometries()[0].GetCollisionMesh()
+                assert(numpy.all(trimesh3.vertices == trimesh.vertices))
+                assert(numpy.all(trimesh3.indices == trimesh.indices))
+            finally:
+                env2.Destroy()
+                env3.Destroy()
+
+            with open(jsonfilename, 'r') as f:
+                typedarrays = GetTypedArrays(json.load(f), [])
+            with open(jsonfilename2, 'r') as f:
+                typedarrays2 = GetTypedArrays(json.load(f), [])
+            assert(len(typedarrays) == 2 and len(typedarrays2) == 2)
+            for typedarray, typedarray2 in izip(typedarrays, typedarrays2):
+                assert(typedarray['typedArray'] == typedarray2['typedArray'])
+                assert(typedarray['typedArray'] in dtypes)
+                values = numpy.frombuffer(base64.b64decode(typedarray['base64']), dtype=dtypes[typedarray['typedArray']])
+                values2 = numpy.frombuffer(base64.b64decode(typedarray2['base64']), dtype=dtypes[typedarray2['typedArray']])
+                assert(numpy.all(values == values2))
+            assert(sorted([typedarray['typedArray'] for typedarray in typedarrays])[1] == 'int32')
+        finally:
+            shutil.rmtree(tempdir)
+
     def test_scalegeometry(self):
         env=self.env
         with env:
@@ -527,6 +527,70 @@ class TestKinematics(EnvironmentSetup):
                         assert( transdist(-torquegravity, gravitypartials) < 0.1*deltastep*len(gravitypartials))
                         assert( transdist(torquegravity, testtorque_e-testtorque_e2) <= 1e-10 )
 
+    def test_inversedynamicsbatch(self):
+        self.log.info('check that the inverse dynamics with given velocities and in batches match ComputeInverseDynamics')
+        env=self.env
+        with env:
+            for envfile in ['robots/wam7.kinbody.xml', 'robots/barrettwam.robot.xml']:
+                for useelectricmotors in [False, True]:
+                    env.Reset()
+                    env.GetPhysicsEngine().SetGravity([0,0,-9.8])
+                    self.LoadEnv(envfile)
+                    body = [body for body in env.GetBodies() if body.GetDOF() > 0][0]
+                    if useelectricmotors:
+                        # re-create the body with a motor on every joint, the rotor inertia and the friction add to the torques
+                        linkinfos = [link.UpdateAndGetInfo() for link in body.GetLinks()]
+                        jointinfos = [joint.UpdateAndGetInfo() for joint in body.GetJoints()]
+                        for ijoint, jointinfo in enumerate(jointinfos):
+                            motor = ElectricMotorActuatorInfo()
+                            motor.gear_ratio = 50.0+ijoint
+                            motor.rotor_inertia = 1e-5*(ijoint+1)
+                            motor.coloumb_friction = 0.2
+                            motor.viscous_friction = 0.05
+                            jointinfo._infoElectricMotor = motor
+                        jointinfos += [joint.UpdateAndGetInfo() for joint in body.GetPassiveJoints()]
+                        bodymotors = RaveCreateKinBody(env,'')
+                        bodymotors.Init(linkinfos,jointinfos)
+                        bodymotors.SetName(body.GetName()+'_motors')
+                        bodymotors.SetTransform(body.GetTransform())
+                        env.Remove(body)
+                        env.Add(bodymotors)
+                        body = bodymotors
+
+                    dof = body.GetDOF()
+                    lower,upper = body.GetDOFLimits()
+                    vellimits = body.GetDOFVelocityLimits()
+                    vdofvalues = []
+                    vdofvelocities = []
+                    vdofaccelerations = []
+                    vtorques = []
+                    for isample in range(20):
+                        dofvalues = randlimits(lower,upper)
+                        dofvelocities = randlimits(-vellimits,vellimits)
+                        dofaccelerations = 10*random.rand(dof)-5
+                        body.SetDOFValues(dofvalues)
+                        body.SetDOFVelocities(dofvelocities,[0,0,0],[0,0,0],checklimits=True)
+                        torques = body.ComputeInverseDynamics(dofaccelerations)
+                        torques2 = body.ComputeInverseDynamicsWithVelocities(dofvelocities,dofaccelerations)
+                        assert(transdist(torques,torques2) <= 1e-10*(1+sum(abs(torques))))
+                        vdofvalues.append(dofvalues)
+                        vdofvelocities.append(dofvelocities)
+                        vdofaccelerations.append(dofaccelerations)
+                        vtorques.append(torques)
+
+                    # no velocities and accelerations means zero
+                    body.SetDOFVelocities(zeros(dof),[0,0,0],[0,0,0],checklimits=True)
+                    torques = body.ComputeInverseDynamics(None)
+                    assert(transdist(torques,body.ComputeInverseDynamicsWithVelocities(None,None)) <= 1e-10*(1+sum(abs(torques))))
+
+                    dofvalues = body.GetDOFValues()
+                    torquesbatch = body.ComputeInverseDynamicsBatch(array(vdofvalues).flatten(),array(vdofvelocities).flatten(),array(vdofaccelerations).flatten())
+                    assert(torquesbatch.shape == (len(vtorques),dof))
+                    for torques, torques2 in izip(vtorques,torquesbatch):
+                        assert(transdist(torques,torques2) <= 1e-10*(1+sum(abs(torques))))
+                    # the batch restores the state
+                    assert(transdist(body.GetDOFValues(),dofvalues) <= g_epsilon)
+
     def test_hessian(self):
         self.log.info('check the jacobian and hessian computation')
         env=self.env
@@ -589,6 +653,28 @@ class TestKinematics(EnvironmentSetup):
                         coeffs1,residuals, rank, singular_values, rcond=polyfit(mults,errsecond/errsecond[-1],3,full=True)
                         assert(residuals<0.01)
                         
+    def test_kinematicsworkspace(self):
+        self.log.info('check the jacobians and hessians computed with a reused workspace against the legacy functions')
+        env=self.env
+        workspace = KinematicsWorkspace()
+        for envfile in ['robots/barrettwam.robot.xml','robots/wam7.kinbody.xml']:
+            env.Reset()
+            self.LoadEnv(envfile,{'skipgeometry':'1'})
+            body = env.GetBodies()[0]
+            assert(envfile != 'robots/barrettwam.robot.xml' or any([joint.IsMimic() for joint in body.GetPassiveJoints()]))
+            lowerlimit,upperlimit = body.GetDOFLimits()
+            with body:
+                for i in range(20):
+                    body.SetDOFValues(randlimits(lowerlimit,upperlimit))
+                    subindices = [idof for idof in range(body.GetDOF()) if random.rand() < 0.6]
+                    for ilink in range(len(body.GetLinks())):
+                        xyzoffset = random.rand(3)-0.5
+                        for indices in [None, subindices, subindices[::-1]]:
+                            assert(numpy.max(abs(body.ComputeJacobianTranslation(workspace,ilink,xyzoffset,indices)-body.ComputeJacobianTranslation(ilink,xyzoffset,indices))) <= g_epsilon)
+                            assert(numpy.max(abs(body.ComputeJacobianAxisAngle(workspace,ilink,indices)-body.ComputeJacobianAxisAngle(ilink,indices))) <= g_epsilon)
+                            assert(numpy.max(abs(body.ComputeHessianTranslation(workspace,ilink,xyzoffset,indices)-body.ComputeHessianTranslation(ilink,xyzoffset,indices))) <= g_epsilon)
+                            assert(numpy.max(abs(body.ComputeHessianAxisAngle(workspace,ilink,indices)-body.ComputeHessianAxisAngle(ilink,indices))) <= g_epsilon)
+
     def test_initkinbody(self):
         self.log.info('tests initializing a kinematics body')
         env=self.env
@@ -874,6 +960,141 @@ class TestKinematics(EnvironmentSetup):
         assert(J0a.GetMimicDOFIndices() == [0])
         assert(J0b.GetMimicDOFIndices() == [0])
 
+    def test_dofvaluesupdates(self):
+        self.log.info('check that the dof values follow SetDOFValues, SetTransform and mimic joints and time reading them')
+        env=self.env
+        xml="""
+<kinbody name="mimic">
+  <body name="L0">
+  </body>
+  <body name="L1">
+  </body>
+  <body name="L2">
+  </body>
+  <joint name="J0" type="hinge">
+    <body>L0</body>
+    <body>L1</body>
+    <axis>1 0 0</axis>
+    <limits>-1 1</limits>
+  </joint>
+  <joint name="J0a" type="hinge" mimic_pos="-0.5*J0+0.1" mimic_vel="|J0 -0.5" mimic_accel="|J0 0">
+    <body>L1</body>
+    <body>L2</body>
+    <axis>0 1 0</axis>
+  </joint>
+</kinbody>
+"""
+        self.LoadEnv('data/lab1.env.xml')
+        robot=env.GetRobots()[0]
+        mimicbody = env.ReadKinBodyData(xml)
+        env.Add(mimicbody)
+        with env:
+            lower,upper = robot.GetDOFLimits()
+            indices = list(range(0,robot.GetDOF(),2))
+            for itry in range(10):
+                values = randlimits(lower,upper)
+                robot.SetDOFValues(values)
+                assert(transdist(robot.GetDOFValues(),values) <= g_epsilon)
+                assert(transdist(robot.GetDOFValues(indices),values[indices]) <= g_epsilon)
+
+                # setting a subset of the dofs keeps the rest
+                subsetvalues = randlimits(lower[indices],upper[indices])
+                robot.SetDOFValues(subsetvalues,indices)
+                values[indices] = subsetvalues
+                assert(transdist(robot.GetDOFValues(),values) <= g_epsilon)
+
+                # moving the base does not change the joint values
+                T = matrixFromAxisAngle(random.rand(3)-0.5)
+                T[0:3,3] = random.rand(3)-0.5
+                robot.SetTransform(T)
+                assert(transdist(robot.GetDOFValues(),values) <= g_epsilon)
+                assert(transdist(robot.GetDOFValues(indices),values[indices]) <= g_epsilon)
+
+                # the mimic joint follows its dof
+                value = random.rand()*2-1
+                mimicbody.SetDOFValues([value])
+                assert(abs(mimicbody.GetDOFValues()[0]-value) <= g_epsilon)
+                assert(abs(mimicbody.GetJoint('J0a').GetValues()[0]-(-0.5*value+0.1)) <= g_epsilon)
+                mimicbody.SetTransform(T)
+                assert(abs(mimicbody.GetDOFValues()[0]-value) <= g_epsilon)
+                assert(abs(mimicbody.GetJoint('J0a').GetValues()[0]-(-0.5*value+0.1)) <= g_epsilon)
+
+            numreads = 10000
+            starttime = time.time()
+            for i in range(numreads):
+                robot.GetDOFValues()
+            readtime = time.time()-starttime
+            starttime = time.time()
+            for i in range(numreads):
+                robot.SetDOFValues(values)
+                robot.GetDOFValues()
+            setreadtime = time.time()-starttime
+            self.log.info('GetDOFValues of %d dofs: %fus per read, %fus per set and read', robot.GetDOF(), 1e6*readtime/numreads, 1e6*setreadtime/numreads)
+
+    def test_mimiclinearequations(self):
+        self.log.info('check that linear mimic equations evaluated in closed form match the function parser')
+        env=self.env
+        xml="""
+<kinbody name="%s">
+  <body name="L0">
+  </body>
+  <body name="L1">
+    <translation>0 0 0.2</translation>
+  </body>
+  <body name="L2">
+    <translation>0 0.1 0.4</translation>
+  </body>
+  <body name="L3">
+    <translation>0.1 0.1 0.6</translation>
+  </body>
+  <body name="L4">
+    <translation>0.1 0.2 0.8</translation>
+  </body>
+  <joint name="J0" type="hinge">
+    <body>L0</body>
+    <body>L1</body>
+    <axis>1 0 0</axis>
+  </joint>
+  <joint name="J1" type="hinge">
+    <body>L1</body>
+    <body>L2</body>
+    <axis>0 1 0</axis>
+  </joint>
+  <joint name="J2" type="hinge" mimic_pos="%s" mimic_vel="%s" mimic_accel="%s">
+    <body>L2</body>
+    <body>L3</body>
+    <axis>0 0.6 0.8</axis>
+  </joint>
+  <joint name="J3" type="slider" mimic_pos="%s" mimic_vel="%s" mimic_accel="%s">
+    <body>L3</body>
+    <body>L4</body>
+    <axis>0 0 1</axis>
+    <limits>-1 1</limits>
+  </joint>
+</kinbody>
+"""
+        # the function calls multiplied by zero make the equations non-linear to the closed form parser, so they are evaluated by the function parser
+        linearbody = env.ReadKinBodyData(xml%('linear', '2*J0-0.5*J1+0.3', '|J0 2 |J1 -0.5', '|J0 0 |J1 0', '0.1*J2-0.05', '|J2 0.1', '|J2 0'))
+        parserbody = env.ReadKinBodyData(xml%('parser', '2*J0-0.5*J1+0.3+0*sin(J0)', '|J0 2+0*sin(J0) |J1 -0.5+0*sin(J1)', '|J0 0*sin(J0) |J1 0*sin(J1)', '0.1*J2-0.05+0*sin(J2)', '|J2 0.1+0*sin(J2)', '|J2 0*sin(J2)'))
+        with env:
+            env.Add(linearbody)
+            env.Add(parserbody)
+            assert(len(linearbody.GetPassiveJoints()) == 2 and len(parserbody.GetPassiveJoints()) == 2)
+            lower,upper = linearbody.GetDOFLimits()
+            for itry in range(20):
+                dofvalues = randlimits(numpy.maximum(lower,-2),numpy.minimum(upper,2))
+                dofvelocities = random.rand(len(dofvalues))-0.5
+                dofaccelerations = random.rand(len(dofvalues))-0.5
+                for body in [linearbody, parserbody]:
+                    body.SetDOFValues(dofvalues)
+                    body.SetDOFVelocities(dofvelocities)
+                for jointname in ['J2','J3']:
+                    assert(abs(linearbody.GetJoint(jointname).GetValues()[0]-parserbody.GetJoint(jointname).GetValues()[0]) <= g_epsilon)
+                assert(abs(linearbody.GetJoint('J2').GetValues()[0]-(2*dofvalues[0]-0.5*dofvalues[1]+0.3)) <= g_epsilon)
+                assert(transdist(linearbody.GetLinkTransformations(),parserbody.GetLinkTransformations()) <= g_epsilon)
+                assert(transdist(linearbody.GetLinkVelocities(),parserbody.GetLinkVelocities()) <= g_epsilon)
+                assert(transdist(linearbody.GetLinkAccelerations(dofaccelerations),parserbody.GetLinkAccelerations(dofaccelerations)) <= g_epsilon)
+
     def test_specification(self):
         env=self.env
         self.LoadEnv('data/lab1.env.xml')
@@ -1121,3 +1342,81 @@ class TestKinematics(EnvironmentSetup):
         assert(robot.CheckSelfCollision())
         robot.SetNonCollidingConfiguration()
         assert(not robot.CheckSelfCollision())
+
+    def test_straightlinekinematics(self):
+        self.log.info('check that the straight-line kinematics generator computes the same link transforms and jacobians as the generic kinematics')
+        env=self.env
+        with env:
+            # the generator does not handle mimic joints, so use bodies without them
+            for robotfile in ['robots/wam7.kinbody.xml','robots/wam4.kinbody.xml','robots/tridof.robot.xml']:
+                env.Reset()
+                self.LoadEnv(robotfile)
+                body = env.GetBodies()[0]
+                assert(not any([joint.IsMimic() for joint in body.GetJoints()+body.GetPassiveJoints()]))
+                body.SetStraightLineKinematics(False)
+                assert(not body.IsStraightLineKinematics())
+                lower,upper = body.GetDOFLimits()
+                vdofvalues = [randlimits(lower,upper) for i in range(50)]
+                vexpected = []
+                for dofvalues in vdofvalues:
+                    body.SetDOFValues(dofvalues)
+                    vjacobians = []
+                    for link in body.GetLinks():
+                        position = link.GetTransform()[0:3,3]+numpy.array([0.1,-0.05,0.02])
+                        vjacobians.append((body.ComputeJacobianTranslation(link.GetIndex(),position),body.ComputeJacobianAxisAngle(link.GetIndex())))
+                    vexpected.append((body.GetLinkTransformations(),vjacobians))
+                body.SetStraightLineKinematics(True)
+                assert(body.IsStraightLineKinematics())
+                for dofvalues, (Tlinks, vjacobians) in izip(vdofvalues, vexpected):
+                    body.SetDOFValues(dofvalues)
+                    assert(transdist(body.GetLinkTransformations(),Tlinks) <= g_epsilon*len(Tlinks))
+                    for link, (Jt, Ja) in izip(body.GetLinks(), vjacobians):
+                        position = link.GetTransform()[0:3,3]+numpy.array([0.1,-0.05,0.02])
+                        assert(transdist(body.ComputeJacobianTranslation(link.GetIndex(),position),Jt) <= g_epsilon*len(Jt))
+                        assert(transdist(body.ComputeJacobianAxisAngle(link.GetIndex()),Ja) <= g_epsilon*len(Ja))
+                body.SetStraightLineKinematics(False)
+                assert(not body.IsStraightLineKinematics())
+
+    def test_nevercollidinglinkpairs(self):
+        self.log.info('check the link pair collision classes and that the never colliding pairs are only reused for dof limits within the analyzed ones')
+        env=self.env
+        with env:
+            robot = self.LoadRobot('robots/barrettwam.robot.xml')
+            lower,upper = robot.GetDOFLimits()
+            dofvalues = robot.GetDOFValues()
+            nonadjacent = robot.GetNonAdjacentLinks()
+            never, always = robot.ComputeLinkPairCollisionClasses(200, 0)
+            assert(len(never) > 0)
+            assert(len(set(never) & set(always)) == 0)
+            for pair in never:
+                assert(pair[0] < pair[1] and not robot.AreAdjacentLinks(pair[0],pair[1]))
+            # the analysis restores the state
+            assert(transdist(robot.GetDOFValues(),dofvalues) <= g_epsilon)
+
+            robot.SetNeverCollidingLinkPairs(never)
+            assert(sorted(robot.GetNeverCollidingLinkPairs()) == sorted(never))
+            prunednonadjacent = robot.GetNonAdjacentLinks()
+            assert(len(set(prunednonadjacent) & set(never)) == 0)
+            assert(set(prunednonadjacent) | set(never) >= set(nonadjacent))
+
+            assert(robot.SaveNeverCollidingLinkPairs())
+            filename = RaveFindDatabaseFile('selfcollision.%s.neverpairs.txt'%robot.GetKinematicsGeometryHash(), True)
+            assert(len(filename) > 0)
+            try:
+                # a body with the same kinematics loads the saved pairs
+                robot2 = self.LoadRobot('robots/barrettwam.robot.xml')
+                assert(sorted(robot2.GetNeverCollidingLinkPairs()) == sorted(never))
+
+                # narrower limits are still covered by the analysis
+                robot2.SetDOFLimits(lower+0.1*(upper-lower), upper-0.1*(upper-lower))
+                assert(sorted(robot2.GetNeverCollidingLinkPairs()) == sorted(never))
+
+                # wider limits were not analyzed, so nothing is known to never collide
+                robot2.SetDOFLimits(lower-0.5, upper+0.5)
+                assert(len(robot2.GetNeverCollidingLinkPairs()) == 0)
+                assert(set(robot2.GetNonAdjacentLinks()) >= set(robot.GetNonAdjacentLinks()))
+
+                robot2.SetDOFLimits(lower, upper)
+                assert(sorted(robot2.GetNeverCollidingLinkPairs()) == sorted(never))
+            finally:
+                os.remove(filename)
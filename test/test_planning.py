@@ -621,6 +621,134 @@ class RunPlanning(EnvironmentSetup):
             assert(success)
             assert(not env.CheckCollision(collisionbody))
 
+    def test_parallelsegmentcheck(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot=env.GetRobots()[0]
+        with env:
+            robot.SetActiveDOFs(robot.GetActiveManipulator().GetArmIndices())
+            robot.SetDOFResolutions(0.002*ones(robot.GetDOF()))
+            params=Planner.PlannerParameters()
+            params.SetRobotActiveJoints(robot)
+            sequential = planningutils.DynamicsCollisionConstraint(params,[robot])
+            parallel = planningutils.DynamicsCollisionConstraint(params,[robot])
+            parallel.SetParallelCheck(4)
+            lower,upper = robot.GetActiveDOFLimits()
+            zeros = numpy.zeros(robot.GetActiveDOF())
+            options = ConstraintFilterOptions.CheckEnvCollisions|ConstraintFilterOptions.CheckSelfCollisions
+            mug = env.GetKinBody('mug1')
+            Tmug = mug.GetTransform()
+            for itry in range(30):
+                if itry == 10:
+                    # the workers only synchronize the moved body
+                    mug.SetTransform(dot(matrixFromAxisAngle([0,0,pi/3]),Tmug))
+                elif itry == 20:
+                    # the workers clone the environment again
+                    box = RaveCreateKinBody(env,'')
+                    box.InitFromBoxes(array([[0.4,0,1.0,0.1,0.1,0.1]]),True)
+                    box.SetName('parallelbox')
+                    env.Add(box)
+                q0 = randlimits(lower,upper)
+                q1 = randlimits(lower,upper)
+                robot.SetActiveDOFValues(q0)
+                expected = sequential.Check(q0,q1,zeros,zeros,0,Interval.OpenStart,options,True)
+                robot.SetActiveDOFValues(q0)
+                result = parallel.Check(q0,q1,zeros,zeros,0,Interval.OpenStart,options,True)
+                assert(result['returncode'] == expected['returncode'])
+                if expected['returncode'] != 0:
+                    # the first invalid state of the segment is found
+                    assert(abs(result['fTimeWhenInvalid']-expected['fTimeWhenInvalid']) <= g_epsilon)
+                    assert(transdist(result['invalidvalues'],expected['invalidvalues']) <= g_epsilon)
+
+    def test_parallelsegmentcheckgrabbed(self):
+        self.log.info('check that the parallel segment check workers see a grabbed body swapped for another one')
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot=env.GetRobots()[0]
+        with env:
+            manip = robot.GetActiveManipulator()
+            robot.SetActiveDOFs(manip.GetArmIndices())
+            robot.SetDOFResolutions(0.002*ones(robot.GetDOF()))
+            params=Planner.PlannerParameters()
+            params.SetRobotActiveJoints(robot)
+            sequential = planningutils.DynamicsCollisionConstraint(params,[robot])
+            parallel = planningutils.DynamicsCollisionConstraint(params,[robot])
+            parallel.SetParallelCheck(4)
+            zeros = numpy.zeros(robot.GetActiveDOF())
+            options = ConstraintFilterOptions.CheckEnvCollisions|ConstraintFilterOptions.CheckSelfCollisions
+            lower,upper = robot.GetActiveDOFLimits()
+            q0 = robot.GetActiveDOFValues()
+            q1 = numpy.minimum(q0 + 0.1, upper)
+            vboxes = []
+            for name, extent in [('smallbox',0.01),('bigbox',2.0)]:
+                box = RaveCreateKinBody(env,'')
+                box.InitFromBoxes(array([[0,0,0,extent,extent,extent]]),True)
+                box.SetName(name)
+                env.Add(box)
+                box.SetTransform(manip.GetTransform())
+                vboxes.append(box)
+            robot.Grab(vboxes[0])
+            robot.SetActiveDOFValues(q0)
+            expected = sequential.Check(q0,q1,zeros,zeros,0,Interval.OpenStart,options,True)
+            robot.SetActiveDOFValues(q0)
+            result = parallel.Check(q0,q1,zeros,zeros,0,Interval.OpenStart,options,True)
+            assert(result['returncode'] == expected['returncode'])
+
+            # same number of grabbed bodies, but the new one hits the environment everywhere
+            robot.Release(vboxes[0])
+            vboxes[0].SetTransform(eye(4)+array([[0,0,0,10],[0,0,0,10],[0,0,0,10],[0,0,0,0]]))
+            robot.Grab(vboxes[1])
+            assert(robot.GetNumGrabbed() == 1)
+            robot.SetActiveDOFValues(q0)
+            expected = sequential.Check(q0,q1,zeros,zeros,0,Interval.OpenStart,options,True)
+            assert(expected['returncode'] != 0)
+            robot.SetActiveDOFValues(q0)
+            result = parallel.Check(q0,q1,zeros,zeros,0,Interval.OpenStart,options,True)
+            assert(result['returncode'] == expected['returncode'])
+            robot.ReleaseAllGrabbed()
+
+    def test_parallelbirrt(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot=env.GetRobots()[0]
+        with env:
+            robot.SetActiveDOFs(robot.GetActiveManipulator().GetArmIndices())
+            lower,upper = robot.GetActiveDOFLimits()
+            initconfig = robot.GetActiveDOFValues()
+            goalconfig = None
+            for itry in range(100):
+                q = randlimits(lower,upper)
+                with robot:
+                    robot.SetActiveDOFValues(q)
+                    if not env.CheckCollision(robot) and not robot.CheckSelfCollision():
+                        goalconfig = q
+                        break
+            assert(goalconfig is not None)
+            # parameters set from the configuration specification keep default functions too, so they also plan in parallel
+            for numthreads, busespec in [(1,False),(4,False),(4,True)]:
+                params = Planner.PlannerParameters()
+                if busespec:
+                    params.SetConfigurationSpecification(env, robot.GetActiveConfigurationSpecification())
+                else:
+                    params.SetRobotActiveJoints(robot)
+                params.SetInitialConfig(initconfig)
+                params.SetGoalConfig(goalconfig)
+                params.SetMaxIterations(5000)
+                params.SetRandomGeneratorSeed(1)
+                params.SetExtraParameters('<numthreads>%d</numthreads>'%numthreads)
+                planner = RaveCreatePlanner(env,'BiRRT')
+                assert(planner.InitPlan(robot,params))
+                traj = RaveCreateTrajectory(env,'')
+                status = planner.PlanPath(traj)
+                assert(status.statusCode == PlannerStatusCode.HasSolution)
+                assert(int(planner.SendCommand('GetNumPlanningThreads')) == numthreads)
+                assert(transdist(traj.GetWaypoint(0,robot.GetActiveConfigurationSpecification()),initconfig) <= g_epsilon)
+                assert(transdist(traj.GetWaypoint(-1,robot.GetActiveConfigurationSpecification()),goalconfig) <= g_epsilon)
+                with robot:
+                    checkparams = Planner.PlannerParameters()
+                    checkparams.SetRobotActiveJoints(robot)
+                    planningutils.VerifyTrajectory(checkparams,traj,samplingstep=0.002)
+
 #generate_classes(RunPlanning, globals(), [('ode','ode'),('bullet','bullet')])
 
 class test_ode(RunPlanning):
@@ -805,6 +805,33 @@ class TestTrajectory(EnvironmentSetup):
                 expectedaccel=array([  0.00000000e+00,   7.50000000e+00,   1.00000000e+01, 1.00000000e+01,   1.00000000e+01,   0.00000000e+00, 3.50596745e-16,   4.67462326e-16,   4.67462326e-16, 4.67462326e-16,   0.00000000e+00,  -7.50000000e+00, -1.00000000e+01,  -1.00000000e+01,  -1.00000000e+01, 0.00000000e+00,   0.00000000e+00,   0.00000000e+00, 0.00000000e+00,   0.00000000e+00])
                 assert(transdist(expectedaccel,acceldata) <= g_epsilon)
 
+    def test_samplepoints(self):
+        # batch sampling has to give the same result as sampling one time at a time
+        env=self.env
+        groups = [[('joint_values dummy 0 1 2','cubic'),('joint_velocities dummy 0 1 2','quadratic')],
+                  [('joint_values dummy 0 1 2','quintic'),('joint_velocities dummy 0 1 2','quartic'),('joint_accelerations dummy 0 1 2','cubic')]]
+        for groupinfos in groups:
+            spec = ConfigurationSpecification()
+            for name,interpolation in groupinfos:
+                spec.AddGroup(name,3,interpolation)
+            spec.AddDeltaTimeGroup()
+            dof = spec.GetDOF()
+            numpoints = 6
+            waypoints = random.rand(numpoints,dof)*2-1
+            deltatimes = 0.1+0.4*random.rand(numpoints)
+            deltatimes[0] = 0
+            waypoints[:,dof-1] = deltatimes
+            traj = RaveCreateTrajectory(env,'')
+            traj.Init(spec)
+            traj.Insert(0,waypoints.flatten())
+            duration = traj.GetDuration()
+            times = r_[random.rand(40)*duration, cumsum(deltatimes), duration+0.1]
+            times.sort()
+            data = traj.SamplePoints2D(times)
+            assert(data.shape == (len(times),dof))
+            for t,point in izip(times,data):
+                assert(numpy.max(abs(point-traj.Sample(t))) <= g_epsilon)
+
     def test_extendwaypoint(self):
         env=self.env
         self.LoadEnv('data/lab1.env.xml')